@@ -0,0 +1,596 @@
+#include "assetRegistry.h"
+#include "fileReader.h"
+#include "meshCache.h"
+#include "ormPacker.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+	uint64_t CombineHash(uint64_t hash, uint64_t value)
+	{
+		return hash ^ (value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+	}
+
+	bool IsSameSamplerState(const VkSamplerCreateInfo& lhs, const VkSamplerCreateInfo& rhs)
+	{
+		return lhs.flags == rhs.flags &&
+			lhs.magFilter == rhs.magFilter && lhs.minFilter == rhs.minFilter && lhs.mipmapMode == rhs.mipmapMode &&
+			lhs.addressModeU == rhs.addressModeU && lhs.addressModeV == rhs.addressModeV && lhs.addressModeW == rhs.addressModeW &&
+			lhs.mipLodBias == rhs.mipLodBias && lhs.anisotropyEnable == rhs.anisotropyEnable &&
+			lhs.maxAnisotropy == rhs.maxAnisotropy && lhs.compareEnable == rhs.compareEnable && lhs.compareOp == rhs.compareOp &&
+			lhs.minLod == rhs.minLod && lhs.maxLod == rhs.maxLod && lhs.borderColor == rhs.borderColor &&
+			lhs.unnormalizedCoordinates == rhs.unnormalizedCoordinates;
+	}
+
+	std::string GetTextureKey(const std::string& path, bool isSrgb)
+	{
+		return path + (isSrgb ? "|srgb" : "|linear");
+	}
+
+	std::string GetOrmKey(const FH::FHMaterialPaths& material)
+	{
+		return "orm|" + material.ao + "|" + material.roughness + "|" + material.specular;
+	}
+
+	double GetMillisSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count();
+	}
+
+	//Bytes of the texture at maxSize, without decoding an image to shrink it
+	VkDeviceSize GetLimitedByteSize(FH::FHTexture::Decoded decoded, uint32_t maxSize)
+	{
+		if (decoded.pKtxFile)
+			FH::FHTexture::LimitSize(decoded, maxSize);
+		else
+		{
+			while (std::max(decoded.width, decoded.height) > std::max(maxSize, 1u))
+			{
+				decoded.width = std::max(decoded.width / 2, 1u);
+				decoded.height = std::max(decoded.height / 2, 1u);
+			}
+		}
+		return FH::FHTexture::GetByteSize(decoded);
+	}
+}
+
+template<typename Asset, typename Loader>
+std::shared_ptr<Asset> FH::FHAssetRegistry::Get(Cache<Asset>& cache, const std::string& key, const std::vector<std::string>& files,
+	uint64_t settingsHash, Loader&& load)
+{
+	if (std::shared_ptr<Asset> pAsset{ cache.byPath[key].lock() })
+	{
+		++m_Stats.sharedCount;
+		return pAsset;
+	}
+
+	//Hashing reads each file at most once per change, far cheaper than decoding and uploading it a second time
+	uint64_t contentHash{ settingsHash };
+	bool isHashed{ true };
+	for (const std::string& file : files)
+	{
+		FHSourceHash sourceHash{};
+		if (!file.empty() && !HashFile(file, sourceHash))
+		{
+			isHashed = false;
+			break;
+		}
+		contentHash = CombineHash(contentHash, sourceHash.hash);
+	}
+
+	if (isHashed)
+	{
+		const auto content{ cache.byContent.find(contentHash) };
+		if (content != cache.byContent.end())
+		{
+			std::shared_ptr<Asset> pAsset{ content->second.pAsset.lock() };
+			if (pAsset && IsSameContent(files, content->second.files))
+			{
+				std::cout << "Sharing " << key << " with an identical asset" << std::endl;
+				cache.byPath[key] = pAsset;
+				++m_Stats.sharedCount;
+				return pAsset;
+			}
+		}
+	}
+
+	//Forget the assets that were freed since the last load
+	std::erase_if(cache.byPath, [](const auto& entry) { return entry.second.expired(); });
+	std::erase_if(cache.byContent, [](const auto& entry) { return entry.second.pAsset.expired(); });
+
+	std::shared_ptr<Asset> pAsset{ load() };
+	cache.byPath[key] = pAsset;
+	//A colliding hash keeps the first asset, the second is loaded every time like any other unshared asset
+	if (isHashed && !cache.byContent.contains(contentHash))
+		cache.byContent[contentHash] = { pAsset, files };
+
+	++m_Stats.loadCount;
+	return pAsset;
+}
+
+bool FH::FHAssetRegistry::HashFile(const std::string& file, FHSourceHash& sourceHash)
+{
+	const std::string sourcePath{ "resources/" + file };
+	FHSourceStamp stamp{};
+	if (!FHMeshCache::StampSourceFile(sourcePath, stamp))
+		return false;
+
+	if (const auto hashed{ m_SourceHashes.find(file) }; hashed != m_SourceHashes.end() && hashed->second.stamp == stamp)
+	{
+		sourceHash = hashed->second;
+		return true;
+	}
+
+	sourceHash.stamp = stamp;
+	//Any flags hold the same source hash, the cache of the default import settings is the one most likely written
+	const std::string cachePath{ FHMeshCache::GetCachePath(sourcePath, FHMeshCache::GetFlags(FHModelLoadOptions{})) };
+	uint64_t size{};
+	if (!FHMeshCache{ cachePath }.GetSourceHash(stamp, sourceHash.hash) &&
+		!FHMeshCache::HashSourceFile(sourcePath, sourceHash.hash, size))
+		return false;
+
+	m_SourceHashes[file] = sourceHash;
+	return true;
+}
+
+bool FH::FHAssetRegistry::IsSameContent(const std::vector<std::string>& files, const std::vector<std::string>& otherFiles)
+{
+	if (files.size() != otherFiles.size())
+		return false;
+
+	//Sizes come from the stamps, the bytes are only compared once those match
+	for (size_t fileIdx = 0; fileIdx < files.size(); ++fileIdx)
+	{
+		if (files[fileIdx] == otherFiles[fileIdx])
+			continue;
+
+		FHSourceHash sourceHash{};
+		FHSourceHash otherHash{};
+		if (files[fileIdx].empty() || otherFiles[fileIdx].empty() || !HashFile(files[fileIdx], sourceHash) ||
+			!HashFile(otherFiles[fileIdx], otherHash) || sourceHash.stamp.size != otherHash.stamp.size)
+			return false;
+
+		const FHMappedFile source{ "resources/" + files[fileIdx] };
+		const FHMappedFile other{ "resources/" + otherFiles[fileIdx] };
+		if (!source.IsOpen() || !other.IsOpen() || source.GetSize() != other.GetSize() ||
+			!std::equal(source.GetData(), source.GetData() + source.GetSize(), other.GetData()))
+			return false;
+	}
+	return true;
+}
+
+FH::FHAssetRegistry::FHAssetRegistry(FHDevice& device, FHGeometryPool& geometryPool)
+	: m_FHDevice{ device }
+	, m_FHGeometryPool{ geometryPool }
+{
+	m_ResidencyManager.SetReloader([this](FHTexture& texture, uint64_t frame) { ReloadTexture(texture, frame); });
+}
+
+FH::FHAssetRegistry::~FHAssetRegistry()
+{
+	for (const auto& [samplerInfo, sampler] : m_Samplers)
+		vkDestroySampler(m_FHDevice.GetDevice(), sampler, nullptr);
+}
+
+std::shared_ptr<FH::FHTexture> FH::FHAssetRegistry::GetTexture(const std::string& path, bool isSrgb)
+{
+	const std::string key{ GetTextureKey(path, isSrgb) };
+	std::shared_ptr<FHTexture> pTexture{ Get(m_Textures, key, { path }, isSrgb ? 1 : 0,
+		[&]() { return UploadTexture(key, [this, path, isSrgb]() { return FHTexture::Probe(m_FHDevice, path, isSrgb); }); }) };
+	if (pTexture->IsEvicted())
+		m_ResidencyManager.Reload(*pTexture);
+
+	//A preloaded image is unused when an identical texture was shared instead
+	m_PendingTextures.erase(key);
+	return pTexture;
+}
+
+std::shared_ptr<FH::FHVirtualTexture> FH::FHAssetRegistry::GetVirtualTexture(const std::string& path)
+{
+	std::shared_ptr<const FHKtxFile> pKtxFile{ OpenVirtualKtx(path) };
+	if (!pKtxFile)
+		return nullptr;
+
+	std::shared_ptr<FHVirtualTexture> pTexture{ Get(m_VirtualTextures, "virtual|" + path, { path }, 3,
+		[&]() { return m_VirtualTextureCache.Create(std::move(pKtxFile)); }) };
+
+	m_PendingTextures.erase(GetTextureKey(path, true));
+	return pTexture;
+}
+
+std::shared_ptr<FH::FHTexture> FH::FHAssetRegistry::GetOrmTexture(const FHMaterialPaths& material)
+{
+	const std::string key{ GetOrmKey(material) };
+	std::shared_ptr<FHTexture> pTexture{ Get(m_Textures, key, { material.ao, material.roughness, material.specular }, 2,
+		[&]() { return UploadTexture(key, [this, material]() { return FHTexture::DecodeOrm(m_FHDevice, material); }); }) };
+	if (pTexture->IsEvicted())
+		m_ResidencyManager.Reload(*pTexture);
+
+	m_PendingTextures.erase(key);
+	return pTexture;
+}
+
+void FH::FHAssetRegistry::AnalyzeTexelDensity(const std::string& modelPath, const FHModelLoadOptions& options,
+	const glm::vec3& scale, const FHMaterialPaths& material, const FHTexelDensity::View& view, bool limitSize)
+{
+	if (!limitSize && !options.printStats)
+		return;
+
+	//Measured on the mesh cache GetModel maps next, a cold import here leaves the cache behind for it
+	FHTexelDensity::Surface surface{};
+	FHModel::InspectModelData(modelPath, options, [&surface, &scale](std::span<const FHModel::Vertex> vertices,
+		std::span<const uint32_t> indices, std::span<const FHModel::Lod> lods)
+		{
+			surface = FHTexelDensity::Measure(vertices, indices, lods, scale);
+		});
+
+	const uint32_t resolvableSize{ FHTexelDensity::GetResolvableSize(surface, view) };
+	if (resolvableSize == UINT32_MAX)
+	{
+		if (options.printStats)
+			std::cout << "Texel density " << modelPath << ": no UV area, textures are loaded as they are" << std::endl;
+		return;
+	}
+
+	if (options.printStats)
+		std::cout << "Texel density " << modelPath << ": " << FHTexelDensity::GetUvDensity(surface) << " UV and "
+			<< FHTexelDensity::GetPixelDensity(view) << " pixels per unit at " << view.distance << " units, "
+			<< resolvableSize << " texels resolvable" << std::endl;
+
+	struct Slot
+	{
+		std::string key{};
+		std::vector<std::string> files{};
+		bool isSrgb{};
+	};
+
+	//Virtual textures only keep the pages that are sampled, they have nothing to gain from a limit
+	std::vector<Slot> slots{};
+	if (!material.diffuse.empty() && !OpenVirtualKtx(material.diffuse))
+		slots.push_back({ GetTextureKey(material.diffuse, true), { material.diffuse }, true });
+	if (!material.normal.empty())
+		slots.push_back({ GetTextureKey(material.normal, false), { material.normal }, false });
+	if (FHOrmPacker::HasChannels(material))
+	{
+		const std::string packedPath{ FHOrmPacker::GetPackedPath(material) };
+		slots.push_back({ GetOrmKey(material), std::filesystem::exists("resources/" + packedPath) ? std::vector<std::string>{ packedPath } :
+			std::vector<std::string>{ material.ao, material.roughness, material.specular }, false });
+	}
+
+	for (const Slot& slot : slots)
+	{
+		//Without a packed .ktx2 the ORM image is as large as its largest source
+		FHTexture::Decoded probed{};
+		for (const std::string& file : slot.files)
+		{
+			if (file.empty())
+				continue;
+
+			try
+			{
+				FHTexture::Decoded fileProbe{ FHTexture::Probe(m_FHDevice, file, slot.isSrgb) };
+				if (FHTexture::GetSize(fileProbe) > FHTexture::GetSize(probed))
+					probed = std::move(fileProbe);
+			}
+			catch (const std::exception&)
+			{
+				//Reported by the Get call that loads it
+			}
+		}
+
+		const uint32_t textureSize{ FHTexture::GetSize(probed) };
+		if (options.printStats && textureSize > resolvableSize)
+		{
+			const VkDeviceSize byteSize{ FHTexture::GetByteSize(probed) };
+			std::cout << "  " << slot.key << ": " << textureSize << " texels, oversized, " << byteSize / 1024 << " KiB -> "
+				<< GetLimitedByteSize(probed, resolvableSize) / 1024 << " KiB at " << resolvableSize << std::endl;
+		}
+
+		if (limitSize)
+		{
+			uint32_t& sizeLimit{ m_TextureSizeLimits[slot.key] };
+			sizeLimit = std::max(sizeLimit, resolvableSize);
+		}
+	}
+}
+
+void FH::FHAssetRegistry::PreloadTextures(const std::vector<FHMaterialPaths>& materials)
+{
+	using FileData = std::vector<std::vector<uint8_t>>;
+	//The ORM sources, reads are tagged with the job and the file within it
+	constexpr size_t maxJobFiles{ 3 };
+
+	//Images without a .ktx2 are read by the file reader and probed from memory, the upload decodes the bytes into its
+	//staging memory. ORM sources are packed here and a .ktx2 is mapped instead
+	struct Job
+	{
+		std::string key{};
+		std::function<FHTexture::Decoded()> decode{};
+		std::vector<std::string> readFiles{};
+		std::function<FHTexture::Decoded(FileData&)> decodeRead{};
+		FileData fileData{};
+		std::vector<FHSourceStamp> fileStamps{};
+		size_t pendingReads{};
+		uintmax_t fileSize{};
+		PendingTexture result{};
+		bool isDecoded{};
+	};
+
+	std::vector<Job> jobs{};
+	auto addJob = [&](const std::string& key, const std::vector<std::string>& files, const std::string& ktxPath,
+		std::function<FHTexture::Decoded()> decode, std::function<FHTexture::Decoded(FileData&)> decodeRead)
+		{
+			const auto loaded{ m_Textures.byPath.find(key) };
+			if ((loaded != m_Textures.byPath.end() && !loaded->second.expired()) || m_PendingTextures.contains(key) ||
+				std::any_of(jobs.begin(), jobs.end(), [&key](const Job& job) { return job.key == key; }))
+				return;
+
+			Job job{ key, std::move(decode) };
+			for (const std::string& file : files)
+			{
+				FHSourceStamp stamp{};
+				if (!file.empty())
+					FHMeshCache::StampSourceFile("resources/" + file, stamp);
+				job.fileSize += stamp.size;
+				job.fileStamps.push_back(stamp);
+			}
+
+			if (!std::filesystem::exists(ktxPath))
+			{
+				job.readFiles = files;
+				job.decodeRead = std::move(decodeRead);
+				job.fileData.resize(files.size());
+			}
+			jobs.push_back(std::move(job));
+		};
+
+	for (const FHMaterialPaths& material : materials)
+	{
+		if (!material.diffuse.empty() && !OpenVirtualKtx(material.diffuse))
+			addJob(GetTextureKey(material.diffuse, true), { material.diffuse }, FHKtxFile::GetKtxPath("resources/" + material.diffuse),
+				[this, path = material.diffuse]() { return FHTexture::Probe(m_FHDevice, path, true); },
+				[](FileData& fileData) { return FHTexture::Probe(std::move(fileData[0]), true); });
+		if (!material.normal.empty())
+			addJob(GetTextureKey(material.normal, false), { material.normal }, FHKtxFile::GetKtxPath("resources/" + material.normal),
+				[this, path = material.normal]() { return FHTexture::Probe(m_FHDevice, path, false); },
+				[](FileData& fileData) { return FHTexture::Probe(std::move(fileData[0]), false); });
+		if (FHOrmPacker::HasChannels(material))
+			addJob(GetOrmKey(material), { material.ao, material.roughness, material.specular },
+				"resources/" + FHOrmPacker::GetPackedPath(material),
+				[this, material]() { return FHTexture::DecodeOrm(m_FHDevice, material); },
+				[material](FileData& fileData)
+				{
+					FHOrmPacker::Image image{ FHOrmPacker::Pack(material, std::span<const std::vector<uint8_t>, 3>{ fileData.data(), 3 }) };
+					FHTexture::Decoded decoded{};
+					decoded.pixels = std::move(image.pixels);
+					decoded.width = image.width;
+					decoded.height = image.height;
+					return decoded;
+				});
+	}
+
+	//Largest first and every worker pulls the next job, so one big image does not hold back a whole range
+	std::sort(jobs.begin(), jobs.end(), [](const Job& lhs, const Job& rhs) { return lhs.fileSize > rhs.fileSize; });
+
+	//Every read is queued up front, the workers probe or pack each image as soon as its files are in
+	const auto start{ std::chrono::steady_clock::now() };
+	FHFileReader reader{};
+	std::vector<size_t> mappedJobs{};
+	for (size_t jobIdx = 0; jobIdx < jobs.size(); ++jobIdx)
+	{
+		Job& job{ jobs[jobIdx] };
+		if (!job.decodeRead)
+		{
+			mappedJobs.push_back(jobIdx);
+			continue;
+		}
+
+		for (size_t fileIdx = 0; fileIdx < job.readFiles.size(); ++fileIdx)
+			if (!job.readFiles[fileIdx].empty())
+			{
+				reader.Read("resources/" + job.readFiles[fileIdx], jobIdx * maxJobFiles + fileIdx);
+				++job.pendingReads;
+			}
+	}
+
+	auto runJob = [](Job& job, const std::function<FHTexture::Decoded()>& decode)
+		{
+			const auto decodeStart{ std::chrono::steady_clock::now() };
+			try
+			{
+				job.result.decoded = decode();
+				job.isDecoded = true;
+			}
+			catch (const std::exception&)
+			{
+				//Decoded again on the main thread by the Get call, which reports the error
+			}
+			job.result.decodeMillis = GetMillisSince(decodeStart);
+		};
+
+	std::mutex jobMutex{};
+	std::atomic<size_t> nextJob{};
+	ParallelFor(jobs.size(), 1, [&](size_t, size_t)
+		{
+			for (size_t mappedIdx = nextJob++; mappedIdx < mappedJobs.size(); mappedIdx = nextJob++)
+				runJob(jobs[mappedJobs[mappedIdx]], jobs[mappedJobs[mappedIdx]].decode);
+
+			//A failed read leaves its data empty, the decode then fails and the Get call reports it
+			while (std::optional<FHFileReader::Completion> completion{ reader.WaitNext() })
+			{
+				Job& job{ jobs[completion->userData / maxJobFiles] };
+				const size_t fileIdx{ completion->userData % maxJobFiles };
+				//Hashed while the bytes are here, the Get call for the texture then does not read the file again
+				const uint64_t fileHash{ HashBytes(completion->data.data(), completion->data.size()) };
+				{
+					const std::lock_guard lock{ jobMutex };
+					if (completion->isRead)
+						m_SourceHashes[job.readFiles[fileIdx]] = { job.fileStamps[fileIdx], fileHash };
+					job.fileData[fileIdx] = std::move(completion->data);
+					if (--job.pendingReads > 0)
+						continue;
+				}
+
+				runJob(job, [&job]() { return job.decodeRead(job.fileData); });
+				job.fileData.clear();
+			}
+		});
+
+	//Texel density limits first, so the budget is picked for the sizes that are actually uploaded
+	if (!m_TextureSizeLimits.empty())
+	{
+		nextJob = 0;
+		ParallelFor(jobs.size(), 1, [this, &jobs, &nextJob](size_t, size_t)
+			{
+				for (size_t jobIdx = nextJob++; jobIdx < jobs.size(); jobIdx = nextJob++)
+					if (jobs[jobIdx].isDecoded)
+						jobs[jobIdx].result.reclaimedBytes = LimitToTexelDensity(jobs[jobIdx].key, jobs[jobIdx].result.decoded);
+			});
+	}
+
+	//Pick the size the whole set fits the budget at, then shrink the images larger than it on the same workers
+	std::vector<FHResidencyManager::TextureSize> catalogue{};
+	for (const Job& job : jobs)
+		if (job.isDecoded)
+			catalogue.push_back({ FHTexture::GetSize(job.result.decoded), FHTexture::GetByteSize(job.result.decoded) });
+
+	const uint32_t maxTextureSize{ m_ResidencyManager.SelectMaxTextureSize(catalogue) };
+	if (maxTextureSize != UINT32_MAX)
+	{
+		std::cout << "Textures over the memory budget, loading them at " << maxTextureSize << " texels at most" << std::endl;
+		nextJob = 0;
+		ParallelFor(jobs.size(), 1, [&jobs, &nextJob, maxTextureSize](size_t, size_t)
+			{
+				for (size_t jobIdx = nextJob++; jobIdx < jobs.size(); jobIdx = nextJob++)
+					if (jobs[jobIdx].isDecoded)
+						FHTexture::LimitSize(jobs[jobIdx].result.decoded, maxTextureSize);
+			});
+	}
+
+	for (Job& job : jobs)
+		if (job.isDecoded)
+			m_PendingTextures.emplace(job.key, std::move(job.result));
+
+	const size_t threadCount{ std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency())) };
+	std::cout << "Read and probed " << jobs.size() << " textures on " << threadCount << " threads in "
+		<< GetMillisSince(start) << " ms, " << jobs.size() - mappedJobs.size() << " of them read through "
+		<< (reader.IsUsingIoUring() ? "io_uring" : "the reader's thread pool") << std::endl;
+}
+
+std::shared_ptr<FH::FHModel> FH::FHAssetRegistry::GetModel(const std::string& path, const FHModelLoadOptions& options)
+{
+	//Every option that changes what ends up in the geometry pool
+	const uint64_t settings{ static_cast<uint64_t>(options.optimize) | static_cast<uint64_t>(options.buildMeshlets) << 1 |
+		static_cast<uint64_t>(options.generateLods) << 2 | static_cast<uint64_t>(options.positionStream) << 3 |
+		static_cast<uint64_t>(options.vertexFormat) << 4 };
+
+	//The hash Get took is passed on, a model whose mesh cache is stale is not read a second time to check it
+	return Get(m_Models, path + "|" + std::to_string(settings), { path }, settings, [&]()
+		{
+			const auto sourceHash{ m_SourceHashes.find(path) };
+			return std::shared_ptr<FHModel>{ FHModel::CreateModelFromFile(m_FHGeometryPool, path, options,
+				sourceHash != m_SourceHashes.end() ? &sourceHash->second : nullptr) };
+		});
+}
+
+std::shared_ptr<FH::FHTexture> FH::FHAssetRegistry::UploadTexture(const std::string& key,
+	const std::function<FHTexture::Decoded()>& decode)
+{
+	PendingTexture pending{};
+	if (const auto preloaded{ m_PendingTextures.find(key) }; preloaded != m_PendingTextures.end())
+	{
+		pending = std::move(preloaded->second);
+		m_PendingTextures.erase(preloaded);
+	}
+	else
+	{
+		const auto decodeStart{ std::chrono::steady_clock::now() };
+		pending.decoded = decode();
+		pending.decodeMillis = GetMillisSince(decodeStart);
+	}
+
+	//Kept to decode the texture again after the residency manager evicted it
+	m_TextureSources[key] = decode;
+
+	const auto uploadStart{ std::chrono::steady_clock::now() };
+	pending.reclaimedBytes += LimitToTexelDensity(key, pending.decoded);
+	m_Stats.reclaimedBytes += pending.reclaimedBytes;
+	if (FHTexture::GetSize(pending.decoded) > m_ResidencyManager.GetMaxTextureSize())
+		FHTexture::LimitSize(pending.decoded, m_ResidencyManager.GetMaxTextureSize());
+	pending.decoded.isStreamed = pending.decoded.pKtxFile != nullptr;
+	//Probed images are decoded by the upload, straight into the staging memory
+	const bool isDecodedOnUpload{ !pending.decoded.imagePath.empty() || !pending.decoded.fileData.empty() };
+	auto pTexture{ std::make_shared<FHTexture>(m_FHDevice, std::move(pending.decoded), GetSampler(FHTexture::GetSamplerInfo(m_FHDevice))) };
+	m_TextureStreamer.Register(pTexture);
+	m_ResidencyManager.Track(pTexture);
+	if (isDecodedOnUpload)
+		std::cout << "Texture " << key << ": decoded into staging and uploaded in " << GetMillisSince(uploadStart) << " ms" << std::endl;
+	else
+		std::cout << "Texture " << key << ": decoded in " << pending.decodeMillis << " ms, uploaded in "
+			<< GetMillisSince(uploadStart) << " ms" << std::endl;
+	if (pending.reclaimedBytes > 0)
+		std::cout << "Texture " << key << ": " << pending.reclaimedBytes / 1024 << " KiB reclaimed, loaded at the "
+			<< m_TextureSizeLimits.at(key) << " texels its texel density resolves" << std::endl;
+	return pTexture;
+}
+
+void FH::FHAssetRegistry::ReloadTexture(FHTexture& texture, uint64_t frame)
+{
+	//A texture shared under several keys decodes the same image from any of them
+	const auto loaded{ std::find_if(m_Textures.byPath.begin(), m_Textures.byPath.end(),
+		[&texture](const auto& entry) { return entry.second.lock().get() == &texture; }) };
+	if (loaded == m_Textures.byPath.end())
+		return;
+	const auto source{ m_TextureSources.find(loaded->first) };
+	if (source == m_TextureSources.end())
+		return;
+
+	FHTexture::Decoded decoded{ source->second() };
+	LimitToTexelDensity(loaded->first, decoded);
+	if (FHTexture::GetSize(decoded) > m_ResidencyManager.GetMaxTextureSize())
+		FHTexture::LimitSize(decoded, m_ResidencyManager.GetMaxTextureSize());
+	texture.Reload(std::move(decoded), frame);
+}
+
+VkDeviceSize FH::FHAssetRegistry::LimitToTexelDensity(const std::string& key, FHTexture::Decoded& decoded) const
+{
+	const auto sizeLimit{ m_TextureSizeLimits.find(key) };
+	if (sizeLimit == m_TextureSizeLimits.end() || FHTexture::GetSize(decoded) <= sizeLimit->second)
+		return 0;
+
+	const VkDeviceSize byteSize{ FHTexture::GetByteSize(decoded) };
+	FHTexture::LimitSize(decoded, sizeLimit->second);
+	return byteSize - FHTexture::GetByteSize(decoded);
+}
+
+std::shared_ptr<const FH::FHKtxFile> FH::FHAssetRegistry::OpenVirtualKtx(const std::string& path) const
+{
+	auto pKtxFile{ std::make_shared<const FHKtxFile>(FHKtxFile::GetKtxPath("resources/" + path)) };
+	if (!pKtxFile->IsOpen() || !m_VirtualTextureCache.CanVirtualize(*pKtxFile))
+		return nullptr;
+	return pKtxFile;
+}
+
+VkSampler FH::FHAssetRegistry::GetSampler(const VkSamplerCreateInfo& samplerInfo)
+{
+	for (const auto& [cachedInfo, sampler] : m_Samplers)
+		if (IsSameSamplerState(cachedInfo, samplerInfo))
+			return sampler;
+
+	VkSampler sampler{};
+	if (vkCreateSampler(m_FHDevice.GetDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create texture sampler!");
+
+	m_Samplers.emplace_back(samplerInfo, sampler);
+	m_Samplers.back().first.pNext = nullptr;
+	m_Stats.samplerCount = static_cast<uint32_t>(m_Samplers.size());
+	return sampler;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include "device.h"
+#include "geometryPool.h"
+#include "material.h"
+#include "meshCache.h"
+#include "model.h"
+#include "residencyManager.h"
+#include "texelDensity.h"
+#include "texture.h"
+#include "textureStreamer.h"
+#include "virtualTexture.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FH
+{
+	//Hands out shared textures and models so every asset is loaded and uploaded once. Requests are matched on
+	//the path first and on the content of the files second, so copies under another name are shared too.
+	//The registry only keeps weak references, an asset is freed as soon as its last handle goes away.
+	//Textures get their sampler from the registry, it has to outlive every texture it handed out
+	class FHAssetRegistry final
+	{
+	public:
+		struct Stats
+		{
+			uint32_t loadCount{};	//assets read from disk and uploaded
+			uint32_t sharedCount{};	//requests served from an asset still alive
+			uint32_t samplerCount{};
+			VkDeviceSize reclaimedBytes{};	//texture memory saved by the texel density limits
+		};
+
+		FHAssetRegistry(FHDevice& device, FHGeometryPool& geometryPool);
+		~FHAssetRegistry();
+
+		FHAssetRegistry(const FHAssetRegistry&) = delete;
+		FHAssetRegistry& operator=(const FHAssetRegistry&) = delete;
+
+		//Path relative to resources/ like FHTexture. Textures the residency manager evicted are loaded at full size again
+		std::shared_ptr<FHTexture> GetTexture(const std::string& path, bool isSrgb = true);
+		std::shared_ptr<FHTexture> GetOrmTexture(const FHMaterialPaths& material);
+		//Reads every texture of the materials up front and sizes or packs them on all cores, the Get calls for them
+		//afterwards decode the images straight into the staging memory and upload.
+		//Textures are limited to the size at which all of them fit the memory budget, see FHResidencyManager
+		void PreloadTextures(const std::vector<FHMaterialPaths>& materials);
+		//Finds the textures of the material with more texels than the model shows at the view, see FHTexelDensity,
+		//and prints them with options.printStats. With limitSize they are loaded at the resolvable size, a texture
+		//shared by several models at the largest size any of them needs. Call for every model using the texture,
+		//with the options it is loaded with, before PreloadTextures
+		void AnalyzeTexelDensity(const std::string& modelPath, const FHModelLoadOptions& options, const glm::vec3& scale,
+			const FHMaterialPaths& material, const FHTexelDensity::View& view, bool limitSize);
+		//Null unless the .ktx2 of the diffuse texture can be virtualized, see FHVirtualTextureCache::CanVirtualize
+		std::shared_ptr<FHVirtualTexture> GetVirtualTexture(const std::string& path);
+		//Path relative to resources/ like FHModel::CreateModelFromFile
+		std::shared_ptr<FHModel> GetModel(const std::string& path, const FHModelLoadOptions& options = {});
+
+		//Textures with a .ktx2 start with their mip tail and are registered here for their larger levels
+		FHTextureStreamer& GetTextureStreamer() { return m_TextureStreamer; }
+		FHResidencyManager& GetResidencyManager() { return m_ResidencyManager; }
+		FHVirtualTextureCache& GetVirtualTextureCache() { return m_VirtualTextureCache; }
+
+		//One sampler per unique state, owned by the registry
+		VkSampler GetSampler(const VkSamplerCreateInfo& samplerInfo);
+
+		FHDevice& GetDevice() { return m_FHDevice; }
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		//The files an asset was loaded from, a content hash hit only counts when they hold the same bytes
+		template<typename Asset>
+		struct ContentEntry
+		{
+			std::weak_ptr<Asset> pAsset{};
+			std::vector<std::string> files{};
+		};
+
+		template<typename Asset>
+		struct Cache
+		{
+			std::unordered_map<std::string, std::weak_ptr<Asset>> byPath{};
+			std::unordered_map<uint64_t, ContentEntry<Asset>> byContent{};
+		};
+
+		//Looks the asset up by key, then by the content hash of the files, and loads it when neither is alive.
+		//Keys and hashes also cover the load settings, the same file loaded differently is a different asset
+		struct PendingTexture
+		{
+			FHTexture::Decoded decoded{};
+			double decodeMillis{};
+			VkDeviceSize reclaimedBytes{};
+		};
+
+		template<typename Asset, typename Loader>
+		std::shared_ptr<Asset> Get(Cache<Asset>& cache, const std::string& key, const std::vector<std::string>& files,
+			uint64_t settingsHash, Loader&& load);
+
+		//Content hash of a file relative to resources/, taken once and kept until its size or write time changes.
+		//Models take it from their mesh cache, preloaded textures from the bytes PreloadTextures read
+		bool HashFile(const std::string& file, FHSourceHash& sourceHash);
+		bool IsSameContent(const std::vector<std::string>& files, const std::vector<std::string>& otherFiles);
+
+		//Takes the preloaded image of the key or decodes it now, then uploads it
+		std::shared_ptr<FHTexture> UploadTexture(const std::string& key, const std::function<FHTexture::Decoded()>& decode);
+		//The reloader of the residency manager, decodes an evicted texture the way it was uploaded
+		void ReloadTexture(FHTexture& texture, uint64_t frame);
+
+		//Shrinks the image to the texel density limit of the key, returns the bytes that saved
+		VkDeviceSize LimitToTexelDensity(const std::string& key, FHTexture::Decoded& decoded) const;
+
+		std::shared_ptr<const FHKtxFile> OpenVirtualKtx(const std::string& path) const;
+
+		FHDevice& m_FHDevice;
+		FHGeometryPool& m_FHGeometryPool;
+
+		Cache<FHTexture> m_Textures{};
+		Cache<FHModel> m_Models{};
+		Cache<FHVirtualTexture> m_VirtualTextures{};
+		std::unordered_map<std::string, PendingTexture> m_PendingTextures{};
+		std::unordered_map<std::string, std::function<FHTexture::Decoded()>> m_TextureSources{};	//by texture key
+		std::unordered_map<std::string, uint32_t> m_TextureSizeLimits{};	//by texture key
+		std::unordered_map<std::string, FHSourceHash> m_SourceHashes{};	//by file relative to resources/
+		FHTextureStreamer m_TextureStreamer{};
+		FHResidencyManager m_ResidencyManager{ m_FHDevice, m_FHGeometryPool, m_TextureStreamer };
+		FHVirtualTextureCache m_VirtualTextureCache{ m_FHDevice, VK_FORMAT_BC7_SRGB_BLOCK };
+
+		std::vector<std::pair<VkSamplerCreateInfo, VkSampler>> m_Samplers{};
+		Stats m_Stats{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "cullingSystem.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace FH
+{
+	//Matches the push constant block in cull.comp
+	struct CullPushConstants
+	{
+		glm::vec4 frustumPlanes[6]{};	//object space, xyz normal pointing inwards, w distance
+		glm::vec4 cameraPosition{};		//object space
+		uint32_t firstMeshlet{};
+		uint32_t meshletCount{};
+		uint32_t dispatchWidth{};
+		uint32_t padding{};
+	};
+	static_assert(sizeof(CullPushConstants) <= 128, "Push constants must fit the guaranteed 128 bytes");
+}
+
+namespace
+{
+	constexpr uint32_t MAX_DISPATCH_WIDTH{ 65535 };
+
+	//Gribb-Hartmann plane extraction for a [0, 1] depth range. Using the full MVP gives the
+	//planes in object space, so meshlet bounds never have to be transformed
+	void ExtractFrustumPlanes(const glm::mat4& mvp, glm::vec4 (&planes)[6])
+	{
+		const glm::vec4 row0{ mvp[0][0], mvp[1][0], mvp[2][0], mvp[3][0] };
+		const glm::vec4 row1{ mvp[0][1], mvp[1][1], mvp[2][1], mvp[3][1] };
+		const glm::vec4 row2{ mvp[0][2], mvp[1][2], mvp[2][2], mvp[3][2] };
+		const glm::vec4 row3{ mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3] };
+
+		planes[0] = row3 + row0;	//left
+		planes[1] = row3 - row0;	//right
+		planes[2] = row3 + row1;	//top
+		planes[3] = row3 - row1;	//bottom
+		planes[4] = row2;			//near
+		planes[5] = row3 - row2;	//far
+
+		for (glm::vec4& plane : planes)
+			plane /= glm::length(glm::vec3{ plane });
+	}
+}
+
+FH::FHCullingSystem::FHCullingSystem(FHDevice& device)
+	: m_FHDevice{ device }
+{
+	CreateDescriptorSetLayout();
+	CreatePipelineLayout();
+	CreatePipeline();
+}
+
+FH::FHCullingSystem::~FHCullingSystem()
+{
+	vkDestroyPipelineLayout(m_FHDevice.GetDevice(), m_PipelineLayout, nullptr);
+}
+
+void FH::FHCullingSystem::CreateDescriptorSetLayout()
+{
+	m_pSetLayout = FHDescriptorSetLayout::Builder(m_FHDevice)
+		.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) //meshlets
+		.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) //source indices
+		.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) //culled indices
+		.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) //draw command
+		.Build();
+
+	//Retired targets keep their sets until no frame in flight uses them, the pool leaves room for as many
+	constexpr uint32_t maxTargetCount{ 2 * MAX_CULLED_OBJECTS };
+	m_pDescriptorPool = FHDescriptorPool::Builder(m_FHDevice)
+		.SetMaxSets(maxTargetCount * FHSwapChain::MAX_FRAMES_IN_FLIGHT)
+		.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * maxTargetCount * FHSwapChain::MAX_FRAMES_IN_FLIGHT)
+		.SetPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+		.Build();
+}
+
+void FH::FHCullingSystem::CreatePipelineLayout()
+{
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullPushConstants);
+
+	VkDescriptorSetLayout setLayout{ m_pSetLayout->GetDescriptorSetLayout() };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &setLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(m_FHDevice.GetDevice(), &pipelineLayoutInfo,
+		nullptr, &m_PipelineLayout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline layout!");
+}
+
+void FH::FHCullingSystem::CreatePipeline()
+{
+	assert(m_PipelineLayout != nullptr && "Cannot create pipeline without pipeline layout");
+
+	m_pPipeline = std::make_unique<FHComputePipeline>(m_FHDevice, "shaders/cull.comp.spv", m_PipelineLayout);
+}
+
+FH::FHCullingSystem::CullTarget& FH::FHCullingSystem::GetCullTarget(FHGameObject& gameObject)
+{
+	FHModel& model{ *gameObject.m_Model };
+	auto it{ m_CullTargets.find(gameObject.GetId()) };
+	if (it != m_CullTargets.end() && it->second.pModel.lock() == gameObject.m_Model)
+	{
+		it->second.lastCullFrame = m_FrameNumber;
+
+		//The source indices moved, only happens after the device waited idle for a compaction
+		const VkDescriptorBufferInfo sourceIndexInfo{ model.GetIndexBufferInfo() };
+		if (sourceIndexInfo.buffer != it->second.sourceIndexInfo.buffer || sourceIndexInfo.offset != it->second.sourceIndexInfo.offset)
+			WriteDescriptorSets(model, it->second, true);
+		return it->second;
+	}
+
+	//The object got another model, its buffers are sized for the old one
+	if (it != m_CullTargets.end())
+		Retire(it);
+
+	if (m_CullTargets.size() >= MAX_CULLED_OBJECTS)
+	{
+		const auto leastRecent{ std::min_element(m_CullTargets.begin(), m_CullTargets.end(),
+			[](const auto& lhs, const auto& rhs) { return lhs.second.lastCullFrame < rhs.second.lastCullFrame; }) };
+		if (leastRecent->second.lastCullFrame == m_FrameNumber)
+			throw std::runtime_error("failed to create cull target, too many objects culled in one frame!");
+		Retire(leastRecent);
+	}
+
+	if (m_RetiredTargets.size() >= MAX_CULLED_OBJECTS)
+		throw std::runtime_error("failed to create cull target, too many retired targets!");
+
+	CullTarget& target{ m_CullTargets[gameObject.GetId()] };
+	target.pModel = gameObject.m_Model;
+	target.lastCullFrame = m_FrameNumber;
+	for (int frameIdx{}; frameIdx < FHSwapChain::MAX_FRAMES_IN_FLIGHT; ++frameIdx)
+	{
+		target.culledIndexBuffers[frameIdx] = std::make_unique<FHBuffer>
+			(
+				m_FHDevice,
+				sizeof(uint32_t),
+				model.GetLod(0).indexCount,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+		target.drawCommandBuffers[frameIdx] = std::make_unique<FHBuffer>
+			(
+				m_FHDevice,
+				sizeof(VkDrawIndexedIndirectCommand),
+				2,
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+	}
+
+	WriteDescriptorSets(model, target, false);
+	return target;
+}
+
+void FH::FHCullingSystem::WriteDescriptorSets(FHModel& model, CullTarget& target, bool isOverwrite)
+{
+	VkDescriptorBufferInfo meshletInfo{ model.GetMeshletBufferInfo() };
+	target.sourceIndexInfo = model.GetIndexBufferInfo();
+
+	for (int frameIdx{}; frameIdx < FHSwapChain::MAX_FRAMES_IN_FLIGHT; ++frameIdx)
+	{
+		VkDescriptorBufferInfo culledIndexInfo{ target.culledIndexBuffers[frameIdx]->GetDescriptorInfo() };
+		VkDescriptorBufferInfo drawCommandInfo{ target.drawCommandBuffers[frameIdx]->GetDescriptorInfo() };
+
+		FHDescriptorWriter writer{ *m_pSetLayout, *m_pDescriptorPool };
+		writer.WriteBuffer(0, &meshletInfo)
+			.WriteBuffer(1, &target.sourceIndexInfo)
+			.WriteBuffer(2, &culledIndexInfo)
+			.WriteBuffer(3, &drawCommandInfo);
+
+		if (isOverwrite)
+			writer.Overwrite(target.descriptorSets[frameIdx]);
+		else if (!writer.Build(target.descriptorSets[frameIdx]))
+			throw std::runtime_error("failed to allocate culling descriptor set!");
+	}
+}
+
+void FH::FHCullingSystem::BeginFrame(int frameIdx)
+{
+	//The frame's fence was waited on, nothing it recorded is still in use
+	++m_FrameNumber;
+	m_FrameIdx = frameIdx;
+	ReleaseExpired();
+}
+
+void FH::FHCullingSystem::Retire(std::unordered_map<unsigned int, CullTarget>::iterator it)
+{
+	//Frames in flight may still read the target, the current one is included when it already culled with it
+	constexpr uint32_t allFramesMask{ (1u << FHSwapChain::MAX_FRAMES_IN_FLIGHT) - 1 };
+	const uint32_t frameBit{ 1u << m_FrameIdx };
+	const uint32_t pendingFrameMask{ it->second.lastCullFrame == m_FrameNumber ? allFramesMask : allFramesMask & ~frameBit };
+
+	m_RetiredTargets.push_back({ std::move(it->second), pendingFrameMask });
+	m_CullTargets.erase(it);
+}
+
+void FH::FHCullingSystem::ReleaseExpired()
+{
+	const uint32_t frameBit{ 1u << m_FrameIdx };
+
+	std::erase_if(m_RetiredTargets, [this, frameBit](RetiredTarget& retired)
+		{
+			retired.pendingFrameMask &= ~frameBit;
+			if (retired.pendingFrameMask != 0)
+				return false;
+
+			std::vector<VkDescriptorSet> descriptorSets(retired.target.descriptorSets.begin(), retired.target.descriptorSets.end());
+			m_pDescriptorPool->FreeDescriptors(descriptorSets);
+			return true;
+		});
+
+	for (auto it{ m_CullTargets.begin() }; it != m_CullTargets.end();)
+	{
+		auto next{ std::next(it) };
+		if (it->second.pModel.expired())
+			Retire(it);
+		it = next;
+	}
+}
+
+bool FH::FHCullingSystem::CullGameObject(FHFrameInfo& frameInfo, FHGameObject* gameObject, uint32_t lodIdx,
+	FHCullResult& result)
+{
+	if (!gameObject->m_Model || !gameObject->m_Model->HasMeshlets())
+		return false;
+
+	FHModel& model{ *gameObject->m_Model };
+
+	const FHModel::Lod& lod{ model.GetLod(std::min(lodIdx, model.GetLodCount() - 1)) };
+	if (lod.meshletCount == 0)
+		return false;
+
+	const int frameIdx{ frameInfo.m_FrameIdx };
+	assert(frameIdx == m_FrameIdx && "Call BeginFrame before culling");
+	const CullTarget& target{ GetCullTarget(*gameObject) };
+	VkCommandBuffer commandBuffer{ frameInfo.m_CommandBuffer };
+
+	//Reset the draws to zero indices, the shader appends to indexCount. The culled indices are
+	//relative to the model, the pool offset of its vertices or positions goes in vertexOffset
+	const std::array<VkDrawIndexedIndirectCommand, 2> emptyDraws
+	{
+		VkDrawIndexedIndirectCommand{ 0, 1, 0, model.GetVertexOffset(), 0 },
+		VkDrawIndexedIndirectCommand{ 0, 1, 0, model.HasPositionStream() ? model.GetPositionOffset() : 0, 0 }
+	};
+	vkCmdUpdateBuffer(commandBuffer, target.drawCommandBuffers[frameIdx]->GetBuffer(), 0, sizeof(emptyDraws), emptyDraws.data());
+
+	VkMemoryBarrier resetBarrier{};
+	resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+
+	m_pPipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_PipelineLayout,
+		0, 1,
+		&target.descriptorSets[frameIdx],
+		0,
+		nullptr
+	);
+
+	const glm::mat4 modelMatrix{ gameObject->m_Transform.GetModelMatrix() };
+	const glm::mat4& view{ frameInfo.m_FHCamera.GetViewMatrix() };
+	const glm::mat4& projection{ frameInfo.m_FHCamera.GetProjectionMatrix() };
+
+	CullPushConstants push{};
+	ExtractFrustumPlanes(projection * view * modelMatrix, push.frustumPlanes);
+	push.cameraPosition = glm::inverse(modelMatrix) * glm::inverse(view)[3];
+	push.firstMeshlet = lod.firstMeshlet;
+	push.meshletCount = lod.meshletCount;
+	push.dispatchWidth = std::min(push.meshletCount, MAX_DISPATCH_WIDTH);
+
+	vkCmdPushConstants(
+		commandBuffer,
+		m_PipelineLayout,
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(CullPushConstants),
+		&push
+	);
+
+	//One workgroup per meshlet, wrapped into y for meshes with more than 65535 meshlets
+	const uint32_t dispatchHeight{ (push.meshletCount + push.dispatchWidth - 1) / push.dispatchWidth };
+	vkCmdDispatch(commandBuffer, push.dispatchWidth, dispatchHeight, 1);
+
+	VkMemoryBarrier cullBarrier{};
+	cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+
+	result.indexBuffer = target.culledIndexBuffers[frameIdx]->GetBuffer();
+	result.drawCommandBuffer = target.drawCommandBuffers[frameIdx]->GetBuffer();
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "engine/device.h"
+#include "engine/buffer.h"
+#include "engine/descriptors.h"
+#include "engine/pipeline.h"
+#include "engine/gameObject.h"
+#include "engine/frameInfo.h"
+#include "engine/swapchain.h"
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace FH
+{
+	//Buffers the render system draws from after a cull pass
+	struct FHCullResult
+	{
+		VkBuffer indexBuffer{ VK_NULL_HANDLE };
+		VkBuffer drawCommandBuffer{ VK_NULL_HANDLE };
+
+		//The same draw for the position stream follows the colour pass draw
+		static constexpr VkDeviceSize DEPTH_DRAW_OFFSET{ sizeof(VkDrawIndexedIndirectCommand) };
+	};
+
+	//Compute pre-pass that culls a model's meshlets against the view frustum and their normal cone,
+	//then writes the surviving triangles to a compacted index buffer and an indirect draw command
+	class FHCullingSystem
+	{
+	public:
+		//Number of game objects with a cull target, descriptor sets are made per object per frame. When all are taken, the
+		//object culled least recently gives its target up, so destroyed objects need no release call
+		static constexpr uint32_t MAX_CULLED_OBJECTS{ 32 };
+
+		explicit FHCullingSystem(FHDevice& device);
+		~FHCullingSystem();
+
+		FHCullingSystem(const FHCullingSystem&) = delete;
+		FHCullingSystem& operator=(const FHCullingSystem&) = delete;
+
+		//Call once per frame before culling, after the renderer waited on the frame's fence
+		void BeginFrame(int frameIdx);
+
+		//Records the cull dispatch over the meshlets of one LOD, call before the render pass begins. Every game object
+		//gets its own output buffers, so objects sharing a model can be culled in the same frame.
+		//Returns false when the model has no meshlets, draw it normally in that case
+		bool CullGameObject(FHFrameInfo& frameInfo, FHGameObject* gameObject, uint32_t lodIdx, FHCullResult& result);
+
+	private:
+		struct CullTarget
+		{
+			std::array<std::unique_ptr<FHBuffer>, FHSwapChain::MAX_FRAMES_IN_FLIGHT> culledIndexBuffers{};
+			std::array<std::unique_ptr<FHBuffer>, FHSwapChain::MAX_FRAMES_IN_FLIGHT> drawCommandBuffers{};
+			std::array<VkDescriptorSet, FHSwapChain::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+			VkDescriptorBufferInfo sourceIndexInfo{};	//moves when the geometry pool is compacted
+			std::weak_ptr<const FHModel> pModel{};	//the buffers are sized for this model
+			uint64_t lastCullFrame{};
+		};
+
+		struct RetiredTarget
+		{
+			CullTarget target{};
+			uint32_t pendingFrameMask{};	//frame indices whose command buffers may still use the target
+		};
+
+		void CreateDescriptorSetLayout();
+		void CreatePipelineLayout();
+		void CreatePipeline();
+
+		CullTarget& GetCullTarget(FHGameObject& gameObject);
+		void Retire(std::unordered_map<unsigned int, CullTarget>::iterator it);
+		void WriteDescriptorSets(FHModel& model, CullTarget& target, bool isOverwrite);
+
+		//Retires the targets of destroyed models and frees the retired ones the frame no longer uses
+		void ReleaseExpired();
+
+		FHDevice& m_FHDevice;
+
+		std::unique_ptr<FHDescriptorSetLayout> m_pSetLayout{};
+		std::unique_ptr<FHDescriptorPool> m_pDescriptorPool{};
+
+		VkPipelineLayout m_PipelineLayout{};
+		std::unique_ptr<FHComputePipeline> m_pPipeline{};
+
+		std::unordered_map<unsigned int, CullTarget> m_CullTargets{};	//by game object id
+		std::vector<RetiredTarget> m_RetiredTargets{};
+		uint64_t m_FrameNumber{};
+		int m_FrameIdx{};
+	};
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "device.h"
+#include "uploadContext.h"
 
 #include <cstring>
 #include <iostream>
@@ -57,10 +58,14 @@ FH::FHDevice::FHDevice(FHWindow& window) : m_Window{ window }
     PickPhysicalDevice();
     CreateLogicalDevice();
     CreateCommandPool();
+
+    m_pUploadContext = std::make_unique<FHUploadContext>(*this);
 }
 
 FH::FHDevice::~FHDevice() 
 {
+    m_pUploadContext.reset();
+
     vkDestroyCommandPool(m_FHDevice, m_CommandPool, nullptr);
     vkDestroyDevice(m_FHDevice, nullptr);
 
@@ -91,6 +96,10 @@ void FH::FHDevice::CreateInstance()
     createInfo.pApplicationInfo = &appInfo;
 
     auto extensions = GetRequiredExtensions();
+    // needed to query VK_EXT_memory_budget on a 1.0 instance
+    m_HasMemoryProperties2 = IsInstanceExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    if (m_HasMemoryProperties2)
+        extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -157,8 +166,14 @@ void FH::FHDevice::CreateLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+    m_HasFragmentStores = supportedFeatures.fragmentStoresAndAtomics;
+
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // virtual textures write their feedback from the fragment shader, without it they are turned off
+    deviceFeatures.fragmentStoresAndAtomics = supportedFeatures.fragmentStoresAndAtomics;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -166,9 +181,14 @@ void FH::FHDevice::CreateLogicalDevice()
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+    std::vector<const char*> extensions{ DEVICE_EXTENSIONS };
+    m_HasMemoryBudget = m_HasMemoryProperties2 && IsDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (m_HasMemoryBudget)
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size());
-    createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -315,6 +335,32 @@ void FH::FHDevice::HasGflwRequiredInstanceExtensions()
     }
 }
 
+bool FH::FHDevice::IsInstanceExtensionSupported(const char* extensionName)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions)
+        if (strcmp(extension.extensionName, extensionName) == 0)
+            return true;
+    return false;
+}
+
+bool FH::FHDevice::IsDeviceExtensionSupported(const char* extensionName)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions)
+        if (strcmp(extension.extensionName, extensionName) == 0)
+            return true;
+    return false;
+}
+
 bool FH::FHDevice::CheckDeviceExtensionSupport(VkPhysicalDevice device) 
 {
     uint32_t extensionCount;
@@ -426,6 +472,37 @@ uint32_t FH::FHDevice::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
+FH::MemoryBudget FH::FHDevice::GetMemoryBudget() const
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memProperties{};
+    memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memProperties.pNext = &budgetProperties;
+
+    auto getMemoryProperties2 = m_HasMemoryBudget ? (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(
+        m_Instance, "vkGetPhysicalDeviceMemoryProperties2KHR") : nullptr;
+    if (getMemoryProperties2 != nullptr)
+        getMemoryProperties2(m_PhysicalDevice, &memProperties);
+    else
+        vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memProperties.memoryProperties);
+
+    // summed over the device local heaps, without the extension the whole heap counts as budget
+    MemoryBudget budget{};
+    budget.isReported = getMemoryProperties2 != nullptr;
+    const VkPhysicalDeviceMemoryProperties& heaps = memProperties.memoryProperties;
+    for (uint32_t i = 0; i < heaps.memoryHeapCount; ++i)
+    {
+        if ((heaps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0)
+            continue;
+
+        budget.budget += budget.isReported ? budgetProperties.heapBudget[i] : heaps.memoryHeaps[i].size;
+        budget.usage += budget.isReported ? budgetProperties.heapUsage[i] : 0;
+    }
+    return budget;
+}
+
 void FH::FHDevice::CreateBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
@@ -477,6 +554,9 @@ VkCommandBuffer FH::FHDevice::BeginSingleTimeCommands()
 
 void FH::FHDevice::EndSingleTimeCommands(VkCommandBuffer commandBuffer) 
 {
+    // Recorded uploads go first, these commands may read what they write
+    m_pUploadContext->Flush();
+
     vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo{};
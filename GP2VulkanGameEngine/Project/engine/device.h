@@ -1,17 +1,27 @@
 #pragma once
 #include "window.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace FH
 {
+    class FHUploadContext;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
         std::vector<VkPresentModeKHR> presentModes;
     };
 
+    // bytes over the device local heaps, usage is only known with VK_EXT_memory_budget
+    struct MemoryBudget {
+        VkDeviceSize budget{};
+        VkDeviceSize usage{};
+        bool isReported{};
+    };
+
     struct QueueFamilyIndices {
         bool isComplete() const { return graphicsFamilyHasValue && presentFamilyHasValue; }
         uint32_t graphicsFamily{};
@@ -44,11 +54,14 @@ namespace FH
         VkSurfaceKHR GetSurface() const { return m_Surface; }
         VkQueue GetGraphicsQueue() const { return m_GraphicsQueue; }
         VkQueue GetPresentQueue() const { return m_PresentQueue; }
+        // false when fragment shaders cannot write storage buffers, virtual texture feedback is then off
+        bool HasFragmentStores() const { return m_HasFragmentStores; }
 
         SwapChainSupportDetails GetSwapChainSupport()
         { return QuerySwapChainSupport(m_PhysicalDevice); }
 
         uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        MemoryBudget GetMemoryBudget() const;
         QueueFamilyIndices FindPhysicalQueueFamilies() 
         { return FindQueueFamilies(m_PhysicalDevice); }
 
@@ -67,6 +80,9 @@ namespace FH
             VkDeviceMemory& bufferMemory
         );
 
+        // Batched staging uploads, see FHUploadContext
+        FHUploadContext& GetUploadContext() { return *m_pUploadContext; }
+
         VkCommandBuffer BeginSingleTimeCommands();
         void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
         void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -101,6 +117,8 @@ namespace FH
         void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void HasGflwRequiredInstanceExtensions();
         bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+        bool IsInstanceExtensionSupported(const char* extensionName);
+        bool IsDeviceExtensionSupported(const char* extensionName);
         SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance m_Instance;
@@ -113,6 +131,12 @@ namespace FH
         VkSurfaceKHR m_Surface;
         VkQueue m_GraphicsQueue;
         VkQueue m_PresentQueue;
+
+        bool m_HasMemoryProperties2{};
+        bool m_HasMemoryBudget{};
+        bool m_HasFragmentStores{};
+
+        std::unique_ptr<FHUploadContext> m_pUploadContext;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include "fileReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define FH_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	bool ReadWholeFile(const std::string& filePath, std::vector<uint8_t>& data)
+	{
+#ifdef _WIN32
+		std::ifstream file{ filePath, std::ios::ate | std::ios::binary };
+		if (!file.is_open())
+			return false;
+
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())));
+#else
+		const int fileDescriptor{ open(filePath.c_str(), O_RDONLY | O_CLOEXEC) };
+		if (fileDescriptor < 0)
+			return false;
+
+		struct stat fileStat {};
+		bool isRead{ fstat(fileDescriptor, &fileStat) == 0 };
+		if (isRead)
+		{
+			data.resize(static_cast<size_t>(fileStat.st_size));
+			size_t readSize{};
+			while (readSize < data.size())
+			{
+				const ssize_t result{ pread(fileDescriptor, data.data() + readSize, data.size() - readSize, static_cast<off_t>(readSize)) };
+				if (result < 0 && errno == EINTR)
+					continue;
+				if (result <= 0)
+				{
+					//A file that shrank since fstat is read up to its new end
+					isRead = result == 0;
+					data.resize(readSize);
+					break;
+				}
+				readSize += static_cast<size_t>(result);
+			}
+		}
+
+		close(fileDescriptor);
+		return isRead;
+#endif
+	}
+}
+
+#ifdef FH_HAS_IO_URING
+//Submission and completion queues shared with the kernel, set up with the raw system calls so there is no
+//dependency on liburing. Only the reader submits and only the reader reaps, both under its mutex
+class FH::FHFileReader::Ring final
+{
+public:
+	struct Event
+	{
+		Request* pRequest{};
+		int32_t result{};
+	};
+
+	explicit Ring(uint32_t entryCount)
+	{
+		io_uring_params params{};
+		m_RingDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, entryCount, &params));
+		if (m_RingDescriptor < 0)
+			return;
+
+		const bool isSingleMap{ (params.features & IORING_FEAT_SINGLE_MMAP) != 0 };
+		m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (isSingleMap)
+			m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+		m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+		m_pSqRing = Map(m_SqRingSize, IORING_OFF_SQ_RING);
+		m_pCqRing = isSingleMap ? m_pSqRing : Map(m_CqRingSize, IORING_OFF_CQ_RING);
+		m_pSqes = static_cast<io_uring_sqe*>(Map(m_SqesSize, IORING_OFF_SQES));
+		if (!m_pSqRing || !m_pCqRing || !m_pSqes)
+		{
+			Close();
+			return;
+		}
+
+		uint8_t* pSqRing{ static_cast<uint8_t*>(m_pSqRing) };
+		m_pSqTail = reinterpret_cast<uint32_t*>(pSqRing + params.sq_off.tail);
+		m_SqMask = *reinterpret_cast<const uint32_t*>(pSqRing + params.sq_off.ring_mask);
+		m_pSqArray = reinterpret_cast<uint32_t*>(pSqRing + params.sq_off.array);
+
+		uint8_t* pCqRing{ static_cast<uint8_t*>(m_pCqRing) };
+		m_pCqHead = reinterpret_cast<uint32_t*>(pCqRing + params.cq_off.head);
+		m_pCqTail = reinterpret_cast<const uint32_t*>(pCqRing + params.cq_off.tail);
+		m_CqMask = *reinterpret_cast<const uint32_t*>(pCqRing + params.cq_off.ring_mask);
+		m_pCqes = reinterpret_cast<const io_uring_cqe*>(pCqRing + params.cq_off.cqes);
+	}
+
+	~Ring()
+	{
+		Close();
+	}
+
+	Ring(const Ring&) = delete;
+	Ring& operator=(const Ring&) = delete;
+
+	bool IsOpen() const { return m_RingDescriptor >= 0; }
+
+	//Reads the rest of the file after readSize. Vectored reads are the oldest read the ring has
+	void Submit(Request& request)
+	{
+		iovec& vector{ m_Vectors[&request] };
+		vector.iov_base = request.data.data() + request.readSize;
+		vector.iov_len = request.data.size() - request.readSize;
+
+		const uint32_t tail{ *m_pSqTail };
+		const uint32_t index{ tail & m_SqMask };
+		io_uring_sqe& entry{ m_pSqes[index] };
+		entry = {};
+		entry.opcode = IORING_OP_READV;
+		entry.fd = request.fileDescriptor;
+		entry.addr = reinterpret_cast<uint64_t>(&vector);
+		entry.len = 1;
+		entry.off = request.readSize;
+		entry.user_data = reinterpret_cast<uint64_t>(&request);
+		m_pSqArray[index] = index;
+		__atomic_store_n(m_pSqTail, tail + 1, __ATOMIC_RELEASE);
+
+		//The entry is in the queue now, it has to reach the kernel before the request can be let go
+		while (syscall(__NR_io_uring_enter, m_RingDescriptor, 1, 0, 0, nullptr, 0) < 0)
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				throw std::runtime_error("failed to submit file read!");
+	}
+
+	//Blocks until at least one read completed
+	void Wait()
+	{
+		while (syscall(__NR_io_uring_enter, m_RingDescriptor, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+			if (errno != EINTR)
+				throw std::runtime_error("failed to wait for file reads!");
+	}
+
+	std::vector<Event> Reap()
+	{
+		std::vector<Event> events{};
+		uint32_t head{ *m_pCqHead };
+		const uint32_t tail{ __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE) };
+		for (; head != tail; ++head)
+		{
+			const io_uring_cqe& completion{ m_pCqes[head & m_CqMask] };
+			Request* pRequest{ reinterpret_cast<Request*>(completion.user_data) };
+			events.push_back({ pRequest, completion.res });
+			m_Vectors.erase(pRequest);
+		}
+		__atomic_store_n(m_pCqHead, head, __ATOMIC_RELEASE);
+		return events;
+	}
+
+private:
+	void* Map(size_t size, off_t offset) const
+	{
+		void* pMemory{ mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingDescriptor, offset) };
+		return pMemory == MAP_FAILED ? nullptr : pMemory;
+	}
+
+	void Close()
+	{
+		if (m_pSqes)
+			munmap(m_pSqes, m_SqesSize);
+		if (m_pCqRing && m_pCqRing != m_pSqRing)
+			munmap(m_pCqRing, m_CqRingSize);
+		if (m_pSqRing)
+			munmap(m_pSqRing, m_SqRingSize);
+		if (m_RingDescriptor >= 0)
+			close(m_RingDescriptor);
+
+		m_pSqes = nullptr;
+		m_pCqRing = nullptr;
+		m_pSqRing = nullptr;
+		m_RingDescriptor = -1;
+	}
+
+	int m_RingDescriptor{ -1 };
+
+	void* m_pSqRing{};
+	size_t m_SqRingSize{};
+	uint32_t* m_pSqTail{};
+	uint32_t m_SqMask{};
+	uint32_t* m_pSqArray{};
+	io_uring_sqe* m_pSqes{};
+	size_t m_SqesSize{};
+
+	void* m_pCqRing{};
+	size_t m_CqRingSize{};
+	uint32_t* m_pCqHead{};
+	const uint32_t* m_pCqTail{};
+	uint32_t m_CqMask{};
+	const io_uring_cqe* m_pCqes{};
+
+	//The kernel reads the vector of a request until the read completes
+	std::unordered_map<const Request*, iovec> m_Vectors{};
+};
+#else
+class FH::FHFileReader::Ring final
+{
+public:
+	struct Event
+	{
+		Request* pRequest{};
+		int32_t result{};
+	};
+
+	explicit Ring(uint32_t) {}
+
+	bool IsOpen() const { return false; }
+	void Submit(Request&) {}
+	void Wait() {}
+	std::vector<Event> Reap() { return {}; }
+};
+#endif
+
+FH::FHFileReader::FHFileReader(uint32_t queueDepth)
+	: m_pRing{ std::make_unique<Ring>(std::max(queueDepth, 1u)) }
+	, m_QueueDepth{ std::max(queueDepth, 1u) }
+{
+	if (m_pRing->IsOpen())
+		return;
+
+	//No io_uring in this kernel, or it is blocked like in some containers
+	m_pRing.reset();
+	for (uint32_t threadIdx = 0; threadIdx < FALLBACK_THREAD_COUNT; ++threadIdx)
+		m_Workers.emplace_back(&FHFileReader::Work, this);
+}
+
+FH::FHFileReader::~FHFileReader()
+{
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+
+	if (!m_pRing)
+		return;
+
+	//The kernel writes into the buffers of the reads in flight, they have to finish before they are freed
+	const std::lock_guard lock{ m_Mutex };
+	for (const std::unique_ptr<Request>& pRequest : m_Waiting)
+		Complete(*pRequest, false);
+	m_Waiting.clear();
+
+	while (m_InFlightCount > 0)
+	{
+		m_pRing->Wait();
+		ProcessRingCompletions();
+	}
+}
+
+void FH::FHFileReader::Read(const std::string& filePath, uint64_t userData)
+{
+	auto pRequest{ std::make_unique<Request>() };
+	pRequest->filePath = filePath;
+	pRequest->userData = userData;
+
+	if (!m_pRing)
+	{
+		{
+			const std::lock_guard lock{ m_Mutex };
+			++m_PendingCount;
+			m_Requests.push_back(std::move(pRequest));
+		}
+		m_WorkAvailable.notify_one();
+		return;
+	}
+
+	//Opening stays blocking, the ring only takes the reads
+	bool isOpen{};
+#ifdef FH_HAS_IO_URING
+	pRequest->fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat fileStat {};
+	isOpen = pRequest->fileDescriptor >= 0 && fstat(pRequest->fileDescriptor, &fileStat) == 0;
+	if (isOpen)
+		pRequest->data.resize(static_cast<size_t>(fileStat.st_size));
+#endif
+
+	{
+		const std::lock_guard lock{ m_Mutex };
+		++m_PendingCount;
+		if (!isOpen || pRequest->data.empty())
+			Complete(*pRequest, isOpen);
+		else
+			SubmitToRing(std::move(pRequest));
+	}
+	m_Completed.notify_all();
+}
+
+std::optional<FH::FHFileReader::Completion> FH::FHFileReader::WaitNext()
+{
+	std::unique_lock lock{ m_Mutex };
+	while (true)
+	{
+		if (!m_Completions.empty())
+		{
+			Completion completion{ std::move(m_Completions.front()) };
+			m_Completions.pop_front();
+			--m_PendingCount;
+			return completion;
+		}
+
+		if (m_PendingCount == 0)
+			return std::nullopt;
+
+		//One thread waits on the ring, the others wait for it to hand out what it reaped
+		if (!m_pRing || m_IsReaping)
+		{
+			m_Completed.wait(lock);
+			continue;
+		}
+
+		m_IsReaping = true;
+		lock.unlock();
+		m_pRing->Wait();
+		lock.lock();
+		m_IsReaping = false;
+
+		ProcessRingCompletions();
+		m_Completed.notify_all();
+	}
+}
+
+void FH::FHFileReader::SubmitToRing(std::unique_ptr<Request> pRequest)
+{
+	if (m_InFlightCount >= m_QueueDepth)
+	{
+		m_Waiting.push_back(std::move(pRequest));
+		return;
+	}
+
+	//Owned by the ring until its completion is reaped
+	m_pRing->Submit(*pRequest);
+	pRequest.release();
+	++m_InFlightCount;
+}
+
+void FH::FHFileReader::ProcessRingCompletions()
+{
+	for (const Ring::Event& event : m_pRing->Reap())
+	{
+		std::unique_ptr<Request> pRequest{ event.pRequest };
+		--m_InFlightCount;
+
+		if (event.result == -EINTR || event.result == -EAGAIN)
+			SubmitToRing(std::move(pRequest));
+		else if (event.result < 0)
+			Complete(*pRequest, false);
+		else if (event.result == 0)
+		{
+			//A file that shrank since it was opened is read up to its new end
+			pRequest->data.resize(pRequest->readSize);
+			Complete(*pRequest, true);
+		}
+		else
+		{
+			//Large reads can come back short, the rest is queued again
+			pRequest->readSize += static_cast<size_t>(event.result);
+			if (pRequest->readSize < pRequest->data.size())
+				SubmitToRing(std::move(pRequest));
+			else
+				Complete(*pRequest, true);
+		}
+	}
+
+	while (m_InFlightCount < m_QueueDepth && !m_Waiting.empty())
+	{
+		std::unique_ptr<Request> pRequest{ std::move(m_Waiting.front()) };
+		m_Waiting.pop_front();
+		SubmitToRing(std::move(pRequest));
+	}
+}
+
+void FH::FHFileReader::Complete(Request& request, bool isRead)
+{
+#ifndef _WIN32
+	if (request.fileDescriptor >= 0)
+		close(request.fileDescriptor);
+	request.fileDescriptor = -1;
+#endif
+
+	Completion& completion{ m_Completions.emplace_back() };
+	completion.userData = request.userData;
+	completion.isRead = isRead;
+	if (isRead)
+		completion.data = std::move(request.data);
+}
+
+void FH::FHFileReader::Work()
+{
+	while (true)
+	{
+		std::unique_ptr<Request> pRequest{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_WorkAvailable.wait(lock, [this]() { return m_IsStopping || !m_Requests.empty(); });
+			if (m_IsStopping)
+				return;
+
+			pRequest = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		const bool isRead{ ReadWholeFile(pRequest->filePath, pRequest->data) };
+
+		{
+			const std::lock_guard lock{ m_Mutex };
+			Complete(*pRequest, isRead);
+		}
+		m_Completed.notify_all();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace FH
+{
+	//Reads whole files in the background so decoding can start on the first one while the others are still on
+	//their way. On Linux the reads go through an io_uring, elsewhere or when the kernel refuses one a small
+	//pool of threads does blocking reads. Files are opened on the calling thread, only the reads are queued
+	class FHFileReader final
+	{
+	public:
+		//Reads kept in flight at once, the rest wait in the queue
+		static constexpr uint32_t DEFAULT_QUEUE_DEPTH{ 64 };
+		//Blocking reads mostly wait on the storage, so the fallback uses more threads than there are cores
+		static constexpr uint32_t FALLBACK_THREAD_COUNT{ 8 };
+
+		struct Completion
+		{
+			uint64_t userData{};
+			std::vector<uint8_t> data{};
+			bool isRead{};	//false when the file could not be opened or read, data is then empty
+		};
+
+		explicit FHFileReader(uint32_t queueDepth = DEFAULT_QUEUE_DEPTH);
+		~FHFileReader();
+
+		FHFileReader(const FHFileReader&) = delete;
+		FHFileReader& operator=(const FHFileReader&) = delete;
+
+		//Queues a read of the whole file, userData comes back with its completion
+		void Read(const std::string& filePath, uint64_t userData);
+		//Blocks until the next read is done, in the order they finish. Empty once every queued read was handed
+		//out. Safe to call from several threads at once
+		std::optional<Completion> WaitNext();
+
+		bool IsUsingIoUring() const { return m_pRing != nullptr; }
+
+	private:
+		class Ring;
+
+		//A read that was opened but is not done yet
+		struct Request
+		{
+			int fileDescriptor{ -1 };
+			std::string filePath{};
+			uint64_t userData{};
+			std::vector<uint8_t> data{};
+			size_t readSize{};
+		};
+
+		void SubmitToRing(std::unique_ptr<Request> pRequest);
+		void ProcessRingCompletions();
+		void Complete(Request& request, bool isRead);
+		void Work();
+
+		std::unique_ptr<Ring> m_pRing{};
+		uint32_t m_QueueDepth;
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Completed{};
+		std::deque<Completion> m_Completions{};
+		//Queued reads that were not handed out by WaitNext yet
+		size_t m_PendingCount{};
+
+		//Ring reads beyond the queue depth wait here
+		std::deque<std::unique_ptr<Request>> m_Waiting{};
+		size_t m_InFlightCount{};
+		bool m_IsReaping{};
+
+		std::condition_variable m_WorkAvailable{};
+		std::deque<std::unique_ptr<Request>> m_Requests{};
+		bool m_IsStopping{};
+		std::vector<std::thread> m_Workers{};
+	};
+}
\ No newline at end of file
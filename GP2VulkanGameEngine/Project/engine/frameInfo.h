@@ -11,5 +11,6 @@ namespace FH
 		VkCommandBuffer m_CommandBuffer;
 		FHCamera& m_FHCamera;
 		VkDescriptorSet m_GlobalDescriptorSet;
+		VkExtent2D m_Extent;
 	};
 }
\ No newline at end of file
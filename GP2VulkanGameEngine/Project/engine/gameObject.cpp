@@ -1,4 +1,6 @@
 #include "gameObject.h"
+#include "assetRegistry.h"
+#include "ormPacker.h"
 
 glm::mat4 FH::TransformComponent::GetModelMatrix()
 {
@@ -74,10 +76,49 @@ FH::FHGameObject::FHGameObject(uint32_t objectId)
 void FH::FHGameObject::SetDescriptorSetAtFrame(int frame, VkDescriptorSet descriptorSet)
 {
 	if (m_ObjectDescriptorSets.size() < frame + 1)
+	{
 		//Add more space for descriptor sets
 		m_ObjectDescriptorSets.resize(frame + 1);
+		m_DescriptorTextureVersions.resize(frame + 1);
+	}
 	
 	m_ObjectDescriptorSets[frame] = descriptorSet;
+	m_DescriptorTextureVersions[frame] = GetTextureVersion();
+}
+
+bool FH::FHGameObject::IsDescriptorSetStale(int frame) const
+{
+	return frame < static_cast<int>(m_DescriptorTextureVersions.size()) &&
+		m_DescriptorTextureVersions[frame] != GetTextureVersion();
+}
+
+uint32_t FH::FHGameObject::GetTextureVersion() const
+{
+	uint32_t version{};
+	for (const FHTexture* pTexture : { m_DiffuseTexture.get(), m_NormalTexture.get(), m_ORMTexture.get() })
+		if (pTexture)
+			version += pTexture->GetViewVersion();
+	return version;
+}
+
+void FH::FHGameObject::LoadTextures(FHAssetRegistry& assets, const FHMaterialPaths& material)
+{
+	auto load = [&assets](const std::string& path, std::shared_ptr<FHTexture>& texture, bool isSrgb)
+		{
+			if (!path.empty())
+				texture = assets.GetTexture(path, isSrgb);
+		};
+
+	//Only the diffuse map holds colors, the others are sampled as linear data. Large diffuse maps are paged in
+	//as they are seen instead
+	if (!material.diffuse.empty())
+		m_VirtualDiffuseTexture = assets.GetVirtualTexture(material.diffuse);
+	if (!m_VirtualDiffuseTexture)
+		load(material.diffuse, m_DiffuseTexture, true);
+	load(material.normal, m_NormalTexture, false);
+
+	if (FHOrmPacker::HasChannels(material))
+		m_ORMTexture = assets.GetOrmTexture(material);
 }
 
 FH::FHGameObject FH::FHGameObject::CreateDirectionalLight(float intensity, glm::vec3 direction, glm::vec3 color)
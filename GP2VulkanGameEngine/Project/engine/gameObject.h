@@ -1,6 +1,9 @@
 #pragma once
 #include "model.h"
+#include "streamedModel.h"
 #include "texture.h"
+#include "virtualTexture.h"
+#include "material.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -8,6 +11,8 @@
 
 namespace FH
 {
+	class FHAssetRegistry;
+
 	struct TransformComponent
 	{
 		glm::vec3 translation{};
@@ -73,13 +78,17 @@ namespace FH
 
 		unsigned int GetId() { return m_Id; }
 
-		std::unique_ptr<FHModel> m_Model{};
+		//Shared through FHAssetRegistry, other objects may draw the same model and textures
+		std::shared_ptr<FHModel> m_Model{};
+		//Drawn instead of m_Model when set, call its Update every frame
+		std::unique_ptr<FHStreamedModel> m_StreamedModel{};
 
-		std::unique_ptr<FHTexture> m_DiffuseTexture{};
-		std::unique_ptr<FHTexture> m_NormalTexture{};
-		std::unique_ptr<FHTexture> m_RoughnessTexture{};
-		std::unique_ptr<FHTexture> m_SpecularTexture{};
-		std::unique_ptr<FHTexture> m_AOTexture{};
+		std::shared_ptr<FHTexture> m_DiffuseTexture{};
+		//Sampled instead of m_DiffuseTexture when set, see FHVirtualTextureCache
+		std::shared_ptr<FHVirtualTexture> m_VirtualDiffuseTexture{};
+		std::shared_ptr<FHTexture> m_NormalTexture{};
+		//R ambient occlusion, G roughness, B specular
+		std::shared_ptr<FHTexture> m_ORMTexture{};
 
 		std::unique_ptr<DirectionalLightComponent> m_DirLightComp{ nullptr };
 		glm::vec3 m_Color{};
@@ -91,13 +100,24 @@ namespace FH
 			return m_ObjectDescriptorSets[frame];
 		}
 
+		//Remembers the texture versions the set was written with
 		void SetDescriptorSetAtFrame(int frame, VkDescriptorSet descriptorSet);
+		//A texture replaced its image view since the set was written, see FHTextureStreamer
+		bool IsDescriptorSetStale(int frame) const;
+
+		//Loads every non empty slot, the others keep their current texture. Roughness, specular and AO are packed
+		//into one ORM texture together, a missing one of them gets its default
+		void LoadTextures(FHAssetRegistry& assets, const FHMaterialPaths& material);
 
 	private:
 		FHGameObject(uint32_t objectId);
 
+		//Sum of the view versions of the textures, they only increase
+		uint32_t GetTextureVersion() const;
+
 		uint32_t m_Id{};
 		std::vector<VkDescriptorSet> m_ObjectDescriptorSets;
+		std::vector<uint32_t> m_DescriptorTextureVersions;
 	};
 
 	class FHGameObject2D
@@ -0,0 +1,308 @@
+#include "geometryPool.h"
+#include "uploadContext.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+FH::FHGeometryPool::FHGeometryPool(FHDevice& device, VkDeviceSize blockSize)
+	: m_FHDevice{ device }
+	, m_BlockSize{ blockSize }
+{}
+
+uint32_t FH::FHGeometryPool::AllocateVertices(const void* pVertices, uint32_t vertexSize, uint32_t vertexCount)
+{
+	return Allocate(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexSize, pVertices, vertexCount);
+}
+
+uint32_t FH::FHGeometryPool::AllocateIndices(const void* pIndices, VkIndexType indexType, uint32_t indexCount)
+{
+	if (indexType == VK_INDEX_TYPE_UINT16)
+		return Allocate(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(uint16_t), pIndices, indexCount);
+
+	return Allocate(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		sizeof(uint32_t), pIndices, indexCount);
+}
+
+uint32_t FH::FHGeometryPool::Allocate(VkBufferUsageFlags usage, uint32_t elementSize, const void* pData, uint32_t count)
+{
+	if (count == 0)
+		return INVALID_HANDLE;
+
+	uint32_t arenaIdx{};
+	Arena& arena{ GetArena(usage, elementSize, arenaIdx) };
+
+	uint32_t blockIdx{};
+	uint32_t offset{};
+	bool isAllocated{ false };
+	for (; blockIdx < arena.blocks.size(); ++blockIdx)
+	{
+		Block& block{ arena.blocks[blockIdx] };
+		if (block.pBuffer && TryAllocate(block, count, arena.elementAlignment, offset))
+		{
+			isAllocated = true;
+			break;
+		}
+	}
+
+	if (!isAllocated)
+	{
+		//Reuse the slot of a buffer Compact released before adding a new one
+		blockIdx = 0;
+		while (blockIdx < arena.blocks.size() && arena.blocks[blockIdx].pBuffer)
+			++blockIdx;
+		if (blockIdx == arena.blocks.size())
+			arena.blocks.emplace_back();
+
+		CreateBlock(arena, arena.blocks[blockIdx], count);
+		if (!TryAllocate(arena.blocks[blockIdx], count, arena.elementAlignment, offset))
+			throw std::runtime_error("failed to allocate geometry pool range!");
+	}
+
+	Block& block{ arena.blocks[blockIdx] };
+	block.used += count;
+	Upload(block, elementSize, pData, offset, count);
+
+	uint32_t handle{};
+	if (!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else
+	{
+		handle = static_cast<uint32_t>(m_Allocations.size());
+		m_Allocations.emplace_back();
+	}
+
+	m_Allocations[handle] = Allocation{ arenaIdx, blockIdx, offset, count, true };
+	return handle;
+}
+
+void FH::FHGeometryPool::Free(uint32_t handle)
+{
+	if (handle == INVALID_HANDLE)
+		return;
+
+	Allocation& allocation{ m_Allocations[handle] };
+	assert(allocation.isLive && "Geometry pool range freed twice");
+
+	Block& block{ m_Arenas[allocation.arenaIdx].blocks[allocation.blockIdx] };
+	Release(block, allocation.offset, allocation.count);
+	block.used -= allocation.count;
+
+	allocation.isLive = false;
+	m_FreeHandles.push_back(handle);
+}
+
+void FH::FHGeometryPool::Compact()
+{
+	//Old buffers have to outlive the copy, EndSingleTimeCommands waits for the queue
+	std::vector<std::unique_ptr<FHBuffer>> retiredBuffers{};
+	std::vector<uint32_t> blockAllocations{};
+	std::vector<VkBufferCopy> copyRegions{};
+
+	VkCommandBuffer commandBuffer{ m_FHDevice.BeginSingleTimeCommands() };
+
+	for (uint32_t arenaIdx = 0; arenaIdx < m_Arenas.size(); ++arenaIdx)
+	{
+		Arena& arena{ m_Arenas[arenaIdx] };
+		for (uint32_t blockIdx = 0; blockIdx < arena.blocks.size(); ++blockIdx)
+		{
+			Block& block{ arena.blocks[blockIdx] };
+			if (!block.pBuffer)
+				continue;
+
+			if (block.used == 0)
+			{
+				retiredBuffers.push_back(std::move(block.pBuffer));
+				block.freeRanges.clear();
+				block.capacity = 0;
+				continue;
+			}
+
+			//Already packed when the only hole is the tail
+			const bool isPacked{ block.freeRanges.empty() || (block.freeRanges.size() == 1
+				&& block.freeRanges[0].offset + block.freeRanges[0].count == block.capacity) };
+			if (isPacked)
+				continue;
+
+			blockAllocations.clear();
+			for (uint32_t handle = 0; handle < m_Allocations.size(); ++handle)
+			{
+				const Allocation& allocation{ m_Allocations[handle] };
+				if (allocation.isLive && allocation.arenaIdx == arenaIdx && allocation.blockIdx == blockIdx)
+					blockAllocations.push_back(handle);
+			}
+			std::sort(blockAllocations.begin(), blockAllocations.end(), [&](uint32_t lhs, uint32_t rhs)
+				{ return m_Allocations[lhs].offset < m_Allocations[rhs].offset; });
+
+			std::unique_ptr<FHBuffer> pOldBuffer{ std::move(block.pBuffer) };
+			const uint32_t used{ block.used };
+			CreateBlock(arena, block, block.capacity);
+			block.used = used;
+			block.freeRanges.clear();
+
+			copyRegions.clear();
+			uint32_t writeOffset{};
+			for (uint32_t handle : blockAllocations)
+			{
+				Allocation& allocation{ m_Allocations[handle] };
+				const uint32_t alignedOffset{ (writeOffset + arena.elementAlignment - 1)
+					/ arena.elementAlignment * arena.elementAlignment };
+				if (alignedOffset > writeOffset)
+					block.freeRanges.push_back({ writeOffset, alignedOffset - writeOffset });
+
+				VkBufferCopy copyRegion{};
+				copyRegion.srcOffset = static_cast<VkDeviceSize>(allocation.offset) * arena.elementSize;
+				copyRegion.dstOffset = static_cast<VkDeviceSize>(alignedOffset) * arena.elementSize;
+				copyRegion.size = static_cast<VkDeviceSize>(allocation.count) * arena.elementSize;
+				copyRegions.push_back(copyRegion);
+
+				allocation.offset = alignedOffset;
+				writeOffset = alignedOffset + allocation.count;
+			}
+			if (writeOffset < block.capacity)
+				block.freeRanges.push_back({ writeOffset, block.capacity - writeOffset });
+
+			vkCmdCopyBuffer(commandBuffer, pOldBuffer->GetBuffer(), block.pBuffer->GetBuffer(),
+				static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+			retiredBuffers.push_back(std::move(pOldBuffer));
+		}
+	}
+
+	m_FHDevice.EndSingleTimeCommands(commandBuffer);
+}
+
+FH::FHGeometryPool::Range FH::FHGeometryPool::GetRange(uint32_t handle) const
+{
+	const Allocation& allocation{ m_Allocations[handle] };
+	assert(allocation.isLive && "Geometry pool range is not allocated");
+
+	const Block& block{ m_Arenas[allocation.arenaIdx].blocks[allocation.blockIdx] };
+	return Range{ block.pBuffer->GetBuffer(), allocation.offset, allocation.count };
+}
+
+VkDescriptorBufferInfo FH::FHGeometryPool::GetDescriptorInfo(uint32_t handle) const
+{
+	const Allocation& allocation{ m_Allocations[handle] };
+	const uint32_t elementSize{ m_Arenas[allocation.arenaIdx].elementSize };
+	const Range range{ GetRange(handle) };
+
+	return VkDescriptorBufferInfo{
+		range.buffer,
+		static_cast<VkDeviceSize>(range.offset) * elementSize,
+		static_cast<VkDeviceSize>(range.count) * elementSize
+	};
+}
+
+FH::FHGeometryPool::Stats FH::FHGeometryPool::GetStats() const
+{
+	Stats stats{};
+	for (const Arena& arena : m_Arenas)
+		for (const Block& block : arena.blocks)
+		{
+			if (!block.pBuffer)
+				continue;
+
+			++stats.bufferCount;
+			stats.capacity += static_cast<VkDeviceSize>(block.capacity) * arena.elementSize;
+			stats.used += static_cast<VkDeviceSize>(block.used) * arena.elementSize;
+		}
+
+	stats.allocationCount = static_cast<uint32_t>(m_Allocations.size() - m_FreeHandles.size());
+	return stats;
+}
+
+FH::FHGeometryPool::Arena& FH::FHGeometryPool::GetArena(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t& arenaIdx)
+{
+	for (arenaIdx = 0; arenaIdx < m_Arenas.size(); ++arenaIdx)
+		if (m_Arenas[arenaIdx].usage == usage && m_Arenas[arenaIdx].elementSize == elementSize)
+			return m_Arenas[arenaIdx];
+
+	Arena arena{};
+	arena.usage = usage;
+	arena.elementSize = elementSize;
+	arena.elementAlignment = 1;
+
+	//Ranges bound as storage buffers need aligned descriptor offsets
+	if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	{
+		const VkDeviceSize offsetAlignment{ m_FHDevice.m_Properties.limits.minStorageBufferOffsetAlignment };
+		arena.elementAlignment = std::max(1u, static_cast<uint32_t>((offsetAlignment + elementSize - 1) / elementSize));
+	}
+
+	m_Arenas.push_back(std::move(arena));
+	return m_Arenas.back();
+}
+
+void FH::FHGeometryPool::CreateBlock(const Arena& arena, Block& block, uint32_t minCapacity)
+{
+	//Meshes larger than a block get a buffer of their own
+	block.capacity = std::max(static_cast<uint32_t>(m_BlockSize / arena.elementSize), minCapacity);
+	block.used = 0;
+	block.freeRanges = { FreeRange{ 0, block.capacity } };
+
+	block.pBuffer = std::make_unique<FHBuffer>
+		(
+			m_FHDevice,
+			arena.elementSize,
+			block.capacity,
+			arena.usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+}
+
+bool FH::FHGeometryPool::TryAllocate(Block& block, uint32_t count, uint32_t alignment, uint32_t& offset)
+{
+	//First fit, padding in front of the aligned offset and the rest of the range stay free
+	for (size_t rangeIdx = 0; rangeIdx < block.freeRanges.size(); ++rangeIdx)
+	{
+		const FreeRange range{ block.freeRanges[rangeIdx] };
+		const uint64_t alignedOffset{ (static_cast<uint64_t>(range.offset) + alignment - 1) / alignment * alignment };
+		const uint64_t rangeEnd{ static_cast<uint64_t>(range.offset) + range.count };
+		if (alignedOffset + count > rangeEnd)
+			continue;
+
+		auto insertIt{ block.freeRanges.erase(block.freeRanges.begin() + rangeIdx) };
+		if (alignedOffset + count < rangeEnd)
+			insertIt = block.freeRanges.insert(insertIt,
+				{ static_cast<uint32_t>(alignedOffset + count), static_cast<uint32_t>(rangeEnd - alignedOffset - count) });
+		if (alignedOffset > range.offset)
+			block.freeRanges.insert(insertIt, { range.offset, static_cast<uint32_t>(alignedOffset - range.offset) });
+
+		offset = static_cast<uint32_t>(alignedOffset);
+		return true;
+	}
+	return false;
+}
+
+void FH::FHGeometryPool::Release(Block& block, uint32_t offset, uint32_t count)
+{
+	auto it{ std::lower_bound(block.freeRanges.begin(), block.freeRanges.end(), offset,
+		[](const FreeRange& range, uint32_t value) { return range.offset < value; }) };
+	it = block.freeRanges.insert(it, { offset, count });
+
+	//Merge with the next and previous range when they touch
+	auto next{ it + 1 };
+	if (next != block.freeRanges.end() && it->offset + it->count == next->offset)
+	{
+		it->count += next->count;
+		block.freeRanges.erase(next);
+	}
+	if (it != block.freeRanges.begin())
+	{
+		auto previous{ it - 1 };
+		if (previous->offset + previous->count == it->offset)
+		{
+			previous->count += it->count;
+			block.freeRanges.erase(it);
+		}
+	}
+}
+
+void FH::FHGeometryPool::Upload(const Block& block, uint32_t elementSize, const void* pData, uint32_t offset, uint32_t count)
+{
+	m_FHDevice.GetUploadContext().CopyToBuffer(block.pBuffer->GetBuffer(), static_cast<VkDeviceSize>(offset) * elementSize,
+		pData, static_cast<VkDeviceSize>(count) * elementSize);
+}
\ No newline at end of file
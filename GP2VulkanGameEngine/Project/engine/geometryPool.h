@@ -0,0 +1,108 @@
+#pragma once
+#include "buffer.h"
+#include "device.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace FH
+{
+	//Sub-allocates vertex and index ranges from a few large device local buffers. Ranges are grouped in arenas
+	//by vertex stride or index type, so models sharing an arena are drawn with one bind and differ only in
+	//vertexOffset and firstIndex
+	class FHGeometryPool final
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE{ 64ull << 20 };
+		static constexpr uint32_t INVALID_HANDLE{ UINT32_MAX };
+
+		//Element offset and count of an allocation inside its block buffer
+		struct Range
+		{
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			uint32_t offset{};
+			uint32_t count{};
+		};
+
+		struct Stats
+		{
+			uint32_t bufferCount{};
+			uint32_t allocationCount{};
+			VkDeviceSize capacity{};	//bytes
+			VkDeviceSize used{};		//bytes
+		};
+
+		explicit FHGeometryPool(FHDevice& device, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+		~FHGeometryPool() = default;
+
+		FHGeometryPool(const FHGeometryPool&) = delete;
+		FHGeometryPool& operator=(const FHGeometryPool&) = delete;
+
+		//Both upload through a staging buffer and return a handle that stays valid until Free
+		uint32_t AllocateVertices(const void* pVertices, uint32_t vertexSize, uint32_t vertexCount);
+		//32 bit index ranges can also be bound as storage buffers, see GetDescriptorInfo
+		uint32_t AllocateIndices(const void* pIndices, VkIndexType indexType, uint32_t indexCount);
+
+		//The range must no longer be in use by the GPU
+		void Free(uint32_t handle);
+
+		//Moves the allocations of every buffer together and releases empty buffers. Offsets change, so wait
+		//for the device to be idle first and refresh descriptors that point into the pool
+		void Compact();
+
+		Range GetRange(uint32_t handle) const;
+		VkDescriptorBufferInfo GetDescriptorInfo(uint32_t handle) const;
+		Stats GetStats() const;
+
+		FHDevice& GetDevice() const { return m_FHDevice; }
+
+	private:
+		struct FreeRange
+		{
+			uint32_t offset{};
+			uint32_t count{};
+		};
+
+		struct Block
+		{
+			std::unique_ptr<FHBuffer> pBuffer{};
+			uint32_t capacity{};	//elements
+			uint32_t used{};		//elements
+			std::vector<FreeRange> freeRanges{};	//sorted on offset, never adjacent
+		};
+
+		struct Arena
+		{
+			VkBufferUsageFlags usage{};
+			uint32_t elementSize{};
+			uint32_t elementAlignment{};
+			std::vector<Block> blocks{};
+		};
+
+		struct Allocation
+		{
+			uint32_t arenaIdx{};
+			uint32_t blockIdx{};
+			uint32_t offset{};
+			uint32_t count{};
+			bool isLive{};
+		};
+
+		uint32_t Allocate(VkBufferUsageFlags usage, uint32_t elementSize, const void* pData, uint32_t count);
+
+		Arena& GetArena(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t& arenaIdx);
+		void CreateBlock(const Arena& arena, Block& block, uint32_t minCapacity);
+		static bool TryAllocate(Block& block, uint32_t count, uint32_t alignment, uint32_t& offset);
+		static void Release(Block& block, uint32_t offset, uint32_t count);
+
+		void Upload(const Block& block, uint32_t elementSize, const void* pData, uint32_t offset, uint32_t count);
+
+		FHDevice& m_FHDevice;
+		VkDeviceSize m_BlockSize;
+
+		std::vector<Arena> m_Arenas{};
+		std::vector<Allocation> m_Allocations{};
+		std::vector<uint32_t> m_FreeHandles{};
+	};
+}
\ No newline at end of file
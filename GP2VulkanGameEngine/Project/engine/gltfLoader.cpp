@@ -0,0 +1,738 @@
+#include "gltfLoader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+	constexpr uint32_t GLB_MAGIC{ 0x46546C67 };			//"glTF"
+	constexpr uint32_t GLB_CHUNK_JSON{ 0x4E4F534A };	//"JSON"
+	constexpr uint32_t GLB_CHUNK_BIN{ 0x004E4942 };		//"BIN\0"
+
+	//Accessor component types
+	constexpr int COMPONENT_BYTE{ 5120 };
+	constexpr int COMPONENT_UNSIGNED_BYTE{ 5121 };
+	constexpr int COMPONENT_SHORT{ 5122 };
+	constexpr int COMPONENT_UNSIGNED_SHORT{ 5123 };
+	constexpr int COMPONENT_UNSIGNED_INT{ 5125 };
+	constexpr int COMPONENT_FLOAT{ 5126 };
+
+	constexpr int MODE_TRIANGLES{ 4 };
+
+	//Just enough json for the glTF scene description, numbers are kept as doubles
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type{ Type::Null };
+		bool boolean{};
+		double number{};
+		std::string string{};
+		std::vector<std::string> keys{};	//objects only, parallel to values
+		std::vector<JsonValue> values{};	//array elements or object members
+
+		const JsonValue* Find(std::string_view key) const
+		{
+			for (size_t memberIdx = 0; memberIdx < keys.size(); ++memberIdx)
+				if (keys[memberIdx] == key)
+					return &values[memberIdx];
+			return nullptr;
+		}
+
+		const JsonValue* At(size_t idx) const
+		{
+			return type == Type::Array && idx < values.size() ? &values[idx] : nullptr;
+		}
+
+		int GetInt(std::string_view key, int fallback) const
+		{
+			const JsonValue* pValue{ Find(key) };
+			return pValue && pValue->type == Type::Number ? static_cast<int>(pValue->number) : fallback;
+		}
+
+		size_t GetSize(std::string_view key, size_t fallback) const
+		{
+			const JsonValue* pValue{ Find(key) };
+			return pValue && pValue->type == Type::Number ? static_cast<size_t>(pValue->number) : fallback;
+		}
+	};
+
+	class JsonParser final
+	{
+	public:
+		JsonParser(const char* pBegin, const char* pEnd)
+			: m_pCurrent{ pBegin }
+			, m_pEnd{ pEnd }
+		{}
+
+		JsonValue Parse()
+		{
+			JsonValue value{ ParseValue() };
+			SkipWhitespace();
+			if (m_pCurrent != m_pEnd)
+				Fail();
+			return value;
+		}
+
+	private:
+		[[noreturn]] static void Fail()
+		{
+			throw std::runtime_error("failed to parse glTF json!");
+		}
+
+		void SkipWhitespace()
+		{
+			while (m_pCurrent < m_pEnd && (*m_pCurrent == ' ' || *m_pCurrent == '\t' || *m_pCurrent == '\n' || *m_pCurrent == '\r'))
+				++m_pCurrent;
+		}
+
+		char Peek()
+		{
+			SkipWhitespace();
+			if (m_pCurrent == m_pEnd)
+				Fail();
+			return *m_pCurrent;
+		}
+
+		void Expect(char c)
+		{
+			if (Peek() != c)
+				Fail();
+			++m_pCurrent;
+		}
+
+		bool ConsumeLiteral(std::string_view literal)
+		{
+			if (static_cast<size_t>(m_pEnd - m_pCurrent) < literal.size()
+				|| std::memcmp(m_pCurrent, literal.data(), literal.size()) != 0)
+				return false;
+			m_pCurrent += literal.size();
+			return true;
+		}
+
+		JsonValue ParseValue()
+		{
+			JsonValue value{};
+			const char c{ Peek() };
+			if (c == '{')
+			{
+				value.type = JsonValue::Type::Object;
+				++m_pCurrent;
+				if (Peek() == '}')
+				{
+					++m_pCurrent;
+					return value;
+				}
+				do
+				{
+					value.keys.push_back(ParseString());
+					Expect(':');
+					value.values.push_back(ParseValue());
+				} while (ConsumeSeparator('}'));
+			}
+			else if (c == '[')
+			{
+				value.type = JsonValue::Type::Array;
+				++m_pCurrent;
+				if (Peek() == ']')
+				{
+					++m_pCurrent;
+					return value;
+				}
+				do
+				{
+					value.values.push_back(ParseValue());
+				} while (ConsumeSeparator(']'));
+			}
+			else if (c == '"')
+			{
+				value.type = JsonValue::Type::String;
+				value.string = ParseString();
+			}
+			else if (ConsumeLiteral("true"))
+			{
+				value.type = JsonValue::Type::Bool;
+				value.boolean = true;
+			}
+			else if (ConsumeLiteral("false"))
+			{
+				value.type = JsonValue::Type::Bool;
+			}
+			else if (ConsumeLiteral("null"))
+			{
+				value.type = JsonValue::Type::Null;
+			}
+			else
+			{
+				value.type = JsonValue::Type::Number;
+				value.number = ParseNumber();
+			}
+			return value;
+		}
+
+		//True after a ',', false after the closing character
+		bool ConsumeSeparator(char close)
+		{
+			const char c{ Peek() };
+			++m_pCurrent;
+			if (c == ',')
+				return true;
+			if (c != close)
+				Fail();
+			return false;
+		}
+
+		double ParseNumber()
+		{
+			const char* pStart{ m_pCurrent };
+			while (m_pCurrent < m_pEnd && std::string_view{ "+-.eE0123456789" }.find(*m_pCurrent) != std::string_view::npos)
+				++m_pCurrent;
+			if (m_pCurrent == pStart)
+				Fail();
+
+			//strtod needs a terminated string, numbers are short
+			const std::string token{ pStart, m_pCurrent };
+			char* pTokenEnd{};
+			const double number{ std::strtod(token.c_str(), &pTokenEnd) };
+			if (pTokenEnd != token.c_str() + token.size())
+				Fail();
+			return number;
+		}
+
+		std::string ParseString()
+		{
+			Expect('"');
+			std::string result{};
+			while (true)
+			{
+				if (m_pCurrent == m_pEnd)
+					Fail();
+
+				const char c{ *m_pCurrent++ };
+				if (c == '"')
+					return result;
+				if (c != '\\')
+				{
+					result.push_back(c);
+					continue;
+				}
+
+				if (m_pCurrent == m_pEnd)
+					Fail();
+				const char escaped{ *m_pCurrent++ };
+				switch (escaped)
+				{
+				case 'b': result.push_back('\b'); break;
+				case 'f': result.push_back('\f'); break;
+				case 'n': result.push_back('\n'); break;
+				case 'r': result.push_back('\r'); break;
+				case 't': result.push_back('\t'); break;
+				case 'u': AppendCodePoint(result); break;
+				default: result.push_back(escaped); break;
+				}
+			}
+		}
+
+		//Encodes a \uXXXX escape (and a following low surrogate) as utf-8
+		void AppendCodePoint(std::string& result)
+		{
+			uint32_t codePoint{ ParseHex4() };
+			if (codePoint >= 0xD800 && codePoint < 0xDC00 && ConsumeLiteral("\\u"))
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (ParseHex4() - 0xDC00);
+
+			if (codePoint < 0x80)
+				result.push_back(static_cast<char>(codePoint));
+			else if (codePoint < 0x800)
+			{
+				result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+				result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+			else if (codePoint < 0x10000)
+			{
+				result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+				result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+			else
+			{
+				result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+				result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+				result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+		}
+
+		uint32_t ParseHex4()
+		{
+			if (m_pEnd - m_pCurrent < 4)
+				Fail();
+
+			uint32_t value{};
+			for (int digitIdx = 0; digitIdx < 4; ++digitIdx)
+			{
+				const char c{ *m_pCurrent++ };
+				value <<= 4;
+				if (c >= '0' && c <= '9')
+					value |= c - '0';
+				else if (c >= 'a' && c <= 'f')
+					value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					value |= c - 'A' + 10;
+				else
+					Fail();
+			}
+			return value;
+		}
+
+		const char* m_pCurrent;
+		const char* m_pEnd;
+	};
+
+	struct GlbChunks
+	{
+		std::string_view json{};
+		const uint8_t* pBinary{};
+		size_t binarySize{};
+	};
+
+	uint32_t ReadUint32(const uint8_t* pData)
+	{
+		uint32_t value{};
+		std::memcpy(&value, pData, sizeof(value));
+		return value;
+	}
+
+	GlbChunks ReadChunks(const FH::FHMappedFile& file)
+	{
+		const uint8_t* pData{ file.GetData() };
+		const size_t size{ file.GetSize() };
+		if (size < 20 || ReadUint32(pData) != GLB_MAGIC || ReadUint32(pData + 4) != 2)
+			throw std::runtime_error("failed to load glTF, not a version 2 .glb file!");
+
+		GlbChunks chunks{};
+		size_t offset{ 12 };
+		while (offset + 8 <= size)
+		{
+			const uint32_t chunkSize{ ReadUint32(pData + offset) };
+			const uint32_t chunkType{ ReadUint32(pData + offset + 4) };
+			offset += 8;
+			if (chunkSize > size - offset)
+				throw std::runtime_error("failed to load glTF, chunk runs past the end of the file!");
+
+			if (chunkType == GLB_CHUNK_JSON && chunks.json.empty())
+				chunks.json = { reinterpret_cast<const char*>(pData + offset), chunkSize };
+			else if (chunkType == GLB_CHUNK_BIN && !chunks.pBinary)
+			{
+				chunks.pBinary = pData + offset;
+				chunks.binarySize = chunkSize;
+			}
+			offset += (chunkSize + 3) & ~3u;
+		}
+
+		if (chunks.json.empty())
+			throw std::runtime_error("failed to load glTF, missing json chunk!");
+		return chunks;
+	}
+
+	//Resolved accessor, pData points at the first element
+	struct AccessorView
+	{
+		const uint8_t* pData{};
+		size_t count{};
+		size_t stride{};
+		int componentType{};
+		int componentCount{};
+		bool isNormalized{};
+	};
+
+	int GetComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case COMPONENT_BYTE:
+		case COMPONENT_UNSIGNED_BYTE: return 1;
+		case COMPONENT_SHORT:
+		case COMPONENT_UNSIGNED_SHORT: return 2;
+		case COMPONENT_UNSIGNED_INT:
+		case COMPONENT_FLOAT: return 4;
+		default: throw std::runtime_error("failed to load glTF, unknown accessor component type!");
+		}
+	}
+
+	int GetComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		throw std::runtime_error("failed to load glTF, unsupported accessor type " + type + "!");
+	}
+
+	AccessorView GetAccessorView(const JsonValue& root, const GlbChunks& chunks, int accessorIdx)
+	{
+		const JsonValue* pAccessor{ root.Find("accessors") ? root.Find("accessors")->At(accessorIdx) : nullptr };
+		if (!pAccessor)
+			throw std::runtime_error("failed to load glTF, missing accessor!");
+		if (pAccessor->Find("sparse"))
+			throw std::runtime_error("failed to load glTF, sparse accessors are not supported!");
+
+		AccessorView view{};
+		view.count = pAccessor->GetSize("count", 0);
+		view.componentType = pAccessor->GetInt("componentType", 0);
+		const JsonValue* pType{ pAccessor->Find("type") };
+		view.componentCount = GetComponentCount(pType ? pType->string : std::string{});
+		const JsonValue* pNormalized{ pAccessor->Find("normalized") };
+		view.isNormalized = pNormalized && pNormalized->boolean;
+
+		const size_t elementSize{ static_cast<size_t>(GetComponentSize(view.componentType) * view.componentCount) };
+		const int bufferViewIdx{ pAccessor->GetInt("bufferView", -1) };
+		const JsonValue* pBufferView{ root.Find("bufferViews") ? root.Find("bufferViews")->At(bufferViewIdx) : nullptr };
+		if (!pBufferView)
+			throw std::runtime_error("failed to load glTF, accessor without buffer view!");
+
+		//Only the embedded binary chunk, external .bin files need the .gltf flavour
+		const JsonValue* pBuffer{ root.Find("buffers") ? root.Find("buffers")->At(pBufferView->GetInt("buffer", 0)) : nullptr };
+		if (!pBuffer || pBuffer->Find("uri") || !chunks.pBinary)
+			throw std::runtime_error("failed to load glTF, only the embedded .glb buffer is supported!");
+
+		view.stride = pBufferView->GetSize("byteStride", 0);
+		if (view.stride == 0)
+			view.stride = elementSize;
+
+		const size_t viewOffset{ pBufferView->GetSize("byteOffset", 0) };
+		const size_t viewLength{ pBufferView->GetSize("byteLength", 0) };
+		const size_t accessorOffset{ pAccessor->GetSize("byteOffset", 0) };
+		if (viewOffset + viewLength > chunks.binarySize
+			|| (view.count > 0 && accessorOffset + (view.count - 1) * view.stride + elementSize > viewLength))
+			throw std::runtime_error("failed to load glTF, accessor runs past its buffer view!");
+
+		view.pData = chunks.pBinary + viewOffset + accessorOffset;
+		return view;
+	}
+
+	float ReadComponent(const AccessorView& view, size_t elementIdx, int componentIdx)
+	{
+		const uint8_t* pComponent{ view.pData + elementIdx * view.stride
+			+ static_cast<size_t>(componentIdx * GetComponentSize(view.componentType)) };
+
+		switch (view.componentType)
+		{
+		case COMPONENT_FLOAT:
+		{
+			float value{};
+			std::memcpy(&value, pComponent, sizeof(value));
+			return value;
+		}
+		case COMPONENT_BYTE:
+		{
+			const float value{ static_cast<float>(static_cast<int8_t>(*pComponent)) };
+			return view.isNormalized ? std::max(value / 127.f, -1.f) : value;
+		}
+		case COMPONENT_UNSIGNED_BYTE:
+		{
+			const float value{ static_cast<float>(*pComponent) };
+			return view.isNormalized ? value / 255.f : value;
+		}
+		case COMPONENT_SHORT:
+		{
+			int16_t raw{};
+			std::memcpy(&raw, pComponent, sizeof(raw));
+			return view.isNormalized ? std::max(raw / 32767.f, -1.f) : static_cast<float>(raw);
+		}
+		case COMPONENT_UNSIGNED_SHORT:
+		{
+			uint16_t raw{};
+			std::memcpy(&raw, pComponent, sizeof(raw));
+			return view.isNormalized ? raw / 65535.f : static_cast<float>(raw);
+		}
+		default:
+		{
+			uint32_t raw{};
+			std::memcpy(&raw, pComponent, sizeof(raw));
+			return static_cast<float>(raw);
+		}
+		}
+	}
+
+	uint32_t ReadIndex(const AccessorView& view, size_t elementIdx)
+	{
+		const uint8_t* pIndex{ view.pData + elementIdx * view.stride };
+		switch (view.componentType)
+		{
+		case COMPONENT_UNSIGNED_BYTE:
+			return *pIndex;
+		case COMPONENT_UNSIGNED_SHORT:
+		{
+			uint16_t index{};
+			std::memcpy(&index, pIndex, sizeof(index));
+			return index;
+		}
+		case COMPONENT_UNSIGNED_INT:
+		{
+			uint32_t index{};
+			std::memcpy(&index, pIndex, sizeof(index));
+			return index;
+		}
+		default:
+			throw std::runtime_error("failed to load glTF, unsupported index component type!");
+		}
+	}
+
+	//Float vectors without padding between elements can be used as glm vectors in place
+	template<typename VecType>
+	bool CanView(const AccessorView& view)
+	{
+		return view.componentType == COMPONENT_FLOAT && !view.isNormalized
+			&& view.componentCount == VecType::length() && view.stride == sizeof(VecType)
+			&& reinterpret_cast<uintptr_t>(view.pData) % alignof(VecType) == 0;
+	}
+
+	template<typename VecType>
+	void AppendConverted(const AccessorView& view, std::vector<VecType>& output)
+	{
+		const size_t first{ output.size() };
+		output.resize(first + view.count, VecType{ 0.f });
+		for (size_t elementIdx = 0; elementIdx < view.count; ++elementIdx)
+			for (int componentIdx = 0; componentIdx < std::min(view.componentCount, VecType::length()); ++componentIdx)
+				output[first + elementIdx][componentIdx] = ReadComponent(view, elementIdx, componentIdx);
+	}
+
+	struct Primitive
+	{
+		int position{ -1 };
+		int normal{ -1 };
+		int uv{ -1 };
+		int tangent{ -1 };
+		int indices{ -1 };
+		int material{ -1 };
+	};
+
+	std::vector<Primitive> GetTrianglePrimitives(const JsonValue& root)
+	{
+		std::vector<Primitive> primitives{};
+		const JsonValue* pMeshes{ root.Find("meshes") };
+		if (!pMeshes)
+			return primitives;
+
+		for (const JsonValue& mesh : pMeshes->values)
+		{
+			const JsonValue* pPrimitives{ mesh.Find("primitives") };
+			if (!pPrimitives)
+				continue;
+
+			for (const JsonValue& primitive : pPrimitives->values)
+			{
+				const JsonValue* pAttributes{ primitive.Find("attributes") };
+				if (!pAttributes || primitive.GetInt("mode", MODE_TRIANGLES) != MODE_TRIANGLES)
+					continue;
+
+				Primitive result{};
+				result.position = pAttributes->GetInt("POSITION", -1);
+				result.normal = pAttributes->GetInt("NORMAL", -1);
+				result.uv = pAttributes->GetInt("TEXCOORD_0", -1);
+				result.tangent = pAttributes->GetInt("TANGENT", -1);
+				result.indices = primitive.GetInt("indices", -1);
+				result.material = primitive.GetInt("material", -1);
+				if (result.position >= 0)
+					primitives.push_back(result);
+			}
+		}
+		return primitives;
+	}
+
+	//Relative uri of the image behind a textureInfo, empty for embedded or data uri images
+	std::string GetTextureUri(const JsonValue& root, const JsonValue* pTextureInfo)
+	{
+		if (!pTextureInfo)
+			return {};
+
+		const JsonValue* pTextures{ root.Find("textures") };
+		const JsonValue* pTexture{ pTextures ? pTextures->At(pTextureInfo->GetInt("index", -1)) : nullptr };
+		const JsonValue* pImages{ root.Find("images") };
+		const JsonValue* pImage{ pTexture && pImages ? pImages->At(pTexture->GetInt("source", -1)) : nullptr };
+		const JsonValue* pUri{ pImage ? pImage->Find("uri") : nullptr };
+		if (!pUri || pUri->string.starts_with("data:"))
+		{
+			if (pImage)
+				std::cout << "Skipping embedded glTF image, textures are loaded from files" << std::endl;
+			return {};
+		}
+
+		//Uris are percent encoded
+		std::string uri{};
+		for (size_t charIdx = 0; charIdx < pUri->string.size(); ++charIdx)
+		{
+			const char c{ pUri->string[charIdx] };
+			if (c == '%' && charIdx + 2 < pUri->string.size())
+			{
+				uri.push_back(static_cast<char>(std::stoi(pUri->string.substr(charIdx + 1, 2), nullptr, 16)));
+				charIdx += 2;
+			}
+			else
+				uri.push_back(c);
+		}
+		return uri;
+	}
+
+	FH::FHMaterialPaths GetMaterial(const JsonValue& root, int materialIdx, const std::string& directory)
+	{
+		FH::FHMaterialPaths paths{};
+		const JsonValue* pMaterials{ root.Find("materials") };
+		const JsonValue* pMaterial{ pMaterials ? pMaterials->At(materialIdx) : nullptr };
+		if (!pMaterial)
+			return paths;
+
+		auto resolve = [&](const JsonValue* pTextureInfo)
+			{
+				const std::string uri{ GetTextureUri(root, pTextureInfo) };
+				return uri.empty() ? uri : directory + uri;
+			};
+
+		if (const JsonValue* pPbr{ pMaterial->Find("pbrMetallicRoughness") })
+		{
+			paths.diffuse = resolve(pPbr->Find("baseColorTexture"));
+			paths.roughness = resolve(pPbr->Find("metallicRoughnessTexture"));
+		}
+		paths.normal = resolve(pMaterial->Find("normalTexture"));
+		paths.ao = resolve(pMaterial->Find("occlusionTexture"));
+
+		const JsonValue* pExtensions{ pMaterial->Find("extensions") };
+		if (const JsonValue* pSpecular{ pExtensions ? pExtensions->Find("KHR_materials_specular") : nullptr })
+			paths.specular = resolve(pSpecular->Find("specularTexture"));
+
+		return paths;
+	}
+
+	std::string GetDirectory(const std::string& filePath)
+	{
+		const size_t slash{ filePath.find_last_of("/\\") };
+		return slash == std::string::npos ? std::string{} : filePath.substr(0, slash + 1);
+	}
+}
+
+FH::FHGltfLoader::Result FH::FHGltfLoader::Load(const std::string& filePath)
+{
+	Result result{};
+	result.file = FHMappedFile{ filePath };
+	if (!result.file.IsOpen())
+		throw std::runtime_error("failed to open " + filePath + "!");
+
+	const GlbChunks chunks{ ReadChunks(result.file) };
+	const JsonValue root{ JsonParser{ chunks.json.data(), chunks.json.data() + chunks.json.size() }.Parse() };
+
+	const std::vector<Primitive> primitives{ GetTrianglePrimitives(root) };
+	if (primitives.empty())
+		throw std::runtime_error("failed to load glTF, no triangle meshes in " + filePath + "!");
+
+	result.material = GetMaterial(root, primitives.front().material, GetDirectory(filePath));
+
+	//A single primitive can keep its attributes in the mapping, merging several always copies
+	const bool isSingle{ primitives.size() == 1 };
+	auto gather = [&]<typename VecType>(int accessorIdx, size_t vertexCount, std::vector<VecType>& converted,
+		std::span<const VecType>& output)
+		{
+			if (accessorIdx < 0)
+			{
+				converted.resize(converted.size() + vertexCount, VecType{ 0.f });
+				return;
+			}
+
+			const AccessorView view{ GetAccessorView(root, chunks, accessorIdx) };
+			if (view.count != vertexCount)
+				throw std::runtime_error("failed to load glTF, attribute counts differ within a primitive!");
+
+			if (isSingle && CanView<VecType>(view))
+			{
+				output = { reinterpret_cast<const VecType*>(view.pData), view.count };
+				++result.viewedAccessorCount;
+				return;
+			}
+
+			AppendConverted(view, converted);
+			++result.convertedAccessorCount;
+		};
+
+	//Attributes missing on some primitives only are zero filled so the arrays stay parallel
+	bool hasNormals{}, hasUvs{}, hasTangents{};
+	for (const Primitive& primitive : primitives)
+	{
+		hasNormals |= primitive.normal >= 0;
+		hasUvs |= primitive.uv >= 0;
+		hasTangents |= primitive.tangent >= 0;
+	}
+
+	uint32_t baseVertex{};
+	for (const Primitive& primitive : primitives)
+	{
+		const AccessorView positionView{ GetAccessorView(root, chunks, primitive.position) };
+		const size_t vertexCount{ positionView.count };
+
+		gather(primitive.position, vertexCount, result.convertedPositions, result.positions);
+		if (hasNormals)
+			gather(primitive.normal, vertexCount, result.convertedNormals, result.normals);
+		if (hasUvs)
+			gather(primitive.uv, vertexCount, result.convertedUvs, result.uvs);
+		if (hasTangents)
+			gather(primitive.tangent, vertexCount, result.convertedTangents, result.tangents);
+
+		if (primitive.indices < 0)
+		{
+			for (uint32_t vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+				result.convertedIndices.push_back(baseVertex + vertexIdx);
+		}
+		else
+		{
+			const AccessorView indexView{ GetAccessorView(root, chunks, primitive.indices) };
+			if (isSingle && indexView.componentType == COMPONENT_UNSIGNED_INT && indexView.stride == sizeof(uint32_t)
+				&& reinterpret_cast<uintptr_t>(indexView.pData) % alignof(uint32_t) == 0)
+			{
+				result.indices = { reinterpret_cast<const uint32_t*>(indexView.pData), indexView.count };
+				++result.viewedAccessorCount;
+			}
+			else
+			{
+				result.convertedIndices.reserve(result.convertedIndices.size() + indexView.count);
+				for (size_t indexIdx = 0; indexIdx < indexView.count; ++indexIdx)
+					result.convertedIndices.push_back(baseVertex + ReadIndex(indexView, indexIdx));
+				++result.convertedAccessorCount;
+			}
+		}
+
+		baseVertex += static_cast<uint32_t>(vertexCount);
+	}
+
+	//Anything not viewed in place lives in the converted arrays
+	if (result.positions.empty())
+		result.positions = result.convertedPositions;
+	if (result.normals.empty() && hasNormals)
+		result.normals = result.convertedNormals;
+	if (result.uvs.empty() && hasUvs)
+		result.uvs = result.convertedUvs;
+	if (result.tangents.empty() && hasTangents)
+		result.tangents = result.convertedTangents;
+	if (result.indices.empty())
+		result.indices = result.convertedIndices;
+
+	for (uint32_t index : result.indices)
+		if (index >= result.positions.size())
+			throw std::runtime_error("failed to load glTF, index out of range!");
+
+	return result;
+}
+
+FH::FHMaterialPaths FH::FHGltfLoader::LoadMaterial(const std::string& resourcePath)
+{
+	const FHMappedFile file{ "resources/" + resourcePath };
+	if (!file.IsOpen())
+		throw std::runtime_error("failed to open resources/" + resourcePath + "!");
+
+	const GlbChunks chunks{ ReadChunks(file) };
+	const JsonValue root{ JsonParser{ chunks.json.data(), chunks.json.data() + chunks.json.size() }.Parse() };
+
+	const std::vector<Primitive> primitives{ GetTrianglePrimitives(root) };
+	return GetMaterial(root, primitives.empty() ? 0 : primitives.front().material, GetDirectory(resourcePath));
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include "mappedFile.h"
+#include "material.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace FH
+{
+	//Binary glTF 2.0 (.glb) reader. The file stays mapped and accessors that are already tightly packed floats
+	//or 32 bit indices are viewed in place, everything else (quantized, interleaved, several primitives) is
+	//converted into owned arrays. Triangle primitives of all meshes are merged in mesh space, node transforms
+	//are not applied.
+	class FHGltfLoader final
+	{
+	public:
+		struct Result
+		{
+			std::span<const glm::vec3> positions{};
+			std::span<const glm::vec3> normals{};	//empty when the file has none
+			std::span<const glm::vec2> uvs{};		//empty when the file has none
+			std::span<const glm::vec4> tangents{};	//empty when the file has none, w is the bitangent sign
+			std::span<const uint32_t> indices{};	//three per triangle
+
+			//Material of the first primitive, paths are relative to the directory of the .glb
+			FHMaterialPaths material{};
+
+			uint32_t viewedAccessorCount{};
+			uint32_t convertedAccessorCount{};
+
+			//Backing storage, the spans point into one of these
+			FHMappedFile file{};
+			std::vector<glm::vec3> convertedPositions{};
+			std::vector<glm::vec3> convertedNormals{};
+			std::vector<glm::vec2> convertedUvs{};
+			std::vector<glm::vec4> convertedTangents{};
+			std::vector<uint32_t> convertedIndices{};
+		};
+
+		static Result Load(const std::string& filePath);
+
+		//Reads only the json chunk. Takes a path relative to resources/ and returns texture paths relative
+		//to resources/ as well, like FHTexture expects them
+		static FHMaterialPaths LoadMaterial(const std::string& resourcePath);
+
+		FHGltfLoader() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "imageDecoder.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "external/stb_image.h"
+
+namespace
+{
+	std::atomic<uint64_t> g_CopiedBytes{};
+
+	//Info is stbi_info or stbi_info_from_memory with the file bound, given width, height and channels to fill in
+	template<typename Info>
+	void GetImageSize(Info&& info, uint32_t& width, uint32_t& height)
+	{
+		int imageWidth{};
+		int imageHeight{};
+		int channels{};
+		if (!info(&imageWidth, &imageHeight, &channels))
+			throw std::runtime_error("failed to load texture image!");
+
+		width = static_cast<uint32_t>(imageWidth);
+		height = static_cast<uint32_t>(imageHeight);
+	}
+
+	//Load is stbi_load or stbi_load_from_memory with the file and RGBA8 output bound
+	template<typename Load>
+	void DecodeImage(Load&& load, uint8_t* pTarget, uint32_t width, uint32_t height)
+	{
+		int imageWidth{};
+		int imageHeight{};
+		int channels{};
+		//The flag is per thread, textures are decoded on several at once
+		stbi_set_flip_vertically_on_load_thread(true);
+		stbi_uc* pPixels{ load(&imageWidth, &imageHeight, &channels) };
+
+		const bool isExpectedSize{ pPixels && static_cast<uint32_t>(imageWidth) == width && static_cast<uint32_t>(imageHeight) == height };
+		const size_t byteSize{ static_cast<size_t>(width) * height * 4 };
+		if (isExpectedSize)
+		{
+			std::memcpy(pTarget, pPixels, byteSize);
+			g_CopiedBytes += byteSize;
+		}
+		stbi_image_free(pPixels);
+
+		if (!isExpectedSize)
+			throw std::runtime_error("failed to load texture image!");
+	}
+}
+
+void FH::FHImageDecoder::GetSize(const std::string& filePath, uint32_t& width, uint32_t& height)
+{
+	GetImageSize([&filePath](int* pWidth, int* pHeight, int* pChannels)
+		{
+			return stbi_info(filePath.c_str(), pWidth, pHeight, pChannels);
+		}, width, height);
+}
+
+void FH::FHImageDecoder::GetSize(std::span<const uint8_t> fileData, uint32_t& width, uint32_t& height)
+{
+	GetImageSize([fileData](int* pWidth, int* pHeight, int* pChannels)
+		{
+			return stbi_info_from_memory(fileData.data(), static_cast<int>(fileData.size()), pWidth, pHeight, pChannels);
+		}, width, height);
+}
+
+void FH::FHImageDecoder::Decode(const std::string& filePath, uint8_t* pTarget, uint32_t width, uint32_t height)
+{
+	DecodeImage([&filePath](int* pWidth, int* pHeight, int* pChannels)
+		{
+			return stbi_load(filePath.c_str(), pWidth, pHeight, pChannels, STBI_rgb_alpha);
+		}, pTarget, width, height);
+}
+
+void FH::FHImageDecoder::Decode(std::span<const uint8_t> fileData, uint8_t* pTarget, uint32_t width, uint32_t height)
+{
+	DecodeImage([fileData](int* pWidth, int* pHeight, int* pChannels)
+		{
+			return stbi_load_from_memory(fileData.data(), static_cast<int>(fileData.size()), pWidth, pHeight, pChannels, STBI_rgb_alpha);
+		}, pTarget, width, height);
+}
+
+uint64_t FH::FHImageDecoder::GetCopiedBytes()
+{
+	return g_CopiedBytes;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace FH
+{
+	//RGBA8 texels of PNG and JPEG files through stb_image, flipped vertically like the textures expect. The caller
+	//owns the memory the texels go to, an upload hands it the mapped staging memory
+	class FHImageDecoder final
+	{
+	public:
+		//Throws when stb_image cannot read the file
+		static void GetSize(const std::string& filePath, uint32_t& width, uint32_t& height);
+		static void GetSize(std::span<const uint8_t> fileData, uint32_t& width, uint32_t& height);
+
+		//pTarget has room for width * height texels, the size GetSize returned. stb_image decodes into a buffer of
+		//its own, the texels are copied out of it once
+		static void Decode(const std::string& filePath, uint8_t* pTarget, uint32_t width, uint32_t height);
+		static void Decode(std::span<const uint8_t> fileData, uint8_t* pTarget, uint32_t width, uint32_t height);
+
+		//Texel bytes written to callers since startup, across all threads
+		static uint64_t GetCopiedBytes();
+
+		FHImageDecoder() = delete;
+	};
+}
\ No newline at end of file
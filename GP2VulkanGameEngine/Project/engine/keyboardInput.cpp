@@ -58,6 +58,14 @@ void FH::KeyboardInput::UpdateSceneInputs(GLFWwindow* window, FirstApp* app)
 	else if (glfwGetKey(window, m_Keys.toggleModelRotate) == GLFW_RELEASE && m_RotateButtonPressed)
 		m_RotateButtonPressed = false;
 
+	if (glfwGetKey(window, m_Keys.toggleDepthPrepass) == GLFW_PRESS && !m_PrepassButtonPressed)
+	{
+		app->ToggleDepthPrepass();
+		m_PrepassButtonPressed = true;
+	}
+	else if (glfwGetKey(window, m_Keys.toggleDepthPrepass) == GLFW_RELEASE && m_PrepassButtonPressed)
+		m_PrepassButtonPressed = false;
+
 	if (glfwGetKey(window, m_Keys.cycleModelLeft) == GLFW_PRESS && !m_LeftButtonPressed)
 	{
 		app->CycleModelLeft();
@@ -20,6 +20,7 @@ namespace FH
 			int moveDown{ GLFW_KEY_Q };
 
 			int toggleModelRotate{GLFW_KEY_F5};
+			int toggleDepthPrepass{GLFW_KEY_F6};
 			int cycleModelLeft{GLFW_KEY_LEFT};
 			int cycleModelRight{GLFW_KEY_RIGHT};
 		};
@@ -36,6 +37,7 @@ namespace FH
 		double m_PreviousXPos{}, m_PreviousYPos{};
 
 		bool m_RotateButtonPressed{};
+		bool m_PrepassButtonPressed{};
 		bool m_LeftButtonPressed{};
 		bool m_RightButtonPressed{};
 	};
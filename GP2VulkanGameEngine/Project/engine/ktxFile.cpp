@@ -0,0 +1,263 @@
+#include "ktxFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+	constexpr uint8_t KTX2_IDENTIFIER[12]{ 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct KtxHeader
+	{
+		uint8_t identifier[12]{};
+		uint32_t vkFormat{};
+		uint32_t typeSize{};
+		uint32_t pixelWidth{};
+		uint32_t pixelHeight{};
+		uint32_t pixelDepth{};
+		uint32_t layerCount{};
+		uint32_t faceCount{};
+		uint32_t levelCount{};
+		uint32_t supercompressionScheme{};
+
+		uint32_t dfdByteOffset{};
+		uint32_t dfdByteLength{};
+		uint32_t kvdByteOffset{};
+		uint32_t kvdByteLength{};
+		uint64_t sgdByteOffset{};
+		uint64_t sgdByteLength{};
+	};
+	static_assert(sizeof(KtxHeader) == 80, "KTX2 header layout");
+
+	struct KtxLevelIndex
+	{
+		uint64_t byteOffset{};
+		uint64_t byteLength{};
+		uint64_t uncompressedByteLength{};
+	};
+	static_assert(sizeof(KtxLevelIndex) == 24, "KTX2 level index layout");
+
+	//Khronos data format descriptor values for the basic descriptor block
+	constexpr uint32_t KHR_DF_MODEL_BC1A{ 128 };
+	constexpr uint32_t KHR_DF_MODEL_BC4{ 131 };
+	constexpr uint32_t KHR_DF_MODEL_BC5{ 132 };
+	constexpr uint32_t KHR_DF_MODEL_BC7{ 134 };
+	constexpr uint32_t KHR_DF_PRIMARIES_BT709{ 1 };
+	constexpr uint32_t KHR_DF_TRANSFER_LINEAR{ 1 };
+	constexpr uint32_t KHR_DF_TRANSFER_SRGB{ 2 };
+
+	bool IsSrgb(VkFormat format)
+	{
+		return format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+			format == VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	//One basic descriptor block, a sample per channel of the block
+	std::vector<uint32_t> CreateDataFormatDescriptor(VkFormat format)
+	{
+		struct Sample
+		{
+			uint32_t channel{};
+			uint32_t bitOffset{};
+			uint32_t bitLength{};
+		};
+
+		uint32_t model{};
+		std::vector<Sample> samples{};
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC1A;
+			samples.push_back({ 0, 0, 64 });
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC1A;
+			samples.push_back({ 1, 0, 64 });
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			model = KHR_DF_MODEL_BC4;
+			samples.push_back({ 0, 0, 64 });
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			model = KHR_DF_MODEL_BC5;
+			samples.push_back({ 0, 0, 64 });
+			samples.push_back({ 1, 64, 64 });
+			break;
+		default:
+			model = KHR_DF_MODEL_BC7;
+			samples.push_back({ 0, 0, 128 });
+			break;
+		}
+
+		const uint32_t blockSize{ 24 + 16 * static_cast<uint32_t>(samples.size()) };
+		std::vector<uint32_t> words{};
+		words.push_back(4 + blockSize);	//total size
+		words.push_back(0);				//vendor Khronos, basic descriptor type
+		words.push_back(2 | (blockSize << 16));
+		words.push_back(model | (KHR_DF_PRIMARIES_BT709 << 8) |
+			((IsSrgb(format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16));
+		words.push_back(3 | (3 << 8));	//4x4x1x1 texel blocks
+		words.push_back(FH::FHKtxFile::GetBlockSize(format));
+		words.push_back(0);
+
+		for (const Sample& sample : samples)
+		{
+			words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(UINT32_MAX);
+		}
+		return words;
+	}
+}
+
+FH::FHKtxFile::FHKtxFile(const std::string& filePath)
+	: m_File{ filePath }
+{
+	if (!m_File.IsOpen())
+		return;
+
+	KtxHeader header{};
+	if (m_File.GetSize() < sizeof(header))
+		throw std::runtime_error("failed to read ktx2 header: " + filePath);
+	std::memcpy(&header, m_File.GetData(), sizeof(header));
+
+	if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		throw std::runtime_error("failed to read ktx2 file, bad identifier: " + filePath);
+
+	m_Format = static_cast<VkFormat>(header.vkFormat);
+	if (GetBlockSize(m_Format) == 0 || header.supercompressionScheme != 0)
+		throw std::runtime_error("failed to read ktx2 file, only uncompressed BC1/BC4/BC5/BC7 is supported: " + filePath);
+
+	if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 ||
+		header.layerCount > 1 || header.faceCount != 1 || header.levelCount == 0)
+		throw std::runtime_error("failed to read ktx2 file, only single 2D images with stored mips are supported: " + filePath);
+
+	const size_t indexEnd{ sizeof(header) + header.levelCount * sizeof(KtxLevelIndex) };
+	if (indexEnd > m_File.GetSize())
+		throw std::runtime_error("failed to read ktx2 level index: " + filePath);
+
+	m_Width = header.pixelWidth;
+	m_Height = header.pixelHeight;
+	m_Levels.reserve(header.levelCount);
+
+	for (uint32_t level = 0; level < header.levelCount; ++level)
+	{
+		KtxLevelIndex index{};
+		std::memcpy(&index, m_File.GetData() + sizeof(header) + level * sizeof(KtxLevelIndex), sizeof(index));
+
+		const uint32_t width{ std::max(m_Width >> level, 1u) };
+		const uint32_t height{ std::max(m_Height >> level, 1u) };
+		if (index.byteLength != GetLevelSize(m_Format, width, height) ||
+			index.byteOffset > m_File.GetSize() || index.byteLength > m_File.GetSize() - index.byteOffset)
+			throw std::runtime_error("failed to read ktx2 file, level " + std::to_string(level) + " is out of range: " + filePath);
+
+		m_Levels.push_back({ { m_File.GetData() + index.byteOffset, static_cast<size_t>(index.byteLength) }, width, height });
+	}
+}
+
+bool FH::FHKtxFile::Write(const std::string& filePath, VkFormat format, uint32_t width, uint32_t height,
+	const std::vector<std::vector<uint8_t>>& levels)
+{
+	const uint32_t blockSize{ GetBlockSize(format) };
+	if (blockSize == 0 || levels.empty())
+		return false;
+
+	const std::vector<uint32_t> dfd{ CreateDataFormatDescriptor(format) };
+
+	KtxHeader header{};
+	std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	header.vkFormat = static_cast<uint32_t>(format);
+	header.typeSize = 1;
+	header.pixelWidth = width;
+	header.pixelHeight = height;
+	header.faceCount = 1;
+	header.levelCount = static_cast<uint32_t>(levels.size());
+	header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levels.size() * sizeof(KtxLevelIndex));
+	header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+	//Level data is stored smallest first, every level aligned to the block size
+	std::vector<KtxLevelIndex> indices(levels.size());
+	uint64_t dataOffset{ header.dfdByteOffset + header.dfdByteLength };
+	for (size_t level = levels.size(); level-- > 0;)
+	{
+		dataOffset = (dataOffset + blockSize - 1) / blockSize * blockSize;
+		indices[level].byteOffset = dataOffset;
+		indices[level].byteLength = levels[level].size();
+		indices[level].uncompressedByteLength = levels[level].size();
+		dataOffset += levels[level].size();
+	}
+
+	//Write to a temporary file first so a crash never leaves a half written texture behind
+	const std::string tempPath{ filePath + ".tmp" };
+	{
+		std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			std::cerr << "failed to write ktx2 file: " << filePath << std::endl;
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(KtxLevelIndex)));
+		file.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+
+		const char padding[16]{};
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			file.write(padding, static_cast<std::streamsize>(indices[level].byteOffset - file.tellp()));
+			file.write(reinterpret_cast<const char*>(levels[level].data()), static_cast<std::streamsize>(levels[level].size()));
+		}
+
+		if (!file.good())
+		{
+			std::cerr << "failed to write ktx2 file: " << filePath << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(tempPath, filePath, error);
+	if (error)
+	{
+		std::cerr << "failed to write ktx2 file: " << filePath << " (" << error.message() << ")" << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+std::string FH::FHKtxFile::GetKtxPath(const std::string& imagePath)
+{
+	return std::filesystem::path{ imagePath }.replace_extension(".ktx2").string();
+}
+
+uint32_t FH::FHKtxFile::GetBlockSize(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+		return 8;
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+VkDeviceSize FH::FHKtxFile::GetLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+	return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
\ No newline at end of file
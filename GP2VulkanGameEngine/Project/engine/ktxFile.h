@@ -0,0 +1,54 @@
+#pragma once
+#include "mappedFile.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace FH
+{
+	//KTX 2.0 container with block compressed BC1/BC4/BC5/BC7 levels and no supercompression. The file stays
+	//mapped and the levels are viewed in place, they are uploaded as they are stored.
+	class FHKtxFile final
+	{
+	public:
+		struct Level
+		{
+			std::span<const uint8_t> data{};
+			uint32_t width{};
+			uint32_t height{};
+		};
+
+		//IsOpen() is false when the file does not exist, a malformed file throws
+		explicit FHKtxFile(const std::string& filePath);
+
+		bool IsOpen() const { return m_File.IsOpen(); }
+
+		VkFormat GetFormat() const { return m_Format; }
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		std::span<const Level> GetLevels() const { return m_Levels; }
+
+		//Levels are ordered from full size down, each holding exactly the blocks of its size
+		static bool Write(const std::string& filePath, VkFormat format, uint32_t width, uint32_t height,
+			const std::vector<std::vector<uint8_t>>& levels);
+
+		//Same path with a .ktx2 extension
+		static std::string GetKtxPath(const std::string& imagePath);
+
+		//Bytes per 4x4 block, 0 for formats the container does not support
+		static uint32_t GetBlockSize(VkFormat format);
+		static VkDeviceSize GetLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+	private:
+		FHMappedFile m_File;
+
+		VkFormat m_Format{ VK_FORMAT_UNDEFINED };
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		std::vector<Level> m_Levels{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "mappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FH::FHMappedFile::FHMappedFile(const std::string& filePath)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	m_FileHandle = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return;
+	}
+	m_MappingHandle = mapping;
+
+	m_pData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_pData == nullptr)
+	{
+		Close();
+		return;
+	}
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	m_FileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (m_FileDescriptor < 0)
+		return;
+
+	struct stat fileStat {};
+	if (fstat(m_FileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		Close();
+		return;
+	}
+
+	void* pMapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+	if (pMapped == MAP_FAILED)
+	{
+		Close();
+		return;
+	}
+
+	m_pData = static_cast<const uint8_t*>(pMapped);
+	m_Size = static_cast<size_t>(fileStat.st_size);
+	madvise(pMapped, m_Size, MADV_SEQUENTIAL);
+#endif
+}
+
+FH::FHMappedFile::~FHMappedFile()
+{
+	Close();
+}
+
+FH::FHMappedFile::FHMappedFile(FHMappedFile&& other) noexcept
+	: m_pData{ std::exchange(other.m_pData, nullptr) }
+	, m_Size{ std::exchange(other.m_Size, 0) }
+#ifdef _WIN32
+	, m_FileHandle{ std::exchange(other.m_FileHandle, nullptr) }
+	, m_MappingHandle{ std::exchange(other.m_MappingHandle, nullptr) }
+#else
+	, m_FileDescriptor{ std::exchange(other.m_FileDescriptor, -1) }
+#endif
+{}
+
+FH::FHMappedFile& FH::FHMappedFile::operator=(FHMappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		m_pData = std::exchange(other.m_pData, nullptr);
+		m_Size = std::exchange(other.m_Size, 0);
+#ifdef _WIN32
+		m_FileHandle = std::exchange(other.m_FileHandle, nullptr);
+		m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+#else
+		m_FileDescriptor = std::exchange(other.m_FileDescriptor, -1);
+#endif
+	}
+	return *this;
+}
+
+void FH::FHMappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_MappingHandle)
+		CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+	if (m_FileHandle)
+		CloseHandle(static_cast<HANDLE>(m_FileHandle));
+	m_MappingHandle = nullptr;
+	m_FileHandle = nullptr;
+#else
+	if (m_pData)
+		munmap(const_cast<uint8_t*>(m_pData), m_Size);
+	if (m_FileDescriptor >= 0)
+		close(m_FileDescriptor);
+	m_FileDescriptor = -1;
+#endif
+	m_pData = nullptr;
+	m_Size = 0;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace FH
+{
+	//Read-only mapping of a whole file, IsOpen() is false when the file could not be mapped
+	class FHMappedFile
+	{
+	public:
+		FHMappedFile() = default;
+		explicit FHMappedFile(const std::string& filePath);
+		~FHMappedFile();
+
+		FHMappedFile(const FHMappedFile&) = delete;
+		FHMappedFile& operator=(const FHMappedFile&) = delete;
+		FHMappedFile(FHMappedFile&& other) noexcept;
+		FHMappedFile& operator=(FHMappedFile&& other) noexcept;
+
+		bool IsOpen() const { return m_pData != nullptr; }
+		const uint8_t* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		void Close();
+
+		const uint8_t* m_pData{};
+		size_t m_Size{};
+
+#ifdef _WIN32
+		void* m_FileHandle{};
+		void* m_MappingHandle{};
+#else
+		int m_FileDescriptor{ -1 };
+#endif
+	};
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+namespace FH
+{
+	//Texture paths relative to resources/ for the slots an FHGameObject samples, empty slots get a placeholder
+	struct FHMaterialPaths
+	{
+		std::string diffuse{};
+		std::string normal{};
+		std::string roughness{};
+		std::string specular{};
+		std::string ao{};
+
+		bool operator==(const FHMaterialPaths& other) const = default;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "mergedMesh.h"
+
+#include <algorithm>
+#include <limits>
+
+void FH::FHMergedMesh::Append(const FHModel::ModelData& source, const glm::mat4& modelMatrix, const glm::mat3& normalMatrix,
+	uint32_t objectId)
+{
+	const glm::mat3 tangentMatrix{ modelMatrix };
+	const bool isMirrored{ glm::determinant(tangentMatrix) < 0.f };
+
+	const uint32_t baseVertex{ static_cast<uint32_t>(data.vertices.size()) };
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (const FHModel::Vertex& sourceVertex : source.vertices)
+	{
+		FHModel::Vertex vertex{ sourceVertex };
+		vertex.pos = glm::vec3{ modelMatrix * glm::vec4{ sourceVertex.pos, 1.f } };
+		vertex.normal = glm::normalize(normalMatrix * sourceVertex.normal);
+		vertex.tangent = glm::vec4{ glm::normalize(tangentMatrix * glm::vec3{ sourceVertex.tangent }),
+			isMirrored ? -sourceVertex.tangent.w : sourceVertex.tangent.w };
+		data.vertices.push_back(vertex);
+
+		boundsMin = glm::min(boundsMin, vertex.pos);
+		boundsMax = glm::max(boundsMax, vertex.pos);
+	}
+
+	const uint32_t firstIndex{ source.lods.empty() ? 0 : source.lods.front().firstIndex };
+	const uint32_t indexCount{ source.lods.empty() ? static_cast<uint32_t>(source.indices.size()) : source.lods.front().indexCount };
+
+	FHModel::SubMesh subMesh{};
+	subMesh.objectId = objectId;
+	subMesh.firstIndex = static_cast<uint32_t>(data.indices.size());
+	subMesh.indexCount = indexCount;
+
+	for (uint32_t idx = firstIndex; idx < firstIndex + indexCount; idx += 3)
+	{
+		data.indices.push_back(baseVertex + source.indices[idx]);
+		data.indices.push_back(baseVertex + source.indices[idx + (isMirrored ? 2 : 1)]);
+		data.indices.push_back(baseVertex + source.indices[idx + (isMirrored ? 1 : 2)]);
+	}
+
+	const glm::vec3 center{ (boundsMin + boundsMax) * 0.5f };
+	float radius{};
+	for (size_t vertexIdx = baseVertex; vertexIdx < data.vertices.size(); ++vertexIdx)
+		radius = std::max(radius, glm::distance(center, data.vertices[vertexIdx].pos));
+	subMesh.boundingSphere = glm::vec4{ center, radius };
+
+	subMeshes.push_back(subMesh);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#include "model.h"
+
+#include <vector>
+
+namespace FH
+{
+	//Meshes pre-transformed into one vertex and index list, the CPU side of FHStaticBatcher. Every source
+	//keeps its index range as an FHModel::SubMesh
+	struct FHMergedMesh
+	{
+		FHModel::ModelData data{};
+		std::vector<FHModel::SubMesh> subMeshes{};
+
+		//Only LOD 0 of the source is merged. Mirroring transforms flip the winding and the handedness of the tangent frame,
+		//both are flipped back so the merged triangles face the way the source did
+		void Append(const FHModel::ModelData& source, const glm::mat4& modelMatrix, const glm::mat3& normalMatrix, uint32_t objectId);
+	};
+}
\ No newline at end of file
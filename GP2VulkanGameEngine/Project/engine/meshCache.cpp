@@ -0,0 +1,215 @@
+#include "meshCache.h"
+#include "utils.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+
+FH::FHMeshCache::FHMeshCache(const std::string& cachePath)
+	: m_File{ cachePath }
+{}
+
+bool FH::FHMeshCache::IsCurrent(const FHSourceStamp& sourceStamp, uint32_t flags) const
+{
+	return HasValidLayout(flags) && GetHeader().sourceSize == sourceStamp.size &&
+		GetHeader().sourceWriteTime == sourceStamp.writeTime;
+}
+
+bool FH::FHMeshCache::IsValid(uint64_t sourceHash, uint64_t sourceSize, uint32_t flags) const
+{
+	return HasValidLayout(flags) && GetHeader().sourceHash == sourceHash && GetHeader().sourceSize == sourceSize;
+}
+
+bool FH::FHMeshCache::GetSourceHash(const FHSourceStamp& sourceStamp, uint64_t& sourceHash) const
+{
+	if (!m_File.IsOpen() || m_File.GetSize() < sizeof(FHMeshCacheHeader))
+		return false;
+
+	const FHMeshCacheHeader& header{ GetHeader() };
+	if (header.magic != FHMeshCacheHeader::MAGIC || header.version != FHMeshCacheHeader::VERSION ||
+		header.sourceSize != sourceStamp.size || header.sourceWriteTime != sourceStamp.writeTime)
+		return false;
+
+	sourceHash = header.sourceHash;
+	return true;
+}
+
+bool FH::FHMeshCache::HasValidLayout(uint32_t flags) const
+{
+	if (!m_File.IsOpen() || m_File.GetSize() < sizeof(FHMeshCacheHeader))
+		return false;
+
+	const FHMeshCacheHeader& header{ GetHeader() };
+	if (header.magic != FHMeshCacheHeader::MAGIC || header.version != FHMeshCacheHeader::VERSION)
+		return false;
+
+	if (header.vertexStride != sizeof(FHModel::Vertex) || header.flags != flags)
+		return false;
+
+	const uint64_t expectedSize{ sizeof(FHMeshCacheHeader)
+		+ static_cast<uint64_t>(header.vertexCount) * header.vertexStride
+		+ static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t)
+		+ static_cast<uint64_t>(header.meshletCount) * sizeof(FHMeshlet)
+		+ static_cast<uint64_t>(header.lodCount) * sizeof(FHModel::Lod) };
+
+	return m_File.GetSize() == expectedSize;
+}
+
+const FH::FHMeshCacheHeader& FH::FHMeshCache::GetHeader() const
+{
+	return *reinterpret_cast<const FHMeshCacheHeader*>(m_File.GetData());
+}
+
+std::span<const FH::FHModel::Vertex> FH::FHMeshCache::GetVertices() const
+{
+	const uint8_t* pVertices{ m_File.GetData() + sizeof(FHMeshCacheHeader) };
+	return { reinterpret_cast<const FHModel::Vertex*>(pVertices), GetHeader().vertexCount };
+}
+
+std::span<const uint32_t> FH::FHMeshCache::GetIndices() const
+{
+	const FHMeshCacheHeader& header{ GetHeader() };
+	const uint8_t* pIndices{ m_File.GetData() + sizeof(FHMeshCacheHeader)
+		+ static_cast<size_t>(header.vertexCount) * header.vertexStride };
+	return { reinterpret_cast<const uint32_t*>(pIndices), header.indexCount };
+}
+
+std::span<const FH::FHMeshlet> FH::FHMeshCache::GetMeshlets() const
+{
+	const FHMeshCacheHeader& header{ GetHeader() };
+	const uint8_t* pMeshlets{ m_File.GetData() + sizeof(FHMeshCacheHeader)
+		+ static_cast<size_t>(header.vertexCount) * header.vertexStride
+		+ static_cast<size_t>(header.indexCount) * sizeof(uint32_t) };
+	return { reinterpret_cast<const FHMeshlet*>(pMeshlets), header.meshletCount };
+}
+
+std::span<const FH::FHModel::Lod> FH::FHMeshCache::GetLods() const
+{
+	const FHMeshCacheHeader& header{ GetHeader() };
+	const uint8_t* pLods{ m_File.GetData() + sizeof(FHMeshCacheHeader)
+		+ static_cast<size_t>(header.vertexCount) * header.vertexStride
+		+ static_cast<size_t>(header.indexCount) * sizeof(uint32_t)
+		+ static_cast<size_t>(header.meshletCount) * sizeof(FHMeshlet) };
+	return { reinterpret_cast<const FHModel::Lod*>(pLods), header.lodCount };
+}
+
+std::string FH::FHMeshCache::GetCachePath(const std::string& sourcePath, uint32_t flags)
+{
+	return std::filesystem::path{ sourcePath }.replace_extension("." + std::to_string(flags) + ".fhmesh").string();
+}
+
+uint32_t FH::FHMeshCache::GetFlags(const FHModelLoadOptions& options)
+{
+	uint32_t flags{};
+	if (options.optimize)
+		flags |= FHMeshCacheHeader::FLAG_OPTIMIZED;
+	if (options.buildMeshlets)
+		flags |= FHMeshCacheHeader::FLAG_MESHLETS;
+	if (options.generateLods)
+		flags |= FHMeshCacheHeader::FLAG_LODS;
+	return flags;
+}
+
+bool FH::FHMeshCache::StampSourceFile(const std::string& sourcePath, FHSourceStamp& stamp)
+{
+	std::error_code error{};
+	const uintmax_t size{ std::filesystem::file_size(sourcePath, error) };
+	if (error)
+		return false;
+
+	const std::filesystem::file_time_type writeTime{ std::filesystem::last_write_time(sourcePath, error) };
+	if (error)
+		return false;
+
+	stamp.size = size;
+	stamp.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+	return true;
+}
+
+bool FH::FHMeshCache::HashSourceFile(const std::string& sourcePath, uint64_t& hash, uint64_t& size)
+{
+	FHMappedFile source{ sourcePath };
+	if (!source.IsOpen())
+		return false;
+
+	hash = HashBytes(source.GetData(), source.GetSize());
+	size = source.GetSize();
+	return true;
+}
+
+bool FH::FHMeshCache::Write(const std::string& cachePath, const FHModel::ModelData& data,
+	uint64_t sourceHash, const FHSourceStamp& sourceStamp, uint32_t flags)
+{
+	FHMeshCacheHeader header{};
+	header.vertexStride = sizeof(FHModel::Vertex);
+	header.vertexCount = static_cast<uint32_t>(data.vertices.size());
+	header.indexCount = static_cast<uint32_t>(data.indices.size());
+	header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+	header.lodCount = static_cast<uint32_t>(data.lods.size());
+	header.flags = flags;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceStamp.size;
+	header.sourceWriteTime = sourceStamp.writeTime;
+
+	header.boundsMin = glm::vec3{ std::numeric_limits<float>::max() };
+	header.boundsMax = glm::vec3{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : data.vertices)
+	{
+		header.boundsMin = glm::min(header.boundsMin, vertex.pos);
+		header.boundsMax = glm::max(header.boundsMax, vertex.pos);
+	}
+
+	//Write to a temporary file first so a crash never leaves a half written cache behind
+	const std::string tempPath{ cachePath + ".tmp" };
+	{
+		std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			std::cerr << "failed to write mesh cache: " << cachePath << std::endl;
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(data.vertices.data()),
+			static_cast<std::streamsize>(data.vertices.size() * sizeof(FHModel::Vertex)));
+		file.write(reinterpret_cast<const char*>(data.indices.data()),
+			static_cast<std::streamsize>(data.indices.size() * sizeof(uint32_t)));
+		file.write(reinterpret_cast<const char*>(data.meshlets.data()),
+			static_cast<std::streamsize>(data.meshlets.size() * sizeof(FHMeshlet)));
+		file.write(reinterpret_cast<const char*>(data.lods.data()),
+			static_cast<std::streamsize>(data.lods.size() * sizeof(FHModel::Lod)));
+
+		if (!file.good())
+		{
+			std::cerr << "failed to write mesh cache: " << cachePath << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::cerr << "failed to write mesh cache: " << cachePath << " (" << error.message() << ")" << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool FH::FHMeshCache::Restamp(const std::string& cachePath, const FHSourceStamp& sourceStamp)
+{
+	//Only the stamp changes, in place. An interrupted write leaves a stamp that fails IsCurrent, the hash check still passes
+	std::fstream file{ cachePath, std::ios::binary | std::ios::in | std::ios::out };
+	if (!file.is_open())
+		return false;
+
+	file.seekp(offsetof(FHMeshCacheHeader, sourceSize));
+	file.write(reinterpret_cast<const char*>(&sourceStamp.size), sizeof(sourceStamp.size));
+	file.seekp(offsetof(FHMeshCacheHeader, sourceWriteTime));
+	file.write(reinterpret_cast<const char*>(&sourceStamp.writeTime), sizeof(sourceStamp.writeTime));
+	return file.good();
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include "model.h"
+#include "mappedFile.h"
+
+#include <span>
+#include <string>
+
+namespace FH
+{
+	//Size and last write time of a source file. A cache stamped with the same is current without hashing the source
+	struct FHSourceStamp
+	{
+		uint64_t size{};
+		int64_t writeTime{};
+
+		bool operator==(const FHSourceStamp& other) const = default;
+	};
+
+	//Content hash of a source file and the stamp it was taken at, lets a caller that already hashed the file skip reading it again
+	struct FHSourceHash
+	{
+		FHSourceStamp stamp{};
+		uint64_t hash{};
+	};
+
+	//Binary .fhmesh file holding the final vertex and index arrays of a model
+	//Layout: FHMeshCacheHeader | Vertex[vertexCount] | uint32_t[indexCount] | FHMeshlet[meshletCount] | Lod[lodCount]
+	struct FHMeshCacheHeader
+	{
+		static constexpr uint32_t MAGIC{ 0x534D4846 }; //"FHMS"
+		static constexpr uint32_t VERSION{ 5 };
+
+		//flags
+		static constexpr uint32_t FLAG_OPTIMIZED{ 1 << 0 };
+		static constexpr uint32_t FLAG_MESHLETS{ 1 << 1 };
+		static constexpr uint32_t FLAG_LODS{ 1 << 2 };
+
+		uint32_t magic{ MAGIC };
+		uint32_t version{ VERSION };
+		uint32_t vertexStride{};
+		uint32_t vertexCount{};
+		uint32_t indexCount{};
+		uint32_t flags{};
+		uint64_t sourceHash{};
+		uint64_t sourceSize{};
+		glm::vec3 boundsMin{};
+		glm::vec3 boundsMax{};
+		uint32_t meshletCount{};
+		uint32_t lodCount{};
+		int64_t sourceWriteTime{};
+	};
+	static_assert(sizeof(FHMeshCacheHeader) == 80, "Mesh cache header layout changed, bump the version");
+
+	class FHMeshCache
+	{
+	public:
+		//Maps an existing cache file, use IsValid to check it against the current source
+		explicit FHMeshCache(const std::string& cachePath);
+		~FHMeshCache() = default;
+
+		FHMeshCache(const FHMeshCache&) = delete;
+		FHMeshCache& operator=(const FHMeshCache&) = delete;
+
+		//Stamp check only, the source is not read. A touched source with the same content fails it but passes IsValid
+		bool IsCurrent(const FHSourceStamp& sourceStamp, uint32_t flags) const;
+		bool IsValid(uint64_t sourceHash, uint64_t sourceSize, uint32_t flags) const;
+		//Hash of the source the cache was written for, whatever its flags, as long as the source still has the same stamp
+		bool GetSourceHash(const FHSourceStamp& sourceStamp, uint64_t& sourceHash) const;
+
+		const FHMeshCacheHeader& GetHeader() const;
+		std::span<const FHModel::Vertex> GetVertices() const;
+		std::span<const uint32_t> GetIndices() const;
+		std::span<const FHMeshlet> GetMeshlets() const;
+		std::span<const FHModel::Lod> GetLods() const;
+
+		//Every set of import flags gets its own file, so loading a model with other settings does not overwrite the cache
+		static std::string GetCachePath(const std::string& sourcePath, uint32_t flags);
+		static uint32_t GetFlags(const FHModelLoadOptions& options);
+
+		//Both return false when the source file could not be read
+		static bool StampSourceFile(const std::string& sourcePath, FHSourceStamp& stamp);
+		static bool HashSourceFile(const std::string& sourcePath, uint64_t& hash, uint64_t& size);
+
+		//Failing to write a cache is not fatal, the model is simply parsed again next run
+		static bool Write(const std::string& cachePath, const FHModel::ModelData& data,
+			uint64_t sourceHash, const FHSourceStamp& sourceStamp, uint32_t flags);
+		//Moves a cache to the stamp of a touched source whose hash still matches, so later runs skip hashing it again.
+		//The cache must not be mapped while this runs
+		static bool Restamp(const std::string& cachePath, const FHSourceStamp& sourceStamp);
+
+	private:
+		bool HasValidLayout(uint32_t flags) const;
+
+		FHMappedFile m_File;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,398 @@
+#include "meshOptimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+	constexpr uint32_t INVALID_INDEX{ std::numeric_limits<uint32_t>::max() };
+
+	//FIFO cache simulated with timestamps, a vertex is cached while fewer than CACHE_SIZE
+	//misses happened since it was last loaded
+	class FifoCache final
+	{
+	public:
+		explicit FifoCache(size_t vertexCount)
+			: m_Timestamps(vertexCount, 0)
+		{}
+
+		//Returns true on a miss
+		bool Touch(uint32_t vertex)
+		{
+			if (m_Time - m_Timestamps[vertex] > FH::FHMeshOptimizer::CACHE_SIZE)
+			{
+				m_Timestamps[vertex] = m_Time++;
+				return true;
+			}
+			return false;
+		}
+
+		uint32_t TouchTriangle(const uint32_t* pTriangle)
+		{
+			return Touch(pTriangle[0]) + Touch(pTriangle[1]) + Touch(pTriangle[2]);
+		}
+
+		void Flush() { m_Time += FH::FHMeshOptimizer::CACHE_SIZE + 1; }
+
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_Time{ FH::FHMeshOptimizer::CACHE_SIZE + 1 };
+	};
+
+	//Twice the signed area of abc, positive when counter clockwise
+	inline float Edge(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+}
+
+void FH::FHMeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& clusters)
+{
+	clusters.clear();
+
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0)
+		return;
+
+	//Vertex -> triangle adjacency
+	std::vector<uint32_t> liveCount(vertexCount, 0);
+	for (uint32_t index : indices)
+		++liveCount[index];
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	std::inclusive_scan(liveCount.begin(), liveCount.end(), offsets.begin() + 1);
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t idx = 0; idx < indices.size(); ++idx)
+			adjacency[fill[indices[idx]]++] = static_cast<uint32_t>(idx / 3);
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time{ CACHE_SIZE + 1 };
+
+	std::vector<uint32_t> deadEnds{};
+	deadEnds.reserve(indices.size());
+
+	std::vector<uint32_t> candidates{};
+	std::vector<bool> isEmitted(triangleCount, false);
+
+	std::vector<uint32_t> output{};
+	output.reserve(indices.size());
+
+	size_t cursor{};
+	auto SkipDeadEnd = [&]() -> uint32_t
+		{
+			while (!deadEnds.empty())
+			{
+				const uint32_t vertex{ deadEnds.back() };
+				deadEnds.pop_back();
+				if (liveCount[vertex] > 0)
+					return vertex;
+			}
+			for (; cursor < vertexCount; ++cursor)
+				if (liveCount[cursor] > 0)
+					return static_cast<uint32_t>(cursor);
+			return INVALID_INDEX;
+		};
+
+	uint32_t fanning{ SkipDeadEnd() };
+	clusters.push_back(0);
+
+	while (fanning != INVALID_INDEX)
+	{
+		//Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (uint32_t adjacencyIdx = offsets[fanning]; adjacencyIdx < offsets[fanning + 1]; ++adjacencyIdx)
+		{
+			const uint32_t triangle{ adjacency[adjacencyIdx] };
+			if (isEmitted[triangle])
+				continue;
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t vertex{ indices[triangle * 3 + corner] };
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveCount[vertex];
+
+				if (time - timestamps[vertex] > CACHE_SIZE)
+					timestamps[vertex] = time++;
+			}
+			isEmitted[triangle] = true;
+		}
+
+		//Next fanning vertex: the oldest candidate that will still be cached after its fan
+		uint32_t next{ INVALID_INDEX };
+		int64_t bestPriority{ -1 };
+		for (uint32_t vertex : candidates)
+		{
+			if (liveCount[vertex] == 0)
+				continue;
+
+			int64_t priority{ 0 };
+			if (time - timestamps[vertex] + 2 * liveCount[vertex] <= CACHE_SIZE)
+				priority = time - timestamps[vertex];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		if (next == INVALID_INDEX)
+		{
+			next = SkipDeadEnd();
+			if (next != INVALID_INDEX)
+				clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+		}
+
+		fanning = next;
+	}
+
+	indices = std::move(output);
+}
+
+void FH::FHMeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, std::span<const glm::vec3> positions,
+	std::span<const uint32_t> clusters, float threshold)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0)
+		return;
+
+	std::vector<uint32_t> hardBoundaries(clusters.begin(), clusters.end());
+	if (hardBoundaries.empty() || hardBoundaries.front() != 0)
+		hardBoundaries.insert(hardBoundaries.begin(), 0);
+	hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+	//Soft boundaries: split a cluster as soon as the cache restarted at that point would
+	//still perform within threshold of the whole cluster
+	FifoCache cache{ positions.size() };
+	std::vector<uint32_t> boundaries{};
+	for (size_t clusterIdx = 0; clusterIdx + 1 < hardBoundaries.size(); ++clusterIdx)
+	{
+		const uint32_t begin{ hardBoundaries[clusterIdx] };
+		const uint32_t end{ hardBoundaries[clusterIdx + 1] };
+		if (begin == end)
+			continue;
+
+		cache.Flush();
+		uint32_t clusterMisses{};
+		for (uint32_t triangle = begin; triangle < end; ++triangle)
+			clusterMisses += cache.TouchTriangle(&indices[triangle * 3]);
+
+		const float clusterThreshold{ threshold * clusterMisses / (end - begin) };
+
+		cache.Flush();
+		boundaries.push_back(begin);
+
+		uint32_t runningMisses{};
+		uint32_t runningTriangles{};
+		for (uint32_t triangle = begin; triangle < end; ++triangle)
+		{
+			runningMisses += cache.TouchTriangle(&indices[triangle * 3]);
+			++runningTriangles;
+
+			if (triangle + 1 < end && runningMisses <= clusterThreshold * runningTriangles)
+			{
+				boundaries.push_back(triangle + 1);
+				cache.Flush();
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+	}
+	boundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+	//Area weighted centroid and normal per cluster
+	const size_t clusterCount{ boundaries.size() - 1 };
+	std::vector<glm::vec3> centroids(clusterCount, glm::vec3{ 0.f });
+	std::vector<glm::vec3> normals(clusterCount, glm::vec3{ 0.f });
+	glm::vec3 meshCentroid{ 0.f };
+	float meshArea{};
+
+	for (size_t clusterIdx = 0; clusterIdx < clusterCount; ++clusterIdx)
+	{
+		float clusterArea{};
+		for (uint32_t triangle = boundaries[clusterIdx]; triangle < boundaries[clusterIdx + 1]; ++triangle)
+		{
+			const glm::vec3& p0{ positions[indices[triangle * 3 + 0]] };
+			const glm::vec3& p1{ positions[indices[triangle * 3 + 1]] };
+			const glm::vec3& p2{ positions[indices[triangle * 3 + 2]] };
+
+			const glm::vec3 normal{ glm::cross(p1 - p0, p2 - p0) };
+			const float area{ glm::length(normal) };
+
+			centroids[clusterIdx] += (p0 + p1 + p2) * (area / 3.f);
+			normals[clusterIdx] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += centroids[clusterIdx];
+		meshArea += clusterArea;
+
+		if (clusterArea > 0.f)
+			centroids[clusterIdx] /= clusterArea;
+
+		const float normalLength{ glm::length(normals[clusterIdx]) };
+		if (normalLength > 0.f)
+			normals[clusterIdx] /= normalLength;
+	}
+	if (meshArea > 0.f)
+		meshCentroid /= meshArea;
+
+	//Clusters far out along their own normal occlude the rest, draw those first
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t clusterIdx = 0; clusterIdx < clusterCount; ++clusterIdx)
+		sortKeys[clusterIdx] = glm::dot(centroids[clusterIdx] - meshCentroid, normals[clusterIdx]);
+
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[&sortKeys](uint32_t lhs, uint32_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+	std::vector<uint32_t> output{};
+	output.reserve(indices.size());
+	for (uint32_t clusterIdx : order)
+		output.insert(output.end(), indices.begin() + boundaries[clusterIdx] * 3, indices.begin() + boundaries[clusterIdx + 1] * 3);
+
+	indices = std::move(output);
+}
+
+std::vector<uint32_t> FH::FHMeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+	uint32_t nextVertex{};
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == INVALID_INDEX)
+			remap[index] = nextVertex++;
+		index = remap[index];
+	}
+	return remap;
+}
+
+FH::FHMeshOptimizer::VertexCacheStats FH::FHMeshOptimizer::AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount)
+{
+	VertexCacheStats stats{};
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0)
+		return stats;
+
+	FifoCache cache{ vertexCount };
+	std::vector<bool> isUsed(vertexCount, false);
+	size_t misses{};
+	size_t usedVertices{};
+
+	for (uint32_t index : indices)
+	{
+		misses += cache.Touch(index);
+		if (!isUsed[index])
+		{
+			isUsed[index] = true;
+			++usedVertices;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / triangleCount;
+	stats.atvr = static_cast<float>(misses) / usedVertices;
+	return stats;
+}
+
+FH::FHMeshOptimizer::OverdrawStats FH::FHMeshOptimizer::AnalyzeOverdraw(std::span<const uint32_t> indices, std::span<const glm::vec3> positions)
+{
+	constexpr int GRID_SIZE{ 256 };
+
+	OverdrawStats stats{};
+	if (indices.size() < 3 || positions.empty())
+		return stats;
+
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (uint32_t index : indices)
+	{
+		boundsMin = glm::min(boundsMin, positions[index]);
+		boundsMax = glm::max(boundsMax, positions[index]);
+	}
+
+	const glm::vec3 extent{ boundsMax - boundsMin };
+	const float maxExtent{ std::max({ extent.x, extent.y, extent.z }) };
+	if (maxExtent <= 0.f)
+		return stats;
+	const float scale{ GRID_SIZE / maxExtent };
+
+	std::vector<float> depthBuffer(GRID_SIZE * GRID_SIZE);
+
+	for (int axis = 0; axis < 3; ++axis)
+		for (int direction = 0; direction < 2; ++direction)
+		{
+			std::fill(depthBuffer.begin(), depthBuffer.end(), std::numeric_limits<float>::max());
+			const float depthSign{ direction == 0 ? 1.f : -1.f };
+
+			for (size_t idx = 0; idx + 2 < indices.size(); idx += 3)
+			{
+				const glm::vec3& p0{ positions[indices[idx + 0]] };
+				const glm::vec3& p1{ positions[indices[idx + 1]] };
+				const glm::vec3& p2{ positions[indices[idx + 2]] };
+
+				//Back faces are culled, the view looks along +axis for direction 0 and -axis for 1
+				if (glm::cross(p1 - p0, p2 - p0)[axis] * depthSign >= 0.f)
+					continue;
+
+				glm::vec2 screen[3]{};
+				float depth[3]{};
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const glm::vec3 local{ (positions[indices[idx + corner]] - boundsMin) * scale };
+					screen[corner] = { local[(axis + 1) % 3], local[(axis + 2) % 3] };
+					depth[corner] = local[axis] * depthSign;
+				}
+
+				float area{ Edge(screen[0], screen[1], screen[2]) };
+				if (area == 0.f)
+					continue;
+				if (area < 0.f)
+				{
+					std::swap(screen[1], screen[2]);
+					std::swap(depth[1], depth[2]);
+					area = -area;
+				}
+
+				const int minX{ std::max(0, static_cast<int>(std::min({ screen[0].x, screen[1].x, screen[2].x }))) };
+				const int minY{ std::max(0, static_cast<int>(std::min({ screen[0].y, screen[1].y, screen[2].y }))) };
+				const int maxX{ std::min(GRID_SIZE - 1, static_cast<int>(std::max({ screen[0].x, screen[1].x, screen[2].x }))) };
+				const int maxY{ std::min(GRID_SIZE - 1, static_cast<int>(std::max({ screen[0].y, screen[1].y, screen[2].y }))) };
+
+				for (int y = minY; y <= maxY; ++y)
+					for (int x = minX; x <= maxX; ++x)
+					{
+						const glm::vec2 sample{ x + 0.5f, y + 0.5f };
+						const float w0{ Edge(screen[1], screen[2], sample) };
+						const float w1{ Edge(screen[2], screen[0], sample) };
+						const float w2{ Edge(screen[0], screen[1], sample) };
+						if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+							continue;
+
+						const float sampleDepth{ (w0 * depth[0] + w1 * depth[1] + w2 * depth[2]) / area };
+						float& storedDepth{ depthBuffer[y * GRID_SIZE + x] };
+						if (sampleDepth < storedDepth)
+						{
+							storedDepth = sampleDepth;
+							++stats.pixelsShaded;
+						}
+					}
+			}
+
+			stats.pixelsCovered += std::count_if(depthBuffer.begin(), depthBuffer.end(),
+				[](float depth) { return depth != std::numeric_limits<float>::max(); });
+		}
+
+	if (stats.pixelsCovered > 0)
+		stats.overdraw = static_cast<float>(stats.pixelsShaded) / stats.pixelsCovered;
+	return stats;
+}
\ No newline at end of file
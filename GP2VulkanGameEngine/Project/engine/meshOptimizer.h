@@ -0,0 +1,54 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FH
+{
+	//Index and vertex reordering passes for indexed triangle lists
+	class FHMeshOptimizer final
+	{
+	public:
+		//FIFO post-transform cache size used by the optimizer and the analyzer
+		static constexpr uint32_t CACHE_SIZE{ 16 };
+
+		struct VertexCacheStats
+		{
+			float acmr{};	//vertex transforms per triangle
+			float atvr{};	//vertex transforms per unique vertex
+		};
+
+		struct OverdrawStats
+		{
+			float overdraw{};	//shaded / covered pixels, 1.0 is optimal
+			uint64_t pixelsCovered{};
+			uint64_t pixelsShaded{};
+		};
+
+		//Tipsify (Sander et al. 2007). clusters receives the first triangle of every run that
+		//starts after a cache flush, these are the hard boundaries used by OptimizeOverdraw
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& clusters);
+
+		//Splits the clusters further where the cache stays within threshold of its current
+		//efficiency, then draws outward facing clusters on the outside of the mesh first
+		static void OptimizeOverdraw(std::vector<uint32_t>& indices, std::span<const glm::vec3> positions,
+			std::span<const uint32_t> clusters, float threshold = 1.05f);
+
+		//Renumbers vertices in first use order and rewrites the indices. Returns the new index
+		//of every old vertex, UINT32_MAX for vertices no triangle references
+		static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+		static VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount);
+
+		//Software rasterizes the mesh from the six axis directions with a depth test,
+		//culling back faces with counter clockwise front faces like OBJ files
+		static OverdrawStats AnalyzeOverdraw(std::span<const uint32_t> indices, std::span<const glm::vec3> positions);
+
+		FHMeshOptimizer() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,492 @@
+#include "meshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+	//Sum of squared distances to the planes of the faces around a vertex, area weighted
+	struct Quadric
+	{
+		double a00{}, a11{}, a22{}, a10{}, a20{}, a21{};
+		double b0{}, b1{}, b2{};
+		double c{};
+		double weight{};
+
+		//Plane dot(normal, p) + distance = 0, normal is unit length
+		void AddPlane(const glm::vec3& normal, float distance, float planeWeight)
+		{
+			const double x{ normal.x }, y{ normal.y }, z{ normal.z }, d{ distance }, w{ planeWeight };
+			a00 += w * x * x;
+			a11 += w * y * y;
+			a22 += w * z * z;
+			a10 += w * x * y;
+			a20 += w * x * z;
+			a21 += w * y * z;
+			b0 += w * x * d;
+			b1 += w * y * d;
+			b2 += w * z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		//Average squared distance of p to the planes
+		double Evaluate(const glm::vec3& p) const
+		{
+			if (weight == 0.0)
+				return 0.0;
+
+			const double x{ p.x }, y{ p.y }, z{ p.z };
+			const double error{
+				a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z)
+				+ c };
+			return std::max(error, 0.0) / weight;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a10 += other.a10; a20 += other.a20; a21 += other.a21;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+	};
+
+	constexpr uint32_t NO_VERTEX{ std::numeric_limits<uint32_t>::max() };
+
+	enum class VertexKind : uint8_t
+	{
+		Manifold,	//collapses onto any neighbour
+		Seam,		//one of two vertices sharing a position, collapses along the seam together with the other
+		Locked		//on a border or where more than two vertices share a position
+	};
+
+	//A seam collapse also moves the other vertex at the position of from onto its partner at the position of to
+	struct Collapse
+	{
+		uint32_t from{};
+		uint32_t to{};
+		uint32_t seamFrom{ NO_VERTEX };
+		uint32_t seamTo{ NO_VERTEX };
+		double cost{};
+	};
+
+	//Vertices with bitwise equal positions map to the lowest vertex index among them
+	std::vector<uint32_t> BuildPositionRemap(std::span<const glm::vec3> positions)
+	{
+		std::vector<uint32_t> order(positions.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs)
+			{
+				const glm::vec3& a{ positions[lhs] };
+				const glm::vec3& b{ positions[rhs] };
+				if (a.x != b.x) return a.x < b.x;
+				if (a.y != b.y) return a.y < b.y;
+				if (a.z != b.z) return a.z < b.z;
+				return lhs < rhs;
+			});
+
+		std::vector<uint32_t> remap(positions.size());
+		for (size_t idx = 0; idx < order.size(); ++idx)
+		{
+			const bool isSamePosition{ idx > 0 && positions[order[idx]] == positions[order[idx - 1]] };
+			remap[order[idx]] = isSamePosition ? remap[order[idx - 1]] : order[idx];
+		}
+		return remap;
+	}
+
+	//Vertex -> triangle adjacency in CSR form
+	void BuildAdjacency(std::span<const uint32_t> indices, size_t vertexCount,
+		std::vector<uint32_t>& offsets, std::vector<uint32_t>& adjacency)
+	{
+		offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+			++offsets[index + 1];
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		adjacency.resize(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t idx = 0; idx < indices.size(); ++idx)
+			adjacency[fill[indices[idx]]++] = static_cast<uint32_t>(idx / 3);
+	}
+
+	//Locks both ends of every edge that is not shared by exactly two opposite half edges
+	void LockBorders(std::span<const uint32_t> indices, std::span<const uint32_t> positionRemap, std::vector<bool>& isLocked)
+	{
+		auto EdgeKey = [&](uint32_t a, uint32_t b)
+			{
+				return (static_cast<uint64_t>(positionRemap[a]) << 32) | positionRemap[b];
+			};
+
+		std::unordered_map<uint64_t, uint32_t> halfEdges{};
+		halfEdges.reserve(indices.size());
+		for (size_t idx = 0; idx < indices.size(); idx += 3)
+			for (size_t corner = 0; corner < 3; ++corner)
+				++halfEdges[EdgeKey(indices[idx + corner], indices[idx + (corner + 1) % 3])];
+
+		for (size_t idx = 0; idx < indices.size(); idx += 3)
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t a{ indices[idx + corner] };
+				const uint32_t b{ indices[idx + (corner + 1) % 3] };
+
+				const auto reverse{ halfEdges.find(EdgeKey(b, a)) };
+				if (halfEdges[EdgeKey(a, b)] != 1 || reverse == halfEdges.end() || reverse->second != 1)
+				{
+					isLocked[a] = true;
+					isLocked[b] = true;
+				}
+			}
+	}
+
+	//Planes through the seam edges, perpendicular to their face, keep seams from drifting when they collapse.
+	//A seam edge is a half edge whose opposite half edge joins the same positions through other vertices
+	void AddSeamPlanes(std::span<const uint32_t> indices, std::span<const uint32_t> positionRemap,
+		std::span<const glm::vec3> points, std::vector<Quadric>& quadrics)
+	{
+		auto EdgeKey = [&](uint32_t a, uint32_t b)
+			{
+				return (static_cast<uint64_t>(positionRemap[a]) << 32) | positionRemap[b];
+			};
+
+		std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> halfEdges{};
+		halfEdges.reserve(indices.size());
+		for (size_t idx = 0; idx < indices.size(); idx += 3)
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t a{ indices[idx + corner] };
+				const uint32_t b{ indices[idx + (corner + 1) % 3] };
+				halfEdges[EdgeKey(a, b)] = { a, b };
+			}
+
+		for (size_t idx = 0; idx < indices.size(); idx += 3)
+		{
+			const glm::vec3& p0{ points[indices[idx + 0]] };
+			const glm::vec3& p1{ points[indices[idx + 1]] };
+			const glm::vec3& p2{ points[indices[idx + 2]] };
+			const glm::vec3 faceNormal{ glm::cross(p1 - p0, p2 - p0) };
+			if (glm::length(faceNormal) == 0.f)
+				continue;
+
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t a{ indices[idx + corner] };
+				const uint32_t b{ indices[idx + (corner + 1) % 3] };
+
+				const auto reverse{ halfEdges.find(EdgeKey(b, a)) };
+				if (reverse == halfEdges.end() || (reverse->second.first == b && reverse->second.second == a))
+					continue;
+
+				const glm::vec3 edge{ points[b] - points[a] };
+				const glm::vec3 cross{ glm::cross(edge, faceNormal) };
+				const float length{ glm::length(cross) };
+				if (length == 0.f)
+					continue;
+
+				const glm::vec3 normal{ cross / length };
+				const float distance{ -glm::dot(normal, points[a]) };
+				const float edgeWeight{ glm::dot(edge, edge) };
+				quadrics[a].AddPlane(normal, distance, edgeWeight);
+				quadrics[b].AddPlane(normal, distance, edgeWeight);
+			}
+		}
+	}
+
+	bool Contains(const std::vector<uint32_t>& values, uint32_t value)
+	{
+		return std::find(values.begin(), values.end(), value) != values.end();
+	}
+}
+
+std::vector<uint32_t> FH::FHMeshSimplifier::Simplify(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+	std::span<const uint32_t> indices, size_t targetIndexCount, float targetError, float* pResultError)
+{
+	std::vector<uint32_t> result(indices.begin(), indices.end());
+	if (pResultError)
+		*pResultError = 0.f;
+
+	const size_t vertexCount{ positions.size() };
+	if (result.size() <= targetIndexCount || vertexCount == 0)
+		return result;
+
+	//Work in the unit cube so errors are relative to the mesh size
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	for (const glm::vec3& position : positions)
+		boundsMin = glm::min(boundsMin, position);
+
+	const float scale{ GetScale(positions) };
+	const float invScale{ scale > 0.f ? 1.f / scale : 0.f };
+
+	std::vector<glm::vec3> points(vertexCount);
+	for (size_t vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		points[vertexIdx] = (positions[vertexIdx] - boundsMin) * invScale;
+
+	//A position shared by two vertices is an attribute seam (uv seams, hard normals), more than two is where seams meet.
+	//wedges links the vertices of a position in a ring
+	const std::vector<uint32_t> positionRemap{ BuildPositionRemap(positions) };
+	std::vector<uint32_t> positionUseCount(vertexCount, 0);
+	std::vector<uint32_t> wedges(vertexCount);
+	std::iota(wedges.begin(), wedges.end(), 0);
+	for (uint32_t vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+	{
+		const uint32_t first{ positionRemap[vertexIdx] };
+		++positionUseCount[first];
+		if (vertexIdx != first)
+			std::swap(wedges[vertexIdx], wedges[first]);
+	}
+
+	std::vector<bool> isLocked(vertexCount, false);
+	LockBorders(result, positionRemap, isLocked);
+
+	//A border through one vertex of a position locks all of them
+	for (uint32_t vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		if (isLocked[vertexIdx])
+			isLocked[positionRemap[vertexIdx]] = true;
+
+	std::vector<VertexKind> vertexKinds(vertexCount, VertexKind::Manifold);
+	for (uint32_t vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+	{
+		const uint32_t useCount{ positionUseCount[positionRemap[vertexIdx]] };
+		if (isLocked[positionRemap[vertexIdx]] || useCount > 2)
+			vertexKinds[vertexIdx] = VertexKind::Locked;
+		else if (useCount == 2)
+			vertexKinds[vertexIdx] = VertexKind::Seam;
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t idx = 0; idx < result.size(); idx += 3)
+	{
+		const glm::vec3& p0{ points[result[idx + 0]] };
+		const glm::vec3& p1{ points[result[idx + 1]] };
+		const glm::vec3& p2{ points[result[idx + 2]] };
+
+		const glm::vec3 cross{ glm::cross(p1 - p0, p2 - p0) };
+		const float length{ glm::length(cross) };
+		if (length == 0.f)
+			continue;
+
+		const glm::vec3 normal{ cross / length };
+		const float distance{ -glm::dot(normal, p0) };
+		for (size_t corner = 0; corner < 3; ++corner)
+			quadrics[result[idx + corner]].AddPlane(normal, distance, length * 0.5f);
+	}
+	AddSeamPlanes(result, positionRemap, points, quadrics);
+
+	//Plane distance plus a penalty for collapsing onto a vertex with a different normal
+	auto CollapseCost = [&](uint32_t from, uint32_t to)
+		{
+			double cost{ quadrics[from].Evaluate(points[to]) };
+			if (!normals.empty())
+			{
+				const float normalDeviation{ 1.f - glm::dot(normals[from], normals[to]) };
+				const glm::vec3 edge{ points[to] - points[from] };
+				cost += std::max(normalDeviation, 0.f) * glm::dot(edge, edge);
+			}
+			return cost;
+		};
+
+	std::vector<uint32_t> offsets{};
+	std::vector<uint32_t> adjacency{};
+	std::vector<uint32_t> fromNeighbours{};
+	std::vector<uint32_t> sharedNeighbours{};
+
+	//Rejects collapses that flip or fold a triangle, join two uv islands at the target or pinch the surface
+	auto IsValidCollapse = [&](uint32_t from, uint32_t to)
+		{
+			fromNeighbours.clear();
+			sharedNeighbours.clear();
+
+			for (uint32_t adjacencyIdx = offsets[from]; adjacencyIdx < offsets[from + 1]; ++adjacencyIdx)
+			{
+				const uint32_t* pTriangle{ &result[adjacency[adjacencyIdx] * 3] };
+				const bool hasTarget{ pTriangle[0] == to || pTriangle[1] == to || pTriangle[2] == to };
+
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ pTriangle[corner] };
+					if (vertex == from || vertex == to)
+						continue;
+
+					fromNeighbours.push_back(positionRemap[vertex]);
+					if (hasTarget)
+						sharedNeighbours.push_back(positionRemap[vertex]);
+					else if (positionRemap[vertex] == positionRemap[to])
+						return false;
+				}
+
+				if (hasTarget)
+					continue;
+
+				glm::vec3 corners[3]{ points[pTriangle[0]], points[pTriangle[1]], points[pTriangle[2]] };
+				const glm::vec3 oldNormal{ glm::cross(corners[1] - corners[0], corners[2] - corners[0]) };
+				for (uint32_t corner = 0; corner < 3; ++corner)
+					if (pTriangle[corner] == from)
+						corners[corner] = points[to];
+				const glm::vec3 newNormal{ glm::cross(corners[1] - corners[0], corners[2] - corners[0]) };
+
+				const float newLength{ glm::length(newNormal) };
+				if (newLength == 0.f || glm::dot(oldNormal, newNormal) < 0.25f * glm::length(oldNormal) * newLength)
+					return false;
+			}
+
+			//Link condition, the only vertices both ends share are the ones opposite the collapsed edge
+			for (uint32_t adjacencyIdx = offsets[to]; adjacencyIdx < offsets[to + 1]; ++adjacencyIdx)
+			{
+				const uint32_t* pTriangle{ &result[adjacency[adjacencyIdx] * 3] };
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ pTriangle[corner] };
+					if (vertex == from || vertex == to)
+						continue;
+
+					if (Contains(fromNeighbours, positionRemap[vertex]) && !Contains(sharedNeighbours, positionRemap[vertex]))
+						return false;
+				}
+			}
+			return true;
+		};
+
+	const double errorLimit{ static_cast<double>(targetError) * targetError };
+	double maxError{};
+
+	std::vector<Collapse> collapses{};
+	std::vector<uint32_t> collapseTo(vertexCount);
+	std::vector<bool> isTouched(vertexCount);
+
+	while (result.size() > targetIndexCount)
+	{
+		BuildAdjacency(result, vertexCount, offsets, adjacency);
+
+		//The other vertex at the position of from must share an edge with a vertex at the position of to,
+		//then the edge runs along the seam and both sides collapse together
+		auto FindSeamPartner = [&](uint32_t from, uint32_t to)
+			{
+				const uint32_t seamFrom{ wedges[from] };
+				for (uint32_t adjacencyIdx = offsets[seamFrom]; adjacencyIdx < offsets[seamFrom + 1]; ++adjacencyIdx)
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ result[adjacency[adjacencyIdx] * 3 + corner] };
+						if (vertex != to && positionRemap[vertex] == positionRemap[to])
+							return vertex;
+					}
+				return NO_VERTEX;
+			};
+
+		auto AddCollapse = [&](uint32_t from, uint32_t to)
+			{
+				switch (vertexKinds[from])
+				{
+				case VertexKind::Manifold:
+					collapses.push_back({ from, to, NO_VERTEX, NO_VERTEX, CollapseCost(from, to) });
+					break;
+				case VertexKind::Seam:
+					if (vertexKinds[to] != VertexKind::Manifold)
+					{
+						const uint32_t seamTo{ FindSeamPartner(from, to) };
+						if (seamTo != NO_VERTEX)
+							collapses.push_back({ from, to, wedges[from], seamTo,
+								std::max(CollapseCost(from, to), CollapseCost(wedges[from], seamTo)) });
+					}
+					break;
+				case VertexKind::Locked:
+					break;
+				}
+			};
+
+		collapses.clear();
+		for (size_t idx = 0; idx < result.size(); idx += 3)
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t a{ result[idx + corner] };
+				const uint32_t b{ result[idx + (corner + 1) % 3] };
+				AddCollapse(a, b);
+				AddCollapse(b, a);
+			}
+
+		std::sort(collapses.begin(), collapses.end(),
+			[](const Collapse& lhs, const Collapse& rhs) { return lhs.cost < rhs.cost; });
+
+		//An interior collapse removes two triangles
+		const size_t collapseGoal{ (result.size() - targetIndexCount) / 6 + 1 };
+		size_t collapseCount{};
+
+		std::iota(collapseTo.begin(), collapseTo.end(), 0);
+		isTouched.assign(vertexCount, false);
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.cost > errorLimit || collapseCount == collapseGoal)
+				break;
+
+			if (isTouched[collapse.from] || isTouched[collapse.to] || !IsValidCollapse(collapse.from, collapse.to))
+				continue;
+
+			const bool isSeam{ collapse.seamFrom != NO_VERTEX };
+			if (isSeam && (isTouched[collapse.seamFrom] || isTouched[collapse.seamTo] || !IsValidCollapse(collapse.seamFrom, collapse.seamTo)))
+				continue;
+
+			maxError = std::max(maxError, collapse.cost);
+			++collapseCount;
+
+			//Freeze the neighbourhood for the rest of the pass, later validity checks would see stale triangles
+			auto ApplyCollapse = [&](uint32_t from, uint32_t to)
+				{
+					collapseTo[from] = to;
+					quadrics[to] += quadrics[from];
+					for (uint32_t adjacencyIdx = offsets[from]; adjacencyIdx < offsets[from + 1]; ++adjacencyIdx)
+						for (uint32_t corner = 0; corner < 3; ++corner)
+							isTouched[result[adjacency[adjacencyIdx] * 3 + corner]] = true;
+				};
+
+			ApplyCollapse(collapse.from, collapse.to);
+			if (isSeam)
+				ApplyCollapse(collapse.seamFrom, collapse.seamTo);
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		size_t writeIdx{};
+		for (size_t idx = 0; idx < result.size(); idx += 3)
+		{
+			const uint32_t a{ collapseTo[result[idx + 0]] };
+			const uint32_t b{ collapseTo[result[idx + 1]] };
+			const uint32_t c{ collapseTo[result[idx + 2]] };
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[writeIdx++] = a;
+			result[writeIdx++] = b;
+			result[writeIdx++] = c;
+		}
+		result.resize(writeIdx);
+	}
+
+	if (pResultError)
+		*pResultError = static_cast<float>(std::sqrt(maxError));
+	return result;
+}
+
+float FH::FHMeshSimplifier::GetScale(std::span<const glm::vec3> positions)
+{
+	if (positions.empty())
+		return 0.f;
+
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (const glm::vec3& position : positions)
+	{
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+
+	const glm::vec3 extent{ boundsMax - boundsMin };
+	return std::max(extent.x, std::max(extent.y, extent.z));
+}
\ No newline at end of file
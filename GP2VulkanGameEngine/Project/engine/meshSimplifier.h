@@ -0,0 +1,31 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FH
+{
+	//Quadric error edge collapse simplification (Garland and Heckbert 1997) for indexed triangle lists
+	class FHMeshSimplifier final
+	{
+	public:
+		//Collapses vertices onto neighbouring vertices until the index count reaches targetIndexCount or the
+		//cheapest collapse left costs more than targetError. Vertices are never moved or created, so the
+		//result indexes the original vertex buffer. Vertices on attribute seams (two vertices sharing a position,
+		//like uv seams and hard normals) only collapse along the seam, together with the vertex on the other side.
+		//Border vertices and positions where seams meet are locked, collapses that flip a triangle are rejected.
+		//Errors are relative to the mesh extent, multiply with GetScale for model space units
+		static std::vector<uint32_t> Simplify(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+			std::span<const uint32_t> indices, size_t targetIndexCount, float targetError, float* pResultError = nullptr);
+
+		//Largest side of the mesh bounds
+		static float GetScale(std::span<const glm::vec3> positions);
+
+		FHMeshSimplifier() = delete;
+	};
+}
\ No newline at end of file
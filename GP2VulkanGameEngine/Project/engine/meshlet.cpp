@@ -0,0 +1,132 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+std::vector<FH::FHMeshlet> FH::FHMeshletBuilder::Build(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+	std::span<const uint32_t> indices)
+{
+	std::vector<FHMeshlet> meshlets{};
+
+	//Id of the last meshlet every vertex was added to
+	std::vector<uint32_t> vertexMeshlet(positions.size(), std::numeric_limits<uint32_t>::max());
+	uint32_t meshletId{};
+	uint32_t meshletVertexCount{};
+
+	FHMeshlet meshlet{};
+	for (size_t triangleIdx = 0; triangleIdx < indices.size() / 3; ++triangleIdx)
+	{
+		const uint32_t* pTriangle{ &indices[triangleIdx * 3] };
+
+		uint32_t newVertexCount{};
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			if (vertexMeshlet[pTriangle[corner]] != meshletId)
+				++newVertexCount;
+
+		if (meshlet.indexCount / 3 == MAX_TRIANGLES || meshletVertexCount + newVertexCount > MAX_VERTICES)
+		{
+			ComputeBounds(meshlet, positions, normals, indices);
+			meshlets.push_back(meshlet);
+
+			meshlet = FHMeshlet{};
+			meshlet.firstIndex = static_cast<uint32_t>(triangleIdx * 3);
+			meshletVertexCount = 0;
+			++meshletId;
+		}
+
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			if (vertexMeshlet[pTriangle[corner]] != meshletId)
+			{
+				vertexMeshlet[pTriangle[corner]] = meshletId;
+				++meshletVertexCount;
+			}
+
+		meshlet.indexCount += 3;
+	}
+
+	if (meshlet.indexCount > 0)
+	{
+		ComputeBounds(meshlet, positions, normals, indices);
+		meshlets.push_back(meshlet);
+	}
+
+	return meshlets;
+}
+
+void FH::FHMeshletBuilder::ComputeBounds(FHMeshlet& meshlet, std::span<const glm::vec3> positions,
+	std::span<const glm::vec3> normals, std::span<const uint32_t> indices)
+{
+	const std::span<const uint32_t> meshletIndices{ indices.subspan(meshlet.firstIndex, meshlet.indexCount) };
+
+	//Bounding sphere around the AABB center
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (uint32_t index : meshletIndices)
+	{
+		boundsMin = glm::min(boundsMin, positions[index]);
+		boundsMax = glm::max(boundsMax, positions[index]);
+	}
+
+	const glm::vec3 center{ (boundsMin + boundsMax) * 0.5f };
+	float radius{};
+	for (uint32_t index : meshletIndices)
+		radius = std::max(radius, glm::distance(center, positions[index]));
+
+	meshlet.boundingSphere = glm::vec4{ center, radius };
+
+	//No cone by default, a cutoff above 1 never passes the backface test
+	meshlet.coneAxisCutoff = glm::vec4{ 0.f, 0.f, 1.f, 2.f };
+	meshlet.coneApex = glm::vec4{ center, 0.f };
+
+	//Face normals, flipped to agree with the vertex normals so the cone follows the shading side
+	glm::vec3 faceNormals[MAX_TRIANGLES]{};
+	glm::vec3 facePoints[MAX_TRIANGLES]{};
+	uint32_t faceCount{};
+	glm::vec3 axis{ 0.f };
+
+	for (size_t idx = 0; idx + 2 < meshletIndices.size(); idx += 3)
+	{
+		const uint32_t i0{ meshletIndices[idx + 0] };
+		const uint32_t i1{ meshletIndices[idx + 1] };
+		const uint32_t i2{ meshletIndices[idx + 2] };
+
+		glm::vec3 normal{ glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]) };
+		const float length{ glm::length(normal) };
+		if (length == 0.f)
+			continue;
+		normal /= length;
+
+		if (!normals.empty() && glm::dot(normal, normals[i0] + normals[i1] + normals[i2]) < 0.f)
+			normal = -normal;
+
+		faceNormals[faceCount] = normal;
+		facePoints[faceCount] = positions[i0];
+		++faceCount;
+		axis += normal;
+	}
+
+	const float axisLength{ glm::length(axis) };
+	if (faceCount == 0 || axisLength == 0.f)
+		return;
+	axis /= axisLength;
+
+	float minDot{ 1.f };
+	for (uint32_t face = 0; face < faceCount; ++face)
+		minDot = std::min(minDot, glm::dot(axis, faceNormals[face]));
+
+	//Cones wider than ~84 degrees are almost never entirely backfacing
+	if (minDot <= 0.1f)
+		return;
+
+	//Move the apex back along the axis until every triangle plane is in front of it
+	float maxDistance{};
+	for (uint32_t face = 0; face < faceCount; ++face)
+	{
+		const float distance{ glm::dot(center - facePoints[face], faceNormals[face]) / glm::dot(axis, faceNormals[face]) };
+		maxDistance = std::max(maxDistance, distance);
+	}
+
+	meshlet.coneAxisCutoff = glm::vec4{ axis, std::sqrt(1.f - minDot * minDot) };
+	meshlet.coneApex = glm::vec4{ center - axis * maxDistance, 0.f };
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FH
+{
+	//Contiguous run of triangles in the model's index buffer, matches Meshlet in cull.comp (std430)
+	struct FHMeshlet
+	{
+		glm::vec4 boundingSphere{};	//xyz center, w radius
+		glm::vec4 coneAxisCutoff{};	//xyz axis, w cutoff. Backfacing when dot(normalize(apex - eye), axis) >= cutoff
+		glm::vec4 coneApex{};		//xyz apex, w unused
+		uint32_t firstIndex{};
+		uint32_t indexCount{};
+		uint32_t padding[2]{};
+	};
+	static_assert(sizeof(FHMeshlet) == 64, "FHMeshlet must match the std430 layout in cull.comp");
+
+	class FHMeshletBuilder final
+	{
+	public:
+		static constexpr uint32_t MAX_VERTICES{ 64 };
+		static constexpr uint32_t MAX_TRIANGLES{ 124 };
+
+		//Greedily cuts the index buffer in meshlets without reordering it, so run the vertex
+		//cache optimizer first to get compact clusters. Normals only orient the cone and may be empty
+		static std::vector<FHMeshlet> Build(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+			std::span<const uint32_t> indices);
+
+		FHMeshletBuilder() = delete;
+
+	private:
+		static void ComputeBounds(FHMeshlet& meshlet, std::span<const glm::vec3> positions,
+			std::span<const glm::vec3> normals, std::span<const uint32_t> indices);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "mipChain.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FH_MIPCHAIN_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//Decode table for the 256 sRGB values, encode table over 4096 linear steps is within one 8 bit step
+	const std::array<float, 256>& GetSrgbToLinear()
+	{
+		static const auto table{ []
+			{
+				std::array<float, 256> values{};
+				for (size_t idx = 0; idx < values.size(); ++idx)
+				{
+					const float value{ idx / 255.f };
+					values[idx] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+			}() };
+		return table;
+	}
+
+	const std::array<uint8_t, 4096>& GetLinearToSrgb()
+	{
+		static const auto table{ []
+			{
+				std::array<uint8_t, 4096> values{};
+				for (size_t idx = 0; idx < values.size(); ++idx)
+				{
+					const float value{ idx / 4095.f };
+					const float encoded{ value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f };
+					values[idx] = static_cast<uint8_t>(std::clamp(encoded, 0.f, 1.f) * 255.f + 0.5f);
+				}
+				return values;
+			}() };
+		return table;
+	}
+
+	//Rounded average of the 2x2 texels, per channel as stored. x0 and x1 are byte offsets of the two columns
+	void AverageTexel(const uint8_t* pRow0, const uint8_t* pRow1, size_t x0, size_t x1, uint8_t* pTexel, size_t firstChannel)
+	{
+		for (size_t channel = firstChannel; channel < 4; ++channel)
+			pTexel[channel] = static_cast<uint8_t>((pRow0[x0 + channel] + pRow0[x1 + channel] +
+				pRow1[x0 + channel] + pRow1[x1 + channel] + 2) / 4);
+	}
+
+	//Linear data, nextWidth texels from two source rows. Only a 1 texel wide source has to clamp its second column
+	void DownsampleRowLinear(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pDestination, uint32_t width, uint32_t nextWidth)
+	{
+		uint32_t x{};
+#ifdef FH_MIPCHAIN_SSE2
+		//Two destination texels from 16 bytes of each row, summed in 16 bit lanes so the rounding is exact
+		const __m128i zero{ _mm_setzero_si128() };
+		const __m128i rounding{ _mm_set1_epi16(2) };
+		for (; width > 1 && x + 2 <= nextWidth; x += 2)
+		{
+			const __m128i row0{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + static_cast<size_t>(x) * 8)) };
+			const __m128i row1{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + static_cast<size_t>(x) * 8)) };
+
+			const __m128i columnsLow{ _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero)) };
+			const __m128i columnsHigh{ _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero)) };
+			const __m128i sumLow{ _mm_add_epi16(columnsLow, _mm_srli_si128(columnsLow, 8)) };
+			const __m128i sumHigh{ _mm_add_epi16(columnsHigh, _mm_srli_si128(columnsHigh, 8)) };
+
+			const __m128i average{ _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLow, sumHigh), rounding), 2) };
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(pDestination + static_cast<size_t>(x) * 4), _mm_packus_epi16(average, zero));
+		}
+#endif
+		for (; x < nextWidth; ++x)
+		{
+			const size_t x0{ static_cast<size_t>(std::min(x * 2, width - 1)) * 4 };
+			const size_t x1{ static_cast<size_t>(std::min(x * 2 + 1, width - 1)) * 4 };
+			AverageTexel(pRow0, pRow1, x0, x1, pDestination + static_cast<size_t>(x) * 4, 0);
+		}
+	}
+
+	//sRGB colour is averaged in linear space through the tables, alpha as stored. The table lookups are the cost
+	//here, SSE2 has no gather so only the linear rows are vectorized
+	void DownsampleRowSrgb(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pDestination, uint32_t width, uint32_t nextWidth)
+	{
+		const std::array<float, 256>& srgbToLinear{ GetSrgbToLinear() };
+		const std::array<uint8_t, 4096>& linearToSrgb{ GetLinearToSrgb() };
+
+		for (uint32_t x = 0; x < nextWidth; ++x)
+		{
+			const size_t x0{ static_cast<size_t>(std::min(x * 2, width - 1)) * 4 };
+			const size_t x1{ static_cast<size_t>(std::min(x * 2 + 1, width - 1)) * 4 };
+			uint8_t* pTexel{ pDestination + static_cast<size_t>(x) * 4 };
+
+			for (size_t channel = 0; channel < 3; ++channel)
+			{
+				const float linear{ (srgbToLinear[pRow0[x0 + channel]] + srgbToLinear[pRow0[x1 + channel]] +
+					srgbToLinear[pRow1[x0 + channel]] + srgbToLinear[pRow1[x1 + channel]]) * 0.25f };
+				pTexel[channel] = linearToSrgb[static_cast<size_t>(linear * 4095.f + 0.5f)];
+			}
+			AverageTexel(pRow0, pRow1, x0, x1, pTexel, 3);
+		}
+	}
+}
+
+uint32_t FH::FHMipChain::GetLevelCount(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+}
+
+VkDeviceSize FH::FHMipChain::GetSize(uint32_t width, uint32_t height, uint32_t levelCount)
+{
+	VkDeviceSize size{};
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		size += static_cast<VkDeviceSize>(width) * height * 4;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+	return size;
+}
+
+std::vector<VkBufferImageCopy> FH::FHMipChain::Downsample(uint8_t* pLevels, uint32_t width, uint32_t height,
+	uint32_t levelCount, bool isSrgb)
+{
+	std::vector<VkBufferImageCopy> regions{};
+	regions.reserve(levelCount);
+
+	VkDeviceSize offset{};
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { width, height, 1 };
+		regions.push_back(region);
+
+		const VkDeviceSize levelSize{ static_cast<VkDeviceSize>(width) * height * 4 };
+		if (level + 1 == levelCount)
+			break;
+
+		const uint8_t* pSource{ pLevels + offset };
+		uint8_t* pDestination{ pLevels + offset + levelSize };
+		const uint32_t nextWidth{ std::max(width / 2, 1u) };
+		const uint32_t nextHeight{ std::max(height / 2, 1u) };
+
+		//Odd sizes clamp the second texel, a 1 texel wide level averages with itself
+		for (uint32_t y = 0; y < nextHeight; ++y)
+		{
+			const uint8_t* pRow0{ pSource + static_cast<size_t>(std::min(y * 2, height - 1)) * width * 4 };
+			const uint8_t* pRow1{ pSource + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width * 4 };
+			uint8_t* pRow{ pDestination + static_cast<size_t>(y) * nextWidth * 4 };
+
+			if (isSrgb)
+				DownsampleRowSrgb(pRow0, pRow1, pRow, width, nextWidth);
+			else
+				DownsampleRowLinear(pRow0, pRow1, pRow, width, nextWidth);
+		}
+
+		offset += levelSize;
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	return regions;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace FH
+{
+	//CPU mip generation for RGBA8 images, used when the format cannot be blitted and by offline tools
+	class FHMipChain final
+	{
+	public:
+		//Full chain down to 1x1
+		static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+		//Bytes of the first levelCount RGBA8 levels packed back to back
+		static VkDeviceSize GetSize(uint32_t width, uint32_t height, uint32_t levelCount);
+
+		//2x2 box filter, gamma correct for sRGB data. pLevels holds level 0 and gets every following level
+		//tightly packed behind it. Returns the copy region of each level, offsets relative to pLevels
+		static std::vector<VkBufferImageCopy> Downsample(uint8_t* pLevels, uint32_t width, uint32_t height,
+			uint32_t levelCount, bool isSrgb);
+
+		FHMipChain() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "mipResidency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+uint32_t FH::FHMipResidency::GetRequiredLevel(uint32_t textureSize, float screenSize, uint32_t topLevel, uint32_t tailLevel)
+{
+	const float texelsPerPixel{ static_cast<float>(textureSize) / std::max(screenSize, 1.f) };
+	const uint32_t level{ texelsPerPixel <= 1.f ? 0 : static_cast<uint32_t>(std::log2(texelsPerPixel)) };
+	return std::clamp(level, topLevel, tailLevel);
+}
+
+std::vector<size_t> FH::FHMipResidency::SelectEvictions(std::span<const Surplus> surplus, VkDeviceSize residentBytes,
+	VkDeviceSize neededBytes, VkDeviceSize budget)
+{
+	std::vector<size_t> order(surplus.size());
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [surplus](size_t lhs, size_t rhs)
+		{
+			return surplus[lhs].requestFrame != surplus[rhs].requestFrame ? surplus[lhs].requestFrame < surplus[rhs].requestFrame :
+				surplus[lhs].bytes > surplus[rhs].bytes;
+		});
+
+	std::vector<size_t> evictions{};
+	for (size_t surplusIdx : order)
+	{
+		if (residentBytes + neededBytes <= budget)
+			break;
+
+		residentBytes -= std::min(residentBytes, surplus[surplusIdx].bytes);
+		evictions.push_back(surplusIdx);
+	}
+	return evictions;
+}
\ No newline at end of file
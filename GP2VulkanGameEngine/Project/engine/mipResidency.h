@@ -0,0 +1,33 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FH
+{
+	//The decisions of FHTextureStreamer that need no device: which level a screen size needs and which textures
+	//drop their surplus levels when the budget is exceeded
+	class FHMipResidency final
+	{
+	public:
+		//A texture holding levels beyond the ones it needs
+		struct Surplus
+		{
+			uint64_t requestFrame{};	//last frame the texture was drawn
+			VkDeviceSize bytes{};		//freed by dropping to the required level
+		};
+
+		//Assumes the texture is spread over the object once, then one texel per pixel needs the level that halves
+		//textureSize until it matches the screen size. Clamped to the levels the texture has, [topLevel, tailLevel]
+		static uint32_t GetRequiredLevel(uint32_t textureSize, float screenSize, uint32_t topLevel, uint32_t tailLevel);
+
+		//Indices into surplus of the textures to evict, in order, until residentBytes + neededBytes fits the budget.
+		//Least recently drawn first, the largest surplus first among textures drawn in the same frame
+		static std::vector<size_t> SelectEvictions(std::span<const Surplus> surplus, VkDeviceSize residentBytes,
+			VkDeviceSize neededBytes, VkDeviceSize budget);
+
+		FHMipResidency() = delete;
+	};
+}
\ No newline at end of file
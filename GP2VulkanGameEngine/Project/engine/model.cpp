@@ -1,207 +1,399 @@
 #include "model.h"
-#include "utils.h"
+#include "meshCache.h"
+#include "uploadContext.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "external/tiny_obj_loader.h"
-
-#define GLM_ENABLE_EXPERIMENTAL
-#include "glm/gtx/hash.hpp"
+#include <glm/gtc/packing.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <iostream>
-#include <unordered_map>
+#include <limits>
+
+namespace
+{
+	inline int16_t PackSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f));
+	}
 
-namespace std {
-	template<>
-	struct hash<FH::FHModel::Vertex>
+	//Octahedral mapping of a direction onto [-1, 1]^2, a zero vector maps to +Z
+	inline void PackOctahedral(const glm::vec3& direction, int16_t (&packed)[2])
 	{
-		size_t operator()(const FH::FHModel::Vertex& vertex) const
+		const float sum{ std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) };
+		if (sum == 0.f)
 		{
-			size_t seed{};
-			FH::HashCombine(seed, vertex.pos, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+			packed[0] = packed[1] = 0;
+			return;
 		}
-	};
+
+		glm::vec3 n{ direction / sum };
+		if (n.z < 0.f)
+		{
+			const float x{ (1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f) };
+			const float y{ (1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f) };
+			n.x = x;
+			n.y = y;
+		}
+
+		packed[0] = PackSnorm16(n.x);
+		packed[1] = PackSnorm16(n.y);
+	}
 }
 
 //////////////////////
 // MODEL 3D FUNCTIONS
 //////////////////////
 
-//ModelData function
-void FH::FHModel::ModelData::LoadModel(const std::string& filePath)
+FH::FHModel::FHModel(FHGeometryPool& geometryPool, const ModelData& construction, FHVertexFormat format,
+	bool positionStream)
+	: FHModel{ geometryPool, construction.vertices, construction.indices, format, construction.meshlets,
+		construction.lods, positionStream }
+{}
+
+FH::FHModel::FHModel(FHGeometryPool& geometryPool, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+	FHVertexFormat format, std::span<const FHMeshlet> meshlets, std::span<const Lod> lods, bool positionStream)
+	: m_FHDevice{ geometryPool.GetDevice() }
+	, m_FHGeometryPool{ geometryPool }
+	, m_VertexFormat{ format }
+	, m_Lods{ lods.begin(), lods.end() }
 {
-	tinyobj::attrib_t attribute;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string error;
+	if (m_Lods.empty())
+		m_Lods.push_back(Lod{ 0, static_cast<uint32_t>(indices.size()), 0, static_cast<uint32_t>(meshlets.size()) });
 
-	if (!tinyobj::LoadObj(&attribute, &shapes, &materials, &error, filePath.c_str()))
-		throw std::runtime_error(error);
+	//Bounding sphere around the AABB center, used for LOD selection
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.pos);
+		boundsMax = glm::max(boundsMax, vertex.pos);
+	}
 
-	vertices.clear();
-	indices.clear();
+	const glm::vec3 center{ (boundsMin + boundsMax) * 0.5f };
+	float radius{};
+	for (const auto& vertex : vertices)
+		radius = std::max(radius, glm::distance(center, vertex.pos));
+	m_BoundingSphere = glm::vec4{ center, radius };
 
-	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+	if (m_VertexFormat == FHVertexFormat::Compact)
+		CreateCompactVertexBuffers(vertices, positionStream);
+	else
+	{
+		CreateVertexBuffers(vertices.data(), sizeof(Vertex), static_cast<uint32_t>(vertices.size()));
 
-	for (const auto& s : shapes)
-		for (const auto& index : s.mesh.indices)
+		if (positionStream)
 		{
-			Vertex vertex{};
-			if (index.vertex_index >= 0)
-			{
-				vertex.pos = {
-					attribute.vertices[3 * index.vertex_index + 0],
-					attribute.vertices[3 * index.vertex_index + 1],
-					attribute.vertices[3 * index.vertex_index + 2]
-				};
-			}
-			if (index.normal_index >= 0)
-			{
-				vertex.normal = {
-					attribute.normals[3 * index.normal_index + 0],
-					attribute.normals[3 * index.normal_index + 1],
-					attribute.normals[3 * index.normal_index + 2]
-				};
-			}
-			if (index.texcoord_index >= 0)
-			{
-				vertex.uv = {
-					attribute.texcoords[2 * index.texcoord_index + 0],
-					attribute.texcoords[2 * index.texcoord_index + 1]
-				};
-			}
-
-			if (uniqueVertices.count(vertex) == 0)
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-			}
-			indices.push_back(uniqueVertices[vertex]);
+			std::vector<glm::vec3> positions(vertices.size());
+			std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const Vertex& vertex) { return vertex.pos; });
+			CreatePositionBuffer(positions.data(), sizeof(glm::vec3));
 		}
+	}
 
-	//Calculate Tangents
-	for (size_t currentIdx = 0; currentIdx < indices.size(); currentIdx += 3)
-	{
-		Vertex& vertex0{ vertices[indices[currentIdx]] };
-		Vertex& vertex1{ vertices[indices[currentIdx + 1]] };
-		Vertex& vertex2{ vertices[indices[currentIdx + 2]] };
-
-		const glm::vec3& edge0{ vertex1.pos - vertex0.pos };
-		const glm::vec3& edge1{ vertex2.pos - vertex0.pos };
+	CreateMeshletBuffer(meshlets);
+	CreateIndexBuffers(indices);
+}
 
-		const glm::vec2& diffX{ vertex1.uv.x - vertex0.uv.x, vertex2.uv.x - vertex0.uv.x };
-		const glm::vec2& diffY{ vertex1.uv.y - vertex0.uv.y, vertex2.uv.y - vertex0.uv.y };
+FH::FHModel::~FHModel()
+{
+	m_FHGeometryPool.Free(m_VertexHandle);
+	m_FHGeometryPool.Free(m_PositionHandle);
+	m_FHGeometryPool.Free(m_IndexHandle);
+}
 
-		float r{ 1.f / (diffX.x * diffY.y - diffX.y * diffY.x) };
+void FH::FHModel::CreateVertexBuffers(const void* pVertices, uint32_t vertexSize, uint32_t vertexCount)
+{
+	m_VertexCount = vertexCount;
+	assert(m_VertexCount >= 3 && "Vertex count must be at least 3 (1 triangle)");
 
-		glm::vec3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
-		vertex0.tangent += tangent;
-		vertex1.tangent += tangent;
-		vertex2.tangent += tangent;
-	}
+	m_VertexHandle = m_FHGeometryPool.AllocateVertices(pVertices, vertexSize, m_VertexCount);
 }
 
-FH::FHModel::FHModel(FHDevice& device, const ModelData& construction)
-	: m_FHDevice{device}
+void FH::FHModel::CreatePositionBuffer(const void* pPositions, uint32_t positionSize)
 {
-	CreateVertexBuffers(construction.vertices);
-	CreateIndexBuffers(construction.indices);
+	m_PositionHandle = m_FHGeometryPool.AllocateVertices(pPositions, positionSize, m_VertexCount);
 }
 
-void FH::FHModel::CreateVertexBuffers(const std::vector<Vertex>& vertices)
+void FH::FHModel::CreateCompactVertexBuffers(std::span<const Vertex> vertices, bool positionStream)
 {
-	m_VertexCount = static_cast<uint32_t>(vertices.size());
-	assert(m_VertexCount >= 3 && "Vertex count must be at least 3 (1 triangle)");
-	uint32_t vertexSize = sizeof(vertices[0]);
-	VkDeviceSize bufferSize = vertexSize * m_VertexCount;
-
-	FHBuffer stagingBuffer
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : vertices)
 	{
-		m_FHDevice,
-		vertexSize,
-		m_VertexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		boundsMin = glm::min(boundsMin, vertex.pos);
+		boundsMax = glm::max(boundsMax, vertex.pos);
+	}
+
+	const glm::vec3 extent{ boundsMax - boundsMin };
+	const glm::vec3 quantizeScale{
+		extent.x > 0.f ? 65535.f / extent.x : 0.f,
+		extent.y > 0.f ? 65535.f / extent.y : 0.f,
+		extent.z > 0.f ? 65535.f / extent.z : 0.f
 	};
-	
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*)vertices.data());
-	//UnMap takes place in the buffers destructor
 
-	m_pVertexBuffer = std::make_unique<FHBuffer>
-		(
-			m_FHDevice,
-			vertexSize,
-			m_VertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+	//UNORM input is pos / 65535, so model space is boundsMin + input * extent
+	m_DequantizeMatrix = glm::mat4{
+		{ extent.x, 0.f, 0.f, 0.f },
+		{ 0.f, extent.y, 0.f, 0.f },
+		{ 0.f, 0.f, extent.z, 0.f },
+		{ boundsMin, 1.f }
+	};
 
-	m_FHDevice.CopyBuffer(stagingBuffer.GetBuffer(), m_pVertexBuffer->GetBuffer(), bufferSize);
+	std::vector<CompactVertex> compactVertices(vertices.size());
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+		compactVertices[vertexIdx] = CompactVertex::Pack(vertices[vertexIdx], boundsMin, quantizeScale);
+
+	CreateVertexBuffers(compactVertices.data(), sizeof(CompactVertex), static_cast<uint32_t>(compactVertices.size()));
+
+	if (positionStream)
+	{
+		//The same quantized values as the interleaved stream, so both compute bit identical positions
+		std::vector<std::array<uint16_t, 4>> positions(compactVertices.size());
+		for (size_t vertexIdx = 0; vertexIdx < compactVertices.size(); ++vertexIdx)
+			std::copy(std::begin(compactVertices[vertexIdx].pos), std::end(compactVertices[vertexIdx].pos), positions[vertexIdx].begin());
+		CreatePositionBuffer(positions.data(), sizeof(positions[0]));
+	}
 }
 
-void FH::FHModel::CreateIndexBuffers(const std::vector<uint32_t>& indices)
+void FH::FHModel::CreateIndexBuffers(std::span<const uint32_t> indices)
 {
 	m_IndexCount = static_cast<uint32_t>(indices.size());
 	m_HasIndexBuffer = m_IndexCount > 0;
 	if (!m_HasIndexBuffer) return;
 
-	uint32_t indexSize = sizeof(indices[0]);
-	VkDeviceSize bufferSize{ indexSize * m_IndexCount };
+	//16 bit indices whenever every vertex can be addressed with them. Meshlet models keep 32 bit
+	//indices since the cull pass reads them as a storage buffer
+	std::vector<uint16_t> shortIndices{};
+	const void* pIndexData{ indices.data() };
+	m_IndexType = VK_INDEX_TYPE_UINT32;
 
-	FHBuffer stagingBuffer
+	if (!HasMeshlets() && m_VertexCount <= std::numeric_limits<uint16_t>::max())
 	{
-		m_FHDevice,
-		indexSize,
-		m_IndexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
+		shortIndices.assign(indices.begin(), indices.end());
+		pIndexData = shortIndices.data();
+		m_IndexType = VK_INDEX_TYPE_UINT16;
+	}
 
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*)indices.data());
+	m_IndexHandle = m_FHGeometryPool.AllocateIndices(pIndexData, m_IndexType, m_IndexCount);
+}
+
+void FH::FHModel::CreateMeshletBuffer(std::span<const FHMeshlet> meshlets)
+{
+	m_MeshletCount = static_cast<uint32_t>(meshlets.size());
+	if (m_MeshletCount == 0) return;
 
-	m_pIndexBuffer = std::make_unique<FHBuffer>
+	uint32_t meshletSize = sizeof(FHMeshlet);
+	VkDeviceSize bufferSize{ static_cast<VkDeviceSize>(meshletSize) * m_MeshletCount };
+
+	m_pMeshletBuffer = std::make_unique<FHBuffer>
 		(
 			m_FHDevice,
-			indexSize,
-			m_IndexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			meshletSize,
+			m_MeshletCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-	m_FHDevice.CopyBuffer(stagingBuffer.GetBuffer(), m_pIndexBuffer->GetBuffer(), bufferSize);
+	m_FHDevice.GetUploadContext().CopyToBuffer(m_pMeshletBuffer->GetBuffer(), 0, meshlets.data(), bufferSize);
 }
 
-std::unique_ptr<FH::FHModel> FH::FHModel::CreateModelFromFile(FHDevice& device, const std::string& filePath)
+namespace
 {
-	ModelData data{};
-	data.LoadModel("resources/" + filePath);
+	//Cold start: parse, process and write the cache for next time
+	FH::FHModel::ModelData ImportModelData(const std::string& sourcePath, const FH::FHModelLoadOptions& options,
+		uint64_t sourceHash, const FH::FHSourceStamp& sourceStamp)
+	{
+		FH::FHModel::ModelData data{};
+		data.LoadModel(sourcePath, options.printStats);
+		if (options.optimize)
+			data.Optimize(options.printStats);
+		if (options.generateLods)
+			data.BuildLods(options.printStats);
+		if (options.buildMeshlets)
+			data.BuildMeshlets(options.printStats);
+		const uint32_t cacheFlags{ FH::FHMeshCache::GetFlags(options) };
+		FH::FHMeshCache::Write(FH::FHMeshCache::GetCachePath(sourcePath, cacheFlags), data, sourceHash, sourceStamp, cacheFlags);
+		return data;
+	}
+
+	//Opens the cache when it matches the source. The size and write time are checked first, the source is only hashed
+	//when they changed and pKnownHash was not taken at the current stamp. A touched source with the same content gets the
+	//cache restamped. Returns false when the source cannot be read, hash is then left at 0
+	bool OpenCache(const std::string& sourcePath, uint32_t cacheFlags, std::unique_ptr<FH::FHMeshCache>& pCache,
+		uint64_t& sourceHash, FH::FHSourceStamp& sourceStamp, const FH::FHSourceHash* pKnownHash = nullptr)
+	{
+		if (!FH::FHMeshCache::StampSourceFile(sourcePath, sourceStamp))
+			return false;
+
+		const std::string cachePath{ FH::FHMeshCache::GetCachePath(sourcePath, cacheFlags) };
+		pCache = std::make_unique<FH::FHMeshCache>(cachePath);
+		if (pCache->IsCurrent(sourceStamp, cacheFlags))
+		{
+			sourceHash = pCache->GetHeader().sourceHash;
+			return true;
+		}
+
+		uint64_t sourceSize{ sourceStamp.size };
+		if (pKnownHash && pKnownHash->stamp == sourceStamp)
+			sourceHash = pKnownHash->hash;
+		else if (!FH::FHMeshCache::HashSourceFile(sourcePath, sourceHash, sourceSize))
+			return false;
+
+		if (!pCache->IsValid(sourceHash, sourceSize, cacheFlags))
+		{
+			pCache.reset();
+			return true;
+		}
+
+		//Unmapped first, Windows does not share a mapped file for writing
+		pCache.reset();
+		FH::FHMeshCache::Restamp(cachePath, sourceStamp);
+		pCache = std::make_unique<FH::FHMeshCache>(cachePath);
+		if (!pCache->IsValid(sourceHash, sourceSize, cacheFlags))
+			pCache.reset();
+		return true;
+	}
+}
+
+std::unique_ptr<FH::FHModel> FH::FHModel::CreateModelFromFile(FHGeometryPool& geometryPool, const std::string& filePath,
+	const FHModelLoadOptions& options, const FHSourceHash* pSourceHash)
+{
+	const std::string sourcePath{ "resources/" + filePath };
+
+	std::unique_ptr<FHMeshCache> pCache{};
+	uint64_t sourceHash{};
+	FHSourceStamp sourceStamp{};
+	if (OpenCache(sourcePath, FH::FHMeshCache::GetFlags(options), pCache, sourceHash, sourceStamp, pSourceHash) && pCache)
+	{
+		//Warm start: the mapped cache is copied straight into the staging buffers
+		std::cout << "Vertex count: " << pCache->GetVertices().size() << " (cached)" << std::endl;
+		return std::make_unique<FHModel>(geometryPool, pCache->GetVertices(), pCache->GetIndices(),
+			options.vertexFormat, pCache->GetMeshlets(), pCache->GetLods(), options.positionStream);
+	}
+
+	const ModelData data{ ImportModelData(sourcePath, options, sourceHash, sourceStamp) };
+
 	std::cout << "Vertex count: " << data.vertices.size() << std::endl;
-	return std::make_unique<FHModel>(device, data);
+	return std::make_unique<FHModel>(geometryPool, data, options.vertexFormat, options.positionStream);
+}
+
+FH::FHModel::ModelData FH::FHModel::LoadModelData(const std::string& filePath, const FHModelLoadOptions& options)
+{
+	const std::string sourcePath{ "resources/" + filePath };
+
+	std::unique_ptr<FHMeshCache> pCache{};
+	uint64_t sourceHash{};
+	FHSourceStamp sourceStamp{};
+	if (OpenCache(sourcePath, FH::FHMeshCache::GetFlags(options), pCache, sourceHash, sourceStamp) && pCache)
+	{
+		ModelData data{};
+		data.vertices.assign(pCache->GetVertices().begin(), pCache->GetVertices().end());
+		data.indices.assign(pCache->GetIndices().begin(), pCache->GetIndices().end());
+		data.meshlets.assign(pCache->GetMeshlets().begin(), pCache->GetMeshlets().end());
+		data.lods.assign(pCache->GetLods().begin(), pCache->GetLods().end());
+		return data;
+	}
+
+	return ImportModelData(sourcePath, options, sourceHash, sourceStamp);
+}
+
+void FH::FHModel::InspectModelData(const std::string& filePath, const FHModelLoadOptions& options, const Inspect& inspect)
+{
+	const std::string sourcePath{ "resources/" + filePath };
+
+	std::unique_ptr<FHMeshCache> pCache{};
+	uint64_t sourceHash{};
+	FHSourceStamp sourceStamp{};
+	if (OpenCache(sourcePath, FH::FHMeshCache::GetFlags(options), pCache, sourceHash, sourceStamp) && pCache)
+	{
+		inspect(pCache->GetVertices(), pCache->GetIndices(), pCache->GetLods());
+		return;
+	}
+
+	const ModelData data{ ImportModelData(sourcePath, options, sourceHash, sourceStamp) };
+	inspect(data.vertices, data.indices, data.lods);
+}
+
+const FH::FHModel::SubMesh* FH::FHModel::FindSubMesh(uint32_t index) const
+{
+	//Sub meshes are sorted on firstIndex and do not overlap
+	const auto it{ std::upper_bound(m_SubMeshes.begin(), m_SubMeshes.end(), index,
+		[](uint32_t value, const SubMesh& subMesh) { return value < subMesh.firstIndex; }) };
+	if (it == m_SubMeshes.begin())
+		return nullptr;
+
+	const SubMesh& subMesh{ *(it - 1) };
+	return index < subMesh.firstIndex + subMesh.indexCount ? &subMesh : nullptr;
 }
 
 void FH::FHModel::Bind(VkCommandBuffer commandBuffer)
 {
-	VkBuffer buffers[]{ m_pVertexBuffer->GetBuffer() };
+	VkBuffer buffers[]{ GetVertexBuffer() };
 	VkDeviceSize offsets[]{ 0 };
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
 	if (m_HasIndexBuffer)
-		vkCmdBindIndexBuffer(commandBuffer, m_pIndexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(commandBuffer, GetIndexBuffer(), 0, m_IndexType);
 
 }
 
-void FH::FHModel::Draw(VkCommandBuffer commandBuffer)
+void FH::FHModel::Draw(VkCommandBuffer commandBuffer, uint32_t lodIdx)
 {
 	if (m_HasIndexBuffer)
-		vkCmdDrawIndexed(commandBuffer, m_IndexCount, 1, 0, 0, 0);
+	{
+		const Lod& lod{ m_Lods[std::min(lodIdx, GetLodCount() - 1)] };
+		vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, GetFirstIndex() + lod.firstIndex, GetVertexOffset(), 0);
+	}
 	else
-		vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0);
+		vkCmdDraw(commandBuffer, m_VertexCount, 1, static_cast<uint32_t>(GetVertexOffset()), 0);
 	
 }
 
+void FH::FHModel::BindPositions(VkCommandBuffer commandBuffer)
+{
+	VkBuffer buffers[]{ m_FHGeometryPool.GetRange(m_PositionHandle).buffer };
+	VkDeviceSize offsets[]{ 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+	if (m_HasIndexBuffer)
+		vkCmdBindIndexBuffer(commandBuffer, GetIndexBuffer(), 0, m_IndexType);
+}
+
+void FH::FHModel::DrawPositions(VkCommandBuffer commandBuffer, uint32_t lodIdx)
+{
+	if (m_HasIndexBuffer)
+	{
+		const Lod& lod{ m_Lods[std::min(lodIdx, GetLodCount() - 1)] };
+		vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, GetFirstIndex() + lod.firstIndex, GetPositionOffset(), 0);
+	}
+	else
+		vkCmdDraw(commandBuffer, m_VertexCount, 1, static_cast<uint32_t>(GetPositionOffset()), 0);
+}
+
+void FH::FHModel::BindCulled(VkCommandBuffer commandBuffer, VkBuffer culledIndexBuffer)
+{
+	VkBuffer buffers[]{ GetVertexBuffer() };
+	VkDeviceSize offsets[]{ 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+	vkCmdBindIndexBuffer(commandBuffer, culledIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void FH::FHModel::BindPositionsCulled(VkCommandBuffer commandBuffer, VkBuffer culledIndexBuffer)
+{
+	VkBuffer buffers[]{ m_FHGeometryPool.GetRange(m_PositionHandle).buffer };
+	VkDeviceSize offsets[]{ 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+	vkCmdBindIndexBuffer(commandBuffer, culledIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void FH::FHModel::DrawIndirect(VkCommandBuffer commandBuffer, VkBuffer drawCommandBuffer, VkDeviceSize offset)
+{
+	vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
 std::vector<VkVertexInputBindingDescription> FH::FHModel::Vertex::GetBindingDescriptions()
 {
 	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
@@ -222,7 +414,71 @@ std::vector<VkVertexInputAttributeDescription> FH::FHModel::Vertex::GetAttribute
 	//UV
 	attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
 	//Tangent
-	attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent) });
+	attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, tangent) });
+
+	return attributeDescriptions;
+}
+
+FH::FHModel::CompactVertex FH::FHModel::CompactVertex::Pack(const Vertex& vertex, const glm::vec3& boundsMin,
+	const glm::vec3& quantizeScale)
+{
+	CompactVertex compact{};
+
+	const glm::vec3 quantized{ (vertex.pos - boundsMin) * quantizeScale };
+	for (int component = 0; component < 3; ++component)
+		compact.pos[component] = static_cast<uint16_t>(std::clamp(std::round(quantized[component]), 0.f, 65535.f));
+
+	PackOctahedral(vertex.normal, compact.normal);
+	PackOctahedral(glm::vec3{ vertex.tangent }, compact.tangent);
+	compact.pos[3] = vertex.tangent.w < 0.f ? 0 : std::numeric_limits<uint16_t>::max();
+
+	compact.uv[0] = glm::packHalf1x16(vertex.uv.x);
+	compact.uv[1] = glm::packHalf1x16(vertex.uv.y);
+	return compact;
+}
+
+std::vector<VkVertexInputBindingDescription> FH::FHModel::CompactVertex::GetBindingDescriptions()
+{
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(CompactVertex);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> FH::FHModel::CompactVertex::GetAttributeDescriptions()
+{
+	//Same locations as Vertex, decoded in shader_compact.vert
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+	//Position
+	attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, pos) });
+	//Normal
+	attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal) });
+	//UV
+	attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv) });
+	//Tangent
+	attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, tangent) });
+
+	return attributeDescriptions;
+}
+
+std::vector<VkVertexInputBindingDescription> FH::FHModel::GetPositionBindingDescriptions(FHVertexFormat format)
+{
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = format == FHVertexFormat::Compact ? sizeof(uint16_t) * 4 : sizeof(glm::vec3);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> FH::FHModel::GetPositionAttributeDescriptions(FHVertexFormat format)
+{
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+	//Position
+	if (format == FHVertexFormat::Compact)
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, 0 });
+	else
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 });
 
 	return attributeDescriptions;
 }
@@ -244,18 +500,6 @@ void FH::FHModel2D::CreateVertexBuffers(const std::vector<Vertex2D>& vertices)
 	uint32_t vertexSize = sizeof(vertices[0]);
 	VkDeviceSize bufferSize = vertexSize * m_VertexCount;
 
-	FHBuffer stagingBuffer
-	{
-		m_FHDevice,
-		vertexSize,
-		m_VertexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
-
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*)vertices.data());
-
 	m_pVertexBuffer = std::make_unique<FHBuffer>
 		(
 			m_FHDevice,
@@ -265,7 +509,7 @@ void FH::FHModel2D::CreateVertexBuffers(const std::vector<Vertex2D>& vertices)
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-	m_FHDevice.CopyBuffer(stagingBuffer.GetBuffer(), m_pVertexBuffer->GetBuffer(), bufferSize);
+	m_FHDevice.GetUploadContext().CopyToBuffer(m_pVertexBuffer->GetBuffer(), 0, vertices.data(), bufferSize);
 }
 
 void FH::FHModel2D::Bind(VkCommandBuffer commandBuffer)
@@ -1,15 +1,39 @@
 #pragma once
 #include "buffer.h"
 #include "device.h"
+#include "geometryPool.h"
+#include "meshlet.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <functional>
 #include <memory>
+#include <span>
+#include <vector>
 
 namespace FH
 {
+	struct FHSourceHash;
+
+	enum class FHVertexFormat
+	{
+		Standard,	//FHModel::Vertex, full floats
+		Compact		//FHModel::CompactVertex, quantized
+	};
+
+	//Import settings, models imported with different settings get their own mesh cache entry
+	struct FHModelLoadOptions
+	{
+		bool optimize{ true };		//vertex cache, overdraw and vertex fetch reordering
+		bool printStats{ false };	//import time, ACMR/ATVR and overdraw, LOD and meshlet counts of cold imports
+		FHVertexFormat vertexFormat{ FHVertexFormat::Standard };
+		bool buildMeshlets{ true };	//clusters for FHCullingSystem
+		bool generateLods{ true };	//simplified index buffers picked by screen space error
+		bool positionStream{ false };	//extra deinterleaved positions for depth only passes
+	};
+
 	class FHModel
 	{
 	public:
@@ -17,10 +41,9 @@ namespace FH
 		struct Vertex
 		{
 			glm::vec3 pos{};
-			glm::vec3 color{1.f};
 			glm::vec3 normal{};
 			glm::vec2 uv{};
-			glm::vec3 tangent{};
+			glm::vec4 tangent{};	//w is the bitangent sign
 
 			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
 			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
@@ -28,46 +51,179 @@ namespace FH
 			bool operator==(const Vertex& other) const 
 			{
 				return pos == other.pos && 
-					color == other.color &&
 					normal == other.normal &&
 					uv == other.uv;
 			}
 		};
 
+		//Position quantized to the mesh bounds (w is the bitangent sign, 0 for -1), octahedral normal and tangent, half float uv.
+		//The bounds are folded into the model matrix, see GetDequantizeMatrix
+		struct CompactVertex
+		{
+			uint16_t pos[4]{};
+			int16_t normal[2]{};
+			int16_t tangent[2]{};
+			uint16_t uv[2]{};
+
+			//quantizeScale is 65535 / extent of the bounds per axis, 0 for flat axes
+			static CompactVertex Pack(const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& quantizeScale);
+
+			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		};
+
+		static constexpr uint32_t MAX_LOD_COUNT{ 5 };
+
+		//Range of the shared index buffer, every LOD indexes the same vertices
+		struct Lod
+		{
+			uint32_t firstIndex{};
+			uint32_t indexCount{};
+			uint32_t firstMeshlet{};
+			uint32_t meshletCount{};
+			float error{};	//model space distance to the full detail surface, 0 for LOD 0
+		};
+
+		//Range of LOD 0 that came from one source object of a static batch, for picking and culling
+		struct SubMesh
+		{
+			uint32_t objectId{};
+			uint32_t firstIndex{};
+			uint32_t indexCount{};
+			glm::vec4 boundingSphere{};	//model space
+		};
+
 		struct ModelData
 		{
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			std::vector<FHMeshlet> meshlets{};
+			std::vector<Lod> lods{};
+
+			//Picks the importer from the extension, .glb or .obj
+			void LoadModel(const std::string& filePath, bool printStats = false);
+			void LoadObj(const std::string& filePath);
+			void LoadGltf(const std::string& filePath);
 
-			void LoadModel(const std::string& filePath);
+			//Per vertex tangents from positions, normals and uvs
+			void GenerateTangents();
+
+			//Reorders indices for the post-transform cache and overdraw, then vertices for fetch locality
+			void Optimize(bool printStats = false);
+
+			//Appends simplified copies of the index buffer, each with half the triangles of the previous one.
+			//Call after Optimize
+			void BuildLods(bool printStats = false);
+
+			//Splits every LOD in meshlets, call after Optimize and BuildLods
+			void BuildMeshlets(bool printStats = false);
 		};
 
-		FHModel(FHDevice& device, const ModelData& construction);
-		~FHModel() = default;
+		//Vertices and indices are sub-allocated from the pool, which has to outlive the model
+		FHModel(FHGeometryPool& geometryPool, const ModelData& construction, FHVertexFormat format = FHVertexFormat::Standard,
+			bool positionStream = false);
+		FHModel(FHGeometryPool& geometryPool, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+			FHVertexFormat format = FHVertexFormat::Standard, std::span<const FHMeshlet> meshlets = {},
+			std::span<const Lod> lods = {}, bool positionStream = false);
+		~FHModel();
 
 		FHModel(const FHModel&) = delete;
 		FHModel& operator=(const FHModel&) = delete;
 
-		static std::unique_ptr<FHModel> CreateModelFromFile(
-			FHDevice& device, const std::string& filePath);
+		//pSourceHash is the hash the caller already took of the file, used instead of reading it again while the stamp matches
+		static std::unique_ptr<FHModel> CreateModelFromFile(FHGeometryPool& geometryPool, const std::string& filePath,
+			const FHModelLoadOptions& options = {}, const FHSourceHash* pSourceHash = nullptr);
+		//Same import and mesh cache as CreateModelFromFile, but the result stays on the host
+		static ModelData LoadModelData(const std::string& filePath, const FHModelLoadOptions& options = {});
+		//Lends inspect the arrays CreateModelFromFile would upload, mapped from the mesh cache when it is current and
+		//imported and cached otherwise. A warm start copies nothing to the host, a cold one leaves the cache for the next load
+		using Inspect = std::function<void(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const Lod> lods)>;
+		static void InspectModelData(const std::string& filePath, const FHModelLoadOptions& options, const Inspect& inspect);
 
+		//Binds the pool buffers holding this model, skip it when another model of the same pool
+		//buffers is already bound, Draw only needs the offsets
 		void Bind(VkCommandBuffer commandBuffer);
-		void Draw(VkCommandBuffer commandBuffer);
+		void Draw(VkCommandBuffer commandBuffer, uint32_t lodIdx = 0);
+
+		//Position stream only, for pipelines made with GetPositionBindingDescriptions
+		void BindPositions(VkCommandBuffer commandBuffer);
+		void DrawPositions(VkCommandBuffer commandBuffer, uint32_t lodIdx = 0);
+
+		//Draws with an index buffer and indirect command written by FHCullingSystem
+		void BindCulled(VkCommandBuffer commandBuffer, VkBuffer culledIndexBuffer);
+		void BindPositionsCulled(VkCommandBuffer commandBuffer, VkBuffer culledIndexBuffer);
+		void DrawIndirect(VkCommandBuffer commandBuffer, VkBuffer drawCommandBuffer, VkDeviceSize offset = 0);
+
+		//Single binding with only the position attribute at location 0, in the format the vertex format stores it
+		static std::vector<VkVertexInputBindingDescription> GetPositionBindingDescriptions(FHVertexFormat format);
+		static std::vector<VkVertexInputAttributeDescription> GetPositionAttributeDescriptions(FHVertexFormat format);
+
+		FHVertexFormat GetVertexFormat() const { return m_VertexFormat; }
+
+		bool HasPositionStream() const { return m_PositionHandle != FHGeometryPool::INVALID_HANDLE; }
+		int32_t GetPositionOffset() const { return static_cast<int32_t>(m_FHGeometryPool.GetRange(m_PositionHandle).offset); }
+
+		bool HasMeshlets() const { return m_MeshletCount > 0; }
+		uint32_t GetMeshletCount() const { return m_MeshletCount; }
+		uint32_t GetIndexCount() const { return m_IndexCount; }
+
+		uint32_t GetLodCount() const { return static_cast<uint32_t>(m_Lods.size()); }
+		const Lod& GetLod(uint32_t lodIdx) const { return m_Lods[lodIdx]; }
+
+		//Model space xyz center and w radius
+		const glm::vec4& GetBoundingSphere() const { return m_BoundingSphere; }
+
+		void SetSubMeshes(std::vector<SubMesh> subMeshes) { m_SubMeshes = std::move(subMeshes); }
+		std::span<const SubMesh> GetSubMeshes() const { return m_SubMeshes; }
+		//Sub mesh holding the triangle that starts at this LOD 0 index, nullptr when there is none
+		const SubMesh* FindSubMesh(uint32_t index) const;
+		VkDescriptorBufferInfo GetMeshletBufferInfo() const { return m_pMeshletBuffer->GetDescriptorInfo(); }
+		VkDescriptorBufferInfo GetIndexBufferInfo() const { return m_FHGeometryPool.GetDescriptorInfo(m_IndexHandle); }
+
+		VkBuffer GetVertexBuffer() const { return m_FHGeometryPool.GetRange(m_VertexHandle).buffer; }
+		VkBuffer GetPositionBuffer() const { return m_FHGeometryPool.GetRange(m_PositionHandle).buffer; }
+		VkBuffer GetIndexBuffer() const { return m_FHGeometryPool.GetRange(m_IndexHandle).buffer; }
+		VkIndexType GetIndexType() const { return m_IndexType; }
+		//Offsets inside the pool buffers, they change when the pool is compacted
+		int32_t GetVertexOffset() const { return static_cast<int32_t>(m_FHGeometryPool.GetRange(m_VertexHandle).offset); }
+		uint32_t GetFirstIndex() const { return m_FHGeometryPool.GetRange(m_IndexHandle).offset; }
+
+		//Maps quantized positions back to model space, identity for the standard format
+		const glm::mat4& GetDequantizeMatrix() const { return m_DequantizeMatrix; }
 
 	private:
-		void CreateVertexBuffers(const std::vector<Vertex>& vertices);
-		void CreateIndexBuffers(const std::vector<uint32_t>& indices);
+		void CreateVertexBuffers(const void* pVertices, uint32_t vertexSize, uint32_t vertexCount);
+		void CreateCompactVertexBuffers(std::span<const Vertex> vertices, bool positionStream);
+		void CreatePositionBuffer(const void* pPositions, uint32_t positionSize);
+		void CreateIndexBuffers(std::span<const uint32_t> indices);
+		void CreateMeshletBuffer(std::span<const FHMeshlet> meshlets);
 
 		FHDevice& m_FHDevice;
+		FHGeometryPool& m_FHGeometryPool;
 
-		std::unique_ptr<FHBuffer> m_pVertexBuffer;
+		FHVertexFormat m_VertexFormat{ FHVertexFormat::Standard };
+		std::vector<SubMesh> m_SubMeshes{};
+		glm::mat4 m_DequantizeMatrix{ 1.f };
+
+		uint32_t m_VertexHandle{ FHGeometryPool::INVALID_HANDLE };
 		uint32_t m_VertexCount = 0;
 
+		uint32_t m_PositionHandle{ FHGeometryPool::INVALID_HANDLE };
+
 		bool m_HasIndexBuffer{ false };
-		std::unique_ptr<FHBuffer> m_pIndexBuffer;
+		uint32_t m_IndexHandle{ FHGeometryPool::INVALID_HANDLE };
 		uint32_t m_IndexCount = 0;
+		VkIndexType m_IndexType{ VK_INDEX_TYPE_UINT32 };
+
+		std::unique_ptr<FHBuffer> m_pMeshletBuffer;
+		uint32_t m_MeshletCount = 0;
+
+		std::vector<Lod> m_Lods{};
+		glm::vec4 m_BoundingSphere{};
 	};
 
+	static_assert(sizeof(FHModel::CompactVertex) == 20, "CompactVertex must stay tightly packed");
+
 	class FHModel2D
 	{
 	public:
@@ -0,0 +1,240 @@
+#include "model.h"
+#include "gltfLoader.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include "objLoader.h"
+#include "tangentGenerator.h"
+#include "vertexWelder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+//CPU side of FHModel: importing, optimizing and building LODs and meshlets, no device needed
+
+void FH::FHModel::ModelData::LoadModel(const std::string& filePath, bool printStats)
+{
+	const auto loadStart{ std::chrono::steady_clock::now() };
+
+	if (filePath.ends_with(".glb"))
+		LoadGltf(filePath);
+	else
+		LoadObj(filePath);
+
+	const std::chrono::duration<double, std::milli> loadMillis{ std::chrono::steady_clock::now() - loadStart };
+	if (printStats)
+		std::cout << "Imported " << filePath << " in " << loadMillis.count() << "ms" << std::endl;
+}
+
+void FH::FHModel::ModelData::LoadObj(const std::string& filePath)
+{
+	const FHObjLoader::Result obj{ FHObjLoader::Load(filePath) };
+
+	vertices.clear();
+	indices.clear();
+	indices.reserve(obj.indices.size());
+
+	FHVertexWelder welder{ obj.indices.size() };
+
+	for (const auto& index : obj.indices)
+	{
+		Vertex vertex{};
+		if (index.vertex >= 0)
+		{
+			vertex.pos = {
+				obj.positions[3 * index.vertex + 0],
+				obj.positions[3 * index.vertex + 1],
+				obj.positions[3 * index.vertex + 2]
+			};
+		}
+		if (index.normal >= 0)
+		{
+			vertex.normal = {
+				obj.normals[3 * index.normal + 0],
+				obj.normals[3 * index.normal + 1],
+				obj.normals[3 * index.normal + 2]
+			};
+		}
+		if (index.texcoord >= 0)
+		{
+			vertex.uv = {
+				obj.texcoords[2 * index.texcoord + 0],
+				obj.texcoords[2 * index.texcoord + 1]
+			};
+		}
+
+		const uint32_t vertexIdx{ welder.Weld(vertex.pos, vertex.normal, vertex.uv) };
+		if (vertexIdx == vertices.size())
+			vertices.push_back(vertex);
+		indices.push_back(vertexIdx);
+	}
+
+	GenerateTangents();
+}
+
+void FH::FHModel::ModelData::LoadGltf(const std::string& filePath)
+{
+	const FHGltfLoader::Result gltf{ FHGltfLoader::Load(filePath) };
+
+	//glTF is indexed already, the attributes go into the vertices as they are
+	vertices.resize(gltf.positions.size());
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+	{
+		Vertex& vertex{ vertices[vertexIdx] };
+		vertex.pos = gltf.positions[vertexIdx];
+		if (!gltf.normals.empty())
+			vertex.normal = gltf.normals[vertexIdx];
+		if (!gltf.uvs.empty())
+			vertex.uv = gltf.uvs[vertexIdx];
+		if (!gltf.tangents.empty())
+			vertex.tangent = gltf.tangents[vertexIdx];
+	}
+	indices.assign(gltf.indices.begin(), gltf.indices.end());
+
+	//Exported tangents are MikkTSpace already, only generate them when missing
+	if (gltf.tangents.empty())
+		GenerateTangents();
+}
+
+void FH::FHModel::ModelData::GenerateTangents()
+{
+	std::vector<glm::vec3> positions(vertices.size());
+	std::vector<glm::vec3> normals(vertices.size());
+	std::vector<glm::vec2> uvs(vertices.size());
+	std::vector<glm::vec4> tangents(vertices.size());
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+	{
+		positions[vertexIdx] = vertices[vertexIdx].pos;
+		normals[vertexIdx] = vertices[vertexIdx].normal;
+		uvs[vertexIdx] = vertices[vertexIdx].uv;
+	}
+
+	FHTangentGenerator::Generate(positions, normals, uvs, indices, tangents);
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+		vertices[vertexIdx].tangent = tangents[vertexIdx];
+}
+
+void FH::FHModel::ModelData::Optimize(bool printStats)
+{
+	std::vector<glm::vec3> positions(vertices.size());
+	std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const Vertex& vertex) { return vertex.pos; });
+
+	auto PrintStats = [&](const char* label)
+		{
+			const auto cacheStats{ FHMeshOptimizer::AnalyzeVertexCache(indices, vertices.size()) };
+			const auto overdrawStats{ FHMeshOptimizer::AnalyzeOverdraw(indices, positions) };
+			std::cout << label << " ACMR: " << cacheStats.acmr << " ATVR: " << cacheStats.atvr
+				<< " Overdraw: " << overdrawStats.overdraw << std::endl;
+		};
+
+	if (printStats)
+		PrintStats("Before optimizing ->");
+
+	std::vector<uint32_t> clusters{};
+	FHMeshOptimizer::OptimizeVertexCache(indices, vertices.size(), clusters);
+	FHMeshOptimizer::OptimizeOverdraw(indices, positions, clusters);
+
+	const std::vector<uint32_t> remap{ FHMeshOptimizer::OptimizeVertexFetch(indices, vertices.size()) };
+	std::vector<Vertex> remappedVertices(vertices.size());
+	size_t usedVertexCount{};
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+	{
+		if (remap[vertexIdx] == UINT32_MAX)
+			continue;
+
+		remappedVertices[remap[vertexIdx]] = vertices[vertexIdx];
+		positions[remap[vertexIdx]] = vertices[vertexIdx].pos;
+		++usedVertexCount;
+	}
+	remappedVertices.resize(usedVertexCount);
+	positions.resize(usedVertexCount);
+	vertices = std::move(remappedVertices);
+
+	if (printStats)
+		PrintStats("After optimizing  ->");
+}
+
+void FH::FHModel::ModelData::BuildLods(bool printStats)
+{
+	//Each LOD halves the previous one, stop once a level barely gets smaller or drifts too far
+	constexpr float maxRelativeError{ 0.05f };
+	constexpr float minReduction{ 0.85f };
+
+	std::vector<glm::vec3> positions(vertices.size());
+	std::vector<glm::vec3> normals(vertices.size());
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+	{
+		positions[vertexIdx] = vertices[vertexIdx].pos;
+		normals[vertexIdx] = vertices[vertexIdx].normal;
+	}
+
+	const float scale{ FHMeshSimplifier::GetScale(positions) };
+
+	lods.clear();
+	lods.push_back(Lod{ 0, static_cast<uint32_t>(indices.size()) });
+
+	std::vector<uint32_t> lodIndices{ indices };
+	std::vector<uint32_t> clusters{};
+	while (lods.size() < MAX_LOD_COUNT)
+	{
+		const size_t targetIndexCount{ lodIndices.size() / 6 * 3 };
+		float relativeError{};
+		std::vector<uint32_t> simplified{ FHMeshSimplifier::Simplify(positions, normals, lodIndices,
+			targetIndexCount, maxRelativeError, &relativeError) };
+
+		if (printStats && simplified.size() > targetIndexCount)
+			std::cout << "LOD " << lods.size() << " stopped at " << simplified.size() / 3 << " of "
+				<< targetIndexCount / 3 << " triangles, error limit reached" << std::endl;
+
+		if (simplified.empty() || simplified.size() > lodIndices.size() * minReduction)
+			break;
+
+		FHMeshOptimizer::OptimizeVertexCache(simplified, vertices.size(), clusters);
+
+		//Every level simplifies the previous one, so the errors add up
+		Lod lod{};
+		lod.firstIndex = static_cast<uint32_t>(indices.size());
+		lod.indexCount = static_cast<uint32_t>(simplified.size());
+		lod.error = lods.back().error + relativeError * scale;
+		lods.push_back(lod);
+
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		lodIndices = std::move(simplified);
+	}
+
+	for (size_t lodIdx = 0; printStats && lodIdx < lods.size(); ++lodIdx)
+		std::cout << "LOD " << lodIdx << ": " << lods[lodIdx].indexCount / 3
+			<< " triangles, error " << lods[lodIdx].error << std::endl;
+}
+
+void FH::FHModel::ModelData::BuildMeshlets(bool printStats)
+{
+	std::vector<glm::vec3> positions(vertices.size());
+	std::vector<glm::vec3> normals(vertices.size());
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+	{
+		positions[vertexIdx] = vertices[vertexIdx].pos;
+		normals[vertexIdx] = vertices[vertexIdx].normal;
+	}
+
+	if (lods.empty())
+		lods.push_back(Lod{ 0, static_cast<uint32_t>(indices.size()) });
+
+	meshlets.clear();
+	for (Lod& lod : lods)
+	{
+		const std::span<const uint32_t> lodIndices{ std::span<const uint32_t>{ indices }.subspan(lod.firstIndex, lod.indexCount) };
+		std::vector<FHMeshlet> lodMeshlets{ FHMeshletBuilder::Build(positions, normals, lodIndices) };
+
+		lod.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+		lod.meshletCount = static_cast<uint32_t>(lodMeshlets.size());
+		for (FHMeshlet& meshlet : lodMeshlets)
+		{
+			meshlet.firstIndex += lod.firstIndex;
+			meshlets.push_back(meshlet);
+		}
+	}
+
+	if (printStats)
+		std::cout << "Meshlet count: " << meshlets.size() << std::endl;
+}
\ No newline at end of file
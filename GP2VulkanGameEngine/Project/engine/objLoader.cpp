@@ -0,0 +1,393 @@
+#include "objLoader.h"
+#include "mappedFile.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	constexpr int32_t MISSING_INDEX{ std::numeric_limits<int32_t>::min() };
+	constexpr size_t MIN_CHUNK_SIZE{ 1 << 20 };
+
+	enum RelativeFlags : uint8_t
+	{
+		VERTEX_RELATIVE = 1 << 0,
+		NORMAL_RELATIVE = 1 << 1,
+		TEXCOORD_RELATIVE = 1 << 2
+	};
+
+	//Corner as it appears in a chunk. Negative (relative) OBJ indices are resolved against the
+	//chunk local attribute count and get the counts of all previous chunks added when merging.
+	struct RawIndex
+	{
+		int32_t vertex{ MISSING_INDEX };
+		int32_t normal{ MISSING_INDEX };
+		int32_t texcoord{ MISSING_INDEX };
+		uint8_t relativeFlags{};
+	};
+
+	struct Chunk
+	{
+		const char* pBegin{};
+		const char* pEnd{};
+
+		std::vector<float> positions{};
+		std::vector<float> normals{};
+		std::vector<float> texcoords{};
+		std::vector<RawIndex> indices{};
+	};
+
+	inline bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+	inline bool IsDigit(char c) { return static_cast<unsigned int>(c - '0') < 10u; }
+	inline bool IsTokenEnd(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	inline const char* SkipSpaces(const char* p, const char* pEnd)
+	{
+		while (p < pEnd && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	inline const char* FindTokenEnd(const char* p, const char* pEnd)
+	{
+		while (p < pEnd && !IsTokenEnd(*p))
+			++p;
+		return p;
+	}
+
+	//Same digit accumulation as tinyobj's tryParseDouble, so both loaders round every value
+	//identically. No locale, no allocation and never reads past pEnd.
+	bool ParseDouble(const char* p, const char* pEnd, double& result)
+	{
+		if (p >= pEnd)
+			return false;
+
+		double mantissa{};
+		int exponent{};
+		bool negative{};
+
+		if (*p == '+' || *p == '-')
+		{
+			negative = *p == '-';
+			++p;
+		}
+		else if (!IsDigit(*p))
+			return false;
+
+		int read{};
+		while (p < pEnd && IsDigit(*p))
+		{
+			mantissa *= 10;
+			mantissa += static_cast<int>(*p - '0');
+			++p;
+			++read;
+		}
+		if (read == 0)
+			return false;
+
+		if (p < pEnd && *p == '.')
+		{
+			static constexpr double POW_LUT[]{ 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+			constexpr int LUT_ENTRIES{ sizeof(POW_LUT) / sizeof(POW_LUT[0]) };
+
+			++p;
+			read = 1;
+			while (p < pEnd && IsDigit(*p))
+			{
+				mantissa += static_cast<int>(*p - '0') * (read < LUT_ENTRIES ? POW_LUT[read] : std::pow(10.0, -read));
+				++read;
+				++p;
+			}
+		}
+
+		if (p < pEnd && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			bool negativeExponent{};
+			if (p < pEnd && (*p == '+' || *p == '-'))
+			{
+				negativeExponent = *p == '-';
+				++p;
+			}
+			else if (p >= pEnd || !IsDigit(*p))
+				return false;
+
+			read = 0;
+			while (p < pEnd && IsDigit(*p))
+			{
+				exponent *= 10;
+				exponent += static_cast<int>(*p - '0');
+				++p;
+				++read;
+			}
+			if (read == 0)
+				return false;
+			if (negativeExponent)
+				exponent = -exponent;
+		}
+
+		result = (negative ? -1 : 1) *
+			(exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+		return true;
+	}
+
+	inline float ParseFloat(const char*& p, const char* pLineEnd)
+	{
+		p = SkipSpaces(p, pLineEnd);
+		const char* pTokenEnd{ FindTokenEnd(p, pLineEnd) };
+
+		double value{};
+		ParseDouble(p, pTokenEnd, value);
+
+		p = pTokenEnd;
+		return static_cast<float>(value);
+	}
+
+	inline int32_t ParseInt(const char*& p, const char* pLineEnd)
+	{
+		bool negative{};
+		if (p < pLineEnd && (*p == '+' || *p == '-'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		int32_t value{};
+		while (p < pLineEnd && IsDigit(*p))
+		{
+			value = value * 10 + (*p - '0');
+			++p;
+		}
+		return negative ? -value : value;
+	}
+
+	//Zero based like tinyobj's fixIndex, relative indices are flagged for the merge step
+	inline int32_t FixIndex(int32_t index, size_t localCount, uint8_t relativeFlag, uint8_t& flags)
+	{
+		if (index > 0)
+			return index - 1;
+		if (index == 0)
+			return 0;
+
+		flags |= relativeFlag;
+		return static_cast<int32_t>(localCount) + index;
+	}
+
+	inline const char* SkipIndexToken(const char* p, const char* pLineEnd)
+	{
+		while (p < pLineEnd && *p != '/' && !IsTokenEnd(*p))
+			++p;
+		return p;
+	}
+
+	//Parses i, i/j, i//k and i/j/k
+	RawIndex ParseCorner(const char*& p, const char* pLineEnd, const Chunk& chunk)
+	{
+		RawIndex corner{};
+
+		corner.vertex = FixIndex(ParseInt(p, pLineEnd), chunk.positions.size() / 3, VERTEX_RELATIVE, corner.relativeFlags);
+		p = SkipIndexToken(p, pLineEnd);
+		if (p >= pLineEnd || *p != '/')
+			return corner;
+		++p;
+
+		if (p < pLineEnd && *p == '/')
+		{
+			++p;
+			corner.normal = FixIndex(ParseInt(p, pLineEnd), chunk.normals.size() / 3, NORMAL_RELATIVE, corner.relativeFlags);
+			p = SkipIndexToken(p, pLineEnd);
+			return corner;
+		}
+
+		corner.texcoord = FixIndex(ParseInt(p, pLineEnd), chunk.texcoords.size() / 2, TEXCOORD_RELATIVE, corner.relativeFlags);
+		p = SkipIndexToken(p, pLineEnd);
+		if (p >= pLineEnd || *p != '/')
+			return corner;
+		++p;
+
+		corner.normal = FixIndex(ParseInt(p, pLineEnd), chunk.normals.size() / 3, NORMAL_RELATIVE, corner.relativeFlags);
+		p = SkipIndexToken(p, pLineEnd);
+		return corner;
+	}
+
+	void ParseLine(const char* p, const char* pLineEnd, Chunk& chunk, std::vector<RawIndex>& face)
+	{
+		p = SkipSpaces(p, pLineEnd);
+		const ptrdiff_t length{ pLineEnd - p };
+		if (length < 2 || p[0] == '#')
+			return;
+
+		if (p[0] == 'v' && IsSpace(p[1]))
+		{
+			p += 2;
+			chunk.positions.push_back(ParseFloat(p, pLineEnd));
+			chunk.positions.push_back(ParseFloat(p, pLineEnd));
+			chunk.positions.push_back(ParseFloat(p, pLineEnd));
+			return;
+		}
+
+		if (length >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+		{
+			p += 3;
+			chunk.normals.push_back(ParseFloat(p, pLineEnd));
+			chunk.normals.push_back(ParseFloat(p, pLineEnd));
+			chunk.normals.push_back(ParseFloat(p, pLineEnd));
+			return;
+		}
+
+		if (length >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+		{
+			p += 3;
+			chunk.texcoords.push_back(ParseFloat(p, pLineEnd));
+			chunk.texcoords.push_back(ParseFloat(p, pLineEnd));
+			return;
+		}
+
+		if (p[0] == 'f' && IsSpace(p[1]))
+		{
+			p = SkipSpaces(p + 2, pLineEnd);
+
+			face.clear();
+			while (p < pLineEnd)
+			{
+				const char* pCornerBegin{ p };
+				face.push_back(ParseCorner(p, pLineEnd, chunk));
+
+				while (p < pLineEnd && IsTokenEnd(*p))
+					++p;
+				if (p == pCornerBegin)
+					++p;
+			}
+
+			//Polygon -> triangle fan, same as tinyobj
+			for (size_t k = 2; k < face.size(); ++k)
+			{
+				chunk.indices.push_back(face[0]);
+				chunk.indices.push_back(face[k - 1]);
+				chunk.indices.push_back(face[k]);
+			}
+		}
+
+		//Groups, objects and materials do not change the output: faces keep their file order.
+		//tinyobj 1.0.6 can drop a face group that a usemtl flushed right before a g/o line, we keep it.
+	}
+
+	void ParseChunk(Chunk& chunk)
+	{
+		std::vector<RawIndex> face{};
+
+		const char* p{ chunk.pBegin };
+		while (p < chunk.pEnd)
+		{
+			const char* pLineEnd{ p };
+			while (pLineEnd < chunk.pEnd && *pLineEnd != '\n' && *pLineEnd != '\r')
+				++pLineEnd;
+
+			ParseLine(p, pLineEnd, chunk, face);
+
+			p = pLineEnd;
+			if (p < chunk.pEnd && *p == '\r')
+				++p;
+			if (p < chunk.pEnd && *p == '\n')
+				++p;
+		}
+	}
+
+	inline int32_t ResolveIndex(int32_t index, bool isRelative, size_t base)
+	{
+		if (index == MISSING_INDEX)
+			return -1;
+		return isRelative ? index + static_cast<int32_t>(base) : index;
+	}
+}
+
+FH::FHObjLoader::Result FH::FHObjLoader::Load(const std::string& filePath)
+{
+	const FHMappedFile file{ filePath };
+	if (!file.IsOpen())
+		throw std::runtime_error("failed to open obj file: " + filePath);
+
+	const char* pFileBegin{ reinterpret_cast<const char*>(file.GetData()) };
+	const char* pFileEnd{ pFileBegin + file.GetSize() };
+
+	//Split the file in newline aligned chunks, one per hardware thread
+	const size_t maxChunks{ std::max<size_t>(1, std::thread::hardware_concurrency()) };
+	const size_t chunkCount{ std::clamp<size_t>(file.GetSize() / MIN_CHUNK_SIZE, 1, maxChunks) };
+
+	std::vector<Chunk> chunks(chunkCount);
+	const char* pChunkBegin{ pFileBegin };
+	for (size_t chunkIdx = 0; chunkIdx < chunkCount; ++chunkIdx)
+	{
+		const char* pChunkEnd{ pFileEnd };
+		if (chunkIdx + 1 < chunkCount)
+		{
+			pChunkEnd = std::max(pChunkBegin, pFileBegin + file.GetSize() * (chunkIdx + 1) / chunkCount);
+			const void* pNewLine{ memchr(pChunkEnd, '\n', static_cast<size_t>(pFileEnd - pChunkEnd)) };
+			pChunkEnd = pNewLine ? static_cast<const char*>(pNewLine) + 1 : pFileEnd;
+		}
+
+		chunks[chunkIdx].pBegin = pChunkBegin;
+		chunks[chunkIdx].pEnd = pChunkEnd;
+		pChunkBegin = pChunkEnd;
+	}
+
+	ParallelFor(chunks.size(), 1, [&chunks](size_t begin, size_t end)
+		{
+			for (size_t chunkIdx = begin; chunkIdx < end; ++chunkIdx)
+				ParseChunk(chunks[chunkIdx]);
+		});
+
+	//Offsets of every chunk in the merged arrays
+	struct ChunkBase
+	{
+		size_t position{};
+		size_t normal{};
+		size_t texcoord{};
+		size_t index{};
+	};
+
+	std::vector<ChunkBase> bases(chunkCount + 1);
+	for (size_t chunkIdx = 0; chunkIdx < chunkCount; ++chunkIdx)
+	{
+		bases[chunkIdx + 1].position = bases[chunkIdx].position + chunks[chunkIdx].positions.size();
+		bases[chunkIdx + 1].normal = bases[chunkIdx].normal + chunks[chunkIdx].normals.size();
+		bases[chunkIdx + 1].texcoord = bases[chunkIdx].texcoord + chunks[chunkIdx].texcoords.size();
+		bases[chunkIdx + 1].index = bases[chunkIdx].index + chunks[chunkIdx].indices.size();
+	}
+
+	Result result{};
+	result.positions.resize(bases[chunkCount].position);
+	result.normals.resize(bases[chunkCount].normal);
+	result.texcoords.resize(bases[chunkCount].texcoord);
+	result.indices.resize(bases[chunkCount].index);
+
+	ParallelFor(chunks.size(), 1, [&chunks, &bases, &result](size_t begin, size_t end)
+		{
+			for (size_t chunkIdx = begin; chunkIdx < end; ++chunkIdx)
+			{
+				Chunk& chunk{ chunks[chunkIdx] };
+				const ChunkBase& base{ bases[chunkIdx] };
+
+				std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + base.position);
+				std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + base.normal);
+				std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), result.texcoords.begin() + base.texcoord);
+
+				for (size_t idx = 0; idx < chunk.indices.size(); ++idx)
+				{
+					const RawIndex& raw{ chunk.indices[idx] };
+					Index& index{ result.indices[base.index + idx] };
+					index.vertex = ResolveIndex(raw.vertex, raw.relativeFlags & VERTEX_RELATIVE, base.position / 3);
+					index.normal = ResolveIndex(raw.normal, raw.relativeFlags & NORMAL_RELATIVE, base.normal / 3);
+					index.texcoord = ResolveIndex(raw.texcoord, raw.relativeFlags & TEXCOORD_RELATIVE, base.texcoord / 2);
+				}
+
+				//Release chunk memory as soon as it is merged to keep the peak down
+				chunk = Chunk{};
+			}
+		});
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace FH
+{
+	//Wavefront OBJ reader that maps the file and parses newline aligned chunks on all cores.
+	//Produces the same attribute arrays and triangulated (fan) corner list as tinyobj::LoadObj.
+	class FHObjLoader final
+	{
+	public:
+		//Indices are zero based, -1 when the corner does not reference that attribute
+		struct Index
+		{
+			int32_t vertex{ -1 };
+			int32_t normal{ -1 };
+			int32_t texcoord{ -1 };
+		};
+
+		struct Result
+		{
+			std::vector<float> positions{};	//xyz per vertex
+			std::vector<float> normals{};	//xyz per normal
+			std::vector<float> texcoords{};	//uv per texcoord
+			std::vector<Index> indices{};	//three corners per triangle, in file order
+		};
+
+		static Result Load(const std::string& filePath);
+
+		FHObjLoader() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "ormPacker.h"
+
+#include "external/stb_image.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+
+bool FH::FHOrmPacker::HasChannels(const FHMaterialPaths& material)
+{
+	return !material.ao.empty() || !material.roughness.empty() || !material.specular.empty();
+}
+
+std::string FH::FHOrmPacker::GetPackedPath(const FHMaterialPaths& material)
+{
+	const std::string& source{ !material.roughness.empty() ? material.roughness :
+		!material.specular.empty() ? material.specular : material.ao };
+
+	std::filesystem::path path{ source };
+	std::string stem{ path.stem().string() };
+	for (const std::string_view suffix : { "_roughness", "_specular", "_ao" })
+	{
+		if (stem.size() > suffix.size() && stem.compare(stem.size() - suffix.size(), suffix.size(), suffix) == 0)
+		{
+			stem.resize(stem.size() - suffix.size());
+			break;
+		}
+	}
+	return path.replace_filename(stem + "_orm.ktx2").generic_string();
+}
+
+FH::FHOrmPacker::Image FH::FHOrmPacker::Pack(const FHMaterialPaths& material, const std::string& rootPath)
+{
+	return Pack(material, [&rootPath](size_t, const std::string& path, int* pWidth, int* pHeight)
+		{
+			int bytesPerPixel{};
+			return stbi_load((rootPath + path).c_str(), pWidth, pHeight, &bytesPerPixel, STBI_grey);
+		});
+}
+
+FH::FHOrmPacker::Image FH::FHOrmPacker::Pack(const FHMaterialPaths& material, std::span<const std::vector<uint8_t>, 3> files)
+{
+	return Pack(material, [files](size_t channelIdx, const std::string&, int* pWidth, int* pHeight)
+		{
+			int bytesPerPixel{};
+			return stbi_load_from_memory(files[channelIdx].data(), static_cast<int>(files[channelIdx].size()),
+				pWidth, pHeight, &bytesPerPixel, STBI_grey);
+		});
+}
+
+FH::FHOrmPacker::Image FH::FHOrmPacker::Pack(const FHMaterialPaths& material, const LoadChannel& load)
+{
+	struct Channel
+	{
+		const std::string& path;
+		uint8_t defaultValue;
+		stbi_uc* pPixels{};
+		int width{};
+		int height{};
+	};
+
+	Channel channels[3]
+	{
+		{ material.ao, DEFAULT_AO },
+		{ material.roughness, DEFAULT_ROUGHNESS },
+		{ material.specular, DEFAULT_SPECULAR }
+	};
+
+	//Flipped like every other texture, the flag is per thread since materials are packed on several at once
+	Image image{};
+	stbi_set_flip_vertically_on_load_thread(true);
+	for (size_t channelIdx = 0; channelIdx < 3; ++channelIdx)
+	{
+		Channel& channel{ channels[channelIdx] };
+		if (channel.path.empty())
+			continue;
+
+		channel.pPixels = load(channelIdx, channel.path, &channel.width, &channel.height);
+		if (!channel.pPixels)
+		{
+			for (Channel& loaded : channels)
+				stbi_image_free(loaded.pPixels);
+			throw std::runtime_error("failed to load texture image: " + channel.path);
+		}
+
+		image.width = std::max(image.width, static_cast<uint32_t>(channel.width));
+		image.height = std::max(image.height, static_cast<uint32_t>(channel.height));
+	}
+
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+	for (uint32_t y = 0; y < image.height; ++y)
+	{
+		for (uint32_t x = 0; x < image.width; ++x)
+		{
+			uint8_t* pTexel{ image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4 };
+			for (size_t channelIdx = 0; channelIdx < 3; ++channelIdx)
+			{
+				const Channel& channel{ channels[channelIdx] };
+				if (!channel.pPixels)
+				{
+					pTexel[channelIdx] = channel.defaultValue;
+					continue;
+				}
+
+				const size_t sourceX{ static_cast<size_t>(x) * channel.width / image.width };
+				const size_t sourceY{ static_cast<size_t>(y) * channel.height / image.height };
+				pTexel[channelIdx] = channel.pPixels[sourceY * channel.width + sourceX];
+			}
+			pTexel[3] = 255;
+		}
+	}
+
+	for (Channel& channel : channels)
+		stbi_image_free(channel.pPixels);
+	return image;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "material.h"
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace FH
+{
+	//Packs the single channel maps of a material into one linear RGBA8 image: R ambient occlusion,
+	//G roughness, B specular. Missing maps get the value their placeholder had
+	class FHOrmPacker final
+	{
+	public:
+		static constexpr uint8_t DEFAULT_AO{ 255 };
+		static constexpr uint8_t DEFAULT_ROUGHNESS{ 0 };
+		static constexpr uint8_t DEFAULT_SPECULAR{ 0 };
+
+		struct Image
+		{
+			std::vector<uint8_t> pixels{};
+			uint32_t width{ 1 };
+			uint32_t height{ 1 };
+		};
+
+		static bool HasChannels(const FHMaterialPaths& material);
+
+		//The packed .ktx2 the encoder writes next to the sources, "ak47_roughness.png" becomes "ak47_orm.ktx2"
+		static std::string GetPackedPath(const FHMaterialPaths& material);
+
+		//Paths are relative to rootPath. Sources of different sizes are point sampled to the largest one,
+		//a material without any map gives a 1x1 image. Throws when a source cannot be loaded
+		static Image Pack(const FHMaterialPaths& material, const std::string& rootPath);
+		//Same with the sources already read into memory, in the order ambient occlusion, roughness, specular
+		static Image Pack(const FHMaterialPaths& material, std::span<const std::vector<uint8_t>, 3> files);
+
+		FHOrmPacker() = delete;
+
+	private:
+		//Single channel texels of a source, released with stbi_image_free
+		using LoadChannel = std::function<uint8_t*(size_t channelIdx, const std::string& path, int* pWidth, int* pHeight)>;
+
+		static Image Pack(const FHMaterialPaths& material, const LoadChannel& load);
+	};
+}
\ No newline at end of file
@@ -6,10 +6,10 @@
 #include <cassert>
 
 
-FH::FHPipeline::FHPipeline(FHDevice& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, bool is2D)
+FH::FHPipeline::FHPipeline(FHDevice& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
 	: m_Device{ device }
 {
-	CreateGraphicsPipeline(vertFilepath, fragFilepath, configInfo, is2D);
+	CreateGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
 }
 
 FH::FHPipeline::~FHPipeline()
@@ -96,6 +96,17 @@ void FH::FHPipeline::DefaultPipelineConfigInfo(FH::PipelineConfigInfo& configInf
 	configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
 	configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 	configInfo.dynamicStateInfo.flags = 0;
+
+	if (is2D)
+	{
+		configInfo.bindingDescriptions = FH::FHModel2D::Vertex2D::GetBindingDescriptions();
+		configInfo.attributeDescriptions = FH::FHModel2D::Vertex2D::GetAttributeDescriptions();
+	}
+	else
+	{
+		configInfo.bindingDescriptions = FH::FHModel::Vertex::GetBindingDescriptions();
+		configInfo.attributeDescriptions = FH::FHModel::Vertex::GetAttributeDescriptions();
+	}
 }
 
 std::vector<char> FH::FHPipeline::ReadFile(const std::string& filePath)
@@ -118,7 +129,7 @@ std::vector<char> FH::FHPipeline::ReadFile(const std::string& filePath)
 }
 
 void FH::FHPipeline::CreateGraphicsPipeline(const std::string& vertFilePath, 
-	const std::string& fragFilePath, const PipelineConfigInfo& configInfo, bool is2D)
+	const std::string& fragFilePath, const PipelineConfigInfo& configInfo)
 {
 	assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
 	assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
@@ -148,19 +159,8 @@ void FH::FHPipeline::CreateGraphicsPipeline(const std::string& vertFilePath,
 	shaderStages[1].pNext = nullptr;
 	shaderStages[1].pSpecializationInfo = nullptr;
 
-	std::vector<VkVertexInputAttributeDescription> attributeDescriptions{}; 
-	std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
-
-	if (is2D)
-	{
-		attributeDescriptions = FH::FHModel2D::Vertex2D::GetAttributeDescriptions();
-		bindingDescriptions = FH::FHModel2D::Vertex2D::GetBindingDescriptions();
-	}
-	else
-	{
-		attributeDescriptions = FH::FHModel::Vertex::GetAttributeDescriptions();
-		bindingDescriptions = FH::FHModel::Vertex::GetBindingDescriptions();
-	}
+	const auto& attributeDescriptions{ configInfo.attributeDescriptions };
+	const auto& bindingDescriptions{ configInfo.bindingDescriptions };
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -204,4 +204,43 @@ void FH::FHPipeline::CreateShaderModule(const std::vector<char>&code, VkShaderMo
 	{
 		throw std::runtime_error("Failed to create shader module");
 	}
+}
+
+FH::FHComputePipeline::FHComputePipeline(FHDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+	: m_Device{ device }
+{
+	assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+	auto compCode = FHPipeline::ReadFile(compFilepath);
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = compCode.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+	if (vkCreateShaderModule(m_Device.GetDevice(), &moduleInfo, nullptr, &m_CompShaderModule) != VK_SUCCESS)
+		throw std::runtime_error("Failed to create shader module");
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = m_CompShaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.basePipelineIndex = -1;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+	if (vkCreateComputePipelines(m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_ComputePipeline) != VK_SUCCESS)
+		throw std::runtime_error("failed to create compute pipeline");
+}
+
+FH::FHComputePipeline::~FHComputePipeline()
+{
+	vkDestroyShaderModule(m_Device.GetDevice(), m_CompShaderModule, nullptr);
+	vkDestroyPipeline(m_Device.GetDevice(), m_ComputePipeline, nullptr);
+}
+
+void FH::FHComputePipeline::Bind(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
 }
\ No newline at end of file
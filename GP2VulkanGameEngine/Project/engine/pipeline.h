@@ -14,6 +14,8 @@ namespace FH
 		PipelineConfigInfo(const PipelineConfigInfo& other) = delete;
 		PipelineConfigInfo& operator=(const PipelineConfigInfo& other) = delete;
 
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 		VkPipelineViewportStateCreateInfo viewportInfo{};
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo{};
@@ -32,7 +34,7 @@ namespace FH
 	{
 	public:
 		FHPipeline(FHDevice& device, const std::string& vertFilepath, 
-			const std::string& fragFilepath, const PipelineConfigInfo& configInfo, bool is2D = false);
+			const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
 		~FHPipeline();
 		FHPipeline(const FHPipeline&) = delete;
 		FHPipeline& operator=(const FHPipeline&) = delete;
@@ -41,10 +43,10 @@ namespace FH
 
 		static void DefaultPipelineConfigInfo(FH::PipelineConfigInfo& configInfo, bool is2D = false);
 
-	private:
 		static std::vector<char> ReadFile(const std::string& filePath);
 
-		void CreateGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, bool is2D);
+	private:
+		void CreateGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
 
 		void CreateShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
@@ -53,4 +55,20 @@ namespace FH
 		VkShaderModule m_FragShaderModule{};
 		VkPipeline m_GraphicsPipeline{};
 	};
+
+	class FHComputePipeline
+	{
+	public:
+		FHComputePipeline(FHDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+		~FHComputePipeline();
+		FHComputePipeline(const FHComputePipeline&) = delete;
+		FHComputePipeline& operator=(const FHComputePipeline&) = delete;
+
+		void Bind(VkCommandBuffer commandBuffer);
+
+	private:
+		FHDevice& m_Device;
+		VkShaderModule m_CompShaderModule{};
+		VkPipeline m_ComputePipeline{};
+	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "renderSystem.h"
+#include "cullingSystem.h"
 #include "FHTime.h"
 
 #define GLM_FORCE_RADIANS
@@ -7,7 +8,9 @@
 #include <glm/gtc/constants.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <limits>
 
 namespace FH
 {
@@ -63,14 +66,86 @@ void FH::FHRenderSystem::CreatePipeline(VkRenderPass renderPass)
 	FHPipeline::DefaultPipelineConfigInfo(pipelineConfig);
 	pipelineConfig.renderPass = renderPass;
 	pipelineConfig.pipelineLayout = m_FHPipelineLayout;
+	//Equal depth has to pass after the depth prepass
+	pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	//Devices without fragment stores get the build of the shader that never writes the virtual texture feedback
+	const std::string fragmentShader{ m_FHDevice.HasFragmentStores() ? "shaders/shader.frag.spv" : "shaders/shader_nofeedback.frag.spv" };
 	m_pFHPipeline = std::make_unique<FHPipeline>
-		(m_FHDevice, "shaders/shader.vert.spv", "shaders/shader.frag.spv", pipelineConfig);
+		(m_FHDevice, "shaders/shader.vert.spv", fragmentShader, pipelineConfig);
+
+	pipelineConfig.bindingDescriptions = FHModel::CompactVertex::GetBindingDescriptions();
+	pipelineConfig.attributeDescriptions = FHModel::CompactVertex::GetAttributeDescriptions();
+	m_pFHCompactPipeline = std::make_unique<FHPipeline>
+		(m_FHDevice, "shaders/shader_compact.vert.spv", fragmentShader, pipelineConfig);
+
+	PipelineConfigInfo depthConfig{};
+	FHPipeline::DefaultPipelineConfigInfo(depthConfig);
+	depthConfig.renderPass = renderPass;
+	depthConfig.pipelineLayout = m_FHPipelineLayout;
+	depthConfig.colorBlendAttachment.colorWriteMask = 0;
+
+	depthConfig.bindingDescriptions = FHModel::GetPositionBindingDescriptions(FHVertexFormat::Standard);
+	depthConfig.attributeDescriptions = FHModel::GetPositionAttributeDescriptions(FHVertexFormat::Standard);
+	m_pFHDepthPipeline = std::make_unique<FHPipeline>
+		(m_FHDevice, "shaders/depth.vert.spv", "shaders/depth.frag.spv", depthConfig);
+
+	depthConfig.bindingDescriptions = FHModel::GetPositionBindingDescriptions(FHVertexFormat::Compact);
+	depthConfig.attributeDescriptions = FHModel::GetPositionAttributeDescriptions(FHVertexFormat::Compact);
+	m_pFHCompactDepthPipeline = std::make_unique<FHPipeline>
+		(m_FHDevice, "shaders/depth_compact.vert.spv", "shaders/depth.frag.spv", depthConfig);
+}
+
+void FH::FHRenderSystem::BindPipeline(VkCommandBuffer commandBuffer, FHVertexFormat format, FHPipeline*& pBoundPipeline,
+	bool isDepthOnly)
+{
+	const bool isCompact{ format == FHVertexFormat::Compact };
+	FHPipeline* pPipeline{ isDepthOnly ?
+		(isCompact ? m_pFHCompactDepthPipeline.get() : m_pFHDepthPipeline.get()) :
+		(isCompact ? m_pFHCompactPipeline.get() : m_pFHPipeline.get()) };
+
+	if (pPipeline == pBoundPipeline)
+		return;
+
+	pPipeline->Bind(commandBuffer);
+	pBoundPipeline = pPipeline;
+}
+
+void FH::FHRenderSystem::PushConstants(VkCommandBuffer commandBuffer, FHGameObject& gameObject)
+{
+	PushConstantData3D push{};
+	push.modelMatrix = gameObject.m_Transform.GetModelMatrix() * (gameObject.m_StreamedModel ?
+		gameObject.m_StreamedModel->GetDequantizeMatrix() : gameObject.m_Model->GetDequantizeMatrix());
+	push.normalMatrix = gameObject.m_Transform.GetNormalMatrix();
+
+	vkCmdPushConstants(
+		commandBuffer,
+		m_FHPipelineLayout,
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		0,
+		sizeof(PushConstantData3D),
+		&push
+	);
+}
+
+void FH::FHRenderSystem::BindGeometry(VkCommandBuffer commandBuffer, FHModel& model,
+	VkBuffer& boundVertexBuffer, VkBuffer& boundIndexBuffer)
+{
+	const VkBuffer vertexBuffer{ model.GetVertexBuffer() };
+	const VkBuffer indexBuffer{ model.GetIndexBuffer() };
+	if (vertexBuffer == boundVertexBuffer && indexBuffer == boundIndexBuffer)
+		return;
+
+	model.Bind(commandBuffer);
+	boundVertexBuffer = vertexBuffer;
+	boundIndexBuffer = indexBuffer;
 }
 
 void FH::FHRenderSystem::RenderGameObjects(FHFrameInfo& frameInfo, 
 	std::vector<FHGameObject*>& gameObjects)
 {
-	m_pFHPipeline->Bind(frameInfo.m_CommandBuffer);
+	FHPipeline* pBoundPipeline{};
+	VkBuffer boundVertexBuffer{ VK_NULL_HANDLE };
+	VkBuffer boundIndexBuffer{ VK_NULL_HANDLE };
 
 	vkCmdBindDescriptorSets(
 		frameInfo.m_CommandBuffer,
@@ -84,6 +159,9 @@ void FH::FHRenderSystem::RenderGameObjects(FHFrameInfo& frameInfo,
 
 	for (auto& o : gameObjects)
 	{
+		BindPipeline(frameInfo.m_CommandBuffer,
+			o->m_StreamedModel ? FHVertexFormat::Compact : o->m_Model->GetVertexFormat(), pBoundPipeline);
+
 		// Bind descriptor set for access to object specific textures
 		VkDescriptorSet objectDescriptorSet = o->GetDescriptorSetAtFrame(frameInfo.m_FrameIdx);
 		vkCmdBindDescriptorSets(
@@ -96,28 +174,28 @@ void FH::FHRenderSystem::RenderGameObjects(FHFrameInfo& frameInfo,
 			nullptr
 		);
 
-		PushConstantData3D push{};
-		push.modelMatrix = o->m_Transform.GetModelMatrix();
-		push.normalMatrix = o->m_Transform.GetNormalMatrix();
+		PushConstants(frameInfo.m_CommandBuffer, *o);
 
-		vkCmdPushConstants(
-			frameInfo.m_CommandBuffer,
-			m_FHPipelineLayout,
-			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-			0,
-			sizeof(PushConstantData3D),
-			&push
-		);
+		if (o->m_StreamedModel)
+		{
+			//Binds per chunk itself
+			o->m_StreamedModel->Draw(frameInfo.m_CommandBuffer);
+			boundVertexBuffer = VK_NULL_HANDLE;
+			boundIndexBuffer = VK_NULL_HANDLE;
+			continue;
+		}
 
-		o->m_Model->Bind(frameInfo.m_CommandBuffer);
-		o->m_Model->Draw(frameInfo.m_CommandBuffer);
+		BindGeometry(frameInfo.m_CommandBuffer, *o->m_Model, boundVertexBuffer, boundIndexBuffer);
+		o->m_Model->Draw(frameInfo.m_CommandBuffer, SelectLod(frameInfo, *o));
 	}
 }
 
 void FH::FHRenderSystem::RenderGameObject(FHFrameInfo& frameInfo,
-	FHGameObject* gameObject)
+	FHGameObject* gameObject, const FHCullResult* pCullResult)
 {
-	m_pFHPipeline->Bind(frameInfo.m_CommandBuffer);
+	FHPipeline* pBoundPipeline{};
+	BindPipeline(frameInfo.m_CommandBuffer,
+		gameObject->m_StreamedModel ? FHVertexFormat::Compact : gameObject->m_Model->GetVertexFormat(), pBoundPipeline);
 
 	vkCmdBindDescriptorSets(
 		frameInfo.m_CommandBuffer,
@@ -141,19 +219,144 @@ void FH::FHRenderSystem::RenderGameObject(FHFrameInfo& frameInfo,
 		nullptr
 	);
 
-	PushConstantData3D push{};
-	push.modelMatrix = gameObject->m_Transform.GetModelMatrix();
-	push.normalMatrix = gameObject->m_Transform.GetNormalMatrix();
+	PushConstants(frameInfo.m_CommandBuffer, *gameObject);
 
-	vkCmdPushConstants(
+	if (gameObject->m_StreamedModel)
+	{
+		gameObject->m_StreamedModel->Draw(frameInfo.m_CommandBuffer);
+		return;
+	}
+
+	if (pCullResult)
+	{
+		gameObject->m_Model->BindCulled(frameInfo.m_CommandBuffer, pCullResult->indexBuffer);
+		gameObject->m_Model->DrawIndirect(frameInfo.m_CommandBuffer, pCullResult->drawCommandBuffer);
+		return;
+	}
+
+	gameObject->m_Model->Bind(frameInfo.m_CommandBuffer);
+	gameObject->m_Model->Draw(frameInfo.m_CommandBuffer, SelectLod(frameInfo, *gameObject));
+}
+
+void FH::FHRenderSystem::RenderDepthPrepass(FHFrameInfo& frameInfo,
+	std::vector<FHGameObject*>& gameObjects)
+{
+	FHPipeline* pBoundPipeline{};
+	VkBuffer boundPositionBuffer{ VK_NULL_HANDLE };
+	VkBuffer boundIndexBuffer{ VK_NULL_HANDLE };
+
+	vkCmdBindDescriptorSets(
 		frameInfo.m_CommandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
 		m_FHPipelineLayout,
-		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		0, 1,
+		&frameInfo.m_GlobalDescriptorSet,
 		0,
-		sizeof(PushConstantData3D),
-		&push
+		nullptr
 	);
 
-	gameObject->m_Model->Bind(frameInfo.m_CommandBuffer);
-	gameObject->m_Model->Draw(frameInfo.m_CommandBuffer);
+	for (auto& o : gameObjects)
+	{
+		if (!o->m_Model || !o->m_Model->HasPositionStream())
+			continue;
+
+		FHModel& model{ *o->m_Model };
+		BindPipeline(frameInfo.m_CommandBuffer, model.GetVertexFormat(), pBoundPipeline, true);
+		PushConstants(frameInfo.m_CommandBuffer, *o);
+
+		//Position streams share arenas like the interleaved vertices, rebind only on a new block
+		const VkBuffer positionBuffer{ model.GetPositionBuffer() };
+		const VkBuffer indexBuffer{ model.GetIndexBuffer() };
+		if (positionBuffer != boundPositionBuffer || indexBuffer != boundIndexBuffer)
+		{
+			model.BindPositions(frameInfo.m_CommandBuffer);
+			boundPositionBuffer = positionBuffer;
+			boundIndexBuffer = indexBuffer;
+		}
+
+		model.DrawPositions(frameInfo.m_CommandBuffer, SelectLod(frameInfo, *o));
+	}
+}
+
+void FH::FHRenderSystem::RenderGameObjectDepth(FHFrameInfo& frameInfo,
+	FHGameObject* gameObject, const FHCullResult* pCullResult)
+{
+	if (!gameObject->m_Model || !gameObject->m_Model->HasPositionStream())
+		return;
+
+	FHModel& model{ *gameObject->m_Model };
+	FHPipeline* pBoundPipeline{};
+	BindPipeline(frameInfo.m_CommandBuffer, model.GetVertexFormat(), pBoundPipeline, true);
+
+	vkCmdBindDescriptorSets(
+		frameInfo.m_CommandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		m_FHPipelineLayout,
+		0, 1,
+		&frameInfo.m_GlobalDescriptorSet,
+		0,
+		nullptr
+	);
+
+	PushConstants(frameInfo.m_CommandBuffer, *gameObject);
+
+	if (pCullResult)
+	{
+		model.BindPositionsCulled(frameInfo.m_CommandBuffer, pCullResult->indexBuffer);
+		model.DrawIndirect(frameInfo.m_CommandBuffer, pCullResult->drawCommandBuffer, FHCullResult::DEPTH_DRAW_OFFSET);
+		return;
+	}
+
+	model.BindPositions(frameInfo.m_CommandBuffer);
+	model.DrawPositions(frameInfo.m_CommandBuffer, SelectLod(frameInfo, *gameObject));
+}
+
+uint32_t FH::FHRenderSystem::SelectLod(const FHFrameInfo& frameInfo, FHGameObject& gameObject) const
+{
+	if (!gameObject.m_Model || gameObject.m_Model->GetLodCount() <= 1)
+		return 0;
+
+	const FHModel& model{ *gameObject.m_Model };
+
+	float scale{};
+	const float pixelsPerUnit{ GetPixelsPerUnit(frameInfo, gameObject, scale) };
+	if (pixelsPerUnit <= 0.f)
+		return 0;
+
+	for (uint32_t lodIdx = model.GetLodCount() - 1; lodIdx > 0; --lodIdx)
+		if (model.GetLod(lodIdx).error * scale * pixelsPerUnit <= m_LodPixelError)
+			return lodIdx;
+
+	return 0;
+}
+
+float FH::FHRenderSystem::GetScreenSize(const FHFrameInfo& frameInfo, FHGameObject& gameObject) const
+{
+	if (!gameObject.m_Model)
+		return std::numeric_limits<float>::infinity();
+
+	float scale{};
+	const float pixelsPerUnit{ GetPixelsPerUnit(frameInfo, gameObject, scale) };
+	if (pixelsPerUnit <= 0.f)
+		return std::numeric_limits<float>::infinity();
+
+	return 2.f * gameObject.m_Model->GetBoundingSphere().w * scale * pixelsPerUnit;
+}
+
+float FH::FHRenderSystem::GetPixelsPerUnit(const FHFrameInfo& frameInfo, FHGameObject& gameObject, float& scale)
+{
+	const glm::mat4 modelMatrix{ gameObject.m_Transform.GetModelMatrix() };
+	scale = std::max({ glm::length(glm::vec3{ modelMatrix[0] }),
+		glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) });
+
+	//Distance from the camera to the closest point of the bounding sphere, 0 from inside it
+	const glm::vec4& sphere{ gameObject.m_Model->GetBoundingSphere() };
+	const glm::vec3 viewCenter{ frameInfo.m_FHCamera.GetViewMatrix() * modelMatrix * glm::vec4{ glm::vec3{ sphere }, 1.f } };
+	const float distance{ glm::length(viewCenter) - sphere.w * scale };
+	if (distance <= 0.f)
+		return 0.f;
+
+	//Pixels covered by one world unit at that distance
+	const float projectionScale{ std::abs(frameInfo.m_FHCamera.GetProjectionMatrix()[1][1]) };
+	return projectionScale * 0.5f * static_cast<float>(frameInfo.m_Extent.height) / distance;
 }
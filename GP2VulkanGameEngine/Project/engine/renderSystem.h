@@ -11,6 +11,8 @@
 
 namespace FH
 {
+	struct FHCullResult;
+
 	class FHRenderSystem
 	{
 	public:
@@ -25,15 +27,46 @@ namespace FH
 
 		void RenderGameObjects(FHFrameInfo& frameInfo, 
 			std::vector<FHGameObject*>& gameObjects);
+		//Draws from the cull pass output when a cull result is given
 		void RenderGameObject(FHFrameInfo& frameInfo,
-			FHGameObject* gameObject);
+			FHGameObject* gameObject, const FHCullResult* pCullResult = nullptr);
+
+		//Depth only passes over the position streams, models without one are skipped. Render the same
+		//objects afterwards in the same render pass so only visible fragments get shaded
+		void RenderDepthPrepass(FHFrameInfo& frameInfo,
+			std::vector<FHGameObject*>& gameObjects);
+		void RenderGameObjectDepth(FHFrameInfo& frameInfo,
+			FHGameObject* gameObject, const FHCullResult* pCullResult = nullptr);
+
+		//Coarsest LOD whose simplification error projects to at most the allowed pixel error
+		uint32_t SelectLod(const FHFrameInfo& frameInfo, FHGameObject& gameObject) const;
+		//Pixels the bounding sphere of the object spans on screen, infinite from inside it or without a model
+		float GetScreenSize(const FHFrameInfo& frameInfo, FHGameObject& gameObject) const;
+
+		void SetLodPixelError(float pixelError) { m_LodPixelError = pixelError; }
+		float GetLodPixelError() const { return m_LodPixelError; }
 		
 	private:
+		//Pixels one world unit at the nearest point of the bounding sphere covers, 0 from inside it
+		static float GetPixelsPerUnit(const FHFrameInfo& frameInfo, FHGameObject& gameObject, float& scale);
+
 		void CreatePipelineLayout(const std::vector<VkDescriptorSetLayout>& globalSetLayouts);
 		void CreatePipeline(VkRenderPass renderPass);
+
+		//Binds the pipeline matching the vertex format when it is not bound yet
+		void BindPipeline(VkCommandBuffer commandBuffer, FHVertexFormat format, FHPipeline*& pBoundPipeline,
+			bool isDepthOnly = false);
+		void PushConstants(VkCommandBuffer commandBuffer, FHGameObject& gameObject);
+		//Binds the geometry pool buffers of the model when they are not bound yet
+		void BindGeometry(VkCommandBuffer commandBuffer, FHModel& model, VkBuffer& boundVertexBuffer, VkBuffer& boundIndexBuffer);
 		
 		VkPipelineLayout m_FHPipelineLayout{};
 		std::unique_ptr<FHPipeline> m_pFHPipeline{};
+		std::unique_ptr<FHPipeline> m_pFHCompactPipeline{};
+		std::unique_ptr<FHPipeline> m_pFHDepthPipeline{};
+		std::unique_ptr<FHPipeline> m_pFHCompactDepthPipeline{};
 		FHDevice& m_FHDevice;
+
+		float m_LodPixelError{ 1.f };
 	};
 }
\ No newline at end of file
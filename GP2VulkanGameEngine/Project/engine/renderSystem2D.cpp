@@ -61,8 +61,7 @@ void FH::FHRenderSystem2D::CreatePipeline(VkRenderPass renderPass)
 			m_FHDevice,
 			"shaders/shader2D.vert.spv",
 			"shaders/shader2D.frag.spv",
-			pipelineConfig,
-			true
+			pipelineConfig
 		);
 }
 
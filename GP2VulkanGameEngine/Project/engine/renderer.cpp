@@ -1,4 +1,5 @@
 #include "renderer.h"
+#include "uploadContext.h"
 
 #include <stdexcept>
 #include <array>
@@ -98,6 +99,9 @@ void FH::FHRenderer::EndFrame()
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 		throw std::runtime_error("failed to record command buffer");
 
+	//Uploads recorded since the last frame are submitted ahead of it on the same queue
+	m_FHDevice.GetUploadContext().Flush();
+
 	auto result = m_pFHSwapChain->SubmitCommandBuffers(&commandBuffer, &m_CurrentImageIdx);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_FHWindow.IsWindowResized())
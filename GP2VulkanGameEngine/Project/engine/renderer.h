@@ -21,6 +21,7 @@ namespace FH
 
 		VkRenderPass GetSwapChainRenderPass() const { return m_pFHSwapChain->GetRenderPass(); }
 		float GetAspectRatio() const { return m_pFHSwapChain->ExtentAspectRatio(); }
+		VkExtent2D GetSwapChainExtent() const { return m_pFHSwapChain->GetSwapChainExtent(); }
 		bool IsFrameInProgress() const { return m_IsFrameStarted; }
 		VkCommandBuffer GetCurrentCommandBuffer() const 
 		{
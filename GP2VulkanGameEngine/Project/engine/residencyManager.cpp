@@ -0,0 +1,159 @@
+#include "residencyManager.h"
+#include "swapchain.h"
+
+#include <algorithm>
+#include <iostream>
+
+FH::FHResidencyManager::FHResidencyManager(FHDevice& device, FHGeometryPool& geometryPool, FHTextureStreamer& textureStreamer,
+	const FHResidencySettings& settings)
+	: m_FHDevice{ device }
+	, m_FHGeometryPool{ geometryPool }
+	, m_FHTextureStreamer{ textureStreamer }
+	, m_Settings{ settings }
+{
+	Update();
+}
+
+void FH::FHResidencyManager::Track(const std::shared_ptr<FHTexture>& pTexture)
+{
+	std::erase_if(m_Textures, [](const auto& entry) { return entry.second.pTexture.expired(); });
+	m_Textures[pTexture.get()] = { pTexture, m_FrameCount };
+}
+
+void FH::FHResidencyManager::MarkDrawn(const FHTexture& texture)
+{
+	if (const auto it{ m_Textures.find(&texture) }; it != m_Textures.end())
+		it->second.drawFrame = m_FrameCount;
+}
+
+void FH::FHResidencyManager::Reload(FHTexture& texture)
+{
+	if (!m_Reload || !texture.IsEvicted())
+		return;
+
+	m_Reload(texture, m_FrameCount);
+	++m_ReloadCount;
+	if (const auto it{ m_Textures.find(&texture) }; it != m_Textures.end())
+		it->second.drawFrame = m_FrameCount;
+}
+
+uint32_t FH::FHResidencyManager::SelectMaxTextureSize(std::span<const TextureSize> catalogue)
+{
+	m_Budget = m_FHDevice.GetMemoryBudget();
+	const VkDeviceSize available{ GetStreamingBudget() };
+
+	const uint32_t maxSize{ FHTextureTiers::SelectMaxSize(catalogue, available, m_Settings.minTextureSize) };
+	if (maxSize == UINT32_MAX)
+		return m_MaxTextureSize;
+
+	if (FHTextureTiers::GetBytes(catalogue, maxSize) > available)
+		std::cout << "Textures need " << FHTextureTiers::GetBytes(catalogue, maxSize) / (1024 * 1024) << " MiB at the "
+			<< maxSize << " texels minimum, only " << available / (1024 * 1024) << " MiB of the budget is left for them" << std::endl;
+
+	m_MaxTextureSize = std::min(m_MaxTextureSize, maxSize);
+	return m_MaxTextureSize;
+}
+
+void FH::FHResidencyManager::Update()
+{
+	m_Budget = m_FHDevice.GetMemoryBudget();
+	const VkDeviceSize budget{ static_cast<VkDeviceSize>(m_Budget.budget * m_Settings.budgetShare) };
+	UpdateImages(budget);
+	m_FHTextureStreamer.GetSettings().memoryBudget = GetStreamingBudget();
+
+	//Evicting every streamed level would not help, the images left are drawn this frame or already evicted
+	const VkDeviceSize residentBytes{ GetResidentBytes() };
+	const bool isOverBudget{ residentBytes > budget };
+	if (isOverBudget && !m_IsOverBudget)
+		std::cout << "Residency: " << residentBytes / (1024 * 1024) << " MiB that cannot be evicted exceed the "
+			<< budget / (1024 * 1024) << " MiB budget" << std::endl;
+	m_IsOverBudget = isOverBudget;
+	++m_FrameCount;
+}
+
+void FH::FHResidencyManager::UpdateImages(VkDeviceSize budget)
+{
+	std::vector<FHTextureEviction::Texture> images{};
+	std::vector<std::pair<std::shared_ptr<FHTexture>, TrackedTexture*>> imageTextures{};
+	for (auto it{ m_Textures.begin() }; it != m_Textures.end();)
+	{
+		std::shared_ptr<FHTexture> pTexture{ it->second.pTexture.lock() };
+		if (!pTexture)
+		{
+			it = m_Textures.erase(it);
+			continue;
+		}
+
+		//Streamed textures are left to the streamer. Update runs once per frame, after MAX_FRAMES_IN_FLIGHT more
+		//frames the fences have covered the old views
+		TrackedTexture& tracked{ it->second };
+		++it;
+		if (pTexture->IsStreamed())
+			continue;
+		if (m_FrameCount >= FHSwapChain::MAX_FRAMES_IN_FLIGHT)
+			pTexture->ReleaseRetired(m_FrameCount - FHSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		const VkDeviceSize fullBytes{ pTexture->IsEvicted() ? tracked.fullBytes : pTexture->GetResidentBytes() };
+		images.push_back({ tracked.drawFrame, fullBytes, pTexture->GetTailBytes(), pTexture->IsEvicted() });
+		imageTextures.emplace_back(std::move(pTexture), &tracked);
+	}
+
+	//The reported usage holds the images evicted last until they are released, evicting more would overshoot
+	VkDeviceSize residentBytes{ GetResidentBytes() };
+	const bool isSettled{ m_FrameCount > m_LastEvictionFrame + FHSwapChain::MAX_FRAMES_IN_FLIGHT };
+	if (isSettled || !m_Budget.isReported)
+	{
+		const VkDeviceSize reloadBytes{ FHTextureEviction::GetReloadBytes(images, m_FrameCount) };
+		for (size_t imageIdx : FHTextureEviction::SelectEvictions(images, m_FrameCount, residentBytes, reloadBytes, budget))
+		{
+			auto& [pTexture, pTracked] { imageTextures[imageIdx] };
+			pTracked->fullBytes = images[imageIdx].fullBytes;
+			pTexture->Evict(m_FrameCount);
+			residentBytes -= std::min(residentBytes, images[imageIdx].fullBytes - images[imageIdx].tailBytes);
+			m_LastEvictionFrame = m_FrameCount;
+			++m_EvictionCount;
+		}
+	}
+
+	for (size_t imageIdx : FHTextureEviction::SelectReloads(images, m_FrameCount, residentBytes, budget))
+		Reload(*imageTextures[imageIdx].first);
+}
+
+FH::FHResidencyManager::Stats FH::FHResidencyManager::GetStats() const
+{
+	Stats stats{};
+	stats.budget = static_cast<VkDeviceSize>(m_Budget.budget * m_Settings.budgetShare);
+	stats.textureBytes = GetTextureBytes();
+	stats.geometryBytes = m_FHGeometryPool.GetStats().capacity;
+	stats.usage = m_Budget.isReported ? m_Budget.usage : stats.textureBytes + stats.geometryBytes;
+	stats.maxTextureSize = m_MaxTextureSize;
+	stats.evictionCount = m_FHTextureStreamer.GetStats().evictionCount + m_EvictionCount;
+	stats.reloadCount = m_FHTextureStreamer.GetStats().reloadCount + m_ReloadCount;
+	stats.isOverBudget = m_IsOverBudget;
+	return stats;
+}
+
+VkDeviceSize FH::FHResidencyManager::GetTextureBytes() const
+{
+	VkDeviceSize bytes{};
+	for (const auto& [pKey, tracked] : m_Textures)
+		if (const std::shared_ptr<FHTexture> pTexture{ tracked.pTexture.lock() })
+			bytes += pTexture->GetResidentBytes();
+	return bytes;
+}
+
+VkDeviceSize FH::FHResidencyManager::GetResidentBytes() const
+{
+	//The reported usage covers the swapchain and buffers too, without it only the tracked assets are known
+	const VkDeviceSize streamedBytes{ m_FHTextureStreamer.GetResidentBytes() };
+	const VkDeviceSize usage{ m_Budget.isReported ? m_Budget.usage :
+		GetTextureBytes() + m_FHGeometryPool.GetStats().capacity };
+	return usage - std::min(usage, streamedBytes);
+}
+
+VkDeviceSize FH::FHResidencyManager::GetStreamingBudget() const
+{
+	const VkDeviceSize budget{ static_cast<VkDeviceSize>(m_Budget.budget * m_Settings.budgetShare) };
+	const VkDeviceSize otherBytes{ GetResidentBytes() };
+	return budget > otherBytes ? budget - otherBytes : 0;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+#include "device.h"
+#include "geometryPool.h"
+#include "texture.h"
+#include "textureEviction.h"
+#include "textureStreamer.h"
+#include "textureTiers.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace FH
+{
+	struct FHResidencySettings
+	{
+		float budgetShare{ 0.8f };			//part of the device local budget the assets may fill
+		uint32_t minTextureSize{ 256 };		//load tiers never shrink textures below this size
+	};
+
+	//Keeps the assets inside the device memory budget, read from VK_EXT_memory_budget when the device has it and
+	//from the heap sizes otherwise. At load time it picks the largest texture size at which the whole catalogue
+	//fits, every frame it hands what the other allocations leave to the texture streamer, which evicts the levels
+	//of the least recently drawn textures.
+	//Textures without a .ktx2 that were not drawn this frame drop to their mip tail while the rest exceeds the
+	//budget, least recently drawn first. The reloader set by their owner decodes them again once they are drawn and
+	//fit. Models and the geometry pool stay resident until their last handle goes, they are only counted against
+	//the budget. When what cannot be evicted exceeds it the budget cannot be met, which is logged once each time it
+	//happens and shown in the stats
+	class FHResidencyManager final
+	{
+	public:
+		using TextureSize = FHTextureTiers::TextureSize;
+
+		struct Stats
+		{
+			VkDeviceSize budget{};
+			VkDeviceSize usage{};			//device wide with VK_EXT_memory_budget, the tracked assets otherwise
+			VkDeviceSize textureBytes{};
+			VkDeviceSize geometryBytes{};
+			uint32_t maxTextureSize{};
+			uint32_t evictionCount{};		//of streamed levels and of whole images
+			uint32_t reloadCount{};
+			bool isOverBudget{};	//what cannot be evicted does not fit on its own
+		};
+
+		FHResidencyManager(FHDevice& device, FHGeometryPool& geometryPool, FHTextureStreamer& textureStreamer,
+			const FHResidencySettings& settings = {});
+
+		FHResidencyManager(const FHResidencyManager&) = delete;
+		FHResidencyManager& operator=(const FHResidencyManager&) = delete;
+
+		//Decodes an evicted texture again and hands it to FHTexture::Reload with the frame
+		using Reloader = std::function<void(FHTexture& texture, uint64_t frame)>;
+
+		void Track(const std::shared_ptr<FHTexture>& pTexture);
+		void SetReloader(Reloader reload) { m_Reload = std::move(reload); }
+
+		//The texture is drawn this frame, call before Update
+		void MarkDrawn(const FHTexture& texture);
+		//Brings an evicted texture back at full size right away
+		void Reload(FHTexture& texture);
+
+		//Halves the size textures load at until the catalogue fits next to the current allocations
+		uint32_t SelectMaxTextureSize(std::span<const TextureSize> catalogue);
+		uint32_t GetMaxTextureSize() const { return m_MaxTextureSize; }
+
+		//Call once per frame before FHTextureStreamer::Update
+		void Update();
+
+		Stats GetStats() const;
+		FHResidencySettings& GetSettings() { return m_Settings; }
+
+	private:
+		struct TrackedTexture
+		{
+			std::weak_ptr<FHTexture> pTexture{};
+			uint64_t drawFrame{};
+			VkDeviceSize fullBytes{};	//before it was evicted
+		};
+
+		//Evicts the images drawn least recently while the budget is exceeded, reloads the evicted ones drawn this frame
+		void UpdateImages(VkDeviceSize budget);
+
+		VkDeviceSize GetTextureBytes() const;
+		//Everything but the streamed texture levels, images without a .ktx2 included
+		VkDeviceSize GetResidentBytes() const;
+		//What is left for streamed texture levels once everything else is resident
+		VkDeviceSize GetStreamingBudget() const;
+
+		FHDevice& m_FHDevice;
+		FHGeometryPool& m_FHGeometryPool;
+		FHTextureStreamer& m_FHTextureStreamer;
+		FHResidencySettings m_Settings;
+
+		MemoryBudget m_Budget{};
+		uint32_t m_MaxTextureSize{ UINT32_MAX };
+		std::unordered_map<const FHTexture*, TrackedTexture> m_Textures{};
+		Reloader m_Reload{};
+		uint64_t m_FrameCount{};
+		//Reported usage still holds evicted images until the frames in flight let them go
+		uint64_t m_LastEvictionFrame{};
+		uint32_t m_EvictionCount{};
+		uint32_t m_ReloadCount{};
+		bool m_IsOverBudget{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "staticBatcher.h"
+#include "assetRegistry.h"
+
+#include <algorithm>
+
+uint32_t FH::FHStaticBatcher::Add(const std::string& filePath, TransformComponent transform, const FHMaterialPaths& material,
+	const FHModelLoadOptions& options)
+{
+	//LODs and meshlets are made for the merged mesh instead
+	FHModelLoadOptions sourceOptions{ options };
+	sourceOptions.generateLods = false;
+	sourceOptions.buildMeshlets = false;
+
+	return Add(FHModel::LoadModelData(filePath, sourceOptions), transform, material);
+}
+
+uint32_t FH::FHStaticBatcher::Add(const FHModel::ModelData& data, TransformComponent transform, const FHMaterialPaths& material)
+{
+	auto it{ std::find_if(m_Batches.begin(), m_Batches.end(),
+		[&material](const Batch& batch) { return batch.material == material; }) };
+	if (it == m_Batches.end())
+	{
+		m_Batches.push_back(Batch{ material });
+		it = m_Batches.end() - 1;
+	}
+	it->mesh.Append(data, transform.GetModelMatrix(), transform.GetNormalMatrix(), m_ObjectCount);
+	return m_ObjectCount++;
+}
+
+std::vector<std::unique_ptr<FH::FHGameObject>> FH::FHStaticBatcher::Build(FHAssetRegistry& assets, FHGeometryPool& geometryPool,
+	const FHModelLoadOptions& options)
+{
+	std::vector<std::unique_ptr<FHGameObject>> gameObjects{};
+	for (Batch& batch : m_Batches)
+	{
+		//Same order as a model import, the LODs append after LOD 0 so the sub mesh ranges stay valid
+		if (options.generateLods)
+			batch.mesh.data.BuildLods();
+		if (options.buildMeshlets)
+			batch.mesh.data.BuildMeshlets();
+
+		auto gameObject{ std::make_unique<FHGameObject>(FHGameObject::CreateGameObject()) };
+		gameObject->m_Model = std::make_unique<FHModel>(geometryPool, batch.mesh.data, options.vertexFormat, options.positionStream);
+		gameObject->m_Model->SetSubMeshes(std::move(batch.mesh.subMeshes));
+		gameObject->LoadTextures(assets, batch.material);
+
+		gameObjects.push_back(std::move(gameObject));
+	}
+
+	m_Batches.clear();
+	m_ObjectCount = 0;
+	return gameObjects;
+}
\ No newline at end of file
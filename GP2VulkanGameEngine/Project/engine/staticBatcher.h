@@ -0,0 +1,41 @@
+#pragma once
+#include "gameObject.h"
+#include "geometryPool.h"
+#include "material.h"
+#include "mergedMesh.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FH
+{
+	//Merges static meshes that share a material into one model per material at load time. Vertices are
+	//pre-transformed, so a whole batch costs one descriptor bind, push constant and draw. Every source
+	//keeps its index range as an FHModel::SubMesh for picking and culling
+	class FHStaticBatcher final
+	{
+	public:
+		//Both return the object id the source gets in its SubMesh. Only LOD 0 of the source is merged
+		uint32_t Add(const std::string& filePath, TransformComponent transform, const FHMaterialPaths& material,
+			const FHModelLoadOptions& options = {});
+		uint32_t Add(const FHModel::ModelData& data, TransformComponent transform, const FHMaterialPaths& material);
+
+		//One game object per material with an identity transform, the batcher is empty afterwards. The merged
+		//meshes are not reordered, that would interleave the sub meshes
+		std::vector<std::unique_ptr<FHGameObject>> Build(FHAssetRegistry& assets, FHGeometryPool& geometryPool,
+			const FHModelLoadOptions& options = {});
+
+		uint32_t GetObjectCount() const { return m_ObjectCount; }
+
+	private:
+		struct Batch
+		{
+			FHMaterialPaths material{};
+			FHMergedMesh mesh{};
+		};
+
+		std::vector<Batch> m_Batches{};
+		uint32_t m_ObjectCount{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,419 @@
+#include "streamedModel.h"
+#include "meshCache.h"
+#include "meshOptimizer.h"
+#include "swapchain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+std::unique_ptr<FH::FHStreamedModel> FH::FHStreamedModel::CreateFromFile(FHGeometryPool& geometryPool,
+	const std::string& filePath, const FHStreamingSettings& settings)
+{
+	const std::string sourcePath{ "resources/" + filePath };
+	const std::string chunkPath{ GetChunkPath(sourcePath) };
+
+	//Without the source an existing chunk file is used as is, scans can be shipped converted only
+	uint64_t sourceHash{};
+	uint64_t sourceSize{};
+	const bool hasSource{ FHMeshCache::HashSourceFile(sourcePath, sourceHash, sourceSize) };
+	{
+		const FHMappedFile chunkFile{ chunkPath };
+		if (IsValid(chunkFile, sourceHash, sourceSize, hasSource))
+			return std::make_unique<FHStreamedModel>(geometryPool, chunkPath, settings);
+	}
+
+	if (!hasSource)
+		throw std::runtime_error("failed to open " + sourcePath + "!");
+
+	if (sourceSize * CONVERSION_MEMORY_PER_SOURCE_BYTE > settings.maxConversionMemory)
+		throw std::runtime_error("failed to convert " + sourcePath + ", it needs more host memory than maxConversionMemory!");
+
+	//Converting needs the whole mesh once, it is released before anything gets streamed
+	{
+		FHModel::ModelData data{};
+		data.LoadModel(sourcePath);
+		if (!Build(data, chunkPath, sourceHash, sourceSize))
+			throw std::runtime_error("failed to write chunked mesh " + chunkPath + "!");
+	}
+
+	return std::make_unique<FHStreamedModel>(geometryPool, chunkPath, settings);
+}
+
+FH::FHStreamedModel::FHStreamedModel(FHGeometryPool& geometryPool, const std::string& chunkPath, const FHStreamingSettings& settings)
+	: m_FHGeometryPool{ geometryPool }
+	, m_File{ chunkPath }
+	, m_Settings{ settings }
+{
+	if (!IsValid(m_File, 0, 0, false))
+		throw std::runtime_error("failed to open chunked mesh " + chunkPath + "!");
+
+	const FHChunkFileHeader& header{ *reinterpret_cast<const FHChunkFileHeader*>(m_File.GetData()) };
+
+	//UNORM input is pos / 65535, so model space is boundsMin + input * extent
+	const glm::vec3 extent{ header.boundsMax - header.boundsMin };
+	m_DequantizeMatrix = glm::mat4{
+		{ extent.x, 0.f, 0.f, 0.f },
+		{ 0.f, extent.y, 0.f, 0.f },
+		{ 0.f, 0.f, extent.z, 0.f },
+		{ header.boundsMin, 1.f }
+	};
+
+	const FHChunkInfo* pInfos{ reinterpret_cast<const FHChunkInfo*>(m_File.GetData() + sizeof(FHChunkFileHeader)) };
+	m_Chunks.resize(header.chunkCount);
+	for (uint32_t chunkIdx = 0; chunkIdx < header.chunkCount; ++chunkIdx)
+		m_Chunks[chunkIdx].info = pInfos[chunkIdx];
+
+	std::cout << "Streaming " << header.chunkCount << " chunks from " << chunkPath << std::endl;
+}
+
+FH::FHStreamedModel::~FHStreamedModel()
+{
+	ReleaseEvicted(true);
+	for (const Chunk& chunk : m_Chunks)
+	{
+		m_FHGeometryPool.Free(chunk.vertexHandle);
+		m_FHGeometryPool.Free(chunk.indexHandle);
+	}
+}
+
+void FH::FHStreamedModel::Update(const glm::vec3& cameraPosition, const glm::mat4& modelMatrix)
+{
+	++m_FrameCount;
+	ReleaseEvicted(false);
+
+	const float scale{ std::max({ glm::length(glm::vec3{ modelMatrix[0] }),
+		glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) }) };
+
+	std::vector<uint32_t> missing{};
+	std::vector<uint32_t> resident{};
+	for (uint32_t chunkIdx = 0; chunkIdx < m_Chunks.size(); ++chunkIdx)
+	{
+		Chunk& chunk{ m_Chunks[chunkIdx] };
+		const glm::vec4& sphere{ chunk.info.boundingSphere };
+		const glm::vec3 center{ modelMatrix * glm::vec4{ glm::vec3{ sphere }, 1.f } };
+		chunk.distance = std::max(glm::length(center - cameraPosition) - sphere.w * scale, 0.f);
+
+		if (chunk.vertexHandle == FHGeometryPool::INVALID_HANDLE)
+			missing.push_back(chunkIdx);
+		else
+			resident.push_back(chunkIdx);
+	}
+
+	//Closest missing chunks first, they may push out the farthest resident ones
+	std::sort(missing.begin(), missing.end(),
+		[this](uint32_t a, uint32_t b) { return m_Chunks[a].distance < m_Chunks[b].distance; });
+	std::sort(resident.begin(), resident.end(),
+		[this](uint32_t a, uint32_t b) { return m_Chunks[a].distance > m_Chunks[b].distance; });
+
+	size_t evictIdx{};
+	while (m_ResidentBytes > m_Settings.memoryBudget && evictIdx < resident.size())
+		Evict(m_Chunks[resident[evictIdx++]]);
+
+	uint32_t uploadCount{};
+	for (uint32_t chunkIdx : missing)
+	{
+		if (uploadCount == m_Settings.maxUploadsPerFrame)
+			break;
+
+		Chunk& chunk{ m_Chunks[chunkIdx] };
+		const VkDeviceSize chunkSize{ GetChunkSize(chunk.info) };
+		while (m_ResidentBytes + chunkSize > m_Settings.memoryBudget && evictIdx < resident.size()
+			&& m_Chunks[resident[evictIdx]].distance > chunk.distance)
+			Evict(m_Chunks[resident[evictIdx++]]);
+
+		if (m_ResidentBytes + chunkSize > m_Settings.memoryBudget)
+			break;
+
+		Upload(chunk);
+		++uploadCount;
+	}
+}
+
+void FH::FHStreamedModel::Draw(VkCommandBuffer commandBuffer)
+{
+	//Chunks share the pool arenas, so most of them draw without rebinding
+	VkBuffer boundVertexBuffer{ VK_NULL_HANDLE };
+	VkBuffer boundIndexBuffer{ VK_NULL_HANDLE };
+
+	for (const Chunk& chunk : m_Chunks)
+	{
+		if (chunk.vertexHandle == FHGeometryPool::INVALID_HANDLE)
+			continue;
+
+		const FHGeometryPool::Range vertexRange{ m_FHGeometryPool.GetRange(chunk.vertexHandle) };
+		const FHGeometryPool::Range indexRange{ m_FHGeometryPool.GetRange(chunk.indexHandle) };
+
+		if (vertexRange.buffer != boundVertexBuffer)
+		{
+			VkBuffer buffers[]{ vertexRange.buffer };
+			VkDeviceSize offsets[]{ 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+			boundVertexBuffer = vertexRange.buffer;
+		}
+		if (indexRange.buffer != boundIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, indexRange.buffer, 0, VK_INDEX_TYPE_UINT16);
+			boundIndexBuffer = indexRange.buffer;
+		}
+
+		vkCmdDrawIndexed(commandBuffer, indexRange.count, 1, indexRange.offset, static_cast<int32_t>(vertexRange.offset), 0);
+	}
+}
+
+std::string FH::FHStreamedModel::GetChunkPath(const std::string& sourcePath)
+{
+	return std::filesystem::path{ sourcePath }.replace_extension(".fhchunks").string();
+}
+
+bool FH::FHStreamedModel::Build(const FHModel::ModelData& data, const std::string& chunkPath,
+	uint64_t sourceHash, uint64_t sourceSize)
+{
+	const auto buildStart{ std::chrono::steady_clock::now() };
+
+	FHChunkFileHeader header{};
+	header.vertexStride = sizeof(FHModel::CompactVertex);
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.boundsMin = glm::vec3{ std::numeric_limits<float>::max() };
+	header.boundsMax = glm::vec3{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : data.vertices)
+	{
+		header.boundsMin = glm::min(header.boundsMin, vertex.pos);
+		header.boundsMax = glm::max(header.boundsMax, vertex.pos);
+	}
+
+	const glm::vec3 extent{ header.boundsMax - header.boundsMin };
+	const glm::vec3 quantizeScale{
+		extent.x > 0.f ? 65535.f / extent.x : 0.f,
+		extent.y > 0.f ? 65535.f / extent.y : 0.f,
+		extent.z > 0.f ? 65535.f / extent.z : 0.f
+	};
+
+	//Median splits on the longest axis of the triangle centroids
+	const size_t triangleCount{ data.indices.size() / 3 };
+	std::vector<glm::vec3> centroids(triangleCount);
+	for (size_t triangleIdx = 0; triangleIdx < triangleCount; ++triangleIdx)
+		centroids[triangleIdx] = (data.vertices[data.indices[triangleIdx * 3 + 0]].pos
+			+ data.vertices[data.indices[triangleIdx * 3 + 1]].pos
+			+ data.vertices[data.indices[triangleIdx * 3 + 2]].pos) / 3.f;
+
+	std::vector<uint32_t> triangles(triangleCount);
+	std::iota(triangles.begin(), triangles.end(), 0);
+
+	struct TriangleRange
+	{
+		size_t begin{};
+		size_t end{};
+	};
+
+	std::vector<TriangleRange> leaves{};
+	std::vector<TriangleRange> stack{ { 0, triangleCount } };
+	while (!stack.empty())
+	{
+		const TriangleRange range{ stack.back() };
+		stack.pop_back();
+		if (range.end - range.begin <= MAX_CHUNK_TRIANGLES)
+		{
+			if (range.end > range.begin)
+				leaves.push_back(range);
+			continue;
+		}
+
+		glm::vec3 rangeMin{ std::numeric_limits<float>::max() };
+		glm::vec3 rangeMax{ std::numeric_limits<float>::lowest() };
+		for (size_t idx = range.begin; idx < range.end; ++idx)
+		{
+			rangeMin = glm::min(rangeMin, centroids[triangles[idx]]);
+			rangeMax = glm::max(rangeMax, centroids[triangles[idx]]);
+		}
+
+		const glm::vec3 rangeExtent{ rangeMax - rangeMin };
+		const int axis{ rangeExtent.x >= rangeExtent.y && rangeExtent.x >= rangeExtent.z ? 0 : (rangeExtent.y >= rangeExtent.z ? 1 : 2) };
+		const size_t middle{ range.begin + (range.end - range.begin) / 2 };
+		std::nth_element(triangles.begin() + range.begin, triangles.begin() + middle, triangles.begin() + range.end,
+			[&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+		//Second half popped last, so neighbouring leaves stay neighbours in the file
+		stack.push_back({ middle, range.end });
+		stack.push_back({ range.begin, middle });
+	}
+	header.chunkCount = static_cast<uint32_t>(leaves.size());
+
+	//Write to a temporary file first so a crash never leaves a half written file behind
+	const std::string tempPath{ chunkPath + ".tmp" };
+	{
+		std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			std::cerr << "failed to write chunked mesh: " << chunkPath << std::endl;
+			return false;
+		}
+
+		std::vector<FHChunkInfo> infos(leaves.size());
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(infos.data()), static_cast<std::streamsize>(infos.size() * sizeof(FHChunkInfo)));
+		uint64_t dataOffset{ sizeof(header) + infos.size() * sizeof(FHChunkInfo) };
+
+		std::vector<uint32_t> localIndexOf(data.vertices.size(), UINT32_MAX);
+		std::vector<uint32_t> globalIndices{};
+		std::vector<uint32_t> localIndices{};
+		std::vector<uint32_t> clusters{};
+		std::vector<FHModel::CompactVertex> chunkVertices{};
+		std::vector<uint16_t> chunkIndices{};
+
+		for (size_t leafIdx = 0; leafIdx < leaves.size(); ++leafIdx)
+		{
+			globalIndices.clear();
+			localIndices.clear();
+			for (size_t idx = leaves[leafIdx].begin; idx < leaves[leafIdx].end; ++idx)
+			{
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t globalIdx{ data.indices[triangles[idx] * 3 + corner] };
+					if (localIndexOf[globalIdx] == UINT32_MAX)
+					{
+						localIndexOf[globalIdx] = static_cast<uint32_t>(globalIndices.size());
+						globalIndices.push_back(globalIdx);
+					}
+					localIndices.push_back(localIndexOf[globalIdx]);
+				}
+			}
+			for (uint32_t globalIdx : globalIndices)
+				localIndexOf[globalIdx] = UINT32_MAX;
+
+			FHMeshOptimizer::OptimizeVertexCache(localIndices, globalIndices.size(), clusters);
+			const std::vector<uint32_t> remap{ FHMeshOptimizer::OptimizeVertexFetch(localIndices, globalIndices.size()) };
+
+			chunkVertices.assign(globalIndices.size(), FHModel::CompactVertex{});
+			glm::vec3 chunkMin{ std::numeric_limits<float>::max() };
+			glm::vec3 chunkMax{ std::numeric_limits<float>::lowest() };
+			for (size_t localIdx = 0; localIdx < globalIndices.size(); ++localIdx)
+			{
+				const FHModel::Vertex& vertex{ data.vertices[globalIndices[localIdx]] };
+				chunkVertices[remap[localIdx]] = FHModel::CompactVertex::Pack(vertex, header.boundsMin, quantizeScale);
+				chunkMin = glm::min(chunkMin, vertex.pos);
+				chunkMax = glm::max(chunkMax, vertex.pos);
+			}
+
+			const glm::vec3 center{ (chunkMin + chunkMax) * 0.5f };
+			float radius{};
+			for (uint32_t globalIdx : globalIndices)
+				radius = std::max(radius, glm::length(data.vertices[globalIdx].pos - center));
+
+			chunkIndices.assign(localIndices.begin(), localIndices.end());
+
+			FHChunkInfo& info{ infos[leafIdx] };
+			info.boundingSphere = glm::vec4{ center, radius };
+			info.dataOffset = dataOffset;
+			info.vertexCount = static_cast<uint32_t>(chunkVertices.size());
+			info.indexCount = static_cast<uint32_t>(chunkIndices.size());
+
+			const VkDeviceSize chunkSize{ GetChunkSize(info) };
+			const VkDeviceSize paddedSize{ (chunkSize + 3) & ~VkDeviceSize{ 3 } };
+			file.write(reinterpret_cast<const char*>(chunkVertices.data()),
+				static_cast<std::streamsize>(chunkVertices.size() * sizeof(FHModel::CompactVertex)));
+			file.write(reinterpret_cast<const char*>(chunkIndices.data()),
+				static_cast<std::streamsize>(chunkIndices.size() * sizeof(uint16_t)));
+			const char padding[4]{};
+			file.write(padding, static_cast<std::streamsize>(paddedSize - chunkSize));
+			dataOffset += paddedSize;
+		}
+
+		file.seekp(sizeof(header));
+		file.write(reinterpret_cast<const char*>(infos.data()), static_cast<std::streamsize>(infos.size() * sizeof(FHChunkInfo)));
+
+		if (!file.good())
+		{
+			std::cerr << "failed to write chunked mesh: " << chunkPath << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(tempPath, chunkPath, error);
+	if (error)
+	{
+		std::cerr << "failed to write chunked mesh: " << chunkPath << " (" << error.message() << ")" << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	const std::chrono::duration<double, std::milli> buildMillis{ std::chrono::steady_clock::now() - buildStart };
+	std::cout << "Built " << header.chunkCount << " chunks of at most " << MAX_CHUNK_TRIANGLES
+		<< " triangles in " << buildMillis.count() << "ms" << std::endl;
+	return true;
+}
+
+bool FH::FHStreamedModel::IsValid(const FHMappedFile& file, uint64_t sourceHash, uint64_t sourceSize, bool checkSource)
+{
+	if (!file.IsOpen() || file.GetSize() < sizeof(FHChunkFileHeader))
+		return false;
+
+	const FHChunkFileHeader& header{ *reinterpret_cast<const FHChunkFileHeader*>(file.GetData()) };
+	if (header.magic != FHChunkFileHeader::MAGIC || header.version != FHChunkFileHeader::VERSION
+		|| header.vertexStride != sizeof(FHModel::CompactVertex))
+		return false;
+
+	if (checkSource && (header.sourceHash != sourceHash || header.sourceSize != sourceSize))
+		return false;
+
+	const uint64_t tableEnd{ sizeof(FHChunkFileHeader) + static_cast<uint64_t>(header.chunkCount) * sizeof(FHChunkInfo) };
+	if (file.GetSize() < tableEnd)
+		return false;
+
+	const FHChunkInfo* pInfos{ reinterpret_cast<const FHChunkInfo*>(file.GetData() + sizeof(FHChunkFileHeader)) };
+	for (uint32_t chunkIdx = 0; chunkIdx < header.chunkCount; ++chunkIdx)
+		if (pInfos[chunkIdx].dataOffset < tableEnd || pInfos[chunkIdx].dataOffset % 4 != 0
+			|| pInfos[chunkIdx].dataOffset + GetChunkSize(pInfos[chunkIdx]) > file.GetSize())
+			return false;
+
+	return true;
+}
+
+VkDeviceSize FH::FHStreamedModel::GetChunkSize(const FHChunkInfo& info)
+{
+	return static_cast<VkDeviceSize>(info.vertexCount) * sizeof(FHModel::CompactVertex)
+		+ static_cast<VkDeviceSize>(info.indexCount) * sizeof(uint16_t);
+}
+
+void FH::FHStreamedModel::Upload(Chunk& chunk)
+{
+	//Straight from the mapping into the pool's staging buffer, only this chunk's pages get touched
+	const uint8_t* pData{ m_File.GetData() + chunk.info.dataOffset };
+	chunk.vertexHandle = m_FHGeometryPool.AllocateVertices(pData, sizeof(FHModel::CompactVertex), chunk.info.vertexCount);
+	chunk.indexHandle = m_FHGeometryPool.AllocateIndices(pData + static_cast<size_t>(chunk.info.vertexCount) * sizeof(FHModel::CompactVertex),
+		VK_INDEX_TYPE_UINT16, chunk.info.indexCount);
+
+	m_ResidentBytes += GetChunkSize(chunk.info);
+	++m_ResidentChunkCount;
+}
+
+void FH::FHStreamedModel::Evict(Chunk& chunk)
+{
+	m_EvictedRanges.push_back({ chunk.vertexHandle, chunk.indexHandle, m_FrameCount });
+	chunk.vertexHandle = FHGeometryPool::INVALID_HANDLE;
+	chunk.indexHandle = FHGeometryPool::INVALID_HANDLE;
+
+	m_ResidentBytes -= GetChunkSize(chunk.info);
+	--m_ResidentChunkCount;
+}
+
+void FH::FHStreamedModel::ReleaseEvicted(bool releaseAll)
+{
+	//Update runs once per frame, after MAX_FRAMES_IN_FLIGHT more frames the fences have covered the old draws
+	std::erase_if(m_EvictedRanges, [&](const EvictedRange& range)
+		{
+			if (!releaseAll && range.frame + FHSwapChain::MAX_FRAMES_IN_FLIGHT > m_FrameCount)
+				return false;
+
+			m_FHGeometryPool.Free(range.vertexHandle);
+			m_FHGeometryPool.Free(range.indexHandle);
+			return true;
+		});
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include "model.h"
+#include "geometryPool.h"
+#include "mappedFile.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FH
+{
+	//Binary .fhchunks file: FHChunkFileHeader | FHChunkInfo[chunkCount] | per chunk CompactVertex[vertexCount] uint16_t[indexCount].
+	//Every chunk is a spatially coherent piece of the mesh with its own vertices, quantized to the bounds of the whole mesh
+	struct FHChunkFileHeader
+	{
+		static constexpr uint32_t MAGIC{ 0x4B434846 }; //"FHCK"
+		static constexpr uint32_t VERSION{ 1 };
+
+		uint32_t magic{ MAGIC };
+		uint32_t version{ VERSION };
+		uint32_t vertexStride{};
+		uint32_t chunkCount{};
+		uint64_t sourceHash{};
+		uint64_t sourceSize{};
+		glm::vec3 boundsMin{};
+		glm::vec3 boundsMax{};
+	};
+	static_assert(sizeof(FHChunkFileHeader) == 56, "Chunk file header layout changed, bump the version");
+
+	struct FHChunkInfo
+	{
+		glm::vec4 boundingSphere{};	//model space
+		uint64_t dataOffset{};		//bytes from the start of the file, 4 byte aligned
+		uint32_t vertexCount{};
+		uint32_t indexCount{};
+	};
+	static_assert(sizeof(FHChunkInfo) == 32, "Chunk info layout changed, bump the version");
+
+	struct FHStreamingSettings
+	{
+		VkDeviceSize memoryBudget{ 256ull << 20 };	//vertex and index bytes of resident chunks
+		uint32_t maxUploadsPerFrame{ 4 };
+		uint64_t maxConversionMemory{ 4ull << 30 };	//estimated host bytes CreateFromFile may use to convert a source
+	};
+
+	//Out of core mesh for scans too large to keep resident. The chunk file stays mapped and Update uploads the
+	//chunks closest to the camera a few per frame, evicting the farthest ones when over the memory budget.
+	//Host memory while streaming is bounded by one chunk, its staging copy is the only one made. Converting
+	//the source is not: it imports the whole mesh once, see CreateFromFile.
+	class FHStreamedModel final
+	{
+	public:
+		//At most 21845 triangles keeps the chunk local vertex count in 16 bit indices
+		static constexpr uint32_t MAX_CHUNK_TRIANGLES{ 16384 };
+		//Peak host memory of a conversion per source byte, the source mapping included. A 109 MiB .obj
+		//peaked at 2.2 times its size, .glb is denser so it gets the same margin
+		static constexpr uint64_t CONVERSION_MEMORY_PER_SOURCE_BYTE{ 3 };
+
+		//Builds the .fhchunks file next to the source when it is missing or stale, the source is only parsed then.
+		//The conversion holds the whole mesh in host memory, it throws instead when that would exceed
+		//settings.maxConversionMemory. Convert such scans offline and ship the .fhchunks file alone
+		static std::unique_ptr<FHStreamedModel> CreateFromFile(FHGeometryPool& geometryPool, const std::string& filePath,
+			const FHStreamingSettings& settings = {});
+
+		FHStreamedModel(FHGeometryPool& geometryPool, const std::string& chunkPath, const FHStreamingSettings& settings = {});
+		~FHStreamedModel();
+
+		FHStreamedModel(const FHStreamedModel&) = delete;
+		FHStreamedModel& operator=(const FHStreamedModel&) = delete;
+
+		//Call once per frame before recording any draw of this model
+		void Update(const glm::vec3& cameraPosition, const glm::mat4& modelMatrix);
+
+		//Draws the resident chunks, for pipelines made with CompactVertex descriptions
+		void Draw(VkCommandBuffer commandBuffer);
+
+		const glm::mat4& GetDequantizeMatrix() const { return m_DequantizeMatrix; }
+
+		uint32_t GetChunkCount() const { return static_cast<uint32_t>(m_Chunks.size()); }
+		uint32_t GetResidentChunkCount() const { return m_ResidentChunkCount; }
+		VkDeviceSize GetResidentBytes() const { return m_ResidentBytes; }
+
+		FHStreamingSettings& GetSettings() { return m_Settings; }
+
+		static std::string GetChunkPath(const std::string& sourcePath);
+
+		//Splits the mesh on triangle centroids until every chunk fits MAX_CHUNK_TRIANGLES, then optimizes and
+		//quantizes each chunk on its own. Returns false when the file could not be written
+		static bool Build(const FHModel::ModelData& data, const std::string& chunkPath, uint64_t sourceHash, uint64_t sourceSize);
+
+	private:
+		struct Chunk
+		{
+			FHChunkInfo info{};
+			uint32_t vertexHandle{ FHGeometryPool::INVALID_HANDLE };
+			uint32_t indexHandle{ FHGeometryPool::INVALID_HANDLE };
+			float distance{};	//to the camera at the last Update
+		};
+
+		//Ranges of evicted chunks wait until the frames that may still draw them have finished
+		struct EvictedRange
+		{
+			uint32_t vertexHandle{};
+			uint32_t indexHandle{};
+			uint64_t frame{};
+		};
+
+		static bool IsValid(const FHMappedFile& file, uint64_t sourceHash, uint64_t sourceSize, bool checkSource);
+		static VkDeviceSize GetChunkSize(const FHChunkInfo& info);
+
+		void Upload(Chunk& chunk);
+		void Evict(Chunk& chunk);
+		void ReleaseEvicted(bool releaseAll);
+
+		FHGeometryPool& m_FHGeometryPool;
+		FHMappedFile m_File;
+		FHStreamingSettings m_Settings;
+
+		glm::mat4 m_DequantizeMatrix{ 1.f };
+		std::vector<Chunk> m_Chunks{};
+		std::vector<EvictedRange> m_EvictedRanges{};
+
+		uint32_t m_ResidentChunkCount{};
+		VkDeviceSize m_ResidentBytes{};
+		uint64_t m_FrameCount{};
+	};
+}
\ No newline at end of file
@@ -24,7 +24,7 @@ FH::FHSwapChain::FHSwapChain(FHDevice& deviceRef, VkExtent2D extent, std::shared
     Init();
 }
 
-VkImageView FH::FHSwapChain::CreateImageView(FHDevice& deviceRef, VkImage image, VkFormat format)
+VkImageView FH::FHSwapChain::CreateImageView(FHDevice& deviceRef, VkImage image, VkFormat format, uint32_t mipLevels)
 {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -33,7 +33,7 @@ VkImageView FH::FHSwapChain::CreateImageView(FHDevice& deviceRef, VkImage image,
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
@@ -44,7 +44,7 @@ namespace FH {
                 && swapChain.m_SwapChainImageFormat == m_SwapChainImageFormat;
         }
 
-        static VkImageView CreateImageView(FHDevice& device, VkImage image, VkFormat format);
+        static VkImageView CreateImageView(FHDevice& device, VkImage image, VkFormat format, uint32_t mipLevels = 1);
     
     private:
         void Init();
@@ -0,0 +1,121 @@
+#include "tangentGenerator.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+	//Triangles or vertices handed to a worker thread at least
+	constexpr size_t MIN_RANGE_SIZE{ 8192 };
+
+	struct FaceFrame
+	{
+		glm::vec3 tangent{};	//dP/du
+		glm::vec3 bitangent{};	//dP/dv
+		bool isValid{};
+	};
+
+	//Any unit vector perpendicular to normal, +X for a missing normal
+	glm::vec3 GetPerpendicular(const glm::vec3& normal)
+	{
+		const glm::vec3 axis{ std::abs(normal.x) < 0.9f ? glm::vec3{ 1.f, 0.f, 0.f } : glm::vec3{ 0.f, 1.f, 0.f } };
+		const glm::vec3 perpendicular{ glm::cross(axis, normal) };
+		const float length{ glm::length(perpendicular) };
+		return length > 0.f ? perpendicular / length : glm::vec3{ 1.f, 0.f, 0.f };
+	}
+
+	//Removes the part of direction along normal and normalizes, zero when nothing is left
+	glm::vec3 ProjectOnPlane(const glm::vec3& direction, const glm::vec3& normal)
+	{
+		const glm::vec3 projected{ direction - normal * glm::dot(normal, direction) };
+		const float length{ glm::length(projected) };
+		return length > 1e-20f ? projected / length : glm::vec3{ 0.f };
+	}
+}
+
+void FH::FHTangentGenerator::Generate(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+	std::span<const glm::vec2> uvs, std::span<const uint32_t> indices, std::span<glm::vec4> tangents)
+{
+	const size_t vertexCount{ positions.size() };
+	const size_t triangleCount{ indices.size() / 3 };
+
+	//Face tangents, every thread writes its own triangles only
+	std::vector<FaceFrame> faces(triangleCount);
+	ParallelFor(triangleCount, MIN_RANGE_SIZE, [&](size_t begin, size_t end)
+		{
+			for (size_t triangleIdx = begin; triangleIdx < end; ++triangleIdx)
+			{
+				const uint32_t* pTriangle{ &indices[triangleIdx * 3] };
+
+				const glm::vec3 edge0{ positions[pTriangle[1]] - positions[pTriangle[0]] };
+				const glm::vec3 edge1{ positions[pTriangle[2]] - positions[pTriangle[0]] };
+				const glm::vec2 uvEdge0{ uvs[pTriangle[1]] - uvs[pTriangle[0]] };
+				const glm::vec2 uvEdge1{ uvs[pTriangle[2]] - uvs[pTriangle[0]] };
+
+				//Zero area in uv space has no defined tangent, those faces do not vote
+				const float determinant{ uvEdge0.x * uvEdge1.y - uvEdge1.x * uvEdge0.y };
+				if (std::abs(determinant) < 1e-20f)
+					continue;
+
+				const float invDeterminant{ 1.f / determinant };
+				FaceFrame& face{ faces[triangleIdx] };
+				face.tangent = (edge0 * uvEdge1.y - edge1 * uvEdge0.y) * invDeterminant;
+				face.bitangent = (edge1 * uvEdge0.x - edge0 * uvEdge1.x) * invDeterminant;
+				face.isValid = std::isfinite(glm::dot(face.tangent, face.tangent))
+					&& std::isfinite(glm::dot(face.bitangent, face.bitangent));
+			}
+		});
+
+	//Vertex -> corner adjacency so every vertex gathers its own corners instead of faces scattering into vertices
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (uint32_t index : indices)
+		++offsets[index + 1];
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	std::vector<uint32_t> corners(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t cornerIdx = 0; cornerIdx < corners.size(); ++cornerIdx)
+			corners[fill[indices[cornerIdx]]++] = static_cast<uint32_t>(cornerIdx);
+	}
+
+	ParallelFor(vertexCount, MIN_RANGE_SIZE, [&](size_t begin, size_t end)
+		{
+			for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+			{
+				const glm::vec3& normal{ normals[vertexIdx] };
+				glm::vec3 tangentSum{ 0.f };
+				glm::vec3 bitangentSum{ 0.f };
+
+				for (uint32_t adjacencyIdx = offsets[vertexIdx]; adjacencyIdx < offsets[vertexIdx + 1]; ++adjacencyIdx)
+				{
+					const uint32_t cornerIdx{ corners[adjacencyIdx] };
+					const FaceFrame& face{ faces[cornerIdx / 3] };
+					if (!face.isValid)
+						continue;
+
+					//Weight by the angle the face spans at this corner
+					const uint32_t* pTriangle{ &indices[cornerIdx / 3 * 3] };
+					const uint32_t corner{ cornerIdx % 3 };
+					const glm::vec3& position{ positions[pTriangle[corner]] };
+					const glm::vec3 toNext{ ProjectOnPlane(positions[pTriangle[(corner + 1) % 3]] - position, normal) };
+					const glm::vec3 toPrevious{ ProjectOnPlane(positions[pTriangle[(corner + 2) % 3]] - position, normal) };
+					const float angle{ std::acos(std::clamp(glm::dot(toNext, toPrevious), -1.f, 1.f)) };
+
+					tangentSum += ProjectOnPlane(face.tangent, normal) * angle;
+					bitangentSum += ProjectOnPlane(face.bitangent, normal) * angle;
+				}
+
+				//Gram-Schmidt against the normal, the sign says whether the uvs are mirrored
+				glm::vec3 tangent{ ProjectOnPlane(tangentSum, normal) };
+				if (tangent == glm::vec3{ 0.f })
+					tangent = GetPerpendicular(normal);
+
+				const float sign{ glm::dot(glm::cross(normal, tangent), bitangentSum) < 0.f ? -1.f : 1.f };
+				tangents[vertexIdx] = glm::vec4{ tangent, sign };
+			}
+		});
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+
+namespace FH
+{
+	//Per vertex tangent frames following the MikkTSpace conventions: face tangents are projected on the
+	//vertex normal plane and angle weighted, the result is orthonormalized against the normal and w holds
+	//the bitangent sign, so bitangent = w * cross(normal, tangent)
+	class FHTangentGenerator final
+	{
+	public:
+		//Runs over triangle ranges and then vertex ranges on worker threads, tangents must hold one
+		//entry per vertex. Vertices without usable uvs get an arbitrary tangent perpendicular to the normal
+		static void Generate(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+			std::span<const glm::vec2> uvs, std::span<const uint32_t> indices, std::span<glm::vec4> tangents);
+
+		FHTangentGenerator() = delete;
+	};
+}
\ No newline at end of file
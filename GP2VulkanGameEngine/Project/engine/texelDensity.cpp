@@ -0,0 +1,63 @@
+#include "texelDensity.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+FH::FHTexelDensity::Surface FH::FHTexelDensity::Measure(const FHModel::ModelData& data, const glm::vec3& scale)
+{
+	return Measure(data.vertices, data.indices, data.lods, scale);
+}
+
+FH::FHTexelDensity::Surface FH::FHTexelDensity::Measure(std::span<const FHModel::Vertex> vertices, std::span<const uint32_t> indices,
+	std::span<const FHModel::Lod> lods, const glm::vec3& scale)
+{
+	const uint32_t firstIndex{ lods.empty() ? 0 : lods.front().firstIndex };
+	const uint32_t indexCount{ lods.empty() ? static_cast<uint32_t>(indices.size()) : lods.front().indexCount };
+
+	//Rotation and translation keep areas, only the scale changes them
+	Surface surface{};
+	for (uint32_t idx = firstIndex; idx + 2 < firstIndex + indexCount; idx += 3)
+	{
+		const FHModel::Vertex& vertex0{ vertices[indices[idx]] };
+		const FHModel::Vertex& vertex1{ vertices[indices[idx + 1]] };
+		const FHModel::Vertex& vertex2{ vertices[indices[idx + 2]] };
+
+		const glm::vec3 edge0{ (vertex1.pos - vertex0.pos) * scale };
+		const glm::vec3 edge1{ (vertex2.pos - vertex0.pos) * scale };
+		surface.worldArea += 0.5 * glm::length(glm::cross(edge0, edge1));
+
+		const glm::vec2 uvEdge0{ vertex1.uv - vertex0.uv };
+		const glm::vec2 uvEdge1{ vertex2.uv - vertex0.uv };
+		surface.uvArea += 0.5 * std::abs(static_cast<double>(uvEdge0.x) * uvEdge1.y - static_cast<double>(uvEdge0.y) * uvEdge1.x);
+	}
+	return surface;
+}
+
+double FH::FHTexelDensity::GetUvDensity(const Surface& surface)
+{
+	if (surface.worldArea <= 0.0)
+		return 0.0;
+
+	//Areas scale with the square of the density
+	return std::sqrt(surface.uvArea / surface.worldArea);
+}
+
+double FH::FHTexelDensity::GetPixelDensity(const View& view)
+{
+	const double viewHeight{ 2.0 * view.distance * std::tan(view.verticalFov * 0.5) };
+	return viewHeight > 0.0 ? view.screenHeight / viewHeight : 0.0;
+}
+
+uint32_t FH::FHTexelDensity::GetResolvableSize(const Surface& surface, const View& view)
+{
+	const double uvDensity{ GetUvDensity(surface) };
+	if (uvDensity <= 0.0)
+		return UINT32_MAX;
+
+	//Rounded up, so the limit never drops below one texel per pixel
+	const double size{ std::ceil(GetPixelDensity(view) / uvDensity) };
+	if (size >= static_cast<double>(1u << 31))
+		return UINT32_MAX;
+	return std::bit_ceil(std::max(static_cast<uint32_t>(size), 1u));
+}
\ No newline at end of file
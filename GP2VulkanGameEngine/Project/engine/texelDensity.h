@@ -0,0 +1,43 @@
+#pragma once
+#include "model.h"
+
+#include <cstdint>
+#include <span>
+
+namespace FH
+{
+	//Compares how densely a mesh's UVs cover its surface with how many pixels that surface gets on screen, to find
+	//the texture size past which extra texels can no longer be told apart at the distance the model is viewed from
+	class FHTexelDensity final
+	{
+	public:
+		//Summed over the triangles of LOD 0, the world area with the scale of the object applied
+		struct Surface
+		{
+			double worldArea{};
+			double uvArea{};
+		};
+
+		struct View
+		{
+			float distance{};
+			float verticalFov{};	//radians
+			uint32_t screenHeight{};
+		};
+
+		static Surface Measure(const FHModel::ModelData& data, const glm::vec3& scale = glm::vec3{ 1.f });
+		//Same on arrays lent by FHModel::InspectModelData, without LODs every index is LOD 0
+		static Surface Measure(std::span<const FHModel::Vertex> vertices, std::span<const uint32_t> indices,
+			std::span<const FHModel::Lod> lods, const glm::vec3& scale = glm::vec3{ 1.f });
+
+		//UV units per world unit, a texture of size N gives N times this many texels per world unit
+		static double GetUvDensity(const Surface& surface);
+		//Screen pixels per world unit for a surface facing the camera at the view distance
+		static double GetPixelDensity(const View& view);
+
+		//Smallest power of two at which one texel covers at most one pixel, UINT32_MAX for a mesh without UV area
+		static uint32_t GetResolvableSize(const Surface& surface, const View& view);
+
+		FHTexelDensity() = delete;
+	};
+}
\ No newline at end of file
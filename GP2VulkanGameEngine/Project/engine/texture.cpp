@@ -1,67 +1,394 @@
 #include "texture.h"
 #include "swapchain.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "external/stb_image.h"
-
+#include "uploadContext.h"
+#include "imageDecoder.h"
+#include "ktxFile.h"
+#include "mipChain.h"
+#include "ormPacker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 #include <stdexcept>
 
-FH::FHTexture::FHTexture(FHDevice& device, const std::string& path)
+FH::FHTexture::FHTexture(FHDevice& device, const std::string& path, bool isSrgb, VkSampler sharedSampler)
+	: FHTexture{ device, Probe(device, path, isSrgb), sharedSampler }
+{
+}
+
+FH::FHTexture::FHTexture(FHDevice& device, Decoded&& decoded, VkSampler sharedSampler)
 	: m_FHDevice{ device }
 {
-	CreateTextureFromImage("resources/" + path);
-	CreateTextureSampler();
+	CreateTexture(std::move(decoded));
+	CreateTextureSampler(sharedSampler);
+}
+
+void FH::FHTexture::CreateTexture(Decoded&& decoded)
+{
+	if (decoded.pKtxFile)
+	{
+		const std::span<const FHKtxFile::Level> levels{ decoded.pKtxFile->GetLevels() };
+		m_TopLevel = std::min(decoded.topLevel, static_cast<uint32_t>(levels.size()) - 1);
+		m_TailLevel = static_cast<uint32_t>(levels.size()) - 1;
+		while (m_TailLevel > m_TopLevel &&
+			std::max(levels[m_TailLevel - 1].width, levels[m_TailLevel - 1].height) <= STREAMING_TAIL_SIZE)
+			--m_TailLevel;
+
+		const uint32_t firstLevel{ decoded.isStreamed ? m_TailLevel : m_TopLevel };
+		std::vector<std::span<const uint8_t>> levelData{};
+		for (uint32_t levelIdx = firstLevel; levelIdx < levels.size(); ++levelIdx)
+			levelData.push_back(levels[levelIdx].data);
+
+		CreateTextureFromKtx(*decoded.pKtxFile, firstLevel, levelData);
+		if (decoded.isStreamed)
+			m_pKtxFile = std::move(decoded.pKtxFile);
+	}
+	else if (!decoded.imagePath.empty() || !decoded.fileData.empty())
+		CreateTextureFromImage(decoded);
+	else
+		CreateTextureFromPixels(decoded.pixels.data(), decoded.width, decoded.height, decoded.isSrgb);
+}
+
+std::unique_ptr<FH::FHTexture> FH::FHTexture::CreateOrm(FHDevice& device, const FHMaterialPaths& material,
+	VkSampler sharedSampler)
+{
+	return std::make_unique<FHTexture>(device, DecodeOrm(device, material), sharedSampler);
+}
+
+FH::FHTexture::Decoded FH::FHTexture::Probe(FHDevice& device, const std::string& path, bool isSrgb)
+{
+	Decoded decoded{};
+	decoded.isSrgb = isSrgb;
+	decoded.pKtxFile = OpenKtx(device, FHKtxFile::GetKtxPath("resources/" + path));
+	if (!decoded.pKtxFile)
+	{
+		decoded.imagePath = "resources/" + path;
+		FHImageDecoder::GetSize(decoded.imagePath, decoded.width, decoded.height);
+	}
+	return decoded;
+}
+
+FH::FHTexture::Decoded FH::FHTexture::Probe(std::vector<uint8_t>&& fileData, bool isSrgb)
+{
+	Decoded decoded{};
+	decoded.isSrgb = isSrgb;
+	FHImageDecoder::GetSize(fileData, decoded.width, decoded.height);
+	decoded.fileData = std::move(fileData);
+	return decoded;
+}
+
+FH::FHTexture::Decoded FH::FHTexture::DecodeOrm(FHDevice& device, const FHMaterialPaths& material)
+{
+	//The packed file from FHTextureEncoder skips decoding three images at startup
+	Decoded decoded{};
+	if (FHOrmPacker::HasChannels(material))
+		decoded.pKtxFile = OpenKtx(device, "resources/" + FHOrmPacker::GetPackedPath(material));
+
+	if (!decoded.pKtxFile)
+	{
+		FHOrmPacker::Image image{ FHOrmPacker::Pack(material, "resources/") };
+		decoded.pixels = std::move(image.pixels);
+		decoded.width = image.width;
+		decoded.height = image.height;
+	}
+	return decoded;
+}
+
+void FH::FHTexture::LimitSize(Decoded& decoded, uint32_t maxSize)
+{
+	if (decoded.pKtxFile)
+	{
+		const std::span<const FHKtxFile::Level> levels{ decoded.pKtxFile->GetLevels() };
+		decoded.topLevel = 0;
+		while (decoded.topLevel + 1 < levels.size() &&
+			std::max(levels[decoded.topLevel].width, levels[decoded.topLevel].height) > maxSize)
+			++decoded.topLevel;
+		return;
+	}
+
+	uint32_t levelCount{ 1 };
+	while (std::max(decoded.width, decoded.height) >> (levelCount - 1) > std::max(maxSize, 1u))
+		++levelCount;
+	if (levelCount == 1)
+		return;
+
+	LoadPixels(decoded);
+
+	//Filtered the same way as the mips, then only the last level is kept
+	decoded.pixels.resize(FHMipChain::GetSize(decoded.width, decoded.height, levelCount));
+	const std::vector<VkBufferImageCopy> regions{ FHMipChain::Downsample(decoded.pixels.data(), decoded.width, decoded.height,
+		levelCount, decoded.isSrgb) };
+
+	const VkBufferImageCopy& region{ regions.back() };
+	const size_t levelSize{ static_cast<size_t>(region.imageExtent.width) * region.imageExtent.height * 4 };
+	decoded.pixels.erase(decoded.pixels.begin() + region.bufferOffset + levelSize, decoded.pixels.end());
+	decoded.pixels.erase(decoded.pixels.begin(), decoded.pixels.begin() + region.bufferOffset);
+	decoded.width = region.imageExtent.width;
+	decoded.height = region.imageExtent.height;
+}
+
+void FH::FHTexture::LoadPixels(Decoded& decoded)
+{
+	if (decoded.imagePath.empty() && decoded.fileData.empty())
+		return;
+
+	decoded.pixels.resize(static_cast<size_t>(decoded.width) * decoded.height * 4);
+	if (!decoded.fileData.empty())
+		FHImageDecoder::Decode(decoded.fileData, decoded.pixels.data(), decoded.width, decoded.height);
+	else
+		FHImageDecoder::Decode(decoded.imagePath, decoded.pixels.data(), decoded.width, decoded.height);
+	decoded.imagePath.clear();
+	decoded.fileData = {};
+}
+
+uint32_t FH::FHTexture::GetSize(const Decoded& decoded)
+{
+	if (!decoded.pKtxFile)
+		return std::max(decoded.width, decoded.height);
+
+	const FHKtxFile::Level& level{ decoded.pKtxFile->GetLevels()[decoded.topLevel] };
+	return std::max(level.width, level.height);
+}
+
+VkDeviceSize FH::FHTexture::GetByteSize(const Decoded& decoded)
+{
+	if (!decoded.pKtxFile)
+		return FHMipChain::GetSize(decoded.width, decoded.height, FHMipChain::GetLevelCount(decoded.width, decoded.height));
+
+	VkDeviceSize size{};
+	const std::span<const FHKtxFile::Level> levels{ decoded.pKtxFile->GetLevels() };
+	for (uint32_t levelIdx = decoded.topLevel; levelIdx < levels.size(); ++levelIdx)
+		size += levels[levelIdx].data.size();
+	return size;
 }
 
 FH::FHTexture::~FHTexture()
 {
-	vkDestroySampler(m_FHDevice.GetDevice(), m_TextureSampler, nullptr);
+	ReleaseRetired(UINT64_MAX);
+	if (m_OwnsSampler)
+		vkDestroySampler(m_FHDevice.GetDevice(), m_TextureSampler, nullptr);
 	vkDestroyImageView(m_FHDevice.GetDevice(), m_TextureImageView, nullptr);
 	vkDestroyImage(m_FHDevice.GetDevice(), m_TextureImage, nullptr);
 	vkFreeMemory(m_FHDevice.GetDevice(), m_TextureImageMemory, nullptr);
 }
 
-void FH::FHTexture::CreateTextureFromImage(const std::string& path)
+std::shared_ptr<FH::FHKtxFile> FH::FHTexture::OpenKtx(FHDevice& device, const std::string& path)
 {
-    int bytesPerPixel;
-	stbi_set_flip_vertically_on_load(true);
-    stbi_uc* pPixels = stbi_load(path.c_str(), &m_TexWidth, &m_TexHeight, &bytesPerPixel, STBI_rgb_alpha);
-    VkDeviceSize imageSize = m_TexWidth * m_TexHeight * 4;
+	auto pFile{ std::make_shared<FHKtxFile>(path) };
+	if (!pFile->IsOpen())
+		return nullptr;
 
-    if (!pPixels)
-        throw std::runtime_error("failed to load texture image!");
+	try
+	{
+		device.FindSupportedFormat({ pFile->GetFormat() }, VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+	}
+	catch (const std::runtime_error&)
+	{
+		std::cout << "Block compressed format of " << path << " is not supported, falling back to RGBA8" << std::endl;
+		return nullptr;
+	}
+	return pFile;
+}
 
-	FHBuffer stagingBuffer
+void FH::FHTexture::CreateTextureFromKtx(const FHKtxFile& file, uint32_t firstLevel,
+	std::span<const std::span<const uint8_t>> levelData)
+{
+	const std::span<const FHKtxFile::Level> levels{ file.GetLevels() };
+	m_FirstResidentLevel = firstLevel;
+	m_TexWidth = static_cast<int>(levels[firstLevel].width);
+	m_TexHeight = static_cast<int>(levels[firstLevel].height);
+	m_MipmapCount = static_cast<uint32_t>(levels.size()) - firstLevel;
+
+	VkDeviceSize stagingSize{};
+	for (const std::span<const uint8_t>& data : levelData)
+		stagingSize += data.size();
+	m_ResidentBytes = stagingSize;
+
+	FHUploadContext& uploads{ m_FHDevice.GetUploadContext() };
+	const FHUploadContext::Staging staging{ uploads.Stage(stagingSize) };
+
+	//Block sizes keep every offset aligned, the blocks are copied as stored
+	std::vector<VkBufferImageCopy> regions{};
+	VkDeviceSize offset{};
+	for (uint32_t levelIdx = 0; levelIdx < m_MipmapCount; ++levelIdx)
 	{
-		m_FHDevice,
-		4,
-		static_cast<uint32_t>(m_TexWidth * m_TexHeight),
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
+		const FHKtxFile::Level& level{ levels[firstLevel + levelIdx] };
+		std::memcpy(staging.pData + offset, levelData[levelIdx].data(), levelData[levelIdx].size());
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = levelIdx;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { level.width, level.height, 1 };
+		regions.push_back(region);
+
+		offset += levelData[levelIdx].size();
+	}
+
+	CreateImage(file.GetFormat(), VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_TextureImage, m_TextureImageMemory);
+
+	TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	uploads.CopyToImage(staging, m_TextureImage, regions);
+	TransitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*)pPixels);
+	m_Format = file.GetFormat();
+	m_TextureImageView =
+		FHSwapChain::CreateImageView(m_FHDevice, m_TextureImage, file.GetFormat(), m_MipmapCount);
+}
 
-	stbi_image_free(pPixels);
+void FH::FHTexture::CreateTextureFromPixels(const uint8_t* pPixels, uint32_t width, uint32_t height, bool isSrgb)
+{
+	const FHUploadContext::Staging staging{ StagePixels(width, height, isSrgb) };
+	std::memcpy(staging.pData, pPixels, static_cast<size_t>(width) * height * 4);
+	CreateTextureFromStaging(staging, width, height, isSrgb);
+}
 
-	CreateImage(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_TextureImage, m_TextureImageMemory);
+void FH::FHTexture::CreateTextureFromImage(const Decoded& decoded)
+{
+	const FHUploadContext::Staging staging{ StagePixels(decoded.width, decoded.height, decoded.isSrgb) };
+	if (!decoded.fileData.empty())
+		FHImageDecoder::Decode(decoded.fileData, staging.pData, decoded.width, decoded.height);
+	else
+		FHImageDecoder::Decode(decoded.imagePath, staging.pData, decoded.width, decoded.height);
+	CreateTextureFromStaging(staging, decoded.width, decoded.height, decoded.isSrgb);
+}
+
+FH::FHUploadContext::Staging FH::FHTexture::StagePixels(uint32_t width, uint32_t height, bool isSrgb) const
+{
+	//Without blit support the staging buffer holds the whole chain
+	const VkFormat format{ isSrgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM };
+	const uint32_t stagedLevels{ CanBlitMipmaps(format) ? 1 : FHMipChain::GetLevelCount(width, height) };
+	return m_FHDevice.GetUploadContext().Stage(FHMipChain::GetSize(width, height, stagedLevels));
+}
+
+void FH::FHTexture::CreateTextureFromStaging(const FHUploadContext::Staging& staging, uint32_t width, uint32_t height, bool isSrgb)
+{
+	const VkFormat format{ isSrgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM };
+	m_TexWidth = static_cast<int>(width);
+	m_TexHeight = static_cast<int>(height);
+	m_MipmapCount = FHMipChain::GetLevelCount(width, height);
+	m_ResidentBytes = FHMipChain::GetSize(width, height, m_MipmapCount);
+
+	const bool canBlit{ CanBlitMipmaps(format) };
+	const uint32_t stagedLevels{ canBlit ? 1 : m_MipmapCount };
+
+	const std::vector<VkBufferImageCopy> regions{ FHMipChain::Downsample(staging.pData, width, height, stagedLevels, isSrgb) };
+
+	CreateImage(format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_TextureImage, m_TextureImageMemory);
 
 	TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	m_FHDevice.GetUploadContext().CopyToImage(staging, m_TextureImage, regions);
+
+	if (canBlit)
+		GenerateMipmaps();
+	else
+		TransitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-	m_FHDevice.CopyBufferToImage(stagingBuffer.GetBuffer(), m_TextureImage, 
-		static_cast<uint32_t>(m_TexWidth), static_cast<uint32_t>(m_TexHeight), 1);
+	m_Format = format;
+	m_TextureImageView =
+		FHSwapChain::CreateImageView(m_FHDevice, m_TextureImage, format, m_MipmapCount);
+}
+
+void FH::FHTexture::SetResidentLevels(uint32_t firstLevel, std::span<const std::span<const uint8_t>> levelData, uint64_t frame)
+{
+	//Frames in flight may still sample the old image, its view stays valid until they are done
+	m_RetiredImages.push_back({ m_TextureImage, m_TextureImageView, m_TextureImageMemory, frame });
+	CreateTextureFromKtx(*m_pKtxFile, firstLevel, levelData);
+	++m_ViewVersion;
+}
+
+VkDeviceSize FH::FHTexture::GetTailBytes() const
+{
+	//Only RGBA8 images are made with transfer source usage, block compressed ones stream their levels instead
+	if (m_IsEvicted || (m_Format != VK_FORMAT_R8G8B8A8_SRGB && m_Format != VK_FORMAT_R8G8B8A8_UNORM))
+		return m_ResidentBytes;
+
+	const uint32_t width{ static_cast<uint32_t>(m_TexWidth) };
+	const uint32_t height{ static_cast<uint32_t>(m_TexHeight) };
+	return FHMipChain::GetSize(width, height, m_MipmapCount) - FHMipChain::GetSize(width, height, GetImageTailLevel());
+}
 
+void FH::FHTexture::Evict(uint64_t frame)
+{
+	if (GetTailBytes() == m_ResidentBytes)
+		return;
+
+	//The old image is read by the copy and stays alive for the frames in flight
+	const uint32_t tailLevel{ GetImageTailLevel() };
+	const VkImage oldImage{ m_TextureImage };
+	const uint32_t oldLevelCount{ m_MipmapCount };
+	m_ResidentBytes = GetTailBytes();
+	m_RetiredImages.push_back({ m_TextureImage, m_TextureImageView, m_TextureImageMemory, frame });
+	TransitionImageLayout(oldImage, oldLevelCount, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	m_TexWidth = std::max(m_TexWidth >> tailLevel, 1);
+	m_TexHeight = std::max(m_TexHeight >> tailLevel, 1);
+	m_MipmapCount = oldLevelCount - tailLevel;
+	CreateImage(m_Format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_TextureImage, m_TextureImageMemory);
+	TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+	std::vector<VkImageCopy> regions{};
+	for (uint32_t levelIdx = 0; levelIdx < m_MipmapCount; ++levelIdx)
+	{
+		VkImageCopy region{};
+		region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, tailLevel + levelIdx, 0, 1 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, levelIdx, 0, 1 };
+		region.extent = { std::max(static_cast<uint32_t>(m_TexWidth) >> levelIdx, 1u),
+			std::max(static_cast<uint32_t>(m_TexHeight) >> levelIdx, 1u), 1 };
+		regions.push_back(region);
+	}
+	vkCmdCopyImage(m_FHDevice.GetUploadContext().GetCommandBuffer(),
+		oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		m_TextureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()), regions.data());
 	TransitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 	m_TextureImageView =
-		FHSwapChain::CreateImageView(m_FHDevice, m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB);
+		FHSwapChain::CreateImageView(m_FHDevice, m_TextureImage, m_Format, m_MipmapCount);
+	m_IsEvicted = true;
+	++m_ViewVersion;
+}
 
+void FH::FHTexture::Reload(Decoded&& decoded, uint64_t frame)
+{
+	m_RetiredImages.push_back({ m_TextureImage, m_TextureImageView, m_TextureImageMemory, frame });
+	CreateTexture(std::move(decoded));
+	m_IsEvicted = false;
+	++m_ViewVersion;
 }
 
-void FH::FHTexture::CreateTextureSampler()
+uint32_t FH::FHTexture::GetImageTailLevel() const
+{
+	uint32_t tailLevel{};
+	while (tailLevel + 1 < m_MipmapCount && static_cast<uint32_t>(std::max(m_TexWidth, m_TexHeight)) >> tailLevel > STREAMING_TAIL_SIZE)
+		++tailLevel;
+	return tailLevel;
+}
+
+void FH::FHTexture::ReleaseRetired(uint64_t completedFrame)
+{
+	std::erase_if(m_RetiredImages, [this, completedFrame](const RetiredImage& retired)
+		{
+			if (retired.frame > completedFrame)
+				return false;
+
+			vkDestroyImageView(m_FHDevice.GetDevice(), retired.imageView, nullptr);
+			vkDestroyImage(m_FHDevice.GetDevice(), retired.image, nullptr);
+			vkFreeMemory(m_FHDevice.GetDevice(), retired.imageMemory, nullptr);
+			return true;
+		});
+}
+
+VkSamplerCreateInfo FH::FHTexture::GetSamplerInfo(const FHDevice& device)
 {
 	VkSamplerCreateInfo samplerInfo{};
 	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -71,7 +398,7 @@ void FH::FHTexture::CreateTextureSampler()
 	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 	samplerInfo.anisotropyEnable = VK_TRUE;
-	samplerInfo.maxAnisotropy = m_FHDevice.m_Properties.limits.maxSamplerAnisotropy;
+	samplerInfo.maxAnisotropy = device.m_Properties.limits.maxSamplerAnisotropy;
 	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 	samplerInfo.unnormalizedCoordinates = VK_FALSE;
 	samplerInfo.compareEnable = VK_FALSE;
@@ -79,10 +406,23 @@ void FH::FHTexture::CreateTextureSampler()
 	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	samplerInfo.mipLodBias = 0.0f;
 	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = 0.0f;
+	//The image view limits the levels, so one sampler fits textures of any size
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	return samplerInfo;
+}
+
+void FH::FHTexture::CreateTextureSampler(VkSampler sharedSampler)
+{
+	if (sharedSampler != VK_NULL_HANDLE)
+	{
+		m_TextureSampler = sharedSampler;
+		return;
+	}
 
+	const VkSamplerCreateInfo samplerInfo{ GetSamplerInfo(m_FHDevice) };
 	if (vkCreateSampler(m_FHDevice.GetDevice(), &samplerInfo, nullptr, &m_TextureSampler) != VK_SUCCESS)
 		throw std::runtime_error("failed to create texture sampler!");
+	m_OwnsSampler = true;
 }
 
 void FH::FHTexture::CreateImage(VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
@@ -92,7 +432,7 @@ void FH::FHTexture::CreateImage(VkFormat format, VkImageTiling tiling, VkImageUs
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
 	imageInfo.extent = { static_cast<uint32_t>(m_TexWidth), static_cast<uint32_t>(m_TexHeight), 1 };
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = m_MipmapCount;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -101,29 +441,17 @@ void FH::FHTexture::CreateImage(VkFormat format, VkImageTiling tiling, VkImageUs
 	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-	m_FHDevice.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-		m_TextureImage, m_TextureImageMemory);
-
-	if (vkCreateImage(m_FHDevice.GetDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS)
-		throw std::runtime_error("failed to create image!");
-
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(m_FHDevice.GetDevice(), image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = m_FHDevice.FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-	if (vkAllocateMemory(m_FHDevice.GetDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-		throw std::runtime_error("failed to allocate image memory!");
-
-	vkBindImageMemory(m_FHDevice.GetDevice(), image, imageMemory, 0);
+	m_FHDevice.CreateImageWithInfo(imageInfo, properties, image, imageMemory);
 }
 
 void FH::FHTexture::TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout) 
 {
-	VkCommandBuffer commandBuffer = m_FHDevice.BeginSingleTimeCommands();
+	TransitionImageLayout(m_TextureImage, m_MipmapCount, oldLayout, newLayout);
+}
+
+void FH::FHTexture::TransitionImageLayout(VkImage image, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+	VkCommandBuffer commandBuffer{ m_FHDevice.GetUploadContext().GetCommandBuffer() };
 
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -131,10 +459,10 @@ void FH::FHTexture::TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout
 	barrier.newLayout = newLayout;
 	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = m_TextureImage;
+	barrier.image = image;
 	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.levelCount = levelCount;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
 
@@ -155,6 +483,14 @@ void FH::FHTexture::TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout
 		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 	}
+	else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+		//Earlier frames only read it, the copy has to wait for them
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
 	else {
 		throw std::invalid_argument("unsupported layout transition!");
 	}
@@ -167,6 +503,98 @@ void FH::FHTexture::TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout
 		0, nullptr,
 		1, &barrier
 	);
+}
+
+bool FH::FHTexture::CanBlitMipmaps(VkFormat format) const
+{
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(m_FHDevice.GetPhysicalDevice(), format, &formatProperties);
+
+	constexpr VkFormatFeatureFlags requiredFeatures{ VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+	return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+void FH::FHTexture::GenerateMipmaps()
+{
+	VkCommandBuffer commandBuffer{ m_FHDevice.GetUploadContext().GetCommandBuffer() };
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = m_TextureImage;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	int32_t mipWidth{ m_TexWidth };
+	int32_t mipHeight{ m_TexHeight };
 
-	m_FHDevice.EndSingleTimeCommands(commandBuffer);
+	for (uint32_t level = 1; level < m_MipmapCount; ++level)
+	{
+		//The level above was written by the copy or the previous blit
+		barrier.subresourceRange.baseMipLevel = level - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+
+		const int32_t nextWidth{ std::max(mipWidth / 2, 1) };
+		const int32_t nextHeight{ std::max(mipHeight / 2, 1) };
+
+		//sRGB formats are filtered in linear space by the blit
+		VkImageBlit blit{};
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+
+		vkCmdBlitImage(commandBuffer,
+			m_TextureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			m_TextureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+
+		mipWidth = nextWidth;
+		mipHeight = nextHeight;
+	}
+
+	//The last level was only written
+	barrier.subresourceRange.baseMipLevel = m_MipmapCount - 1;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier);
 }
\ No newline at end of file
@@ -1,15 +1,45 @@
 #pragma once
 #include "buffer.h"
+#include "ktxFile.h"
+#include "material.h"
+#include "uploadContext.h"
 
 #include <string>
 #include <memory>
+#include <span>
+#include <vector>
 
 namespace FH
 {
 	class FHTexture
 	{
 	public:
-		FHTexture(FHDevice& device, const std::string& path);
+		//CPU half of a load, the mapped .ktx2 or the decoded RGBA8 image. Decoding only queries format support
+		//from the device, so it can run on worker threads while the upload stays on the main thread
+		struct Decoded
+		{
+			std::shared_ptr<FHKtxFile> pKtxFile{};
+			std::vector<uint8_t> pixels{};
+			//Set by Probe instead of pixels, the upload decodes the file or the bytes read from it straight into the
+			//staging memory, no pixel vector between
+			std::string imagePath{};
+			std::vector<uint8_t> fileData{};
+			uint32_t width{};
+			uint32_t height{};
+			bool isSrgb{};
+			//Only the mip tail of a .ktx2 is uploaded, FHTextureStreamer adds the larger levels
+			bool isStreamed{};
+			//Levels of the .ktx2 above it are never uploaded, see LimitSize
+			uint32_t topLevel{};
+		};
+
+		//Levels up to this size are uploaded with a streamed texture, so it can be drawn right away
+		static constexpr uint32_t STREAMING_TAIL_SIZE{ 64 };
+
+		//Prefers a .ktx2 next to the image with pre-compressed mips, isSrgb only applies to the image fallback.
+		//Without a shared sampler the texture creates its own from GetSamplerInfo
+		FHTexture(FHDevice& device, const std::string& path, bool isSrgb = true, VkSampler sharedSampler = VK_NULL_HANDLE);
+		FHTexture(FHDevice& device, Decoded&& decoded, VkSampler sharedSampler = VK_NULL_HANDLE);
 		~FHTexture();
 
 		FHTexture(const FHTexture&)				= delete;
@@ -20,21 +50,107 @@ namespace FH
 		VkSampler GetTextureSampler() const { return m_TextureSampler; }
 		VkImageView GetTextureImageView() const { return m_TextureImageView; }
 		VkImageLayout GetTextureImageLayout() const { return m_TextureImageLayout; }
+		uint32_t GetMipLevelCount() const { return m_MipmapCount; }
+
+		//Streamed textures keep their .ktx2 mapped and hold the levels from GetFirstResidentLevel down
+		bool IsStreamed() const { return m_pKtxFile != nullptr; }
+		const std::shared_ptr<const FHKtxFile>& GetKtxFile() const { return m_pKtxFile; }
+		uint32_t GetFirstResidentLevel() const { return m_FirstResidentLevel; }
+		uint32_t GetTailLevel() const { return m_TailLevel; }
+		uint32_t GetTopLevel() const { return m_TopLevel; }
+		VkDeviceSize GetResidentBytes() const { return m_ResidentBytes; }
+		//Increases every time the image view is replaced, descriptor sets written before are stale
+		uint32_t GetViewVersion() const { return m_ViewVersion; }
+
+		//Replaces the image with one holding levels [firstLevel, last] of the .ktx2, levelData has the bytes of
+		//each of them. The old image stays alive until ReleaseRetired is called with frame or later
+		void SetResidentLevels(uint32_t firstLevel, std::span<const std::span<const uint8_t>> levelData, uint64_t frame);
+		void ReleaseRetired(uint64_t completedFrame);
+
+		//Textures without a .ktx2 drop to their mip tail for the memory budget, the levels are copied on the GPU.
+		//Reload replaces the tail with the decoded image again. Both retire the old image like SetResidentLevels
+		bool IsEvicted() const { return m_IsEvicted; }
+		//Bytes the texture holds once evicted, all of them when it is no larger than its tail
+		VkDeviceSize GetTailBytes() const;
+		void Evict(uint64_t frame);
+		void Reload(Decoded&& decoded, uint64_t frame);
+
+		//Ambient occlusion, roughness and specular of the material in one texture, see FHOrmPacker.
+		//A material without any of them gives a 1x1 texture of the defaults
+		static std::unique_ptr<FHTexture> CreateOrm(FHDevice& device, const FHMaterialPaths& material,
+			VkSampler sharedSampler = VK_NULL_HANDLE);
+
+		//Only reads the size of an image, the upload decodes it. A .ktx2 next to it is mapped instead
+		static Decoded Probe(FHDevice& device, const std::string& path, bool isSrgb = true);
+		//An image file that was already read into memory, see FHFileReader. There is no .ktx2 lookup
+		static Decoded Probe(std::vector<uint8_t>&& fileData, bool isSrgb = true);
+		static Decoded DecodeOrm(FHDevice& device, const FHMaterialPaths& material);
+		//Keeps the texture at most maxSize texels across, a .ktx2 skips its larger levels and an image is downsampled
+		static void LimitSize(Decoded& decoded, uint32_t maxSize);
+		//Width or height, whichever is larger, and the bytes of the full mip chain at the current size
+		static uint32_t GetSize(const Decoded& decoded);
+		static VkDeviceSize GetByteSize(const Decoded& decoded);
+
+		//Trilinear anisotropic repeat sampling over every mip, the same for all textures so it can be shared
+		static VkSamplerCreateInfo GetSamplerInfo(const FHDevice& device);
 
 	private:
-		void CreateTextureFromImage(const std::string& path);
-		void CreateTextureSampler();
+		//Null when there is no .ktx2 or the device cannot sample its format
+		static std::shared_ptr<FHKtxFile> OpenKtx(FHDevice& device, const std::string& path);
+		//Decodes the image of a probed texture into its pixels
+		static void LoadPixels(Decoded& decoded);
+
+		void CreateTexture(Decoded&& decoded);
+		//First level of an RGBA8 chain no larger than STREAMING_TAIL_SIZE
+		uint32_t GetImageTailLevel() const;
+
+		//Image of levels [firstLevel, last] of the file, the blocks of each level are copied as stored
+		void CreateTextureFromKtx(const FHKtxFile& file, uint32_t firstLevel, std::span<const std::span<const uint8_t>> levelData);
+		//Tightly packed RGBA8 texels, mips are generated
+		void CreateTextureFromPixels(const uint8_t* pPixels, uint32_t width, uint32_t height, bool isSrgb);
+		//Same as from pixels, but the image of a probed texture is decoded straight into the staging memory
+		void CreateTextureFromImage(const Decoded& decoded);
+		//Room for level 0, or for the whole chain when the mips are made on the CPU
+		FHUploadContext::Staging StagePixels(uint32_t width, uint32_t height, bool isSrgb) const;
+		//Level 0 is in the staging memory
+		void CreateTextureFromStaging(const FHUploadContext::Staging& staging, uint32_t width, uint32_t height, bool isSrgb);
+		void CreateTextureSampler(VkSampler sharedSampler);
 
 		void CreateImage(VkFormat format, VkImageTiling tiling,
 			VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
 
 		void TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
+		void TransitionImageLayout(VkImage image, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+		//Linear filtered blits need format support, other formats are downsampled on the CPU
+		bool CanBlitMipmaps(VkFormat format) const;
+		//Blits every level from the one above it, leaves the whole image in shader read layout
+		void GenerateMipmaps();
+
+		struct RetiredImage
+		{
+			VkImage image{};
+			VkImageView imageView{};
+			VkDeviceMemory imageMemory{};
+			uint64_t frame{};
+		};
 
 		int m_TexWidth{};
 		int m_TexHeight{};
-		int m_MipmapCount{};
+		uint32_t m_MipmapCount{ 1 };
+
+		std::shared_ptr<const FHKtxFile> m_pKtxFile{};
+		uint32_t m_FirstResidentLevel{};
+		uint32_t m_TailLevel{};
+		uint32_t m_TopLevel{};
+		VkDeviceSize m_ResidentBytes{};
+		uint32_t m_ViewVersion{};
+		VkFormat m_Format{};
+		bool m_IsEvicted{};
+		std::vector<RetiredImage> m_RetiredImages{};
 
 		VkSampler m_TextureSampler{};
+		bool m_OwnsSampler{};
 		VkImageView m_TextureImageView{};
 		VkImageLayout m_TextureImageLayout{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
@@ -0,0 +1,53 @@
+#include "textureEviction.h"
+#include "mipResidency.h"
+
+VkDeviceSize FH::FHTextureEviction::GetReloadBytes(std::span<const Texture> textures, uint64_t frame)
+{
+	VkDeviceSize bytes{};
+	for (const Texture& texture : textures)
+		if (texture.isEvicted && texture.drawFrame == frame)
+			bytes += texture.fullBytes - texture.tailBytes;
+	return bytes;
+}
+
+std::vector<size_t> FH::FHTextureEviction::SelectEvictions(std::span<const Texture> textures, uint64_t frame,
+	VkDeviceSize residentBytes, VkDeviceSize neededBytes, VkDeviceSize budget)
+{
+	//Dropping to the tail is the surplus of a texture that needs none of its larger levels
+	std::vector<FHMipResidency::Surplus> surplus{};
+	std::vector<size_t> candidates{};
+	for (size_t textureIdx = 0; textureIdx < textures.size(); ++textureIdx)
+	{
+		const Texture& texture{ textures[textureIdx] };
+		if (texture.isEvicted || texture.drawFrame == frame || texture.fullBytes <= texture.tailBytes)
+			continue;
+
+		surplus.push_back({ texture.drawFrame, texture.fullBytes - texture.tailBytes });
+		candidates.push_back(textureIdx);
+	}
+
+	std::vector<size_t> evictions{};
+	for (size_t surplusIdx : FHMipResidency::SelectEvictions(surplus, residentBytes, neededBytes, budget))
+		evictions.push_back(candidates[surplusIdx]);
+	return evictions;
+}
+
+std::vector<size_t> FH::FHTextureEviction::SelectReloads(std::span<const Texture> textures, uint64_t frame,
+	VkDeviceSize residentBytes, VkDeviceSize budget)
+{
+	std::vector<size_t> reloads{};
+	for (size_t textureIdx = 0; textureIdx < textures.size(); ++textureIdx)
+	{
+		const Texture& texture{ textures[textureIdx] };
+		if (!texture.isEvicted || texture.drawFrame != frame)
+			continue;
+
+		const VkDeviceSize growth{ texture.fullBytes - texture.tailBytes };
+		if (residentBytes + growth > budget)
+			continue;
+
+		residentBytes += growth;
+		reloads.push_back(textureIdx);
+	}
+	return reloads;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FH
+{
+	//The runtime decisions of FHResidencyManager that need no device: which textures without a .ktx2 drop to their
+	//mip tail when the budget is exceeded, and which of the evicted ones are loaded at full size again
+	class FHTextureEviction final
+	{
+	public:
+		struct Texture
+		{
+			uint64_t drawFrame{};		//last frame the texture was drawn
+			VkDeviceSize fullBytes{};	//of the whole chain
+			VkDeviceSize tailBytes{};	//left once it dropped to its mip tail
+			bool isEvicted{};
+		};
+
+		//Bytes the evicted textures drawn in frame need to be reloaded
+		static VkDeviceSize GetReloadBytes(std::span<const Texture> textures, uint64_t frame);
+
+		//Indices into textures of the ones to evict, in order, until residentBytes + neededBytes fits the budget.
+		//Least recently drawn first, the largest first among textures drawn in the same frame. Textures drawn in
+		//frame stay
+		static std::vector<size_t> SelectEvictions(std::span<const Texture> textures, uint64_t frame,
+			VkDeviceSize residentBytes, VkDeviceSize neededBytes, VkDeviceSize budget);
+
+		//Indices of the evicted textures drawn in frame, in order, while their full chains fit the budget
+		static std::vector<size_t> SelectReloads(std::span<const Texture> textures, uint64_t frame,
+			VkDeviceSize residentBytes, VkDeviceSize budget);
+
+		FHTextureEviction() = delete;
+	};
+}
\ No newline at end of file
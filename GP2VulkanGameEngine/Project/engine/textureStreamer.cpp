@@ -0,0 +1,232 @@
+#include "textureStreamer.h"
+#include "swapchain.h"
+
+#include <algorithm>
+
+FH::FHTextureStreamer::FHTextureStreamer(const FHTextureStreamingSettings& settings)
+	: m_Settings{ settings }
+{
+	m_Worker = std::thread{ &FHTextureStreamer::Work, this };
+}
+
+FH::FHTextureStreamer::~FHTextureStreamer()
+{
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	m_Worker.join();
+}
+
+void FH::FHTextureStreamer::Register(const std::shared_ptr<FHTexture>& pTexture)
+{
+	if (!pTexture || !pTexture->IsStreamed())
+		return;
+
+	Entry& entry{ m_Entries[pTexture.get()] };
+	entry = Entry{ pTexture, pTexture->GetTailLevel() };
+}
+
+void FH::FHTextureStreamer::RequestSize(const FHTexture& texture, float screenSize)
+{
+	const auto it{ m_Entries.find(&texture) };
+	if (it == m_Entries.end())
+		return;
+
+	//Objects sharing the texture this frame get the largest level any of them needs
+	Entry& entry{ it->second };
+	const uint32_t requiredLevel{ GetRequiredLevel(texture, screenSize) };
+	entry.requiredLevel = entry.requestFrame == m_FrameCount ? std::min(entry.requiredLevel, requiredLevel) : requiredLevel;
+	entry.requestFrame = m_FrameCount;
+}
+
+bool FH::FHTextureStreamer::Update()
+{
+	bool isChanged{};
+
+	std::vector<std::shared_ptr<FHTexture>> textures{};
+	m_ResidentBytes = 0;
+	for (auto it{ m_Entries.begin() }; it != m_Entries.end();)
+	{
+		std::shared_ptr<FHTexture> pTexture{ it->second.pTexture.lock() };
+		if (!pTexture)
+		{
+			it = m_Entries.erase(it);
+			continue;
+		}
+
+		//Update runs once per frame, after MAX_FRAMES_IN_FLIGHT more frames the fences have covered the old views
+		if (m_FrameCount >= FHSwapChain::MAX_FRAMES_IN_FLIGHT)
+			pTexture->ReleaseRetired(m_FrameCount - FHSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		//Not drawn this frame, only the tail is needed
+		if (it->second.requestFrame != m_FrameCount)
+			it->second.requiredLevel = pTexture->GetTailLevel();
+
+		m_ResidentBytes += pTexture->GetResidentBytes();
+		textures.push_back(std::move(pTexture));
+		++it;
+	}
+
+	std::vector<Load> loads{};
+	{
+		const std::lock_guard lock{ m_Mutex };
+		while (!m_Loaded.empty() && loads.size() < m_Settings.maxUploadsPerFrame)
+		{
+			loads.push_back(std::move(m_Loaded.front()));
+			m_Loaded.pop_front();
+		}
+	}
+
+	for (Load& load : loads)
+	{
+		const auto it{ m_Entries.find(load.pTexture) };
+		if (it == m_Entries.end())
+			continue;
+		it->second.isPending = false;
+
+		//The texture may have been freed and another one made at the same address since the request, or it
+		//may no longer need the levels
+		const std::shared_ptr<FHTexture> pTexture{ it->second.pTexture.lock() };
+		if (!pTexture || pTexture->GetKtxFile() != load.pKtxFile || load.firstLevel >= pTexture->GetFirstResidentLevel() ||
+			load.firstLevel < it->second.requiredLevel)
+			continue;
+
+		m_ResidentBytes -= pTexture->GetResidentBytes();
+		pTexture->SetResidentLevels(load.firstLevel, GetLevelData(*load.pKtxFile, load.firstLevel, load.data.data()), m_FrameCount);
+		m_ResidentBytes += pTexture->GetResidentBytes();
+		isChanged = true;
+
+		if (it->second.isEvicted)
+		{
+			it->second.isEvicted = false;
+			++m_Stats.reloadCount;
+		}
+	}
+
+	//Bytes the textures needing larger levels would add
+	VkDeviceSize neededBytes{};
+	for (const std::shared_ptr<FHTexture>& pTexture : textures)
+	{
+		const Entry& entry{ m_Entries[pTexture.get()] };
+		if (!entry.isPending && entry.requiredLevel < pTexture->GetFirstResidentLevel())
+			neededBytes += GetLevelsSize(*pTexture->GetKtxFile(), entry.requiredLevel) - pTexture->GetResidentBytes();
+	}
+
+	//Over budget, drop the levels textures hold beyond what they need
+	if (m_ResidentBytes + neededBytes > m_Settings.memoryBudget)
+	{
+		std::vector<FHMipResidency::Surplus> surplus{};
+		std::vector<FHTexture*> surplusTextures{};
+		for (const std::shared_ptr<FHTexture>& pTexture : textures)
+		{
+			const Entry& entry{ m_Entries[pTexture.get()] };
+			if (pTexture->GetFirstResidentLevel() < entry.requiredLevel)
+			{
+				surplus.push_back({ entry.requestFrame, pTexture->GetResidentBytes() -
+					GetLevelsSize(*pTexture->GetKtxFile(), entry.requiredLevel) });
+				surplusTextures.push_back(pTexture.get());
+			}
+		}
+
+		for (size_t surplusIdx : FHMipResidency::SelectEvictions(surplus, m_ResidentBytes, neededBytes, m_Settings.memoryBudget))
+		{
+			FHTexture* pTexture{ surplusTextures[surplusIdx] };
+			Entry& entry{ m_Entries[pTexture] };
+			m_ResidentBytes -= surplus[surplusIdx].bytes;
+			pTexture->SetResidentLevels(entry.requiredLevel, GetLevelData(*pTexture->GetKtxFile(), entry.requiredLevel, nullptr), m_FrameCount);
+			entry.isEvicted = true;
+			++m_Stats.evictionCount;
+			isChanged = true;
+		}
+	}
+
+	//Request the larger levels textures need while they fit the budget
+	VkDeviceSize requestedBytes{};
+	{
+		const std::lock_guard lock{ m_Mutex };
+		for (const std::shared_ptr<FHTexture>& pTexture : textures)
+		{
+			Entry& entry{ m_Entries[pTexture.get()] };
+			if (entry.isPending || entry.requiredLevel >= pTexture->GetFirstResidentLevel())
+				continue;
+
+			const VkDeviceSize growth{ GetLevelsSize(*pTexture->GetKtxFile(), entry.requiredLevel) - pTexture->GetResidentBytes() };
+			if (m_ResidentBytes + requestedBytes + growth > m_Settings.memoryBudget)
+				continue;
+
+			requestedBytes += growth;
+			entry.isPending = true;
+			m_Requests.push_back(Load{ pTexture.get(), pTexture->GetKtxFile(), entry.requiredLevel });
+		}
+	}
+	if (requestedBytes > 0)
+		m_WorkAvailable.notify_one();
+
+	++m_FrameCount;
+	return isChanged;
+}
+
+uint32_t FH::FHTextureStreamer::GetRequiredLevel(const FHTexture& texture, float screenSize)
+{
+	//Levels above the top one were left out at load
+	const FHKtxFile& file{ *texture.GetKtxFile() };
+	return FHMipResidency::GetRequiredLevel(std::max(file.GetWidth(), file.GetHeight()), screenSize,
+		texture.GetTopLevel(), texture.GetTailLevel());
+}
+
+std::vector<std::span<const uint8_t>> FH::FHTextureStreamer::GetLevelData(const FHKtxFile& file, uint32_t firstLevel,
+	const uint8_t* pData)
+{
+	//Without loaded data the levels are read from the mapping, dropping levels only needs the small ones
+	std::vector<std::span<const uint8_t>> levelData{};
+	const std::span<const FHKtxFile::Level> levels{ file.GetLevels() };
+	for (uint32_t levelIdx = firstLevel; levelIdx < levels.size(); ++levelIdx)
+	{
+		if (!pData)
+		{
+			levelData.push_back(levels[levelIdx].data);
+			continue;
+		}
+
+		levelData.emplace_back(pData, levels[levelIdx].data.size());
+		pData += levels[levelIdx].data.size();
+	}
+	return levelData;
+}
+
+VkDeviceSize FH::FHTextureStreamer::GetLevelsSize(const FHKtxFile& file, uint32_t firstLevel)
+{
+	VkDeviceSize size{};
+	const std::span<const FHKtxFile::Level> levels{ file.GetLevels() };
+	for (uint32_t levelIdx = firstLevel; levelIdx < levels.size(); ++levelIdx)
+		size += levels[levelIdx].data.size();
+	return size;
+}
+
+void FH::FHTextureStreamer::Work()
+{
+	while (true)
+	{
+		Load load{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_WorkAvailable.wait(lock, [this]() { return m_IsStopping || !m_Requests.empty(); });
+			if (m_IsStopping)
+				return;
+
+			load = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		//Copying out of the mapping faults the levels in from disk here instead of on the render thread
+		const std::span<const FHKtxFile::Level> levels{ load.pKtxFile->GetLevels() };
+		load.data.reserve(GetLevelsSize(*load.pKtxFile, load.firstLevel));
+		for (uint32_t levelIdx = load.firstLevel; levelIdx < levels.size(); ++levelIdx)
+			load.data.insert(load.data.end(), levels[levelIdx].data.begin(), levels[levelIdx].data.end());
+
+		const std::lock_guard lock{ m_Mutex };
+		m_Loaded.push_back(std::move(load));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include "mipResidency.h"
+#include "texture.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace FH
+{
+	struct FHTextureStreamingSettings
+	{
+		VkDeviceSize memoryBudget{ 256ull << 20 };	//bytes of resident levels over every streamed texture
+		uint32_t maxUploadsPerFrame{ 2 };
+	};
+
+	//Streams the larger mips of textures made with Decoded::isStreamed. Textures start with their mip tail, every
+	//frame RequestSize tells which level the screen size needs and Update swaps in the textures whose levels a
+	//worker thread read from the mapped .ktx2. When the levels needed would not fit the memory budget, the
+	//textures drawn least recently drop the levels they do not need first.
+	class FHTextureStreamer final
+	{
+	public:
+		struct Stats
+		{
+			uint32_t evictionCount{};	//textures that dropped levels for the budget
+			uint32_t reloadCount{};		//evicted textures that streamed their levels back in
+		};
+
+		explicit FHTextureStreamer(const FHTextureStreamingSettings& settings = {});
+		~FHTextureStreamer();
+
+		FHTextureStreamer(const FHTextureStreamer&) = delete;
+		FHTextureStreamer& operator=(const FHTextureStreamer&) = delete;
+
+		void Register(const std::shared_ptr<FHTexture>& pTexture);
+
+		//The texture covers about screenSize pixels across this frame
+		void RequestSize(const FHTexture& texture, float screenSize);
+
+		//Call once per frame outside the render pass, after the requests of the frame.
+		//Returns true when an image view changed, descriptor sets holding the old one have to be rewritten
+		bool Update();
+
+		VkDeviceSize GetResidentBytes() const { return m_ResidentBytes; }
+		FHTextureStreamingSettings& GetSettings() { return m_Settings; }
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Entry
+		{
+			std::weak_ptr<FHTexture> pTexture{};
+			uint32_t requiredLevel{};
+			uint64_t requestFrame{};
+			bool isPending{};
+			bool isEvicted{};
+		};
+
+		//Levels [firstLevel, last] of the file, read by the worker
+		struct Load
+		{
+			const FHTexture* pTexture{};
+			std::shared_ptr<const FHKtxFile> pKtxFile{};
+			uint32_t firstLevel{};
+			std::vector<uint8_t> data{};
+		};
+
+		static uint32_t GetRequiredLevel(const FHTexture& texture, float screenSize);
+		static std::vector<std::span<const uint8_t>> GetLevelData(const FHKtxFile& file, uint32_t firstLevel, const uint8_t* pData);
+		static VkDeviceSize GetLevelsSize(const FHKtxFile& file, uint32_t firstLevel);
+
+		void Work();
+
+		FHTextureStreamingSettings m_Settings;
+		std::unordered_map<const FHTexture*, Entry> m_Entries{};
+		VkDeviceSize m_ResidentBytes{};
+		uint64_t m_FrameCount{};
+		Stats m_Stats{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WorkAvailable{};
+		std::deque<Load> m_Requests{};
+		std::deque<Load> m_Loaded{};
+		bool m_IsStopping{};
+		std::thread m_Worker{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "textureTiers.h"
+
+#include <algorithm>
+
+VkDeviceSize FH::FHTextureTiers::GetBytes(std::span<const TextureSize> catalogue, uint32_t maxSize)
+{
+	VkDeviceSize bytes{};
+	for (const TextureSize& texture : catalogue)
+	{
+		VkDeviceSize textureBytes{ texture.bytes };
+		for (uint32_t size = texture.size; size > maxSize; size /= 2)
+			textureBytes /= 4;
+		bytes += textureBytes;
+	}
+	return bytes;
+}
+
+uint32_t FH::FHTextureTiers::SelectMaxSize(std::span<const TextureSize> catalogue, VkDeviceSize available, uint32_t minSize)
+{
+	uint32_t maxSize{};
+	for (const TextureSize& texture : catalogue)
+		maxSize = std::max(maxSize, texture.size);
+	if (GetBytes(catalogue, maxSize) <= available)
+		return UINT32_MAX;
+
+	while (maxSize > minSize && GetBytes(catalogue, maxSize) > available)
+		maxSize /= 2;
+	return std::max(maxSize, minSize);
+}
\ No newline at end of file
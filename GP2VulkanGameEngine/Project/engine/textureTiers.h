@@ -0,0 +1,29 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+
+namespace FH
+{
+	//The load time size tiers of FHResidencyManager. Textures larger than the tier are loaded halved down to it,
+	//the tier is halved until the whole catalogue fits the memory it is given
+	class FHTextureTiers final
+	{
+	public:
+		//Width or height, whichever is larger, and bytes of a texture at full size
+		struct TextureSize
+		{
+			uint32_t size{};
+			VkDeviceSize bytes{};
+		};
+
+		//Bytes of the catalogue with every texture larger than maxSize halved until it is not, each halving quarters them
+		static VkDeviceSize GetBytes(std::span<const TextureSize> catalogue, uint32_t maxSize);
+
+		//UINT32_MAX when the catalogue fits at full size. Never goes below minSize, the catalogue may still not fit there
+		static uint32_t SelectMaxSize(std::span<const TextureSize> catalogue, VkDeviceSize available, uint32_t minSize);
+
+		FHTextureTiers() = delete;
+	};
+}
\ No newline at end of file
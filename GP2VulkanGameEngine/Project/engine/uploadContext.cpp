@@ -0,0 +1,201 @@
+#include "uploadContext.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	//Image decoders and the CPU mip downsample read back what they wrote to the staging memory, which is slow
+	//from uncached memory. Cached and coherent memory is on nearly every device, plain coherent is the fallback
+	std::unique_ptr<FH::FHBuffer> CreateStagingBuffer(FH::FHDevice& device, VkDeviceSize size)
+	{
+		VkPhysicalDeviceMemoryProperties memProperties{};
+		vkGetPhysicalDeviceMemoryProperties(device.GetPhysicalDevice(), &memProperties);
+
+		const VkMemoryPropertyFlags cachedProperties{
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT };
+		VkMemoryPropertyFlags properties{ VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+		for (uint32_t typeIdx = 0; typeIdx < memProperties.memoryTypeCount; ++typeIdx)
+			if ((memProperties.memoryTypes[typeIdx].propertyFlags & cachedProperties) == cachedProperties)
+				properties = cachedProperties;
+
+		auto pBuffer{ std::make_unique<FH::FHBuffer>(device, 1, static_cast<uint32_t>(size), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			properties) };
+		pBuffer->Map();
+		return pBuffer;
+	}
+}
+
+FH::FHUploadContext::FHUploadContext(FHDevice& device, VkDeviceSize ringSize)
+	: m_FHDevice{ device }
+	, m_SegmentSize{ ringSize / SEGMENT_COUNT }
+{
+	m_pRingBuffer = CreateStagingBuffer(m_FHDevice, ringSize);
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = m_FHDevice.FindPhysicalQueueFamilies().graphicsFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	if (vkCreateCommandPool(m_FHDevice.GetDevice(), &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create upload command pool!");
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = m_CommandPool;
+	allocInfo.commandBufferCount = 1;
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	for (Segment& segment : m_Segments)
+	{
+		if (vkAllocateCommandBuffers(m_FHDevice.GetDevice(), &allocInfo, &segment.commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate upload command buffer!");
+		if (vkCreateFence(m_FHDevice.GetDevice(), &fenceInfo, nullptr, &segment.fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to create upload fence!");
+	}
+}
+
+FH::FHUploadContext::~FHUploadContext()
+{
+	WaitIdle();
+
+	for (Segment& segment : m_Segments)
+		vkDestroyFence(m_FHDevice.GetDevice(), segment.fence, nullptr);
+	vkDestroyCommandPool(m_FHDevice.GetDevice(), m_CommandPool, nullptr);
+}
+
+FH::FHUploadContext::Staging FH::FHUploadContext::Stage(VkDeviceSize size, VkDeviceSize alignment)
+{
+	m_Stats.stagedBytes += size;
+
+	if (size > m_SegmentSize)
+	{
+		Segment& segment{ m_Segments[m_CurrentSegment] };
+		Begin(segment);
+
+		std::unique_ptr<FHBuffer> pBuffer{ CreateStagingBuffer(m_FHDevice, size) };
+
+		const Staging staging{ static_cast<uint8_t*>(pBuffer->GetMappedMemory()), pBuffer->GetBuffer(), 0 };
+		segment.dedicatedBuffers.push_back(std::move(pBuffer));
+		return staging;
+	}
+
+	Begin(m_Segments[m_CurrentSegment]);
+	VkDeviceSize offset{ (m_Segments[m_CurrentSegment].used + alignment - 1) / alignment * alignment };
+	if (offset + size > m_SegmentSize)
+	{
+		Flush();
+		Begin(m_Segments[m_CurrentSegment]);
+		offset = 0;
+	}
+
+	Segment& segment{ m_Segments[m_CurrentSegment] };
+	segment.used = offset + size;
+
+	const VkDeviceSize ringOffset{ m_CurrentSegment * m_SegmentSize + offset };
+	return Staging{ static_cast<uint8_t*>(m_pRingBuffer->GetMappedMemory()) + ringOffset, m_pRingBuffer->GetBuffer(), ringOffset };
+}
+
+void FH::FHUploadContext::CopyToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+{
+	const Staging staging{ Stage(size) };
+	std::memcpy(staging.pData, pData, size);
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = staging.offset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(GetCommandBuffer(), staging.buffer, dstBuffer, 1, &copyRegion);
+}
+
+void FH::FHUploadContext::CopyToImage(const Staging& staging, VkImage image, std::span<const VkBufferImageCopy> regions)
+{
+	std::vector<VkBufferImageCopy> stagedRegions{ regions.begin(), regions.end() };
+	for (VkBufferImageCopy& region : stagedRegions)
+		region.bufferOffset += staging.offset;
+
+	vkCmdCopyBufferToImage(GetCommandBuffer(), staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(stagedRegions.size()), stagedRegions.data());
+}
+
+VkCommandBuffer FH::FHUploadContext::GetCommandBuffer()
+{
+	Segment& segment{ m_Segments[m_CurrentSegment] };
+	Begin(segment);
+	return segment.commandBuffer;
+}
+
+void FH::FHUploadContext::Flush()
+{
+	Segment& segment{ m_Segments[m_CurrentSegment] };
+	if (!segment.isRecording)
+		return;
+
+	//Buffer copies are made visible to every later read, images got their own barriers
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+	vkCmdPipelineBarrier(segment.commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+
+	if (vkEndCommandBuffer(segment.commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to record upload command buffer!");
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &segment.commandBuffer;
+
+	if (vkQueueSubmit(m_FHDevice.GetGraphicsQueue(), 1, &submitInfo, segment.fence) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit upload command buffer!");
+
+	segment.isRecording = false;
+	segment.isSubmitted = true;
+	++m_Stats.submitCount;
+
+	m_CurrentSegment = (m_CurrentSegment + 1) % SEGMENT_COUNT;
+}
+
+void FH::FHUploadContext::WaitIdle()
+{
+	Flush();
+	for (Segment& segment : m_Segments)
+		Wait(segment);
+}
+
+void FH::FHUploadContext::Begin(Segment& segment)
+{
+	if (segment.isRecording)
+		return;
+
+	//The segment's memory and command buffer are free once its last batch has finished
+	Wait(segment);
+	segment.used = 0;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(segment.commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin upload command buffer!");
+	segment.isRecording = true;
+}
+
+void FH::FHUploadContext::Wait(Segment& segment)
+{
+	if (!segment.isSubmitted)
+		return;
+
+	vkWaitForFences(m_FHDevice.GetDevice(), 1, &segment.fence, VK_TRUE, UINT64_MAX);
+	vkResetFences(m_FHDevice.GetDevice(), 1, &segment.fence);
+	segment.dedicatedBuffers.clear();
+	segment.isSubmitted = false;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "buffer.h"
+#include "device.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace FH
+{
+	//Records staging copies and layout transitions into one command buffer and submits them in batches with a
+	//fence, instead of a queue submit and wait per copy. Staging memory comes from a persistent ring split in
+	//segments, a full segment is submitted and the next one is reused once its previous batch has finished.
+	//Batches go to the graphics queue before any later submit, so the frame that follows sees the results
+	class FHUploadContext final
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_RING_SIZE{ 64ull << 20 };
+		static constexpr uint32_t SEGMENT_COUNT{ 2 };
+
+		//Mapped staging memory of the batch being recorded
+		struct Staging
+		{
+			uint8_t* pData{};
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			VkDeviceSize offset{};
+		};
+
+		struct Stats
+		{
+			uint32_t submitCount{};
+			VkDeviceSize stagedBytes{};
+		};
+
+		explicit FHUploadContext(FHDevice& device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+		~FHUploadContext();
+
+		FHUploadContext(const FHUploadContext&) = delete;
+		FHUploadContext& operator=(const FHUploadContext&) = delete;
+
+		//Can submit the current batch, so stage before recording the commands that read from it.
+		//Uploads larger than a segment get a buffer of their own
+		Staging Stage(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+		void CopyToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+		//Region buffer offsets are relative to the staging memory, the image has to be in transfer dst layout
+		void CopyToImage(const Staging& staging, VkImage image, std::span<const VkBufferImageCopy> regions);
+
+		//For commands of the batch that have no helper, like transitions and blits
+		VkCommandBuffer GetCommandBuffer();
+
+		//Submits the recorded batch without waiting for it
+		void Flush();
+		//Submits the recorded batch and waits for every batch in flight
+		void WaitIdle();
+
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Segment
+		{
+			VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+			VkFence fence{ VK_NULL_HANDLE };
+			VkDeviceSize used{};
+			bool isRecording{};
+			bool isSubmitted{};
+			std::vector<std::unique_ptr<FHBuffer>> dedicatedBuffers{};
+		};
+
+		void Begin(Segment& segment);
+		void Wait(Segment& segment);
+
+		FHDevice& m_FHDevice;
+		VkDeviceSize m_SegmentSize;
+
+		std::unique_ptr<FHBuffer> m_pRingBuffer{};
+		VkCommandPool m_CommandPool{ VK_NULL_HANDLE };
+		std::array<Segment, SEGMENT_COUNT> m_Segments{};
+		uint32_t m_CurrentSegment{};
+
+		Stats m_Stats{};
+	};
+}
\ No newline at end of file
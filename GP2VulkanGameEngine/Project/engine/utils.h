@@ -1,6 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <functional>
+#include <thread>
+#include <vector>
 
 namespace FH {
 	template <typename T, typename... Rest>
@@ -8,4 +14,61 @@ namespace FH {
 		seed ^= std::hash<T>{}(v)+0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(HashCombine(seed, rest), ...);
 	};
+
+	//64 bit FNV-1a over a block of memory, stable between runs so it can be stored on disk
+	inline uint64_t HashBytes(const void* data, std::size_t size, uint64_t seed = 0xcbf29ce484222325ull) {
+		const uint8_t* pBytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= pBytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	};
+
+	//Splits [0, count) in contiguous ranges of at least minRangeSize and calls func(begin, end)
+	//for each range on its own thread. The calling thread takes the first range. Every range runs
+	//to the end, then the first exception thrown by any of them is rethrown on the calling thread.
+	template <typename Func>
+	void ParallelFor(std::size_t count, std::size_t minRangeSize, Func&& func) {
+		const std::size_t maxThreads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		const std::size_t threadCount = std::clamp<std::size_t>(
+			count / std::max<std::size_t>(minRangeSize, 1), 1, maxThreads);
+
+		if (threadCount == 1)
+		{
+			if (count > 0)
+				func(std::size_t{ 0 }, count);
+			return;
+		}
+
+		const std::size_t rangeSize = (count + threadCount - 1) / threadCount;
+		std::vector<std::exception_ptr> exceptions(threadCount);
+		auto runRange = [&func, &exceptions](std::size_t rangeIdx, std::size_t begin, std::size_t end)
+		{
+			try
+			{
+				func(begin, end);
+			}
+			catch (...)
+			{
+				exceptions[rangeIdx] = std::current_exception();
+			}
+		};
+
+		{
+			//jthread joins on destruction, also when starting one of them throws
+			std::vector<std::jthread> threads{};
+			threads.reserve(threadCount - 1);
+			for (std::size_t begin = rangeSize, rangeIdx = 1; begin < count; begin += rangeSize, ++rangeIdx)
+				threads.emplace_back(runRange, rangeIdx, begin, std::min(count, begin + rangeSize));
+
+			runRange(0, std::size_t{ 0 }, std::min(count, rangeSize));
+		}
+
+		for (const std::exception_ptr& exception : exceptions)
+			if (exception)
+				std::rethrow_exception(exception);
+	};
 }
\ No newline at end of file
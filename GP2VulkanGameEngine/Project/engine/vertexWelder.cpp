@@ -0,0 +1,108 @@
+#include "vertexWelder.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FH_WELDER_SSE2
+#include <emmintrin.h>
+#endif
+
+FH::FHVertexWelder::FHVertexWelder(size_t expectedCount)
+{
+	//At most half full when every corner turns out to be unique
+	const size_t slotCount{ std::bit_ceil(std::max<size_t>(expectedCount * 2, 16)) };
+	m_Slots.resize(slotCount);
+	m_Mask = slotCount - 1;
+	m_Keys.reserve(expectedCount / 2);
+}
+
+uint32_t FH::FHVertexWelder::Weld(const glm::vec3& pos, const glm::vec3& normal, const glm::vec2& uv)
+{
+	//Adding +0 turns -0 into +0 so both end up on the same bits, every other value is unchanged
+	const Key key{ {
+		pos.x + 0.f, pos.y + 0.f, pos.z + 0.f,
+		normal.x + 0.f, normal.y + 0.f, normal.z + 0.f,
+		uv.x + 0.f, uv.y + 0.f
+	} };
+
+	const uint64_t hash{ HashKey(key) };
+	const uint32_t shortHash{ static_cast<uint32_t>(hash >> 32) };
+
+	size_t slotIdx{ static_cast<size_t>(hash) & m_Mask };
+	while (true)
+	{
+		Slot& slot{ m_Slots[slotIdx] };
+		if (slot.index == EMPTY_SLOT)
+			break;
+
+		if (slot.hash == shortHash && KeysEqual(m_Keys[slot.index], key))
+			return slot.index;
+
+		slotIdx = (slotIdx + 1) & m_Mask;
+	}
+
+	const uint32_t newIndex{ static_cast<uint32_t>(m_Keys.size()) };
+	m_Keys.push_back(key);
+	m_Slots[slotIdx] = { shortHash, newIndex };
+
+	if (m_Keys.size() * 2 > m_Slots.size())
+		Grow();
+
+	return newIndex;
+}
+
+uint64_t FH::FHVertexWelder::HashKey(const Key& key)
+{
+	uint64_t words[4];
+	std::memcpy(words, key.values, sizeof(words));
+
+	//One multiply-rotate round per 8 bytes, finalised with a murmur style avalanche
+	uint64_t hash{ 0x9E3779B97F4A7C15ull };
+	for (uint64_t word : words)
+	{
+		hash ^= word * 0xBF58476D1CE4E5B9ull;
+		hash = std::rotl(hash, 31) * 0x94D049BB133111EBull;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+bool FH::FHVertexWelder::KeysEqual(const Key& lhs, const Key& rhs)
+{
+#ifdef FH_WELDER_SSE2
+	//Position, normal and uv in two 16 byte compares
+	const __m128i lhsLow{ _mm_load_si128(reinterpret_cast<const __m128i*>(lhs.values)) };
+	const __m128i lhsHigh{ _mm_load_si128(reinterpret_cast<const __m128i*>(lhs.values + 4)) };
+	const __m128i rhsLow{ _mm_load_si128(reinterpret_cast<const __m128i*>(rhs.values)) };
+	const __m128i rhsHigh{ _mm_load_si128(reinterpret_cast<const __m128i*>(rhs.values + 4)) };
+
+	const __m128i equal{ _mm_and_si128(_mm_cmpeq_epi32(lhsLow, rhsLow), _mm_cmpeq_epi32(lhsHigh, rhsHigh)) };
+	return _mm_movemask_epi8(equal) == 0xFFFF;
+#else
+	return std::memcmp(lhs.values, rhs.values, sizeof(lhs.values)) == 0;
+#endif
+}
+
+void FH::FHVertexWelder::Grow()
+{
+	std::vector<Slot> slots(m_Slots.size() * 2);
+	const size_t mask{ slots.size() - 1 };
+
+	for (const Slot& slot : m_Slots)
+	{
+		if (slot.index == EMPTY_SLOT)
+			continue;
+
+		size_t slotIdx{ static_cast<size_t>(HashKey(m_Keys[slot.index])) & mask };
+		while (slots[slotIdx].index != EMPTY_SLOT)
+			slotIdx = (slotIdx + 1) & mask;
+		slots[slotIdx] = slot;
+	}
+
+	m_Slots = std::move(slots);
+	m_Mask = mask;
+}
\ No newline at end of file
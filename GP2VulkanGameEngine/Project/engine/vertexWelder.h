@@ -0,0 +1,53 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace FH
+{
+	//Open addressing hash table that maps (position, normal, uv) to a unique vertex index.
+	//Keys are compared on their raw bits, -0.0 is folded onto +0.0 before hashing.
+	class FHVertexWelder final
+	{
+	public:
+		//expectedCount is the number of Weld calls you expect (the index count), the table
+		//is sized once so it never has to grow while welding a single mesh
+		explicit FHVertexWelder(size_t expectedCount);
+		~FHVertexWelder() = default;
+
+		FHVertexWelder(const FHVertexWelder&) = delete;
+		FHVertexWelder& operator=(const FHVertexWelder&) = delete;
+
+		//Returns the index of the matching vertex. A new vertex gets index GetVertexCount() - 1
+		uint32_t Weld(const glm::vec3& pos, const glm::vec3& normal, const glm::vec2& uv);
+
+		uint32_t GetVertexCount() const { return static_cast<uint32_t>(m_Keys.size()); }
+
+	private:
+		struct alignas(16) Key
+		{
+			float values[8];
+		};
+
+		struct Slot
+		{
+			uint32_t hash{};
+			uint32_t index{ EMPTY_SLOT };
+		};
+
+		static constexpr uint32_t EMPTY_SLOT{ UINT32_MAX };
+
+		static uint64_t HashKey(const Key& key);
+		static bool KeysEqual(const Key& lhs, const Key& rhs);
+
+		void Grow();
+
+		std::vector<Slot> m_Slots;
+		std::vector<Key> m_Keys;
+		size_t m_Mask{};
+	};
+}
\ No newline at end of file
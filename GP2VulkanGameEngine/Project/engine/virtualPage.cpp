@@ -0,0 +1,27 @@
+#include "virtualPage.h"
+
+#include <cstring>
+
+void FH::FHVirtualPage::Copy(const FHKtxFile& file, uint32_t levelIdx, uint32_t x, uint32_t y, std::vector<uint8_t>& data)
+{
+	const FHKtxFile::Level& level{ file.GetLevels()[levelIdx] };
+	const uint32_t blockSize{ FHKtxFile::GetBlockSize(file.GetFormat()) };
+	const uint32_t levelBlocksX{ (level.width + 3) / 4 };
+	const uint32_t levelBlocksY{ (level.height + 3) / 4 };
+
+	constexpr uint32_t slotBlocks{ SLOT_SIZE / 4 };
+	constexpr uint32_t pageBlocks{ PAGE_SIZE / 4 };
+	constexpr uint32_t borderBlocks{ PAGE_BORDER / 4 };
+
+	data.resize(static_cast<size_t>(slotBlocks) * slotBlocks * blockSize);
+	for (uint32_t blockY = 0; blockY < slotBlocks; ++blockY)
+	{
+		const uint32_t sourceY{ (y * pageBlocks + levelBlocksY + blockY - borderBlocks) % levelBlocksY };
+		for (uint32_t blockX = 0; blockX < slotBlocks; ++blockX)
+		{
+			const uint32_t sourceX{ (x * pageBlocks + levelBlocksX + blockX - borderBlocks) % levelBlocksX };
+			std::memcpy(data.data() + (static_cast<size_t>(blockY) * slotBlocks + blockX) * blockSize,
+				level.data.data() + (static_cast<size_t>(sourceY) * levelBlocksX + sourceX) * blockSize, blockSize);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include "ktxFile.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace FH
+{
+	//The blocks of one virtual texture page and its border, as FHVirtualTextureCache uploads them into an atlas slot.
+	//Only needs the mapped .ktx2, not the device
+	class FHVirtualPage final
+	{
+	public:
+		static constexpr uint32_t PAGE_SIZE{ 128 };
+		//One block of texels around every page, enough for bilinear filtering across the page edge
+		static constexpr uint32_t PAGE_BORDER{ 4 };
+		static constexpr uint32_t SLOT_SIZE{ PAGE_SIZE + 2 * PAGE_BORDER };
+
+		//Page x, y of the level, SLOT_SIZE / 4 rows of blocks. The border wraps around the edges of the level
+		//like the repeat addressing of the other textures
+		static void Copy(const FHKtxFile& file, uint32_t level, uint32_t x, uint32_t y, std::vector<uint8_t>& data);
+
+		FHVirtualPage() = delete;
+	};
+}
\ No newline at end of file
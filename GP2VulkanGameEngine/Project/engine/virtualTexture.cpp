@@ -0,0 +1,576 @@
+#include "virtualTexture.h"
+#include "swapchain.h"
+#include "uploadContext.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	constexpr VkFormat PAGE_TABLE_FORMAT{ VK_FORMAT_R8G8B8A8_UINT };
+	//Alpha of the page table entry for objects without a virtual texture
+	constexpr uint32_t NULL_PAGE_ENTRY{ 0xFF000000u };
+
+	void CreateImage(FH::FHDevice& device, VkFormat format, uint32_t width, uint32_t height, uint32_t levelCount,
+		VkImage& image, VkDeviceMemory& imageMemory, VkImageView& imageView)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = width;
+		imageInfo.extent.height = height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+		imageView = FH::FHSwapChain::CreateImageView(device, image, format, levelCount);
+	}
+
+	void TransitionImage(VkCommandBuffer commandBuffer, VkImage image, uint32_t levelCount,
+		VkImageLayout oldLayout, VkImageLayout newLayout)
+	{
+		auto getAccess = [](VkImageLayout layout, VkAccessFlags& access, VkPipelineStageFlags& stage)
+			{
+				switch (layout)
+				{
+				case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+					access = VK_ACCESS_TRANSFER_WRITE_BIT;
+					stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+					break;
+				case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+					access = VK_ACCESS_SHADER_READ_BIT;
+					stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+					break;
+				default:
+					access = 0;
+					stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+					break;
+				}
+			};
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = levelCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		VkPipelineStageFlags sourceStage{};
+		VkPipelineStageFlags destinationStage{};
+		getAccess(oldLayout, barrier.srcAccessMask, sourceStage);
+		getAccess(newLayout, barrier.dstAccessMask, destinationStage);
+
+		vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	//Entries hold every level one after the other, the regions say where each of them goes
+	void UploadPageTable(FH::FHDevice& device, VkImage pageTable, bool isWritten, uint32_t levelCount,
+		std::span<const uint32_t> entries, std::span<const VkBufferImageCopy> regions)
+	{
+		FH::FHUploadContext& uploads{ device.GetUploadContext() };
+		const FH::FHUploadContext::Staging staging{ uploads.Stage(entries.size_bytes()) };
+		std::memcpy(staging.pData, entries.data(), entries.size_bytes());
+
+		//Earlier frames sampling the old entries are done before the copy, the queue runs the barrier after them
+		TransitionImage(uploads.GetCommandBuffer(), pageTable, levelCount,
+			isWritten ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		uploads.CopyToImage(staging, pageTable, regions);
+		TransitionImage(uploads.GetCommandBuffer(), pageTable, levelCount,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	VkBufferImageCopy GetRegion(VkDeviceSize bufferOffset, uint32_t level, VkOffset3D offset, VkExtent3D extent)
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset = bufferOffset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = offset;
+		region.imageExtent = extent;
+		return region;
+	}
+}
+
+FH::FHVirtualTexture::FHVirtualTexture(FHDevice& device, std::shared_ptr<const FHKtxFile> pKtxFile, uint32_t pageSize)
+	: m_pKtxFile{ std::move(pKtxFile) }
+	, m_FHDevice{ device }
+{
+	m_PagesX = m_pKtxFile->GetWidth() / pageSize;
+	m_PagesY = m_pKtxFile->GetHeight() / pageSize;
+
+	const uint32_t levelCount{ static_cast<uint32_t>(std::bit_width(std::min(m_PagesX, m_PagesY))) };
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		m_LevelOffsets.push_back(m_PageCount);
+		m_PageCount += GetPagesX(level) * GetPagesY(level);
+	}
+
+	CreateImage(m_FHDevice, PAGE_TABLE_FORMAT, m_PagesX, m_PagesY, levelCount, m_PageTable, m_PageTableMemory, m_PageTableView);
+
+	//Read back on the CPU, so one per frame in flight
+	for (int frameIdx{}; frameIdx < FHSwapChain::MAX_FRAMES_IN_FLIGHT; ++frameIdx)
+	{
+		auto pBuffer{ std::make_unique<FHBuffer>(m_FHDevice, sizeof(uint32_t), m_PageCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) };
+		pBuffer->Map();
+		std::memset(pBuffer->GetMappedMemory(), 0, pBuffer->GetBufferSize());
+		m_pFeedbackBuffers.push_back(std::move(pBuffer));
+	}
+}
+
+FH::FHVirtualTexture::~FHVirtualTexture()
+{
+	vkDestroyImageView(m_FHDevice.GetDevice(), m_PageTableView, nullptr);
+	vkDestroyImage(m_FHDevice.GetDevice(), m_PageTable, nullptr);
+	vkFreeMemory(m_FHDevice.GetDevice(), m_PageTableMemory, nullptr);
+}
+
+void FH::FHVirtualTexture::WritePageTable(std::span<const uint32_t> entries)
+{
+	std::vector<VkBufferImageCopy> regions{};
+	for (uint32_t level = 0; level < GetLevelCount(); ++level)
+		regions.push_back(GetRegion(m_LevelOffsets[level] * sizeof(uint32_t), level, { 0, 0, 0 },
+			{ GetPagesX(level), GetPagesY(level), 1 }));
+
+	UploadPageTable(m_FHDevice, m_PageTable, m_IsPageTableWritten, GetLevelCount(), entries, regions);
+	m_IsPageTableWritten = true;
+}
+
+std::span<uint32_t> FH::FHVirtualTexture::GetFeedback(int frameIdx) const
+{
+	return { static_cast<uint32_t*>(m_pFeedbackBuffers[frameIdx]->GetMappedMemory()), m_PageCount };
+}
+
+VkDescriptorBufferInfo FH::FHVirtualTexture::GetFeedbackInfo(int frameIdx) const
+{
+	return m_pFeedbackBuffers[frameIdx]->GetDescriptorInfo();
+}
+
+FH::FHVirtualTextureCache::FHVirtualTextureCache(FHDevice& device, VkFormat format, const FHVirtualTextureSettings& settings)
+	: m_FHDevice{ device }
+	, m_Format{ format }
+	, m_Settings{ settings }
+{
+	//Slot coordinates are stored in 8 bit channels
+	m_Settings.atlasSlotsPerSide = std::clamp(m_Settings.atlasSlotsPerSide, 1u, 255u);
+
+	VkFormatProperties formatProperties{};
+	vkGetPhysicalDeviceFormatProperties(m_FHDevice.GetPhysicalDevice(), m_Format, &formatProperties);
+	const VkFormatFeatureFlags features{ VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+	m_IsSupported = m_FHDevice.HasFragmentStores() && FHKtxFile::GetBlockSize(m_Format) != 0 &&
+		(formatProperties.optimalTilingFeatures & features) == features;
+
+	CreateAtlas();
+	CreateSamplers();
+
+	const VkBufferImageCopy region{ GetRegion(0, 0, { 0, 0, 0 }, { 1, 1, 1 }) };
+	CreateImage(m_FHDevice, PAGE_TABLE_FORMAT, 1, 1, 1, m_NullPageTable, m_NullPageTableMemory, m_NullPageTableView);
+	UploadPageTable(m_FHDevice, m_NullPageTable, false, 1, std::span{ &NULL_PAGE_ENTRY, 1 }, std::span{ &region, 1 });
+
+	//Never read, the shader skips the feedback without a virtual texture
+	m_pNullFeedbackBuffer = std::make_unique<FHBuffer>(m_FHDevice, sizeof(uint32_t), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	m_Worker = std::thread{ &FHVirtualTextureCache::Work, this };
+}
+
+FH::FHVirtualTextureCache::~FHVirtualTextureCache()
+{
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	m_Worker.join();
+
+	vkDestroySampler(m_FHDevice.GetDevice(), m_AtlasSampler, nullptr);
+	vkDestroySampler(m_FHDevice.GetDevice(), m_PageTableSampler, nullptr);
+
+	vkDestroyImageView(m_FHDevice.GetDevice(), m_AtlasView, nullptr);
+	vkDestroyImage(m_FHDevice.GetDevice(), m_Atlas, nullptr);
+	vkFreeMemory(m_FHDevice.GetDevice(), m_AtlasMemory, nullptr);
+
+	vkDestroyImageView(m_FHDevice.GetDevice(), m_NullPageTableView, nullptr);
+	vkDestroyImage(m_FHDevice.GetDevice(), m_NullPageTable, nullptr);
+	vkFreeMemory(m_FHDevice.GetDevice(), m_NullPageTableMemory, nullptr);
+}
+
+bool FH::FHVirtualTextureCache::CanVirtualize(const FHKtxFile& file) const
+{
+	const uint32_t width{ file.GetWidth() };
+	const uint32_t height{ file.GetHeight() };
+	if (!m_IsSupported || file.GetFormat() != m_Format || !std::has_single_bit(width) || !std::has_single_bit(height) ||
+		std::min(width, height) < std::max(m_Settings.minSize, PAGE_SIZE))
+		return false;
+
+	const uint32_t levelCount{ static_cast<uint32_t>(std::bit_width(std::min(width, height) / PAGE_SIZE)) };
+	return file.GetLevels().size() >= levelCount;
+}
+
+std::shared_ptr<FH::FHVirtualTexture> FH::FHVirtualTextureCache::Create(std::shared_ptr<const FHKtxFile> pKtxFile)
+{
+	ReleaseExpired();
+
+	auto pTexture{ std::make_shared<FHVirtualTexture>(m_FHDevice, pKtxFile, PAGE_SIZE) };
+	Entry& entry{ m_Entries[pTexture.get()] };
+	entry = Entry{ pTexture, std::vector<Page>(pTexture->GetPageCount()) };
+
+	//Every missing page falls back to the coarsest level in the end, it is loaded now and kept
+	const uint32_t level{ pTexture->GetLevelCount() - 1 };
+	std::vector<Load> loads{};
+	std::vector<PageUpload> uploads{};
+	for (uint32_t y = 0; y < pTexture->GetPagesY(level); ++y)
+		for (uint32_t x = 0; x < pTexture->GetPagesX(level); ++x)
+		{
+			Load& load{ loads.emplace_back(Load{ pTexture.get(), pKtxFile, pTexture->GetPageIndex(level, x, y), level, x, y }) };
+			FHVirtualPage::Copy(*load.pKtxFile, load.level, load.x, load.y, load.data);
+		}
+
+	for (const Load& load : loads)
+	{
+		const int32_t slot{ AllocateSlot() };
+		if (slot < 0)
+			throw std::runtime_error("failed to fit virtual texture in the atlas!");
+
+		m_Slots[slot] = Slot{ pTexture.get(), load.pageIdx, m_FrameCount, true };
+		entry.pages[load.pageIdx].slot = slot;
+		uploads.push_back({ slot, load.data });
+		++m_Stats.residentPages;
+	}
+
+	UploadPages(uploads);
+	WritePageTable(entry, *pTexture);
+	return pTexture;
+}
+
+void FH::FHVirtualTextureCache::Update(int frameIdx)
+{
+	++m_FrameCount;
+	ReleaseExpired();
+
+	struct Request
+	{
+		Entry* pEntry{};
+		const FHVirtualTexture* pTexture{};
+		uint32_t level{};
+		uint32_t x{};
+		uint32_t y{};
+	};
+
+	//Wanted pages mark their slot as used, missing ones are requested along with the missing coarser pages the
+	//shader falls back to in the meantime
+	std::vector<Request> requests{};
+	for (auto& [pKey, entry] : m_Entries)
+	{
+		const std::shared_ptr<FHVirtualTexture> pTexture{ entry.pTexture.lock() };
+		const std::span<uint32_t> feedback{ pTexture->GetFeedback(frameIdx) };
+		for (uint32_t level = 0; level < pTexture->GetLevelCount(); ++level)
+			for (uint32_t y = 0; y < pTexture->GetPagesY(level); ++y)
+				for (uint32_t x = 0; x < pTexture->GetPagesX(level); ++x)
+				{
+					uint32_t& isWanted{ feedback[pTexture->GetPageIndex(level, x, y)] };
+					if (!isWanted)
+						continue;
+					isWanted = 0;
+
+					for (uint32_t parentLevel = level; parentLevel < pTexture->GetLevelCount(); ++parentLevel)
+					{
+						const uint32_t parentX{ x >> (parentLevel - level) };
+						const uint32_t parentY{ y >> (parentLevel - level) };
+						Page& page{ entry.pages[pTexture->GetPageIndex(parentLevel, parentX, parentY)] };
+						if (page.slot >= 0)
+						{
+							m_Slots[page.slot].lastUsedFrame = m_FrameCount;
+							break;
+						}
+
+						if (!page.isPending)
+						{
+							page.isPending = true;
+							requests.push_back({ &entry, pTexture.get(), parentLevel, parentX, parentY });
+						}
+					}
+				}
+	}
+
+	std::vector<Load> loads{};
+	{
+		const std::lock_guard lock{ m_Mutex };
+		while (!m_Loaded.empty() && loads.size() < m_Settings.maxUploadsPerFrame)
+		{
+			loads.push_back(std::move(m_Loaded.front()));
+			m_Loaded.pop_front();
+		}
+	}
+
+	std::vector<PageUpload> uploads{};
+	for (const Load& load : loads)
+	{
+		//The texture may have been freed and another one made at the same address since the request
+		const auto it{ m_Entries.find(load.pTexture) };
+		if (it == m_Entries.end() || it->second.pTexture.lock()->GetKtxFile() != load.pKtxFile)
+			continue;
+
+		Entry& entry{ it->second };
+		Page& page{ entry.pages[load.pageIdx] };
+		page.isPending = false;
+		if (page.slot >= 0)
+			continue;
+
+		const int32_t slot{ AllocateSlot() };
+		if (slot < 0)
+			continue;
+
+		m_Slots[slot] = Slot{ load.pTexture, load.pageIdx, m_FrameCount, false };
+		page.slot = slot;
+		entry.isDirty = true;
+		uploads.push_back({ slot, load.data });
+		++m_Stats.residentPages;
+		++m_Stats.uploadCount;
+	}
+	UploadPages(uploads);
+
+	//Coarse pages first, they improve the most of the screen. Requests that do not fit the queue come back
+	//with the feedback of a later frame
+	std::stable_sort(requests.begin(), requests.end(), [](const Request& lhs, const Request& rhs) { return lhs.level > rhs.level; });
+	{
+		const std::lock_guard lock{ m_Mutex };
+		const size_t maxQueued{ static_cast<size_t>(m_Settings.maxUploadsPerFrame) * 4 };
+		for (const Request& request : requests)
+		{
+			const uint32_t pageIdx{ request.pTexture->GetPageIndex(request.level, request.x, request.y) };
+			if (m_Requests.size() >= maxQueued)
+			{
+				request.pEntry->pages[pageIdx].isPending = false;
+				continue;
+			}
+			m_Requests.push_back(Load{ request.pTexture, request.pTexture->GetKtxFile(), pageIdx, request.level, request.x, request.y });
+		}
+	}
+	if (!requests.empty())
+		m_WorkAvailable.notify_one();
+
+	for (auto& [pKey, entry] : m_Entries)
+		if (entry.isDirty)
+			WritePageTable(entry, *entry.pTexture.lock());
+}
+
+void FH::FHVirtualTextureCache::RecordFeedbackBarrier(VkCommandBuffer commandBuffer) const
+{
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+}
+
+VkDescriptorImageInfo FH::FHVirtualTextureCache::GetPageTableInfo(const FHVirtualTexture* pTexture) const
+{
+	return { m_PageTableSampler, pTexture ? pTexture->GetPageTableView() : m_NullPageTableView,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+}
+
+VkDescriptorImageInfo FH::FHVirtualTextureCache::GetAtlasInfo() const
+{
+	return { m_AtlasSampler, m_AtlasView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+}
+
+VkDescriptorBufferInfo FH::FHVirtualTextureCache::GetFeedbackInfo(const FHVirtualTexture* pTexture, int frameIdx) const
+{
+	return pTexture ? pTexture->GetFeedbackInfo(frameIdx) : m_pNullFeedbackBuffer->GetDescriptorInfo();
+}
+
+void FH::FHVirtualTextureCache::CreateAtlas()
+{
+	//Without format or fragment store support no texture is virtual, a small image keeps the descriptors valid
+	const uint32_t size{ m_IsSupported ? m_Settings.atlasSlotsPerSide * SLOT_SIZE : 4 };
+	CreateImage(m_FHDevice, m_IsSupported ? m_Format : VK_FORMAT_R8G8B8A8_UNORM, size, size, 1, m_Atlas, m_AtlasMemory, m_AtlasView);
+	TransitionImage(m_FHDevice.GetUploadContext().GetCommandBuffer(), m_Atlas, 1,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	if (!m_IsSupported)
+		return;
+
+	const uint32_t slotCount{ m_Settings.atlasSlotsPerSide * m_Settings.atlasSlotsPerSide };
+	m_Slots.resize(slotCount);
+	for (uint32_t slot = slotCount; slot-- > 0;)
+		m_FreeSlots.push_back(static_cast<int32_t>(slot));
+}
+
+void FH::FHVirtualTextureCache::CreateSamplers()
+{
+	//Pages are sampled inside their border, the atlas has no mips of its own
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.minLod = 0.f;
+	samplerInfo.maxLod = 0.f;
+
+	if (vkCreateSampler(m_FHDevice.GetDevice(), &samplerInfo, nullptr, &m_AtlasSampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create texture sampler!");
+
+	//Integer formats cannot be filtered, the shader fetches the entries anyway
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(m_FHDevice.GetDevice(), &samplerInfo, nullptr, &m_PageTableSampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create texture sampler!");
+}
+
+void FH::FHVirtualTextureCache::ReleaseExpired()
+{
+	std::erase_if(m_Entries, [this](const auto& keyEntry)
+		{
+			if (!keyEntry.second.pTexture.expired())
+				return false;
+
+			for (size_t slotIdx = 0; slotIdx < m_Slots.size(); ++slotIdx)
+				if (m_Slots[slotIdx].pOwner == keyEntry.first)
+				{
+					m_Slots[slotIdx] = Slot{};
+					m_FreeSlots.push_back(static_cast<int32_t>(slotIdx));
+					--m_Stats.residentPages;
+				}
+			return true;
+		});
+}
+
+int32_t FH::FHVirtualTextureCache::AllocateSlot()
+{
+	if (!m_FreeSlots.empty())
+	{
+		const int32_t slot{ m_FreeSlots.back() };
+		m_FreeSlots.pop_back();
+		return slot;
+	}
+
+	int32_t oldestSlot{ -1 };
+	for (size_t slotIdx = 0; slotIdx < m_Slots.size(); ++slotIdx)
+	{
+		const Slot& slot{ m_Slots[slotIdx] };
+		if (slot.isPinned || slot.lastUsedFrame >= m_FrameCount)
+			continue;
+		if (oldestSlot < 0 || slot.lastUsedFrame < m_Slots[oldestSlot].lastUsedFrame)
+			oldestSlot = static_cast<int32_t>(slotIdx);
+	}
+	if (oldestSlot < 0)
+		return -1;
+
+	//The page falls back to a coarser one until it is wanted and loaded again
+	Entry& owner{ m_Entries[m_Slots[oldestSlot].pOwner] };
+	owner.pages[m_Slots[oldestSlot].pageIdx].slot = -1;
+	owner.isDirty = true;
+	--m_Stats.residentPages;
+	++m_Stats.evictionCount;
+	return oldestSlot;
+}
+
+void FH::FHVirtualTextureCache::UploadPages(std::span<const PageUpload> uploads)
+{
+	if (uploads.empty())
+		return;
+
+	const VkDeviceSize slotBytes{ uploads.front().data.size() };
+	FHUploadContext& uploadContext{ m_FHDevice.GetUploadContext() };
+	const FHUploadContext::Staging staging{ uploadContext.Stage(slotBytes * uploads.size()) };
+
+	std::vector<VkBufferImageCopy> regions{};
+	for (const PageUpload& upload : uploads)
+	{
+		const VkDeviceSize offset{ slotBytes * regions.size() };
+		std::memcpy(staging.pData + offset, upload.data.data(), upload.data.size());
+
+		const uint32_t slotX{ static_cast<uint32_t>(upload.slot) % m_Settings.atlasSlotsPerSide };
+		const uint32_t slotY{ static_cast<uint32_t>(upload.slot) / m_Settings.atlasSlotsPerSide };
+		regions.push_back(GetRegion(offset, 0, { static_cast<int32_t>(slotX * SLOT_SIZE), static_cast<int32_t>(slotY * SLOT_SIZE), 0 },
+			{ SLOT_SIZE, SLOT_SIZE, 1 }));
+	}
+
+	//Evicted slots may still be sampled by frames submitted earlier, the barrier waits for them
+	TransitionImage(uploadContext.GetCommandBuffer(), m_Atlas, 1,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	uploadContext.CopyToImage(staging, m_Atlas, regions);
+	TransitionImage(uploadContext.GetCommandBuffer(), m_Atlas, 1,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+void FH::FHVirtualTextureCache::WritePageTable(Entry& entry, FHVirtualTexture& texture)
+{
+	//Coarsest level first, a missing page takes the entry of the page above it
+	std::vector<uint32_t> entries(texture.GetPageCount());
+	for (uint32_t level = texture.GetLevelCount(); level-- > 0;)
+		for (uint32_t y = 0; y < texture.GetPagesY(level); ++y)
+			for (uint32_t x = 0; x < texture.GetPagesX(level); ++x)
+			{
+				const uint32_t pageIdx{ texture.GetPageIndex(level, x, y) };
+				const int32_t slot{ entry.pages[pageIdx].slot };
+				if (slot < 0)
+				{
+					entries[pageIdx] = entries[texture.GetPageIndex(level + 1, x / 2, y / 2)];
+					continue;
+				}
+
+				const uint32_t slotX{ static_cast<uint32_t>(slot) % m_Settings.atlasSlotsPerSide };
+				const uint32_t slotY{ static_cast<uint32_t>(slot) / m_Settings.atlasSlotsPerSide };
+				entries[pageIdx] = slotX | slotY << 8 | level << 16;
+			}
+
+	texture.WritePageTable(entries);
+	entry.isDirty = false;
+}
+
+void FH::FHVirtualTextureCache::Work()
+{
+	while (true)
+	{
+		Load load{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_WorkAvailable.wait(lock, [this]() { return m_IsStopping || !m_Requests.empty(); });
+			if (m_IsStopping)
+				return;
+
+			load = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		//Reading the blocks faults the page in from disk here instead of on the render thread
+		FHVirtualPage::Copy(*load.pKtxFile, load.level, load.x, load.y, load.data);
+
+		const std::lock_guard lock{ m_Mutex };
+		m_Loaded.push_back(std::move(load));
+	}
+}
\ No newline at end of file
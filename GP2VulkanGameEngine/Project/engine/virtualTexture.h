@@ -0,0 +1,196 @@
+#pragma once
+#include "buffer.h"
+#include "device.h"
+#include "ktxFile.h"
+#include "virtualPage.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace FH
+{
+	//Page table and sampling feedback of one texture whose pages live in the atlas of an FHVirtualTextureCache.
+	//Pages are numbered level by level from the full size down, x first
+	class FHVirtualTexture final
+	{
+	public:
+		FHVirtualTexture(FHDevice& device, std::shared_ptr<const FHKtxFile> pKtxFile, uint32_t pageSize);
+		~FHVirtualTexture();
+
+		FHVirtualTexture(const FHVirtualTexture&) = delete;
+		FHVirtualTexture& operator=(const FHVirtualTexture&) = delete;
+
+		const std::shared_ptr<const FHKtxFile>& GetKtxFile() const { return m_pKtxFile; }
+		//Down to the level that is one page tall or wide
+		uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_LevelOffsets.size()); }
+		uint32_t GetPagesX(uint32_t level) const { return std::max(m_PagesX >> level, 1u); }
+		uint32_t GetPagesY(uint32_t level) const { return std::max(m_PagesY >> level, 1u); }
+		uint32_t GetPageIndex(uint32_t level, uint32_t x, uint32_t y) const { return m_LevelOffsets[level] + y * GetPagesX(level) + x; }
+		uint32_t GetPageCount() const { return m_PageCount; }
+
+		//One entry per page, R and G the atlas slot and B the level of the page sampled for it
+		void WritePageTable(std::span<const uint32_t> entries);
+		VkImageView GetPageTableView() const { return m_PageTableView; }
+
+		//Non zero for the pages the fragment shader wanted, read and cleared once the frame has finished
+		std::span<uint32_t> GetFeedback(int frameIdx) const;
+		VkDescriptorBufferInfo GetFeedbackInfo(int frameIdx) const;
+
+	private:
+		std::shared_ptr<const FHKtxFile> m_pKtxFile;
+		uint32_t m_PagesX{};
+		uint32_t m_PagesY{};
+		uint32_t m_PageCount{};
+		std::vector<uint32_t> m_LevelOffsets{};
+
+		VkImage m_PageTable{};
+		VkDeviceMemory m_PageTableMemory{};
+		VkImageView m_PageTableView{};
+		bool m_IsPageTableWritten{};
+
+		std::vector<std::unique_ptr<FHBuffer>> m_pFeedbackBuffers{};
+
+		FHDevice& m_FHDevice;
+	};
+
+	struct FHVirtualTextureSettings
+	{
+		uint32_t minSize{ 4096 };				//textures at least this wide and tall are virtual
+		uint32_t atlasSlotsPerSide{ 32 };		//32 by 32 pages in the atlas
+		uint32_t maxUploadsPerFrame{ 16 };
+	};
+
+	//Software virtual texturing for .ktx2 textures too large to keep resident, no sparse binding needed. Pages of
+	//PAGE_SIZE texels are copied with a border into the slots of one physical atlas, the page table of a texture
+	//tells the fragment shader which slot holds each page or the nearest coarser page that is resident. The
+	//shader writes the pages it wanted into a feedback buffer, Update reads it back a frame later, a worker
+	//thread copies the missing pages out of the mapped .ktx2 and the least recently wanted slots are reused.
+	//The coarsest level is loaded up front and never evicted, so every page table entry stays valid.
+	//Devices without fragmentStoresAndAtomics cannot write the feedback, no texture is virtual on them
+	class FHVirtualTextureCache final
+	{
+	public:
+		static constexpr uint32_t PAGE_SIZE{ FHVirtualPage::PAGE_SIZE };
+		static constexpr uint32_t PAGE_BORDER{ FHVirtualPage::PAGE_BORDER };
+		static constexpr uint32_t SLOT_SIZE{ FHVirtualPage::SLOT_SIZE };
+
+		struct Stats
+		{
+			uint32_t residentPages{};
+			uint32_t uploadCount{};
+			uint32_t evictionCount{};
+		};
+
+		//Pages are copied as stored, every texture of the cache has the format of the atlas
+		FHVirtualTextureCache(FHDevice& device, VkFormat format, const FHVirtualTextureSettings& settings = {});
+		~FHVirtualTextureCache();
+
+		FHVirtualTextureCache(const FHVirtualTextureCache&) = delete;
+		FHVirtualTextureCache& operator=(const FHVirtualTextureCache&) = delete;
+
+		//Atlas format, power of two size of at least the minimum and a full mip chain
+		bool CanVirtualize(const FHKtxFile& file) const;
+		std::shared_ptr<FHVirtualTexture> Create(std::shared_ptr<const FHKtxFile> pKtxFile);
+
+		//Call once per frame outside the render pass, after the fence of the frame was waited on
+		void Update(int frameIdx);
+		//Makes the feedback written in the frame visible to Update, record after the render pass
+		void RecordFeedbackBarrier(VkCommandBuffer commandBuffer) const;
+
+		//Objects without a virtual texture get a page table that tells the shader to skip it
+		VkDescriptorImageInfo GetPageTableInfo(const FHVirtualTexture* pTexture) const;
+		VkDescriptorImageInfo GetAtlasInfo() const;
+		VkDescriptorBufferInfo GetFeedbackInfo(const FHVirtualTexture* pTexture, int frameIdx) const;
+
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Page
+		{
+			int32_t slot{ -1 };
+			bool isPending{};
+		};
+
+		struct Entry
+		{
+			std::weak_ptr<FHVirtualTexture> pTexture{};
+			std::vector<Page> pages{};
+			bool isDirty{};
+		};
+
+		struct Slot
+		{
+			const FHVirtualTexture* pOwner{};
+			uint32_t pageIdx{};
+			uint64_t lastUsedFrame{};
+			bool isPinned{};
+		};
+
+		//A page with its border as the blocks of one slot, read by the worker
+		struct Load
+		{
+			const FHVirtualTexture* pTexture{};
+			std::shared_ptr<const FHKtxFile> pKtxFile{};
+			uint32_t pageIdx{};
+			uint32_t level{};
+			uint32_t x{};
+			uint32_t y{};
+			std::vector<uint8_t> data{};
+		};
+
+		struct PageUpload
+		{
+			int32_t slot{};
+			std::span<const uint8_t> data{};
+		};
+
+		void CreateAtlas();
+		void CreateSamplers();
+
+		//Frees the slots of textures that were destroyed
+		void ReleaseExpired();
+		//A free slot or the least recently used unpinned one, -1 when every slot was used this frame
+		int32_t AllocateSlot();
+		void UploadPages(std::span<const PageUpload> uploads);
+		void WritePageTable(Entry& entry, FHVirtualTexture& texture);
+
+		void Work();
+
+		FHDevice& m_FHDevice;
+		VkFormat m_Format;
+		FHVirtualTextureSettings m_Settings;
+		bool m_IsSupported{};
+
+		VkImage m_Atlas{};
+		VkDeviceMemory m_AtlasMemory{};
+		VkImageView m_AtlasView{};
+		VkSampler m_AtlasSampler{};
+		VkSampler m_PageTableSampler{};
+
+		VkImage m_NullPageTable{};
+		VkDeviceMemory m_NullPageTableMemory{};
+		VkImageView m_NullPageTableView{};
+		std::unique_ptr<FHBuffer> m_pNullFeedbackBuffer{};
+
+		std::unordered_map<const FHVirtualTexture*, Entry> m_Entries{};
+		std::vector<Slot> m_Slots{};
+		std::vector<int32_t> m_FreeSlots{};
+		uint64_t m_FrameCount{};
+		Stats m_Stats{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WorkAvailable{};
+		std::deque<Load> m_Requests{};
+		std::deque<Load> m_Loaded{};
+		bool m_IsStopping{};
+		std::thread m_Worker{};
+	};
+}
\ No newline at end of file
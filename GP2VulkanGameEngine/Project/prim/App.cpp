@@ -1,10 +1,13 @@
 #include "App.h"
 #include "engine/renderSystem.h"
 #include "engine/renderSystem2D.h"
+#include "engine/cullingSystem.h"
 #include "camera.h"
 #include "engine/FHTime.h"
 #include "engine/keyboardInput.h"
 #include "engine/frameInfo.h"
+#include "engine/staticBatcher.h"
+#include "engine/uploadContext.h"
 
 #include <glm/gtc/constants.hpp>
 
@@ -12,21 +15,29 @@
 #include <array>
 #include <numeric>
 #include <iostream>
+#include <filesystem>
 
 FH::FirstApp::FirstApp()
 {
     LoadGameObjects();
     LoadGameObjects2D();
 
+    const int objectCount{ static_cast<int>(m_Models.size() + m_StaticProps.size()) };
+
     m_pAppPool = FHDescriptorPool::Builder(m_FHDevice)
         //"." chaining (See descriptor pool builder declaration!!!)
         .SetMaxSets(FHSwapChain::MAX_FRAMES_IN_FLIGHT + 
-            FHSwapChain::MAX_FRAMES_IN_FLIGHT * static_cast<int>(m_Models.size()))
+            FHSwapChain::MAX_FRAMES_IN_FLIGHT * objectCount)
 
         .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, FHSwapChain::MAX_FRAMES_IN_FLIGHT)
 
+        //Diffuse, normal, ORM, virtual page table and atlas per object
         .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 
-            FHSwapChain::MAX_FRAMES_IN_FLIGHT * static_cast<int>(m_Models.size()))
+            5 * FHSwapChain::MAX_FRAMES_IN_FLIGHT * objectCount)
+
+        //Virtual texture feedback per object
+        .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 
+            FHSwapChain::MAX_FRAMES_IN_FLIGHT * objectCount)
 
         .SetPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
 
@@ -59,6 +70,7 @@ void FH::FirstApp::Run()
             .AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .AddBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .AddBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .Build()
     };
 
@@ -69,9 +81,54 @@ void FH::FirstApp::Run()
     };
 
 
-    const auto whitePlaceHolder{ std::make_unique<FHTexture>(m_FHDevice, "textures/placeholder/whitesquare.png") };
-    const auto blackPlaceHolder{ std::make_unique<FHTexture>(m_FHDevice, "textures/placeholder/blacksquare.png") };
-    const auto normalPlaceHolder{ std::make_unique<FHTexture>(m_FHDevice, "textures/placeholder/normalmap.png") };
+    const auto whitePlaceHolder{ m_Assets.GetTexture("textures/placeholder/whitesquare.png") };
+    const auto normalPlaceHolder{ m_Assets.GetTexture("textures/placeholder/normalmap.png", false) };
+    //Full occlusion, zero roughness and specular, what the separate placeholders gave
+    const auto ormPlaceHolder{ m_Assets.GetOrmTexture({}) };
+
+    FHVirtualTextureCache& virtualTextures{ m_Assets.GetVirtualTextureCache() };
+
+    //Streamed textures replace their image view as mips land, the sets are then overwritten in place
+    auto writeObjectSet = [&](FHGameObject& gameObject, int frameIdx, bool overwrite)
+        {
+            auto getImageInfo = [](const std::shared_ptr<FHTexture>& pTexture, const std::shared_ptr<FHTexture>& pPlaceHolder)
+                {
+                    const FHTexture& texture{ pTexture ? *pTexture : *pPlaceHolder };
+                    return VkDescriptorImageInfo{
+                        texture.GetTextureSampler(),
+                        texture.GetTextureImageView(),
+                        texture.GetTextureImageLayout() };
+                };
+
+            VkDescriptorImageInfo imageDiffuseInfo{ getImageInfo(gameObject.m_DiffuseTexture, whitePlaceHolder) };
+            VkDescriptorImageInfo imageNormalInfo{ getImageInfo(gameObject.m_NormalTexture, normalPlaceHolder) };
+            VkDescriptorImageInfo imageORMInfo{ getImageInfo(gameObject.m_ORMTexture, ormPlaceHolder) };
+
+            //Objects without a virtual diffuse map get a page table that tells the shader so
+            const FHVirtualTexture* pVirtualTexture{ gameObject.m_VirtualDiffuseTexture.get() };
+            VkDescriptorImageInfo pageTableInfo{ virtualTextures.GetPageTableInfo(pVirtualTexture) };
+            VkDescriptorImageInfo atlasInfo{ virtualTextures.GetAtlasInfo() };
+            VkDescriptorBufferInfo feedbackInfo{ virtualTextures.GetFeedbackInfo(pVirtualTexture, frameIdx) };
+
+            FHDescriptorWriter writer{ *objectSetLayout, *m_pAppPool };
+            writer.WriteImage(0, &imageDiffuseInfo)
+                .WriteImage(1, &imageNormalInfo)
+                .WriteImage(2, &imageORMInfo)
+                .WriteImage(3, &pageTableInfo)
+                .WriteImage(4, &atlasInfo)
+                .WriteBuffer(5, &feedbackInfo);
+
+            VkDescriptorSet descriptorSet{};
+            if (overwrite)
+            {
+                descriptorSet = gameObject.GetDescriptorSetAtFrame(frameIdx);
+                writer.Overwrite(descriptorSet);
+            }
+            else
+                writer.Build(descriptorSet);
+
+            gameObject.SetDescriptorSetAtFrame(frameIdx, descriptorSet);
+        };
 
     for (int i{}; i < FHSwapChain::MAX_FRAMES_IN_FLIGHT; ++i)
     {
@@ -90,80 +147,9 @@ void FH::FirstApp::Run()
             .Build(appDescriptorSets[i]);
 
         for (int meshIdx{}; meshIdx < static_cast<int>(m_Models.size()); ++meshIdx)
-        {
-            auto currentObj = m_Models[meshIdx].get();
-
-            VkDescriptorImageInfo imageDiffuseInfo{};
-            if (m_Models[meshIdx]->m_DiffuseTexture)
-                imageDiffuseInfo = {
-                    currentObj->m_DiffuseTexture->GetTextureSampler(),
-                    currentObj->m_DiffuseTexture->GetTextureImageView(),
-                    currentObj->m_DiffuseTexture->GetTextureImageLayout() };
-            else
-                imageDiffuseInfo = {
-                    whitePlaceHolder->GetTextureSampler(),
-                    whitePlaceHolder->GetTextureImageView(),
-                    whitePlaceHolder->GetTextureImageLayout() };
-
-            VkDescriptorImageInfo imageNormalInfo{};
-            if (m_Models[meshIdx]->m_NormalTexture)
-                imageNormalInfo = {
-                    currentObj->m_NormalTexture->GetTextureSampler(),
-                    currentObj->m_NormalTexture->GetTextureImageView(),
-                    currentObj->m_NormalTexture->GetTextureImageLayout() };
-            else
-                imageNormalInfo = {
-                    normalPlaceHolder->GetTextureSampler(),
-                    normalPlaceHolder->GetTextureImageView(),
-                    normalPlaceHolder->GetTextureImageLayout() };
-
-            VkDescriptorImageInfo imageRoughnessInfo{};
-            if (m_Models[meshIdx]->m_RoughnessTexture)
-                imageRoughnessInfo = {
-                    currentObj->m_RoughnessTexture->GetTextureSampler(),
-                    currentObj->m_RoughnessTexture->GetTextureImageView(),
-                    currentObj->m_RoughnessTexture->GetTextureImageLayout() };
-            else
-                imageRoughnessInfo = {
-                    blackPlaceHolder->GetTextureSampler(),
-                    blackPlaceHolder->GetTextureImageView(),
-                    blackPlaceHolder->GetTextureImageLayout() };
-
-            VkDescriptorImageInfo imageSpecularInfo{};
-            if (m_Models[meshIdx]->m_SpecularTexture)
-                imageSpecularInfo = {
-                    currentObj->m_SpecularTexture->GetTextureSampler(),
-                    currentObj->m_SpecularTexture->GetTextureImageView(),
-                    currentObj->m_SpecularTexture->GetTextureImageLayout() };
-            else
-                imageSpecularInfo = {
-                    blackPlaceHolder->GetTextureSampler(),
-                    blackPlaceHolder->GetTextureImageView(),
-                    blackPlaceHolder->GetTextureImageLayout() };
-
-            VkDescriptorImageInfo imageAOInfo{};
-            if (m_Models[meshIdx]->m_AOTexture)
-                imageAOInfo = {
-                    currentObj->m_AOTexture->GetTextureSampler(),
-                    currentObj->m_AOTexture->GetTextureImageView(),
-                    currentObj->m_AOTexture->GetTextureImageLayout() };
-            else
-                imageAOInfo = {
-                    whitePlaceHolder->GetTextureSampler(),
-                    whitePlaceHolder->GetTextureImageView(),
-                    whitePlaceHolder->GetTextureImageLayout() };
-
-            VkDescriptorSet descriptorSet{};
-            FHDescriptorWriter(*objectSetLayout, *m_pAppPool)
-                .WriteImage(0, &imageDiffuseInfo)
-                .WriteImage(1, &imageNormalInfo)
-                .WriteImage(2, &imageRoughnessInfo)
-                .WriteImage(3, &imageSpecularInfo)
-                .WriteImage(4, &imageAOInfo)
-                .Build(descriptorSet);
-
-            currentObj->SetDescriptorSetAtFrame(i, descriptorSet);
-        }
+            writeObjectSet(*m_Models[meshIdx], i, false);
+        for (const auto& pProp : m_StaticProps)
+            writeObjectSet(*pProp, i, false);
     }
     ////////////////////////
 
@@ -179,6 +165,10 @@ void FH::FirstApp::Run()
         m_FHDevice,
         m_FHRenderer.GetSwapChainRenderPass()
     };
+
+    FHCullingSystem cullingSystem{ m_FHDevice };
+    FHTextureStreamer& textureStreamer{ m_Assets.GetTextureStreamer() };
+    FHResidencyManager& residencyManager{ m_Assets.GetResidencyManager() };
     
     FHCamera camera{};
 
@@ -209,7 +199,8 @@ void FH::FirstApp::Run()
                 frameIdx, 
                 commandBuffer, 
                 camera, 
-                appDescriptorSets[frameIdx]
+                appDescriptorSets[frameIdx],
+                m_FHRenderer.GetSwapChainExtent()
             };
 
             //update
@@ -240,18 +231,72 @@ void FH::FirstApp::Run()
                         m_Models[idx]->m_Transform.rotation.y -= 360.f;
                 }
 
+            //stream, uploads have to happen outside of the render pass
+            if (FHStreamedModel* pStreamedModel{ pModelVec[m_CurrentModelIdx]->m_StreamedModel.get() })
+                pStreamedModel->Update(viewerObject.m_Transform.translation, pModelVec[m_CurrentModelIdx]->m_Transform.GetModelMatrix());
+
+            //texture mips for the size the object covers on screen, the others fall back to their tail
+            FHGameObject& currentObject{ *pModelVec[m_CurrentModelIdx] };
+            const float screenSize{ renderSystem.GetScreenSize(frameInfo, currentObject) };
+            for (const FHTexture* pTexture : { currentObject.m_DiffuseTexture.get(), currentObject.m_NormalTexture.get(), currentObject.m_ORMTexture.get() })
+                if (pTexture)
+                {
+                    textureStreamer.RequestSize(*pTexture, screenSize);
+                    residencyManager.MarkDrawn(*pTexture);
+                }
+            //textures not drawn lately drop to their mip tail when over budget, drawn ones come back
+            for (const auto& pProp : m_StaticProps)
+                for (const FHTexture* pTexture : { pProp->m_DiffuseTexture.get(), pProp->m_NormalTexture.get(), pProp->m_ORMTexture.get() })
+                    if (pTexture)
+                        residencyManager.MarkDrawn(*pTexture);
+            residencyManager.Update();
+            textureStreamer.Update();
+            //reads the feedback this frame index wrote last time, its fence was waited on in BeginFrame
+            virtualTextures.Update(frameIdx);
+
+            if (currentObject.IsDescriptorSetStale(frameIdx))
+                writeObjectSet(currentObject, frameIdx, true);
+            for (const auto& pProp : m_StaticProps)
+                if (pProp->IsDescriptorSetStale(frameIdx))
+                    writeObjectSet(*pProp, frameIdx, true);
+
+            //cull, has to be recorded outside of the render pass
+            cullingSystem.BeginFrame(frameIdx);
+            FHCullResult cullResult{};
+            const uint32_t lodIdx{ renderSystem.SelectLod(frameInfo, *pModelVec[m_CurrentModelIdx]) };
+            const bool isCulled{ cullingSystem.CullGameObject(frameInfo, pModelVec[m_CurrentModelIdx], lodIdx, cullResult) };
+
             //render
             m_FHRenderer.BeginSwapChainRenderPass(commandBuffer);
 
-            renderSystem.RenderGameObject(frameInfo, pModelVec[m_CurrentModelIdx]);
+            if (m_DepthPrepass)
+                renderSystem.RenderGameObjectDepth(frameInfo, pModelVec[m_CurrentModelIdx], isCulled ? &cullResult : nullptr);
+            renderSystem.RenderGameObject(frameInfo, pModelVec[m_CurrentModelIdx], isCulled ? &cullResult : nullptr);
+            for (const auto& pProp : m_StaticProps)
+                renderSystem.RenderGameObject(frameInfo, pProp.get(), nullptr);
             renderSystem2D.RenderGameObjects2D(commandBuffer, m_Models2D);
             
             m_FHRenderer.EndSwapChainRenderPass(commandBuffer);
+            virtualTextures.RecordFeedbackBarrier(commandBuffer);
             m_FHRenderer.EndFrame();
         }
     }
 
     vkDeviceWaitIdle(m_FHDevice.GetDevice());
+
+    const FHVirtualTextureCache::Stats virtualStats{ virtualTextures.GetStats() };
+    std::cout << "Virtual textures: " << virtualStats.residentPages << " pages resident, "
+        << virtualStats.uploadCount << " uploaded, " << virtualStats.evictionCount << " evicted" << std::endl;
+    const FHResidencyManager::Stats residencyStats{ residencyManager.GetStats() };
+    std::cout << "Residency: " << residencyStats.evictionCount << " evictions, " << residencyStats.reloadCount
+        << " reloads, textures " << residencyStats.textureBytes / (1024 * 1024) << " MiB, "
+        << residencyStats.usage / (1024 * 1024) << "/" << residencyStats.budget / (1024 * 1024) << " MiB used" << std::endl;
+}
+
+void FH::FirstApp::ToggleDepthPrepass()
+{
+    m_DepthPrepass = !m_DepthPrepass;
+    std::cout << "Depth prepass: " << (m_DepthPrepass ? "on" : "off") << std::endl;
 }
 
 void FH::FirstApp::CycleModelLeft() 
@@ -270,8 +315,49 @@ void FH::FirstApp::CycleModelRight()
 
 void FH::FirstApp::LoadGameObjects()
 {
-    std::unique_ptr<FHModel> deagleModel = FHModel::CreateModelFromFile(m_FHDevice,
-        "models/deagle.obj");
+    //.glb models can pass FHGltfLoader::LoadMaterial(path) instead of listing their textures
+    const FHMaterialPaths baseMaterial{
+        "textures/base/base_diffuse.png",
+        "textures/base/base_normal.png",
+        "textures/base/base_roughness.png",
+        "textures/base/base_specular.png" };
+    const FHMaterialPaths deagleMaterial{
+        "textures/deagle/deagle_diffuse.png",
+        "textures/deagle/deagle_normal.png",
+        "textures/deagle/deagle_roughness.png",
+        "textures/deagle/deagle_specular.png",
+        "textures/deagle/deagle_ao.png" };
+    const FHMaterialPaths ak47Material{
+        "textures/ak47/ak47_diffuse.png",
+        "textures/ak47/ak47_normal.png",
+        "textures/ak47/ak47_roughness.png",
+        "textures/ak47/ak47_specular.png",
+        "textures/ak47/ak47_ao.png" };
+    const FHMaterialPaths m4a4Material{
+        "textures/m4a4/m4a4_diffuse.png",
+        "textures/m4a4/m4a4_normal.png",
+        "textures/m4a4/m4a4_roughness.png",
+        "textures/m4a4/m4a4_specular.png",
+        "textures/m4a4/m4a4_ao.png" };
+
+    FHModelLoadOptions loadOptions{};
+    loadOptions.vertexFormat = FHVertexFormat::Compact;
+    //Only read by the depth prepass, kept so F6 can turn it on at runtime
+    loadOptions.positionStream = true;
+
+    //The camera starts at the origin, 8 units from the inspected model
+    const FHTexelDensity::View inspectView{ 8.f, glm::radians(45.f), m_FHWindow.GetExtent().height };
+    m_Assets.AnalyzeTexelDensity("models/deagle.obj", loadOptions, glm::vec3{ 0.25f }, deagleMaterial, inspectView, LIMIT_TO_TEXEL_DENSITY);
+    m_Assets.AnalyzeTexelDensity("models/ak47.obj", loadOptions, glm::vec3{ 0.2f }, ak47Material, inspectView, LIMIT_TO_TEXEL_DENSITY);
+    m_Assets.AnalyzeTexelDensity("models/m4a4.obj", loadOptions, glm::vec3{ 0.2f }, m4a4Material, inspectView, LIMIT_TO_TEXEL_DENSITY);
+    m_Assets.AnalyzeTexelDensity("models/sphere.obj", loadOptions, glm::vec3{ 0.8f }, baseMaterial, inspectView, LIMIT_TO_TEXEL_DENSITY);
+    m_Assets.AnalyzeTexelDensity("models/cube.obj", loadOptions, glm::vec3{ 0.5f }, baseMaterial, inspectView, LIMIT_TO_TEXEL_DENSITY);
+    m_Assets.AnalyzeTexelDensity("models/vehicle.obj", loadOptions, glm::vec3{ 0.1f }, baseMaterial, inspectView, LIMIT_TO_TEXEL_DENSITY);
+
+    //Decoding is the largest part of startup, done on every core before the objects upload their textures
+    m_Assets.PreloadTextures({ deagleMaterial, ak47Material, m4a4Material, baseMaterial });
+
+    std::shared_ptr<FHModel> deagleModel = m_Assets.GetModel("models/deagle.obj", loadOptions);
 
     auto deagle = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
 
@@ -280,22 +366,11 @@ void FH::FirstApp::LoadGameObjects()
     deagle->m_Transform.scale = { 0.25f, 0.25f, 0.25f };
     deagle->m_Transform.rotation = { 0.f, glm::radians(90.f), glm::radians(180.f) };
 
-    auto deagleDiffuseMap = std::make_unique<FHTexture>(m_FHDevice, "textures/deagle/deagle_diffuse.png");
-    auto deagleNormalMap = std::make_unique<FHTexture>(m_FHDevice, "textures/deagle/deagle_normal.png");
-    auto deagleRoughnessMap = std::make_unique<FHTexture>(m_FHDevice, "textures/deagle/deagle_roughness.png");
-    auto deagleSpecularMap = std::make_unique<FHTexture>(m_FHDevice, "textures/deagle/deagle_specular.png");
-    auto deagleAOMap = std::make_unique<FHTexture>(m_FHDevice, "textures/deagle/deagle_ao.png");
-
-    deagle->m_DiffuseTexture = std::move(deagleDiffuseMap);
-    deagle->m_NormalTexture = std::move(deagleNormalMap);
-    deagle->m_RoughnessTexture = std::move(deagleRoughnessMap);
-    deagle->m_SpecularTexture = std::move(deagleSpecularMap);
-    deagle->m_AOTexture = std::move(deagleAOMap);
+    deagle->LoadTextures(m_Assets, deagleMaterial);
 
     m_Models.push_back(std::move(deagle));
 
-    std::unique_ptr<FHModel> akModel = FHModel::CreateModelFromFile(m_FHDevice,
-        "models/ak47.obj");
+    std::shared_ptr<FHModel> akModel = m_Assets.GetModel("models/ak47.obj", loadOptions);
 
     auto ak47 = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
     ak47->m_Model = std::move(akModel);
@@ -303,22 +378,11 @@ void FH::FirstApp::LoadGameObjects()
     ak47->m_Transform.scale = { 0.2f, 0.2f, 0.2f };
     ak47->m_Transform.rotation = { 0.f, glm::radians(90.f), glm::radians(180.f) };
 
-    auto ak47DiffuseMap = std::make_unique<FHTexture>(m_FHDevice, "textures/ak47/ak47_diffuse.png");
-    auto ak47NormalMap = std::make_unique<FHTexture>(m_FHDevice, "textures/ak47/ak47_normal.png");
-    auto ak47RoughnessMap = std::make_unique<FHTexture>(m_FHDevice, "textures/ak47/ak47_roughness.png");
-    auto ak47SpecularMap = std::make_unique<FHTexture>(m_FHDevice, "textures/ak47/ak47_specular.png");
-    auto ak47AOMap = std::make_unique<FHTexture>(m_FHDevice, "textures/ak47/ak47_ao.png");
-
-    ak47->m_DiffuseTexture = std::move(ak47DiffuseMap);
-    ak47->m_NormalTexture = std::move(ak47NormalMap);
-    ak47->m_RoughnessTexture = std::move(ak47RoughnessMap);
-    ak47->m_SpecularTexture = std::move(ak47SpecularMap);
-    ak47->m_AOTexture = std::move(ak47AOMap);
+    ak47->LoadTextures(m_Assets, ak47Material);
 
     m_Models.push_back(std::move(ak47));
 
-    std::unique_ptr<FHModel> m4a4Model = FHModel::CreateModelFromFile(m_FHDevice,
-        "models/m4a4.obj");
+    std::shared_ptr<FHModel> m4a4Model = m_Assets.GetModel("models/m4a4.obj", loadOptions);
 
     auto m4a4 = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
 
@@ -327,22 +391,11 @@ void FH::FirstApp::LoadGameObjects()
     m4a4->m_Transform.scale = { 0.2f, 0.2f, 0.2f };
     m4a4->m_Transform.rotation = { 0.f, glm::radians(90.f), glm::radians(180.f) };
 
-    auto m4a4DiffuseMap = std::make_unique<FHTexture>(m_FHDevice, "textures/m4a4/m4a4_diffuse.png");
-    auto m4a4NormalMap = std::make_unique<FHTexture>(m_FHDevice, "textures/m4a4/m4a4_normal.png");
-    auto m4a4RoughnessMap = std::make_unique<FHTexture>(m_FHDevice, "textures/m4a4/m4a4_roughness.png");
-    auto m4a4SpecularMap = std::make_unique<FHTexture>(m_FHDevice, "textures/m4a4/m4a4_specular.png");
-    auto m4a4AOMap = std::make_unique<FHTexture>(m_FHDevice, "textures/m4a4/m4a4_ao.png");
-
-    m4a4->m_DiffuseTexture = std::move(m4a4DiffuseMap);
-    m4a4->m_NormalTexture = std::move(m4a4NormalMap);
-    m4a4->m_RoughnessTexture = std::move(m4a4RoughnessMap);
-    m4a4->m_SpecularTexture = std::move(m4a4SpecularMap);
-    m4a4->m_AOTexture = std::move(m4a4AOMap);
+    m4a4->LoadTextures(m_Assets, m4a4Material);
 
     m_Models.push_back(std::move(m4a4));
 
-    std::unique_ptr<FHModel> sphereModel = FHModel::CreateModelFromFile(m_FHDevice,
-        "models/sphere.obj");
+    std::shared_ptr<FHModel> sphereModel = m_Assets.GetModel("models/sphere.obj", loadOptions);
 
     auto sphere = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
 
@@ -351,20 +404,11 @@ void FH::FirstApp::LoadGameObjects()
     sphere->m_Transform.scale = { 0.8f, 0.8f, 0.8f };
     sphere->m_Transform.rotation = { 0.f, 0.f, 0.f };
 
-    auto sphereDiffuseMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_diffuse.png");
-    auto sphereNormalMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_normal.png");
-    auto sphereRoughnessMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_roughness.png");
-    auto sphereSpecularMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_specular.png");
-
-    sphere->m_DiffuseTexture = std::move(sphereDiffuseMap);
-    sphere->m_NormalTexture = std::move(sphereNormalMap);
-    sphere->m_RoughnessTexture = std::move(sphereRoughnessMap);
-    sphere->m_SpecularTexture = std::move(sphereSpecularMap);
+    sphere->LoadTextures(m_Assets, baseMaterial);
 
     m_Models.push_back(std::move(sphere));
 
-    std::unique_ptr<FHModel> cubeModel = FHModel::CreateModelFromFile(m_FHDevice,
-        "models/cube.obj");
+    std::shared_ptr<FHModel> cubeModel = m_Assets.GetModel("models/cube.obj", loadOptions);
 
     auto cube = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
 
@@ -373,20 +417,11 @@ void FH::FirstApp::LoadGameObjects()
     cube->m_Transform.scale = { 0.5f, 0.5f, 0.5f };
     cube->m_Transform.rotation = { 0.f, 0.f, 0.f };
 
-    auto cubeDiffuseMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_diffuse.png");
-    auto cubeNormalMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_normal.png");
-    auto cubeRoughnessMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_roughness.png");
-    auto cubeSpecularMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_specular.png");
-
-    cube->m_DiffuseTexture = std::move(cubeDiffuseMap);
-    cube->m_NormalTexture = std::move(cubeNormalMap);
-    cube->m_RoughnessTexture = std::move(cubeRoughnessMap);
-    cube->m_SpecularTexture = std::move(cubeSpecularMap);
+    cube->LoadTextures(m_Assets, baseMaterial);
 
     m_Models.push_back(std::move(cube));
 
-    std::unique_ptr<FHModel> vehicleModel = FHModel::CreateModelFromFile(m_FHDevice,
-        "models/vehicle.obj");
+    std::shared_ptr<FHModel> vehicleModel = m_Assets.GetModel("models/vehicle.obj", loadOptions);
 
     auto vehicle = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
 
@@ -395,18 +430,56 @@ void FH::FirstApp::LoadGameObjects()
     vehicle->m_Transform.scale = { 0.1f, 0.1f, 0.1f };
     vehicle->m_Transform.rotation = { 0.f, glm::radians(180.f), glm::radians(180.f) };
 
-    auto vehicleDiffuseMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_diffuse.png");
-    auto vehicleNormalMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_normal.png");
-    auto vehicleRoughnessMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_roughness.png");
-    auto vehicleSpecularMap = std::make_unique<FHTexture>(m_FHDevice, "textures/base/base_specular.png");
-
-    vehicle->m_DiffuseTexture = std::move(vehicleDiffuseMap);
-    vehicle->m_NormalTexture = std::move(vehicleNormalMap);
-    vehicle->m_RoughnessTexture = std::move(vehicleRoughnessMap);
-    vehicle->m_SpecularTexture = std::move(vehicleSpecularMap);
+    vehicle->LoadTextures(m_Assets, baseMaterial);
 
     m_Models.push_back(std::move(vehicle));
 
+    //The display stand never moves, its tiles and posts are merged into one draw per material
+    FHStaticBatcher standBatcher{};
+    for (int tileIdx{}; tileIdx < 25; ++tileIdx)
+    {
+        TransformComponent tile{};
+        tile.translation = { (tileIdx % 5 - 2) * 0.5f, 1.5f, 8.f + (tileIdx / 5 - 2) * 0.5f };
+        tile.scale = { 0.24f, 0.05f, 0.24f };
+        standBatcher.Add("models/cube.obj", tile, baseMaterial, loadOptions);
+    }
+    for (int postIdx{}; postIdx < 4; ++postIdx)
+    {
+        TransformComponent post{};
+        post.translation = { (postIdx % 2 ? 1.f : -1.f) * 1.25f, 1.3f, 8.f + (postIdx / 2 ? 1.f : -1.f) * 1.25f };
+        post.scale = { 0.15f, 0.15f, 0.15f };
+        standBatcher.Add("models/sphere.obj", post, baseMaterial, loadOptions);
+    }
+    m_StaticProps = standBatcher.Build(m_Assets, m_FHGeometryPool, loadOptions);
+
+    //Scans too large to keep resident are streamed in chunks, only when one is provided
+    if (std::filesystem::exists("resources/models/scan.obj") || std::filesystem::exists("resources/models/scan.fhchunks"))
+    {
+        auto scan = std::make_unique<FHGameObject>(FHGameObject::CreateGameObject());
+        scan->m_StreamedModel = FHStreamedModel::CreateFromFile(m_FHGeometryPool, "models/scan.obj");
+        scan->m_Transform.translation = { 0.f, 0.f, 8.f };
+        scan->LoadTextures(m_Assets, baseMaterial);
+
+        m_Models.push_back(std::move(scan));
+    }
+
+    const FHAssetRegistry::Stats assetStats{ m_Assets.GetStats() };
+    std::cout << "Assets: " << assetStats.loadCount << " loaded, " << assetStats.sharedCount << " shared, "
+        << assetStats.samplerCount << " samplers, " << assetStats.reclaimedBytes / (1024 * 1024) << " MiB reclaimed by texel density" << std::endl;
+
+    const FHResidencyManager::Stats residencyStats{ m_Assets.GetResidencyManager().GetStats() };
+    std::cout << "Memory: " << residencyStats.usage / (1024 * 1024) << "/" << residencyStats.budget / (1024 * 1024)
+        << " MiB used, textures " << residencyStats.textureBytes / (1024 * 1024) << " MiB" << std::endl;
+
+    const FHGeometryPool::Stats poolStats{ m_FHGeometryPool.GetStats() };
+    std::cout << "Geometry pool: " << poolStats.allocationCount << " ranges in " << poolStats.bufferCount
+        << " buffers, " << poolStats.used / (1024 * 1024) << "/" << poolStats.capacity / (1024 * 1024) << " MiB used" << std::endl;
+
+    FHUploadContext& uploads{ m_FHDevice.GetUploadContext() };
+    uploads.Flush();
+    std::cout << "Uploads: " << uploads.GetStats().submitCount << " submits, "
+        << uploads.GetStats().stagedBytes / (1024 * 1024) << " MiB staged" << std::endl;
+
     //Add light
     auto mainLight = std::make_unique<FHGameObject>(
         FHGameObject::CreateDirectionalLight(7.f, {1.f, 3.f, 1.f}, { 0.9f, 0.9f, 1.f }));
@@ -456,6 +529,7 @@ void FH::FirstApp::PrintControls()
     std::cout << "-- RMB + Mouse -> Aiming\n";
     std::cout << "-- LMB -> Speed up movement\n";
     std::cout << "-- F5 -> Enable model rotation\n";
+    std::cout << "-- F6 -> Toggle depth prepass\n";
     std::cout << "-- Left Arrow -> Cycle model left\n";
     std::cout << "-- Right Arrow -> Cycle model right\n";
     std::cout << "-----------------------------------\n\n";
@@ -7,6 +7,8 @@
 #include "engine/buffer.h"
 #include "engine/descriptors.h"
 #include "engine/texture.h"
+#include "engine/geometryPool.h"
+#include "engine/assetRegistry.h"
 
 #include <memory>
 #include <vector>
@@ -19,6 +21,8 @@ namespace FH
 	public:
 		static inline constexpr int WIDTH{ 800 };
 		static inline constexpr int HEIGHT{ 600 };
+		//Textures are loaded at the size the inspector camera can resolve on the models, see FHTexelDensity
+		static inline constexpr bool LIMIT_TO_TEXEL_DENSITY{ true };
 
 		FirstApp();
 		~FirstApp() = default;
@@ -28,6 +32,7 @@ namespace FH
 		void Run();
 
 		void ToggleModelRotate() { m_ModelRotate = !m_ModelRotate; }
+		void ToggleDepthPrepass();
 
 		void CycleModelLeft();
 		void CycleModelRight();
@@ -42,13 +47,22 @@ namespace FH
 		FHDevice m_FHDevice{ m_FHWindow };
 		FHRenderer m_FHRenderer{ m_FHWindow, m_FHDevice };
 
+		//Define before the models, they free their ranges on destruction
+		FHGeometryPool m_FHGeometryPool{ m_FHDevice };
+		//Define before the models, their textures use its samplers
+		FHAssetRegistry m_Assets{ m_FHDevice, m_FHGeometryPool };
+
 		bool m_ModelRotate{};
+		//Only pays off with enough overdraw, the inspected models barely have any, see FHMeshOptimizer::AnalyzeOverdraw
+		bool m_DepthPrepass{};
 
 		//Define pool after device
 		std::unique_ptr<FHDescriptorPool> m_pAppPool{};
 
 		std::vector<std::unique_ptr<FHGameObject>> m_Models{};
 		int m_CurrentModelIdx{};
+		//Drawn every frame under whichever model is inspected, batched by FHStaticBatcher
+		std::vector<std::unique_ptr<FHGameObject>> m_StaticProps{};
 
 		std::vector<FHGameObject2D> m_Models2D{};
 
@@ -0,0 +1,34 @@
+#version 450
+
+//Position stream only, must compute gl_Position exactly like shader.vert
+layout(location = 0) in vec3 position;
+
+struct DirectionalLight 
+{
+    vec4 direction;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo 
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 ambientlightColor;
+	DirectionalLight directionalLight;
+	vec3 cameraPos;
+	bool useNormals;
+} ubo;
+
+layout(push_constant) uniform Push
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+} push;
+
+invariant gl_Position;
+
+void main() 
+{
+	vec4 worldPos = push.modelMatrix * vec4(position, 1.0);
+	gl_Position = ubo.projectionMatrix * ubo.viewMatrix * worldPos;
+}
\ No newline at end of file
@@ -1,13 +1,21 @@
 #version 450
 #extension GL_KHR_vulkan_glsl : enable
 
+//Hidden fragments must not request virtual texture pages
+layout(early_fragment_tests) in;
+
 const float g_PI = 3.141592654f;
 const float g_SpecularReflectance = 5.f;
 
+//See FHVirtualTextureCache
+const float g_VirtualPageSize = 128.0;
+const float g_VirtualPageBorder = 4.0;
+const float g_VirtualSlotSize = 136.0;
+
 layout(location = 0) in vec3 fragPosWorld;
 layout(location = 1) in vec3 fragNormal;
 layout(location = 2) in vec2 fragUV;
-layout(location = 3) in vec3 fragTangent;
+layout(location = 3) in vec4 fragTangent;
 
 layout(location = 0) out vec4 outColor;
 
@@ -28,9 +36,19 @@ layout(set = 0, binding = 0) uniform GlobalUbo
 
 layout(set = 1, binding = 0) uniform sampler2D textureDiffuseImage;
 layout(set = 1, binding = 1) uniform sampler2D textureNormalImage;
-layout(set = 1, binding = 2) uniform sampler2D textureRoughnessImage;
-layout(set = 1, binding = 3) uniform sampler2D textureSpecularImage;
-layout(set = 1, binding = 4) uniform sampler2D textureAOImage;
+layout(set = 1, binding = 2) uniform sampler2D textureORMImage; //R ambient occlusion, G roughness, B specular
+layout(set = 1, binding = 3) uniform usampler2D virtualPageTable; //RG atlas slot, B level of the page, A 255 when not virtual
+layout(set = 1, binding = 4) uniform sampler2D virtualAtlas;
+//Built a second time with FH_NO_VIRTUAL_FEEDBACK for devices without fragmentStoresAndAtomics, which only allow
+//storage buffers the fragment shader never writes
+#ifdef FH_NO_VIRTUAL_FEEDBACK
+layout(set = 1, binding = 5) readonly buffer VirtualFeedback
+#else
+layout(set = 1, binding = 5) buffer VirtualFeedback
+#endif
+{
+    uint wantedPages[];
+} virtualFeedback;
 
 layout(push_constant) uniform Push
 {
@@ -43,12 +61,67 @@ vec3 GetLambert(vec3 diffuseSample, vec3 kd)
     return diffuseSample * kd / g_PI;
 }
 
+//A missing page points at the coarser page covering it, the position inside follows the level it holds
+vec3 SampleVirtualLevel(vec2 uv, int level)
+{
+    const ivec2 pages = textureSize(virtualPageTable, level);
+    const uvec4 entry = texelFetch(virtualPageTable, min(ivec2(uv * vec2(pages)), pages - 1), level);
+
+    const vec2 inPage = fract(uv * vec2(textureSize(virtualPageTable, int(entry.b))));
+    const vec2 atlasTexel = vec2(entry.rg) * g_VirtualSlotSize + g_VirtualPageBorder + inPage * g_VirtualPageSize;
+    return textureLod(virtualAtlas, atlasTexel / vec2(textureSize(virtualAtlas, 0)), 0.0).rgb;
+}
+
+//One pixel in every 4x4 block is enough to find the pages in view
+void WriteVirtualFeedback(vec2 uv, int level)
+{
+#ifndef FH_NO_VIRTUAL_FEEDBACK
+    if (any(notEqual(ivec2(gl_FragCoord.xy) & 3, ivec2(0))))
+        return;
+
+    uint levelOffset = 0;
+    for (int levelIdx = 0; levelIdx < level; ++levelIdx)
+    {
+        const ivec2 levelPages = textureSize(virtualPageTable, levelIdx);
+        levelOffset += uint(levelPages.x * levelPages.y);
+    }
+
+    const ivec2 pages = textureSize(virtualPageTable, level);
+    const ivec2 page = min(ivec2(uv * vec2(pages)), pages - 1);
+    virtualFeedback.wantedPages[levelOffset + uint(page.y * pages.x + page.x)] = 1u;
+#endif
+}
+
+vec3 GetDiffuse()
+{
+    if (texelFetch(virtualPageTable, ivec2(0), 0).a == 255u)
+        return texture(textureDiffuseImage, fragUV).rgb;
+
+    //Trilinear by hand, the atlas has no mips and the pages of two levels may sit anywhere in it
+    const vec2 texels = fragUV * vec2(textureSize(virtualPageTable, 0)) * g_VirtualPageSize;
+    const vec2 dx = dFdx(texels);
+    const vec2 dy = dFdy(texels);
+    const int maxLevel = textureQueryLevels(virtualPageTable) - 1;
+    const float lod = clamp(0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0)), 0.0, float(maxLevel));
+    const int level = int(lod);
+
+    const vec2 uv = fract(fragUV);
+    WriteVirtualFeedback(uv, level);
+
+    const vec3 fineSample = SampleVirtualLevel(uv, level);
+    const vec3 coarseSample = SampleVirtualLevel(uv, min(level + 1, maxLevel));
+    return mix(fineSample, coarseSample, fract(lod));
+}
+
 vec3 GetNormal()
 {
-    const vec3 normalSample = texture(textureNormalImage, fragUV).rgb * 2.0;
+    //Z is rebuilt from XY so two channel BC5 normal maps work too
+    const vec2 normalXY = texture(textureNormalImage, fragUV).rg * 2.0 - 1.0;
+    const vec3 normalSample = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 
-    const vec3 binormal = normalize(cross(normalize(fragNormal), normalize(fragTangent)));
-    const mat3 tangentSpaceAxis = mat3(normalize(fragTangent), binormal, normalize(fragNormal));
+    //MikkTSpace: the interpolated frame is used as is, only the result is normalized
+    const vec3 bitangent = fragTangent.w * cross(fragNormal, fragTangent.xyz);
+    const mat3 tangentSpaceAxis = mat3(fragTangent.xyz, bitangent, fragNormal);
 
     return normalize(tangentSpaceAxis * normalSample);
 }
@@ -91,10 +164,11 @@ vec3 Fresnel(vec3 F0, vec3 viewDir, vec3 halfvec)
 
 vec3 PBR()
 {
-	const vec3 diffuseSample = texture(textureDiffuseImage, fragUV).rgb;
-	const float roughnessSample = texture(textureRoughnessImage, fragUV).r;
-	const float specularSample = texture(textureSpecularImage, fragUV).r;
-	const float aoSample = texture(textureAOImage, fragUV).r;
+	const vec3 diffuseSample = GetDiffuse();
+	const vec3 ormSample = texture(textureORMImage, fragUV).rgb;
+	const float aoSample = ormSample.r;
+	const float roughnessSample = ormSample.g;
+	const float specularSample = ormSample.b;
 
     vec3 sampledNormal = GetNormal();
 
@@ -3,12 +3,15 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 uv;
-layout(location = 3) in vec3 tangent;
+layout(location = 3) in vec4 tangent;
 
 layout(location = 0) out vec3 fragPosWorld;
 layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec2 fragUV;
-layout(location = 3) out vec3 fragTangent;
+layout(location = 3) out vec4 fragTangent;
+
+//Matches the depth prepass bit for bit
+invariant gl_Position;
 
 struct DirectionalLight 
 {
@@ -40,5 +43,5 @@ void main()
 	fragPosWorld = worldPos.xyz;
 	fragNormal = normalize(mat3(push.normalMatrix) * normal);
 	fragUV = uv;
-	fragTangent = normalize(mat3(push.normalMatrix) * tangent);
+	fragTangent = vec4(normalize(mat3(push.normalMatrix) * tangent.xyz), tangent.w);
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#version 450
+
+//FHModel::CompactVertex input, modelMatrix already contains the dequantization
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 normal;
+layout(location = 2) in vec2 uv;
+layout(location = 3) in vec2 tangent;
+
+layout(location = 0) out vec3 fragPosWorld;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec2 fragUV;
+layout(location = 3) out vec4 fragTangent;
+
+//Matches the depth prepass bit for bit
+invariant gl_Position;
+
+struct DirectionalLight
+{
+    vec4 direction;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 ambientlightColor;
+	DirectionalLight directionalLight;
+	vec3 cameraPos;
+	bool useNormals;
+} ubo;
+
+layout(push_constant) uniform Push
+{
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+} push;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+void main()
+{
+	vec4 worldPos = push.modelMatrix * vec4(position.xyz, 1.0);
+	gl_Position = ubo.projectionMatrix * ubo.viewMatrix * worldPos;
+
+	fragPosWorld = worldPos.xyz;
+	fragNormal = normalize(mat3(push.normalMatrix) * DecodeOctahedral(normal));
+	fragUV = uv;
+	fragTangent = vec4(normalize(mat3(push.normalMatrix) * DecodeOctahedral(tangent)), position.w > 0.5 ? 1.0 : -1.0);
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "engine/gltfLoader.h"
+#include "engine/objLoader.h"
+#include "engine/tangentGenerator.h"
+#include "engine/vertexWelder.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//Times the two importers of ModelData::LoadModel on the same mesh written as .obj and as .glb, up to the vertex
+//and index arrays that get staged. The .obj path parses, welds and generates tangents like LoadObj, the .glb path
+//views the accessors and gathers them like LoadGltf. Fails when the two give different triangles
+namespace
+{
+	struct Vertex
+	{
+		glm::vec3 pos{};
+		glm::vec3 normal{};
+		glm::vec2 uv{};
+		glm::vec4 tangent{};
+	};
+
+	struct Mesh
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+	};
+
+	//Sphere grid with a uv seam column, indexed like an exporter writes it
+	Mesh MakeSphere(int rows, int columns)
+	{
+		Mesh mesh{};
+		for (int row = 0; row <= rows; ++row)
+			for (int column = 0; column <= columns; ++column)
+			{
+				const float theta{ glm::pi<float>() * row / rows };
+				const float phi{ glm::two_pi<float>() * (column % columns) / columns };
+				const glm::vec3 pos{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+				const glm::vec4 tangent{ -std::sin(phi), 0.f, std::cos(phi), 1.f };
+				mesh.vertices.push_back({ pos, pos, { static_cast<float>(column) / columns, static_cast<float>(row) / rows }, tangent });
+			}
+
+		for (int row = 0; row < rows; ++row)
+			for (int column = 0; column < columns; ++column)
+			{
+				const uint32_t a{ static_cast<uint32_t>(row * (columns + 1) + column) };
+				const uint32_t b{ a + 1 };
+				const uint32_t c{ a + columns + 1 };
+				const uint32_t d{ c + 1 };
+				mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+			}
+		return mesh;
+	}
+
+	std::filesystem::path GetTempPath(const std::string& extension)
+	{
+		return std::filesystem::temp_directory_path() / ("fh_gltfbenchmark" + extension);
+	}
+
+	//Nine significant digits so every float reads back bit for bit
+	void WriteObj(const Mesh& mesh, const std::filesystem::path& path)
+	{
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		file << std::setprecision(9);
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			file << "v " << vertex.pos.x << " " << vertex.pos.y << " " << vertex.pos.z << "\n";
+			file << "vt " << vertex.uv.x << " " << vertex.uv.y << "\n";
+			file << "vn " << vertex.normal.x << " " << vertex.normal.y << " " << vertex.normal.z << "\n";
+		}
+		for (size_t idx = 0; idx < mesh.indices.size(); idx += 3)
+		{
+			file << "f";
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t index{ mesh.indices[idx + corner] + 1 };
+				file << " " << index << "/" << index << "/" << index;
+			}
+			file << "\n";
+		}
+	}
+
+	//One buffer with every attribute tightly packed, the layout the loader views in place
+	void WriteGlb(const Mesh& mesh, const std::filesystem::path& path)
+	{
+		std::vector<uint8_t> binary{};
+		auto append = [&binary](const void* pData, size_t size)
+			{
+				const size_t offset{ binary.size() };
+				binary.resize(offset + size);
+				std::memcpy(binary.data() + offset, pData, size);
+				return offset;
+			};
+
+		std::vector<glm::vec3> positions{};
+		std::vector<glm::vec3> normals{};
+		std::vector<glm::vec2> uvs{};
+		std::vector<glm::vec4> tangents{};
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			positions.push_back(vertex.pos);
+			normals.push_back(vertex.normal);
+			uvs.push_back(vertex.uv);
+			tangents.push_back(vertex.tangent);
+		}
+
+		const size_t count{ mesh.vertices.size() };
+		const size_t offsets[5]
+		{
+			append(positions.data(), count * sizeof(glm::vec3)),
+			append(normals.data(), count * sizeof(glm::vec3)),
+			append(uvs.data(), count * sizeof(glm::vec2)),
+			append(tangents.data(), count * sizeof(glm::vec4)),
+			append(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t))
+		};
+		const size_t sizes[5]{ count * 12, count * 12, count * 8, count * 16, mesh.indices.size() * 4 };
+
+		std::ostringstream json{};
+		json << R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":)" << binary.size() << R"(}],"bufferViews":[)";
+		for (int viewIdx = 0; viewIdx < 5; ++viewIdx)
+			json << (viewIdx ? "," : "") << R"({"buffer":0,"byteOffset":)" << offsets[viewIdx] << R"(,"byteLength":)" << sizes[viewIdx] << "}";
+		json << R"(],"accessors":[)"
+			<< R"({"bufferView":0,"componentType":5126,"count":)" << count << R"(,"type":"VEC3"},)"
+			<< R"({"bufferView":1,"componentType":5126,"count":)" << count << R"(,"type":"VEC3"},)"
+			<< R"({"bufferView":2,"componentType":5126,"count":)" << count << R"(,"type":"VEC2"},)"
+			<< R"({"bufferView":3,"componentType":5126,"count":)" << count << R"(,"type":"VEC4"},)"
+			<< R"({"bufferView":4,"componentType":5125,"count":)" << mesh.indices.size() << R"(,"type":"SCALAR"}],)"
+			<< R"("meshes":[{"primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2,"TANGENT":3},"indices":4}]}]})";
+
+		std::string jsonChunk{ json.str() };
+		jsonChunk.resize((jsonChunk.size() + 3) / 4 * 4, ' ');
+		binary.resize((binary.size() + 3) / 4 * 4, 0);
+
+		auto writeWords = [](std::ofstream& file, std::initializer_list<uint32_t> words)
+			{
+				for (uint32_t word : words)
+					file.write(reinterpret_cast<const char*>(&word), sizeof(word));
+			};
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		const uint32_t totalSize{ static_cast<uint32_t>(12 + 8 + jsonChunk.size() + 8 + binary.size()) };
+		writeWords(file, { 0x46546C67, 2, totalSize });
+		writeWords(file, { static_cast<uint32_t>(jsonChunk.size()), 0x4E4F534A });
+		file.write(jsonChunk.data(), static_cast<std::streamsize>(jsonChunk.size()));
+		writeWords(file, { static_cast<uint32_t>(binary.size()), 0x004E4942 });
+		file.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+	}
+
+	Mesh ImportObj(const std::string& filePath)
+	{
+		const FH::FHObjLoader::Result obj{ FH::FHObjLoader::Load(filePath) };
+
+		Mesh mesh{};
+		mesh.indices.reserve(obj.indices.size());
+		FH::FHVertexWelder welder{ obj.indices.size() };
+		for (const FH::FHObjLoader::Index& index : obj.indices)
+		{
+			Vertex vertex{};
+			vertex.pos = { obj.positions[3 * index.vertex], obj.positions[3 * index.vertex + 1], obj.positions[3 * index.vertex + 2] };
+			vertex.normal = { obj.normals[3 * index.normal], obj.normals[3 * index.normal + 1], obj.normals[3 * index.normal + 2] };
+			vertex.uv = { obj.texcoords[2 * index.texcoord], obj.texcoords[2 * index.texcoord + 1] };
+
+			const uint32_t vertexIdx{ welder.Weld(vertex.pos, vertex.normal, vertex.uv) };
+			if (vertexIdx == mesh.vertices.size())
+				mesh.vertices.push_back(vertex);
+			mesh.indices.push_back(vertexIdx);
+		}
+
+		std::vector<glm::vec3> positions(mesh.vertices.size());
+		std::vector<glm::vec3> normals(mesh.vertices.size());
+		std::vector<glm::vec2> uvs(mesh.vertices.size());
+		std::vector<glm::vec4> tangents(mesh.vertices.size());
+		for (size_t vertexIdx = 0; vertexIdx < mesh.vertices.size(); ++vertexIdx)
+		{
+			positions[vertexIdx] = mesh.vertices[vertexIdx].pos;
+			normals[vertexIdx] = mesh.vertices[vertexIdx].normal;
+			uvs[vertexIdx] = mesh.vertices[vertexIdx].uv;
+		}
+		FH::FHTangentGenerator::Generate(positions, normals, uvs, mesh.indices, tangents);
+		for (size_t vertexIdx = 0; vertexIdx < mesh.vertices.size(); ++vertexIdx)
+			mesh.vertices[vertexIdx].tangent = tangents[vertexIdx];
+		return mesh;
+	}
+
+	Mesh ImportGlb(const std::string& filePath)
+	{
+		const FH::FHGltfLoader::Result gltf{ FH::FHGltfLoader::Load(filePath) };
+
+		Mesh mesh{};
+		mesh.vertices.resize(gltf.positions.size());
+		for (size_t vertexIdx = 0; vertexIdx < mesh.vertices.size(); ++vertexIdx)
+			mesh.vertices[vertexIdx] = { gltf.positions[vertexIdx], gltf.normals[vertexIdx], gltf.uvs[vertexIdx], gltf.tangents[vertexIdx] };
+		mesh.indices.assign(gltf.indices.begin(), gltf.indices.end());
+		return mesh;
+	}
+
+	template<typename Import>
+	double TimeBest(const std::string& filePath, Import&& import, Mesh& result)
+	{
+		constexpr int runCount{ 5 };
+		double bestMillis{ std::numeric_limits<double>::max() };
+		for (int run = 0; run < runCount; ++run)
+		{
+			const auto start{ std::chrono::steady_clock::now() };
+			result = import(filePath);
+			bestMillis = std::min(bestMillis, std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count());
+		}
+		return bestMillis;
+	}
+
+	//Tangents are left out, the .obj ones are generated and the .glb ones exported
+	bool IsSameSurface(const Mesh& lhs, const Mesh& rhs)
+	{
+		if (lhs.indices.size() != rhs.indices.size())
+			return false;
+
+		for (size_t idx = 0; idx < lhs.indices.size(); ++idx)
+		{
+			const Vertex& a{ lhs.vertices[lhs.indices[idx]] };
+			const Vertex& b{ rhs.vertices[rhs.indices[idx]] };
+			if (a.pos != b.pos || a.normal != b.normal || a.uv != b.uv)
+				return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	const Mesh sphere{ MakeSphere(256, 512) };
+	const std::filesystem::path objPath{ GetTempPath(".obj") };
+	const std::filesystem::path glbPath{ GetTempPath(".glb") };
+	WriteObj(sphere, objPath);
+	WriteGlb(sphere, glbPath);
+
+	Mesh objMesh{};
+	Mesh glbMesh{};
+	const double objMillis{ TimeBest(objPath.string(), ImportObj, objMesh) };
+	const double glbMillis{ TimeBest(glbPath.string(), ImportGlb, glbMesh) };
+	const bool isMatch{ IsSameSurface(objMesh, glbMesh) };
+
+	std::cout << "generated sphere: " << sphere.indices.size() / 3 << " triangles, " << sphere.vertices.size() << " vertices\n"
+		<< ".obj " << std::filesystem::file_size(objPath) / 1024 << " KiB, " << objMillis << " ms\n"
+		<< ".glb " << std::filesystem::file_size(glbPath) / 1024 << " KiB, " << glbMillis << " ms ("
+		<< objMillis / glbMillis << "x), " << (isMatch ? "identical" : "DIFFERENT") << std::endl;
+
+	std::filesystem::remove(objPath);
+	std::filesystem::remove(glbPath);
+	return isMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
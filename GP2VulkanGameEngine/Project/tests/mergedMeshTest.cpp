@@ -0,0 +1,119 @@
+#include "engine/mergedMesh.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//Merges meshes like FHStaticBatcher::Add: the indices have to point at the source's own vertices, mirrored
+//transforms have to keep the triangles facing out, and every source has to keep its LOD 0 range as a SubMesh
+namespace
+{
+	bool g_Succeeded{ true };
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << what << std::endl;
+		g_Succeeded = g_Succeeded && condition;
+	}
+
+	//Two triangles facing +z, followed by a one triangle LOD 1 that must not be merged
+	FH::FHModel::ModelData MakeQuad()
+	{
+		FH::FHModel::ModelData data{};
+		const glm::vec2 corners[4]{ { 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f } };
+		for (const glm::vec2& corner : corners)
+			data.vertices.push_back({ glm::vec3{ corner, 0.f }, glm::vec3{ 0.f, 0.f, 1.f }, corner, glm::vec4{ 1.f, 0.f, 0.f, 1.f } });
+
+		data.indices = { 0, 1, 2, 0, 2, 3, 0, 1, 2 };
+		data.lods.push_back({ 0, 6 });
+		data.lods.push_back({ 6, 3 });
+		return data;
+	}
+
+	glm::mat4 MakeTransform(const glm::vec3& translation, const glm::vec3& scale)
+	{
+		return glm::mat4{
+			{ scale.x, 0.f, 0.f, 0.f },
+			{ 0.f, scale.y, 0.f, 0.f },
+			{ 0.f, 0.f, scale.z, 0.f },
+			{ translation, 1.f } };
+	}
+
+	glm::mat3 MakeNormalMatrix(const glm::vec3& scale)
+	{
+		return glm::mat3{
+			{ 1.f / scale.x, 0.f, 0.f },
+			{ 0.f, 1.f / scale.y, 0.f },
+			{ 0.f, 0.f, 1.f / scale.z } };
+	}
+
+	//The winding normal of every triangle in the range has to agree with the vertex normals
+	bool FacesAlongNormals(const FH::FHMergedMesh& mesh, const FH::FHModel::SubMesh& subMesh)
+	{
+		for (uint32_t idx = subMesh.firstIndex; idx < subMesh.firstIndex + subMesh.indexCount; idx += 3)
+		{
+			const FH::FHModel::Vertex& v0{ mesh.data.vertices[mesh.data.indices[idx]] };
+			const FH::FHModel::Vertex& v1{ mesh.data.vertices[mesh.data.indices[idx + 1]] };
+			const FH::FHModel::Vertex& v2{ mesh.data.vertices[mesh.data.indices[idx + 2]] };
+			if (glm::dot(glm::cross(v1.pos - v0.pos, v2.pos - v0.pos), v0.normal) <= 0.f)
+				return false;
+		}
+		return true;
+	}
+
+	bool IsInSphere(const FH::FHMergedMesh& mesh, const FH::FHModel::SubMesh& subMesh)
+	{
+		const glm::vec3 center{ subMesh.boundingSphere };
+		for (uint32_t idx = subMesh.firstIndex; idx < subMesh.firstIndex + subMesh.indexCount; ++idx)
+			if (glm::distance(center, mesh.data.vertices[mesh.data.indices[idx]].pos) > subMesh.boundingSphere.w * 1.0001f)
+				return false;
+		return true;
+	}
+}
+
+int main()
+{
+	const FH::FHModel::ModelData quad{ MakeQuad() };
+
+	const glm::vec3 scale{ 2.f, 2.f, 2.f };
+	const glm::vec3 mirroredScale{ -1.f, 1.f, 1.f };
+
+	FH::FHMergedMesh mesh{};
+	mesh.Append(quad, MakeTransform({ 5.f, 0.f, 0.f }, scale), MakeNormalMatrix(scale), 7);
+	mesh.Append(quad, MakeTransform({ -5.f, 0.f, 0.f }, mirroredScale), MakeNormalMatrix(mirroredScale), 8);
+
+	Check(mesh.data.vertices.size() == 8, "every source vertex is merged once");
+	Check(mesh.data.indices.size() == 12, "only LOD 0 of each source is merged");
+	Check(mesh.subMeshes.size() == 2, "one sub mesh per source");
+	if (!g_Succeeded)
+		return EXIT_FAILURE;
+
+	const FH::FHModel::SubMesh& plain{ mesh.subMeshes[0] };
+	const FH::FHModel::SubMesh& mirrored{ mesh.subMeshes[1] };
+
+	Check(plain.objectId == 7 && mirrored.objectId == 8, "sub meshes keep their object id");
+	Check(plain.firstIndex == 0 && plain.indexCount == 6, "first sub mesh range");
+	Check(mirrored.firstIndex == 6 && mirrored.indexCount == 6, "second sub mesh range");
+
+	for (uint32_t idx = 0; idx < 6; ++idx)
+	{
+		Check(mesh.data.indices[plain.firstIndex + idx] == quad.indices[idx], "first sub mesh indices");
+		Check(mesh.data.indices[mirrored.firstIndex + idx] >= 4 && mesh.data.indices[mirrored.firstIndex + idx] < 8,
+			"second sub mesh indices are offset to its vertices");
+	}
+
+	Check(mesh.data.vertices[2].pos == glm::vec3{ 7.f, 2.f, 0.f }, "positions are transformed");
+	Check(mesh.data.vertices[6].pos == glm::vec3{ -6.f, 1.f, 0.f }, "mirrored positions are transformed");
+
+	Check(FacesAlongNormals(mesh, plain), "winding of the scaled source");
+	Check(FacesAlongNormals(mesh, mirrored), "winding of the mirrored source is flipped back");
+	Check(mesh.data.vertices[0].tangent.w == 1.f && mesh.data.vertices[4].tangent.w == -1.f, "mirrored tangent handedness");
+
+	Check(IsInSphere(mesh, plain) && IsInSphere(mesh, mirrored), "bounding spheres hold their sub mesh");
+
+	std::cout << "Merged " << mesh.subMeshes.size() << " sources into " << mesh.data.indices.size() / 3 << " triangles, "
+		<< (g_Succeeded ? "correct" : "WRONG") << std::endl;
+	return g_Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "engine/meshOptimizer.h"
+#include "engine/model.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//Imports generated meshes like a cold start and runs ModelData::Optimize with its stats printed. The faces are written
+//in shuffled order, the way scans and exporters often leave them, so the vertex cache, fetch and overdraw passes have
+//something to fix. ACMR and ATVR must not get worse and every triangle has to survive the reordering. Overdraw is only
+//printed, a sphere hides nothing behind itself so there is little to win
+namespace
+{
+	bool g_Succeeded{ true };
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << what << std::endl;
+		g_Succeeded = g_Succeeded && condition;
+	}
+
+	//A closed UV sphere with bumps, rings x segments quads split in two triangles
+	std::string WriteShuffledSphere(const std::string& name, int rings, int segments, uint32_t seed)
+	{
+		const std::filesystem::path path{ std::filesystem::temp_directory_path() / ("fh_optimizertest_" + name + ".obj") };
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+
+		constexpr float pi{ 3.14159265f };
+		for (int ring = 0; ring <= rings; ++ring)
+		{
+			for (int segment = 0; segment <= segments; ++segment)
+			{
+				const float theta{ pi * ring / rings };
+				const float phi{ 2.f * pi * segment / segments };
+				const float radius{ 1.f + 0.05f * std::sin(7.f * phi) * std::sin(5.f * theta) };
+				file << "v " << radius * std::sin(theta) * std::cos(phi) << " " << radius * std::cos(theta) << " "
+					<< radius * std::sin(theta) * std::sin(phi) << "\n";
+				file << "vt " << segment / static_cast<float>(segments) << " " << ring / static_cast<float>(rings) << "\n";
+			}
+		}
+
+		std::vector<std::array<int, 3>> faces{};
+		for (int ring = 0; ring < rings; ++ring)
+		{
+			for (int segment = 0; segment < segments; ++segment)
+			{
+				const int v0{ ring * (segments + 1) + segment + 1 };
+				const int v1{ v0 + 1 };
+				const int v2{ v0 + segments + 1 };
+				const int v3{ v2 + 1 };
+				faces.push_back({ v0, v2, v1 });
+				faces.push_back({ v1, v2, v3 });
+			}
+		}
+
+		std::mt19937 random{ seed };
+		std::shuffle(faces.begin(), faces.end(), random);
+		for (const auto& face : faces)
+			file << "f " << face[0] << "/" << face[0] << " " << face[1] << "/" << face[1] << " "
+				<< face[2] << "/" << face[2] << "\n";
+
+		return path.string();
+	}
+
+	std::vector<glm::vec3> GetPositions(const FH::FHModel::ModelData& data)
+	{
+		std::vector<glm::vec3> positions(data.vertices.size());
+		std::transform(data.vertices.begin(), data.vertices.end(), positions.begin(),
+			[](const FH::FHModel::Vertex& vertex) { return vertex.pos; });
+		return positions;
+	}
+
+	//Triangles by corner positions, rotated so the smallest corner comes first, sorted
+	std::vector<std::array<float, 9>> GetTriangles(const FH::FHModel::ModelData& data)
+	{
+		std::vector<std::array<float, 9>> triangles(data.indices.size() / 3);
+		for (size_t triangleIdx = 0; triangleIdx < triangles.size(); ++triangleIdx)
+		{
+			std::array<glm::vec3, 3> corners{};
+			for (size_t corner = 0; corner < 3; ++corner)
+				corners[corner] = data.vertices[data.indices[3 * triangleIdx + corner]].pos;
+
+			auto isLess = [](const glm::vec3& a, const glm::vec3& b)
+				{ return std::lexicographical_compare(&a.x, &a.x + 3, &b.x, &b.x + 3); };
+			while (isLess(corners[1], corners[0]) || isLess(corners[2], corners[0]))
+				std::rotate(corners.begin(), corners.begin() + 1, corners.end());
+
+			for (size_t corner = 0; corner < 3; ++corner)
+				std::copy(&corners[corner].x, &corners[corner].x + 3, triangles[triangleIdx].begin() + 3 * corner);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	void TestOptimize(const std::string& name, int rings, int segments, uint32_t seed)
+	{
+		const std::string path{ WriteShuffledSphere(name, rings, segments, seed) };
+
+		FH::FHModel::ModelData data{};
+		data.LoadModel(path, true);
+		const auto trianglesBefore{ GetTriangles(data) };
+		const auto cacheBefore{ FH::FHMeshOptimizer::AnalyzeVertexCache(data.indices, data.vertices.size()) };
+		const auto overdrawBefore{ FH::FHMeshOptimizer::AnalyzeOverdraw(data.indices, GetPositions(data)) };
+
+		data.Optimize(true);
+		const auto cacheAfter{ FH::FHMeshOptimizer::AnalyzeVertexCache(data.indices, data.vertices.size()) };
+		const auto overdrawAfter{ FH::FHMeshOptimizer::AnalyzeOverdraw(data.indices, GetPositions(data)) };
+
+		std::cout << name << ": " << data.indices.size() / 3 << " triangles, ACMR " << cacheBefore.acmr << " -> "
+			<< cacheAfter.acmr << ", ATVR " << cacheBefore.atvr << " -> " << cacheAfter.atvr << ", overdraw "
+			<< overdrawBefore.overdraw << " -> " << overdrawAfter.overdraw << std::endl;
+
+		Check(cacheAfter.acmr <= cacheBefore.acmr, name + ": ACMR got worse");
+		Check(cacheAfter.atvr <= cacheBefore.atvr, name + ": ATVR got worse");
+		Check(GetTriangles(data) == trianglesBefore, name + ": triangles changed");
+
+		std::filesystem::remove(path);
+	}
+}
+
+int main()
+{
+	TestOptimize("small sphere", 8, 12, 1);
+	TestOptimize("sphere", 64, 96, 2);
+	TestOptimize("dense sphere", 200, 300, 3);
+
+	std::cout << (g_Succeeded ? "mesh optimizer: all checks passed" : "mesh optimizer: FAILED") << std::endl;
+	return g_Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
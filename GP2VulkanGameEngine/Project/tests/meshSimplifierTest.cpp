@@ -0,0 +1,167 @@
+#include "engine/meshSimplifier.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+//Simplifies meshes with attribute seams the way FHModel::ModelData::BuildLods does. Every LOD has to reach its
+//target triangle count, and the seams have to collapse without opening cracks, so the surface stays closed
+namespace
+{
+	struct Mesh
+	{
+		std::vector<glm::vec3> positions{};
+		std::vector<glm::vec3> normals{};
+		std::vector<uint32_t> indices{};
+	};
+
+	//Split in uv islands of islandSegments columns, the columns between them share positions like a uv seam.
+	//Every vertex of a pole shares its position
+	Mesh MakeUvSphere(int rings, int segments, int islandSegments)
+	{
+		const int columns{ segments + segments / islandSegments };
+		auto GetVertex = [&](int ring, int segment, bool isIslandStart)
+			{
+				const int column{ segment + segment / islandSegments - (isIslandStart && segment % islandSegments == 0 ? 1 : 0) };
+				return static_cast<uint32_t>(ring * columns + (column + columns) % columns);
+			};
+
+		Mesh mesh{};
+		mesh.positions.resize(static_cast<size_t>((rings + 1) * columns));
+		mesh.normals.resize(mesh.positions.size());
+		for (int ring = 0; ring <= rings; ++ring)
+			for (int segment = 0; segment < segments; ++segment)
+			{
+				const float theta{ glm::pi<float>() * ring / rings };
+				const float phi{ glm::two_pi<float>() * segment / segments };
+				const float radius{ ring == 0 || ring == rings ? 0.f : std::sin(theta) };
+				const glm::vec3 position{ radius * std::cos(phi), ring == rings ? -1.f : std::cos(theta), radius * std::sin(phi) };
+				for (bool isIslandStart : { false, true })
+				{
+					mesh.positions[GetVertex(ring, segment, isIslandStart)] = position;
+					mesh.normals[GetVertex(ring, segment, isIslandStart)] = position;
+				}
+			}
+
+		for (int ring = 0; ring < rings; ++ring)
+			for (int segment = 0; segment < segments; ++segment)
+			{
+				const uint32_t a{ GetVertex(ring, segment, false) };
+				const uint32_t b{ GetVertex(ring, segment + 1, true) };
+				const uint32_t c{ GetVertex(ring + 1, segment, false) };
+				const uint32_t d{ GetVertex(ring + 1, segment + 1, true) };
+				if (ring > 0)
+					mesh.indices.insert(mesh.indices.end(), { a, c, b });
+				if (ring < rings - 1)
+					mesh.indices.insert(mesh.indices.end(), { b, c, d });
+			}
+		return mesh;
+	}
+
+	//Every face has its own vertices for its hard normal, so each edge of the cube is a seam
+	Mesh MakeHardCube(int size)
+	{
+		Mesh mesh{};
+		for (int axis = 0; axis < 3; ++axis)
+			for (float sign : { -1.f, 1.f })
+			{
+				glm::vec3 normal{};
+				normal[axis] = sign;
+				glm::vec3 tangent{};
+				tangent[(axis + 1) % 3] = 1.f;
+				const glm::vec3 bitangent{ glm::cross(normal, tangent) };
+
+				const uint32_t first{ static_cast<uint32_t>(mesh.positions.size()) };
+				for (int y = 0; y <= size; ++y)
+					for (int x = 0; x <= size; ++x)
+					{
+						const float u{ 2.f * x / size - 1.f };
+						const float v{ 2.f * y / size - 1.f };
+						mesh.positions.push_back(normal + tangent * u + bitangent * v);
+						mesh.normals.push_back(normal);
+					}
+
+				for (int y = 0; y < size; ++y)
+					for (int x = 0; x < size; ++x)
+					{
+						const uint32_t a{ first + static_cast<uint32_t>(y * (size + 1) + x) };
+						const uint32_t b{ a + 1 };
+						const uint32_t c{ a + size + 1 };
+						const uint32_t d{ c + 1 };
+						mesh.indices.insert(mesh.indices.end(), { a, b, d, a, d, c });
+					}
+			}
+		return mesh;
+	}
+
+	//Closed when every edge between two positions is used once in each direction
+	bool IsClosed(const Mesh& mesh, const std::vector<uint32_t>& indices)
+	{
+		std::map<glm::vec3, uint32_t, bool(*)(const glm::vec3&, const glm::vec3&)> positionIds
+		{
+			[](const glm::vec3& lhs, const glm::vec3& rhs)
+			{
+				return std::make_pair(lhs.x, std::make_pair(lhs.y, lhs.z)) < std::make_pair(rhs.x, std::make_pair(rhs.y, rhs.z));
+			}
+		};
+		for (const glm::vec3& position : mesh.positions)
+			positionIds.emplace(position, static_cast<uint32_t>(positionIds.size()));
+
+		std::map<std::pair<uint32_t, uint32_t>, int> halfEdges{};
+		for (size_t idx = 0; idx < indices.size(); idx += 3)
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t a{ positionIds.at(mesh.positions[indices[idx + corner]]) };
+				const uint32_t b{ positionIds.at(mesh.positions[indices[idx + (corner + 1) % 3]]) };
+				++halfEdges[{ a, b }];
+			}
+
+		for (const auto& [edge, count] : halfEdges)
+		{
+			const auto reverse{ halfEdges.find({ edge.second, edge.first }) };
+			if (count != 1 || reverse == halfEdges.end() || reverse->second != 1)
+				return false;
+		}
+		return true;
+	}
+
+	bool CheckLods(const std::string& name, const Mesh& mesh)
+	{
+		//The limits BuildLods uses, lodCount is FHModel::MAX_LOD_COUNT
+		constexpr int lodCount{ 5 };
+		constexpr float maxRelativeError{ 0.05f };
+
+		bool isValid{ IsClosed(mesh, mesh.indices) };
+		std::vector<uint32_t> lodIndices{ mesh.indices };
+		for (int lodIdx = 1; isValid && lodIdx < lodCount; ++lodIdx)
+		{
+			const size_t targetIndexCount{ lodIndices.size() / 6 * 3 };
+			float relativeError{};
+			std::vector<uint32_t> simplified{ FH::FHMeshSimplifier::Simplify(mesh.positions, mesh.normals, lodIndices,
+				targetIndexCount, maxRelativeError, &relativeError) };
+
+			const bool isOnTarget{ simplified.size() <= targetIndexCount };
+			const bool isClosed{ IsClosed(mesh, simplified) };
+			std::cout << name << " LOD " << lodIdx << ": " << simplified.size() / 3 << " triangles, target "
+				<< targetIndexCount / 3 << ", error " << relativeError << (isClosed ? "" : ", CRACKED") << std::endl;
+
+			isValid = isOnTarget && isClosed;
+			lodIndices = std::move(simplified);
+		}
+		return isValid;
+	}
+}
+
+int main()
+{
+	bool isValid{ true };
+	isValid = CheckLods("uv sphere", MakeUvSphere(64, 128, 16)) && isValid;
+	isValid = CheckLods("hard cube", MakeHardCube(16)) && isValid;
+	return isValid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "engine/mipChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//Checks every level FHMipChain::Downsample writes against a reference 2x2 box filter of the level above it,
+//computed in double precision with the exact sRGB curves. Linear data and alpha have to match exactly, sRGB colour
+//may be one step off from the table encode. Covers odd, non square and 1 texel wide sizes
+namespace
+{
+	double SrgbToLinear(double value)
+	{
+		return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	double LinearToSrgb(double value)
+	{
+		return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+	}
+
+	//Clamped like Downsample: odd sizes drop the last row or column, a 1 texel side averages with itself
+	uint8_t ReferenceTexel(const uint8_t* pLevel, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint32_t channel, bool isSrgb)
+	{
+		const uint32_t xs[2]{ std::min(x * 2, width - 1), std::min(x * 2 + 1, width - 1) };
+		const uint32_t ys[2]{ std::min(y * 2, height - 1), std::min(y * 2 + 1, height - 1) };
+
+		const bool isEncoded{ isSrgb && channel < 3 };
+		double sum{};
+		for (uint32_t row : ys)
+			for (uint32_t column : xs)
+			{
+				const uint8_t value{ pLevel[(static_cast<size_t>(row) * width + column) * 4 + channel] };
+				sum += isEncoded ? SrgbToLinear(value / 255.0) : value;
+			}
+
+		const double average{ sum / 4.0 };
+		if (isEncoded)
+			return static_cast<uint8_t>(std::floor(std::clamp(LinearToSrgb(average), 0.0, 1.0) * 255.0 + 0.5));
+		return static_cast<uint8_t>(std::floor(average + 0.5));
+	}
+
+	bool CheckChain(uint32_t width, uint32_t height, bool isSrgb, std::mt19937& random)
+	{
+		const std::string name{ std::to_string(width) + "x" + std::to_string(height) + (isSrgb ? " srgb" : " unorm") };
+		const uint32_t levelCount{ FH::FHMipChain::GetLevelCount(width, height) };
+
+		std::vector<uint8_t> levels(FH::FHMipChain::GetSize(width, height, levelCount));
+		std::uniform_int_distribution<int> byteDistribution{ 0, 255 };
+		for (size_t idx = 0; idx < static_cast<size_t>(width) * height * 4; ++idx)
+			levels[idx] = static_cast<uint8_t>(byteDistribution(random));
+		const std::vector<uint8_t> source(levels.begin(), levels.begin() + static_cast<size_t>(width) * height * 4);
+
+		const std::vector<VkBufferImageCopy> regions{ FH::FHMipChain::Downsample(levels.data(), width, height, levelCount, isSrgb) };
+
+		bool isValid{ regions.size() == levelCount && std::equal(source.begin(), source.end(), levels.begin()) };
+		if (!isValid)
+			std::cerr << name << ": wrong level count or level 0 changed" << std::endl;
+
+		int maxDifference{};
+		for (uint32_t level = 1; isValid && level < levelCount; ++level)
+		{
+			const VkBufferImageCopy& previous{ regions[level - 1] };
+			const VkBufferImageCopy& region{ regions[level] };
+			const uint32_t levelWidth{ std::max(width >> level, 1u) };
+			const uint32_t levelHeight{ std::max(height >> level, 1u) };
+
+			if (region.imageSubresource.mipLevel != level || region.imageExtent.width != levelWidth || region.imageExtent.height != levelHeight
+				|| region.bufferOffset != FH::FHMipChain::GetSize(width, height, level))
+			{
+				std::cerr << name << ": wrong region for level " << level << std::endl;
+				isValid = false;
+				break;
+			}
+
+			const uint8_t* pPrevious{ levels.data() + previous.bufferOffset };
+			const uint8_t* pLevel{ levels.data() + region.bufferOffset };
+			for (uint32_t y = 0; y < levelHeight; ++y)
+				for (uint32_t x = 0; x < levelWidth; ++x)
+					for (uint32_t channel = 0; channel < 4; ++channel)
+					{
+						const int expected{ ReferenceTexel(pPrevious, previous.imageExtent.width, previous.imageExtent.height, x, y, channel, isSrgb) };
+						const int actual{ pLevel[(static_cast<size_t>(y) * levelWidth + x) * 4 + channel] };
+						const int difference{ std::abs(expected - actual) };
+						const int tolerance{ isSrgb && channel < 3 ? 1 : 0 };
+						maxDifference = std::max(maxDifference, difference);
+						if (difference > tolerance)
+						{
+							std::cerr << name << ": level " << level << " texel " << x << "," << y << " channel " << channel
+								<< " is " << actual << ", expected " << expected << std::endl;
+							isValid = false;
+						}
+					}
+		}
+
+		std::cout << name << ": " << levelCount << " levels, max difference " << maxDifference << (isValid ? "" : ", WRONG") << std::endl;
+		return isValid;
+	}
+}
+
+int main()
+{
+	std::mt19937 random{ 2024 };
+	const uint32_t sizes[][2]{ { 1, 1 }, { 2, 2 }, { 5, 3 }, { 7, 1 }, { 1, 9 }, { 3, 17 }, { 64, 64 }, { 257, 130 }, { 640, 480 }, { 1023, 33 } };
+
+	bool succeeded{ true };
+	for (const auto& size : sizes)
+		for (bool isSrgb : { false, true })
+			succeeded = CheckChain(size[0], size[1], isSrgb, random) && succeeded;
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "engine/mipResidency.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Checks the device free decisions of FHTextureStreamer: the level a texture needs for the pixels it covers on
+//screen, and the order in which textures drop their surplus levels once the budget is exceeded
+namespace
+{
+	bool g_Succeeded{ true };
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << what << std::endl;
+		g_Succeeded = g_Succeeded && condition;
+	}
+}
+
+int main()
+{
+	using Surplus = FH::FHMipResidency::Surplus;
+
+	//A 4096 texture with 13 levels, its tail starting at the 64 texel level 6
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 4096.f, 0, 6) == 0, "one texel per pixel needs the full size");
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 8000.f, 0, 6) == 0, "a magnified texture needs the full size");
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 1024.f, 0, 6) == 2, "a quarter of the size on screen skips two levels");
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 1500.f, 0, 6) == 1, "the level is rounded to the larger one");
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 10.f, 0, 6) == 6, "a tiny object needs no more than the tail");
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 0.f, 0, 6) == 6, "an object off screen needs no more than the tail");
+	Check(FH::FHMipResidency::GetRequiredLevel(4096, 4096.f, 2, 6) == 2, "levels above the top one are never required");
+
+	//Textures 0 and 2 were drawn in frame 10, 1 in frame 5, 3 in frame 10 with the largest surplus
+	const std::vector<Surplus> surplus{ { 10, 100 }, { 5, 50 }, { 10, 20 }, { 10, 400 } };
+
+	Check(FH::FHMipResidency::SelectEvictions(surplus, 1000, 0, 1000).empty(), "nothing is evicted inside the budget");
+	Check(FH::FHMipResidency::SelectEvictions(surplus, 1000, 30, 1000) == std::vector<size_t>{ 1 },
+		"the least recently drawn texture goes first");
+	Check(FH::FHMipResidency::SelectEvictions(surplus, 1000, 100, 1000) == std::vector<size_t>{ 1, 3 },
+		"within a frame the largest surplus goes first, and eviction stops once the budget fits");
+	Check(FH::FHMipResidency::SelectEvictions(surplus, 1000, 600, 1000) == std::vector<size_t>{ 1, 3, 0, 2 },
+		"every surplus goes when the budget still does not fit");
+	Check(FH::FHMipResidency::SelectEvictions({}, 1000, 600, 100).empty(), "without surplus there is nothing to evict");
+
+	std::cout << (g_Succeeded ? "mip residency: all checks passed" : "mip residency: FAILED") << std::endl;
+	return g_Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "external/tiny_obj_loader.h"
+#include "engine/objLoader.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//FHObjLoader has to produce exactly what tinyobj::LoadObj did before it replaced it: the same attribute arrays,
+//bit for bit, and the same triangulated corner list. Checked on the bundled models and on generated files with
+//the cases a hand written parser gets wrong
+namespace
+{
+	bool CompareWithTinyObj(const std::string& filePath)
+	{
+		tinyobj::attrib_t attrib{};
+		std::vector<tinyobj::shape_t> shapes{};
+		std::vector<tinyobj::material_t> materials{};
+		std::string error{};
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &error, filePath.c_str()))
+		{
+			std::cerr << filePath << ": tinyobj failed: " << error << std::endl;
+			return false;
+		}
+
+		const FH::FHObjLoader::Result result{ FH::FHObjLoader::Load(filePath) };
+
+		std::vector<tinyobj::index_t> expectedIndices{};
+		for (const tinyobj::shape_t& shape : shapes)
+			expectedIndices.insert(expectedIndices.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+
+		bool isMatch{ true };
+		auto check = [&](bool condition, const std::string& what)
+			{
+				if (!condition)
+					std::cerr << filePath << ": " << what << " differ" << std::endl;
+				isMatch = isMatch && condition;
+			};
+
+		check(attrib.vertices == result.positions, "positions");
+		check(attrib.normals == result.normals, "normals");
+		check(attrib.texcoords == result.texcoords, "texcoords");
+		check(expectedIndices.size() == result.indices.size(), "index counts");
+
+		for (size_t idx = 0; isMatch && idx < expectedIndices.size(); ++idx)
+		{
+			const tinyobj::index_t& expected{ expectedIndices[idx] };
+			const FH::FHObjLoader::Index& index{ result.indices[idx] };
+			check(expected.vertex_index == index.vertex && expected.normal_index == index.normal &&
+				expected.texcoord_index == index.texcoord, "corner " + std::to_string(idx));
+		}
+
+		std::cout << filePath << ": " << result.positions.size() / 3 << " positions, " << result.indices.size() / 3
+			<< " triangles, " << (isMatch ? "identical" : "DIFFERENT") << std::endl;
+		return isMatch;
+	}
+
+	std::string WriteTemp(const std::string& name, const std::string& contents)
+	{
+		const std::filesystem::path path{ std::filesystem::temp_directory_path() / ("fh_objtest_" + name + ".obj") };
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		file << contents;
+		return path.string();
+	}
+
+	//Big enough to be split in several chunks on a multi core machine, so relative indices cross chunk borders
+	std::string MakeGrid(int size)
+	{
+		std::ostringstream obj{};
+		for (int y = 0; y <= size; ++y)
+		{
+			for (int x = 0; x <= size; ++x)
+			{
+				obj << "v " << x * 0.125f << " " << y * -0.3333333f << " " << (x * y % 7) * 1.5e-3f << (y % 2 ? "\r\n" : "\n");
+				obj << "vt " << x / static_cast<float>(size) << " " << y / static_cast<float>(size) << "\n";
+			}
+			obj << "vn 0 0 1\n";
+		}
+
+		const int stride{ size + 1 };
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				const int corner{ y * stride + x + 1 };
+				if ((x + y) % 3 == 0)
+					obj << "f " << corner << "/" << corner << "/" << y + 1 << " " << corner + 1 << "/" << corner + 1 << "/" << y + 1
+						<< " " << corner + stride + 1 << "/" << corner + stride + 1 << "/" << y + 1
+						<< " " << corner + stride << "/" << corner + stride << "/" << y + 1 << "\n";
+				else if ((x + y) % 3 == 1)
+					obj << "f " << corner << "//" << y + 1 << " " << corner + 1 << "//" << y + 1 << " " << corner + stride << "//"
+						<< y + 1 << "\r\n";
+				else
+				{
+					//Every face follows all vertices, so -1 is the last vertex of the file
+					const int vertexCount{ stride * stride };
+					obj << "f " << corner - vertexCount - 1 << "/" << corner - vertexCount - 1 << " " << corner + 1 - vertexCount - 1
+						<< "/" << corner + 1 - vertexCount - 1 << " " << corner + stride - vertexCount - 1 << "/"
+						<< corner + stride - vertexCount - 1 << "\n";
+				}
+			}
+		}
+		return obj.str();
+	}
+}
+
+int main()
+{
+	std::vector<std::string> files{};
+
+	files.push_back(WriteTemp("relative",
+		"# relative indices count back from the last attribute read so far\n"
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvn 0 0 1\n"
+		"f -3/-3/-1 -2/-2/-1 -1/-1/-1\n"
+		"v 0 1 0\n"
+		"f 1/1/1 -2/3/1 -1/-2/-1\n"));
+
+	files.push_back(WriteTemp("crlf",
+		"# windows line endings\r\nv 0 0 0\r\nv 1 0 0\r\nv 1 1 0\r\nvn 0 0 1\r\nf 1//1 2//1 3//1\r\n"
+		"v 2 2 2\r\nf 2//1 3//1 4//1"));
+
+	files.push_back(WriteTemp("ngon",
+		"v 0 0 0\nv 1 0 0\nv 2 1 0\nv 1 2 0\nv 0 1 0\nv -1 0.5 0\n"
+		"f 1 2 3 4\n"
+		"f 1 2 3 4 5\n"
+		"f 1 2 3 4 5 6\n"));
+
+	files.push_back(WriteTemp("missing",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvn 0 0 1\n"
+		"f 1 2 3\n"
+		"f 1/1 2/2 3/3\n"
+		"f 1//1 2//1 3//1\n"
+		"f 1/1/1 2/2/1 3/3/1\n"));
+
+	files.push_back(WriteTemp("comments",
+		"# header comment\n\n   # indented comment\nmtllib missing.mtl\no part\ng group\n"
+		"v 1.5e-2 -2.25E+1 +3.\n\t v 4 5 6   \nv .5 0 -0\n"
+		"usemtl none\ns off\n#f 9 9 9\nf 1 2 3\n\n"));
+
+	files.push_back(WriteTemp("grid", MakeGrid(400)));
+
+	//The bundled models, when the resources are checked out
+	if (std::filesystem::is_directory("resources/models"))
+		for (const auto& entry : std::filesystem::directory_iterator{ "resources/models" })
+			if (entry.is_regular_file() && entry.path().extension() == ".obj")
+				files.push_back(entry.path().string());
+
+	bool succeeded{ true };
+	for (const std::string& file : files)
+		succeeded = CompareWithTinyObj(file) && succeeded;
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "engine/tangentGenerator.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Generates tangents for meshes whose uv directions are known. Every tangent has to be unit length, perpendicular to
+//its normal and point along dP/du, and w has to be -1 exactly where the uvs are mirrored. The grid is large enough to
+//be split over the worker threads
+namespace
+{
+	bool g_Succeeded{ true };
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << what << std::endl;
+		g_Succeeded = g_Succeeded && condition;
+	}
+
+	struct Mesh
+	{
+		std::vector<glm::vec3> positions{};
+		std::vector<glm::vec3> normals{};
+		std::vector<glm::vec2> uvs{};
+		std::vector<uint32_t> indices{};
+
+		//What the generator should find for each vertex
+		std::vector<glm::vec3> expectedTangents{};
+		std::vector<float> expectedSigns{};
+	};
+
+	//A quad of cells x cells on the plane spanned by uAxis and vAxis, facing cross(uAxis, vAxis). A mirrored quad
+	//runs u backwards, so its tangent is -uAxis and its bitangent sign flips
+	void AddQuad(Mesh& mesh, const glm::vec3& center, const glm::vec3& uAxis, const glm::vec3& vAxis, int cells, bool isMirrored)
+	{
+		const glm::vec3 normal{ glm::cross(uAxis, vAxis) };
+		const uint32_t firstVertex{ static_cast<uint32_t>(mesh.positions.size()) };
+		for (int y = 0; y <= cells; ++y)
+			for (int x = 0; x <= cells; ++x)
+			{
+				const float u{ x / static_cast<float>(cells) };
+				const float v{ y / static_cast<float>(cells) };
+				mesh.positions.push_back(center + uAxis * (u - 0.5f) + vAxis * (v - 0.5f));
+				mesh.normals.push_back(normal);
+				mesh.uvs.push_back({ isMirrored ? 1.f - u : u, v });
+				mesh.expectedTangents.push_back(isMirrored ? -uAxis : uAxis);
+				mesh.expectedSigns.push_back(isMirrored ? -1.f : 1.f);
+			}
+
+		for (int y = 0; y < cells; ++y)
+			for (int x = 0; x < cells; ++x)
+			{
+				const uint32_t v0{ firstVertex + static_cast<uint32_t>(y * (cells + 1) + x) };
+				const uint32_t v1{ v0 + 1 };
+				const uint32_t v2{ v0 + static_cast<uint32_t>(cells + 1) };
+				const uint32_t v3{ v2 + 1 };
+				mesh.indices.insert(mesh.indices.end(), { v0, v1, v3, v0, v3, v2 });
+			}
+	}
+
+	//Unit cube with hard edges, every face has its own vertices. The -X face mirrors its uvs like a symmetric
+	//model that shares one half of its texture between both sides
+	Mesh MakeCube()
+	{
+		const glm::vec3 x{ 1.f, 0.f, 0.f };
+		const glm::vec3 y{ 0.f, 1.f, 0.f };
+		const glm::vec3 z{ 0.f, 0.f, 1.f };
+
+		Mesh mesh{};
+		AddQuad(mesh, 0.5f * z, x, y, 1, false);
+		AddQuad(mesh, -0.5f * z, -x, y, 1, false);
+		AddQuad(mesh, 0.5f * x, -z, y, 1, false);
+		AddQuad(mesh, -0.5f * x, z, y, 1, true);
+		AddQuad(mesh, 0.5f * y, x, -z, 1, false);
+		AddQuad(mesh, -0.5f * y, x, z, 1, false);
+		return mesh;
+	}
+
+	void CheckTangents(const std::string& name, const Mesh& mesh)
+	{
+		std::vector<glm::vec4> tangents(mesh.positions.size());
+		FH::FHTangentGenerator::Generate(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, tangents);
+
+		size_t wrongCount{};
+		for (size_t vertexIdx = 0; vertexIdx < tangents.size(); ++vertexIdx)
+		{
+			const glm::vec3 tangent{ tangents[vertexIdx] };
+			const bool isUnit{ std::abs(glm::length(tangent) - 1.f) < 1e-4f };
+			const bool isOrthogonal{ std::abs(glm::dot(tangent, mesh.normals[vertexIdx])) < 1e-4f };
+			const bool isAlongU{ glm::dot(tangent, mesh.expectedTangents[vertexIdx]) > 0.9999f };
+			const bool isSignRight{ tangents[vertexIdx].w == mesh.expectedSigns[vertexIdx] };
+
+			if (!(isUnit && isOrthogonal && isAlongU && isSignRight) && wrongCount++ < 4)
+				std::cerr << name << " vertex " << vertexIdx << ": tangent (" << tangent.x << ", " << tangent.y << ", "
+					<< tangent.z << ", " << tangents[vertexIdx].w << ")" << (isUnit ? "" : ", not unit")
+					<< (isOrthogonal ? "" : ", not orthogonal") << (isAlongU ? "" : ", not along u")
+					<< (isSignRight ? "" : ", wrong sign") << std::endl;
+		}
+
+		std::cout << name << ": " << tangents.size() << " vertices, " << wrongCount << " wrong" << std::endl;
+		Check(wrongCount == 0, name + ": tangent frames");
+	}
+
+	//Corners without usable uvs still need a frame the shader can normalize
+	void CheckDegenerateUvs()
+	{
+		const std::vector<glm::vec3> positions{ { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f } };
+		const std::vector<glm::vec3> normals(3, glm::vec3{ 0.f, 0.f, 1.f });
+		const std::vector<glm::vec2> uvs(3, glm::vec2{ 0.5f });
+		const std::vector<uint32_t> indices{ 0, 1, 2 };
+
+		std::vector<glm::vec4> tangents(3);
+		FH::FHTangentGenerator::Generate(positions, normals, uvs, indices, tangents);
+		for (const glm::vec4& tangent : tangents)
+			Check(std::abs(glm::length(glm::vec3{ tangent }) - 1.f) < 1e-4f && std::abs(tangent.z) < 1e-4f &&
+				std::abs(tangent.w) == 1.f, "degenerate uvs: fallback tangent");
+	}
+}
+
+int main()
+{
+	CheckTangents("cube", MakeCube());
+
+	//Over MIN_RANGE_SIZE triangles and vertices, both passes run on several threads when the cores are there
+	Mesh grid{};
+	AddQuad(grid, glm::vec3{ 0.f }, glm::normalize(glm::vec3{ 1.f, 0.f, 1.f }), glm::vec3{ 0.f, 1.f, 0.f }, 160, false);
+	AddQuad(grid, glm::vec3{ 0.f, 0.f, 2.f }, glm::vec3{ 0.f, 0.f, 1.f }, glm::vec3{ 1.f, 0.f, 0.f }, 160, true);
+	CheckTangents("mirrored grid", grid);
+
+	CheckDegenerateUvs();
+
+	std::cout << (g_Succeeded ? "tangent generator: all checks passed" : "tangent generator: FAILED") << std::endl;
+	return g_Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "engine/texelDensity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//Measures meshes with known areas like FHAssetRegistry::AnalyzeTexelDensity: only LOD 0 counts, the scale of the
+//object changes the world area but not the UV area, and the resolvable size is the power of two at which one texel
+//covers at most one pixel of the view
+namespace
+{
+	bool g_Succeeded{ true };
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << what << std::endl;
+		g_Succeeded = g_Succeeded && condition;
+	}
+
+	bool IsNear(double value, double expected)
+	{
+		return std::abs(value - expected) <= 1e-6 * std::max(1.0, std::abs(expected));
+	}
+
+	//A unit quad in the xy plane with UVs over [0, uvSize], followed by a LOD 1 triangle that must not be measured
+	FH::FHModel::ModelData MakeQuad(float uvSize)
+	{
+		FH::FHModel::ModelData data{};
+		const glm::vec2 corners[4]{ { 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f } };
+		for (const glm::vec2& corner : corners)
+			data.vertices.push_back({ glm::vec3{ corner, 0.f }, glm::vec3{ 0.f, 0.f, 1.f }, corner * uvSize, glm::vec4{ 1.f, 0.f, 0.f, 1.f } });
+
+		data.indices = { 0, 1, 2, 0, 2, 3, 0, 1, 3 };
+		data.lods.push_back({ 0, 6 });
+		data.lods.push_back({ 6, 3 });
+		return data;
+	}
+}
+
+int main()
+{
+	const FH::FHModel::ModelData quad{ MakeQuad(1.f) };
+
+	const FH::FHTexelDensity::Surface unit{ FH::FHTexelDensity::Measure(quad) };
+	Check(IsNear(unit.worldArea, 1.0) && IsNear(unit.uvArea, 1.0), "a unit quad has unit world and UV area, LOD 1 ignored");
+	Check(IsNear(FH::FHTexelDensity::GetUvDensity(unit), 1.0), "a unit quad maps one UV unit per world unit");
+
+	const FH::FHTexelDensity::Surface lent{ FH::FHTexelDensity::Measure(quad.vertices, quad.indices, quad.lods) };
+	Check(lent.worldArea == unit.worldArea && lent.uvArea == unit.uvArea, "lent arrays measure like the model data");
+
+	FH::FHModel::ModelData withoutLods{ quad };
+	withoutLods.lods.clear();
+	const FH::FHTexelDensity::Surface allIndices{ FH::FHTexelDensity::Measure(withoutLods) };
+	Check(IsNear(allIndices.worldArea, 1.5), "without LODs every index is measured");
+
+	const FH::FHTexelDensity::Surface scaled{ FH::FHTexelDensity::Measure(quad, glm::vec3{ 2.f }) };
+	Check(IsNear(scaled.worldArea, 4.0) && IsNear(scaled.uvArea, 1.0), "a uniform scale of 2 quadruples only the world area");
+	Check(IsNear(FH::FHTexelDensity::GetUvDensity(scaled), 0.5), "a uniform scale of 2 halves the UV density");
+
+	const FH::FHTexelDensity::Surface stretched{ FH::FHTexelDensity::Measure(quad, glm::vec3{ 3.f, 1.f, 5.f }) };
+	Check(IsNear(stretched.worldArea, 3.0), "scaling along the normal does not change the area of a flat quad");
+
+	const FH::FHTexelDensity::Surface tiled{ FH::FHTexelDensity::Measure(MakeQuad(0.25f)) };
+	Check(IsNear(FH::FHTexelDensity::GetUvDensity(tiled), 0.25), "a quarter of the texture on a unit quad is a quarter of the density");
+
+	//A 90 degree view 5 units away is 10 units tall, 1080 pixels over it
+	const FH::FHTexelDensity::View view{ 5.f, 3.14159265358979f * 0.5f, 1080 };
+	Check(IsNear(FH::FHTexelDensity::GetPixelDensity(view), 108.0), "the pixel density is the screen height over the view height");
+	Check(FH::FHTexelDensity::GetResolvableSize(unit, view) == 128, "108 pixels per unit resolve a 128 texel texture");
+	Check(FH::FHTexelDensity::GetResolvableSize(scaled, view) == 256, "twice the size needs twice the texels");
+	Check(FH::FHTexelDensity::GetResolvableSize(tiled, view) == 512, "a quarter of the texture needs four times the texels");
+
+	const FH::FHTexelDensity::View farView{ 5000.f, 3.14159265358979f * 0.5f, 1080 };
+	Check(FH::FHTexelDensity::GetResolvableSize(unit, farView) == 1, "a model far away never drops below one texel");
+
+	Check(FH::FHTexelDensity::GetResolvableSize(FH::FHTexelDensity::Measure(MakeQuad(0.f)), view) == UINT32_MAX,
+		"a mesh without UV area is not limited");
+	Check(FH::FHTexelDensity::GetResolvableSize(FH::FHTexelDensity::Measure(quad, glm::vec3{ 0.f }), view) == UINT32_MAX,
+		"a mesh without world area is not limited");
+
+	std::cout << (g_Succeeded ? "texel density: all checks passed" : "texel density: FAILED") << std::endl;
+	return g_Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
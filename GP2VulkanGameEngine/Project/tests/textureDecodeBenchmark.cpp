@@ -0,0 +1,233 @@
+#include "engine/imageDecoder.h"
+#include "engine/ormPacker.h"
+#include "engine/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Times decoding the bundled textures one after another, like the texture constructors did, against the way
+//FHAssetRegistry::PreloadTextures spreads its jobs over the cores: largest first, every worker pulling the next job.
+//The files are read up front so only the decode is timed. Fails when the two give different pixels.
+//The upload of the images is then run both ways into a buffer standing in for the staging memory: decoded into a pixel
+//vector first and copied over, like the preload did, and decoded straight into it. The texel bytes each way copies are
+//counted, the direct way has to copy every image once
+namespace
+{
+	struct Job
+	{
+		std::string name{};
+		FH::FHMaterialPaths material{};	//the ORM channels, empty for a single image
+		std::vector<std::vector<uint8_t>> fileData{};
+		bool isOrm{};
+	};
+
+	std::vector<uint8_t> ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		return { std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	}
+
+	//A texture per diffuse or normal map and one ORM image per material folder, like the registry asks for
+	std::vector<Job> FindJobs(const std::filesystem::path& textureRoot)
+	{
+		std::vector<Job> jobs{};
+		for (const auto& folder : std::filesystem::directory_iterator{ textureRoot })
+		{
+			if (!folder.is_directory())
+				continue;
+
+			Job orm{ folder.path().filename().string() + " orm" };
+			orm.isOrm = true;
+			orm.fileData.resize(3);
+			for (const auto& entry : std::filesystem::directory_iterator{ folder.path() })
+			{
+				const std::string stem{ entry.path().stem().string() };
+				const std::string file{ entry.path().filename().string() };
+				const std::array<std::pair<const char*, std::string*>, 3> channels{ { { "_ao", &orm.material.ao },
+					{ "_roughness", &orm.material.roughness }, { "_specular", &orm.material.specular } } };
+
+				bool isChannel{};
+				for (size_t channelIdx = 0; channelIdx < channels.size(); ++channelIdx)
+					if (stem.ends_with(channels[channelIdx].first))
+					{
+						*channels[channelIdx].second = file;
+						orm.fileData[channelIdx] = ReadFile(entry.path());
+						isChannel = true;
+					}
+
+				if (!isChannel && entry.path().extension() == ".png")
+					jobs.push_back({ file, {}, { ReadFile(entry.path()) } });
+			}
+
+			if (FH::FHOrmPacker::HasChannels(orm.material))
+				jobs.push_back(std::move(orm));
+		}
+		return jobs;
+	}
+
+	std::vector<uint8_t> Decode(const Job& job)
+	{
+		if (job.isOrm)
+			return FH::FHOrmPacker::Pack(job.material, std::span<const std::vector<uint8_t>, 3>{ job.fileData.data(), 3 }).pixels;
+
+		uint32_t width{};
+		uint32_t height{};
+		FH::FHImageDecoder::GetSize(job.fileData[0], width, height);
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+		FH::FHImageDecoder::Decode(job.fileData[0], pixels.data(), width, height);
+		return pixels;
+	}
+
+	struct UploadRun
+	{
+		double millis{};
+		uint64_t copiedBytes{};
+		//Largest host allocation besides the staging memory and stb_image's own buffer
+		size_t peakExtraBytes{};
+	};
+
+	//Every single image decoded into staging, through a pixel vector or straight into it
+	UploadRun RunUploads(const std::vector<Job>& jobs, std::vector<uint8_t>& staging, bool isThroughPixels)
+	{
+		UploadRun run{};
+		const uint64_t copiedBefore{ FH::FHImageDecoder::GetCopiedBytes() };
+		const auto start{ std::chrono::steady_clock::now() };
+		size_t offset{};
+		for (const Job& job : jobs)
+		{
+			if (job.isOrm)
+				continue;
+
+			uint32_t width{};
+			uint32_t height{};
+			FH::FHImageDecoder::GetSize(job.fileData[0], width, height);
+			const size_t byteSize{ static_cast<size_t>(width) * height * 4 };
+			if (isThroughPixels)
+			{
+				std::vector<uint8_t> pixels(byteSize);
+				FH::FHImageDecoder::Decode(job.fileData[0], pixels.data(), width, height);
+				std::memcpy(staging.data() + offset, pixels.data(), byteSize);
+				run.copiedBytes += byteSize;
+				run.peakExtraBytes = std::max(run.peakExtraBytes, byteSize);
+			}
+			else
+				FH::FHImageDecoder::Decode(job.fileData[0], staging.data() + offset, width, height);
+			offset += byteSize;
+		}
+		run.millis = std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count();
+		run.copiedBytes += FH::FHImageDecoder::GetCopiedBytes() - copiedBefore;
+		return run;
+	}
+
+	template<typename Run>
+	double TimeBest(Run&& run)
+	{
+		double bestMillis{ std::numeric_limits<double>::max() };
+		for (int attempt = 0; attempt < 3; ++attempt)
+		{
+			const auto start{ std::chrono::steady_clock::now() };
+			run();
+			bestMillis = std::min(bestMillis, std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count());
+		}
+		return bestMillis;
+	}
+}
+
+int main()
+{
+	std::vector<Job> jobs{ FindJobs("resources/textures") };
+	if (jobs.empty())
+	{
+		std::cerr << "no textures found under resources/textures" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	size_t fileBytes{};
+	for (const Job& job : jobs)
+		for (const std::vector<uint8_t>& data : job.fileData)
+			fileBytes += data.size();
+	std::sort(jobs.begin(), jobs.end(), [](const Job& lhs, const Job& rhs)
+		{
+			auto size = [](const Job& job) { size_t bytes{}; for (const auto& data : job.fileData) bytes += data.size(); return bytes; };
+			return size(lhs) > size(rhs);
+		});
+
+	std::vector<std::vector<uint8_t>> serial(jobs.size());
+	const double serialMillis{ TimeBest([&]()
+		{
+			for (size_t jobIdx = 0; jobIdx < jobs.size(); ++jobIdx)
+				serial[jobIdx] = Decode(jobs[jobIdx]);
+		}) };
+
+	std::vector<std::vector<uint8_t>> parallel(jobs.size());
+	const double parallelMillis{ TimeBest([&]()
+		{
+			std::atomic<size_t> nextJob{};
+			FH::ParallelFor(jobs.size(), 1, [&](size_t, size_t)
+				{
+					for (size_t jobIdx = nextJob++; jobIdx < jobs.size(); jobIdx = nextJob++)
+						parallel[jobIdx] = Decode(jobs[jobIdx]);
+				});
+		}) };
+
+	//No core count gets the wall time below the largest image
+	double longestMillis{};
+	std::string longestName{};
+	for (const Job& job : jobs)
+	{
+		const double jobMillis{ TimeBest([&]() { Decode(job); }) };
+		if (jobMillis > longestMillis)
+		{
+			longestMillis = jobMillis;
+			longestName = job.name;
+		}
+	}
+
+	const bool isMatch{ serial == parallel };
+	const size_t threadCount{ std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency())) };
+	std::cout << jobs.size() << " textures from " << fileBytes / 1024 << " KiB of PNG\n"
+		<< "serial " << serialMillis << " ms\n"
+		<< "parallel on " << threadCount << " threads " << parallelMillis << " ms (" << serialMillis / parallelMillis << "x), "
+		<< (isMatch ? "identical" : "DIFFERENT") << "\n"
+		<< "longest " << longestName << " " << longestMillis << " ms, at most " << serialMillis / longestMillis
+		<< "x with enough cores" << std::endl;
+
+	size_t imageBytes{};
+	for (const Job& job : jobs)
+		if (!job.isOrm)
+		{
+			uint32_t width{};
+			uint32_t height{};
+			FH::FHImageDecoder::GetSize(job.fileData[0], width, height);
+			imageBytes += static_cast<size_t>(width) * height * 4;
+		}
+
+	std::vector<uint8_t> stagingThroughPixels(imageBytes);
+	std::vector<uint8_t> stagingDirect(imageBytes);
+	const UploadRun throughPixels{ RunUploads(jobs, stagingThroughPixels, true) };
+	const UploadRun direct{ RunUploads(jobs, stagingDirect, false) };
+
+	const bool isSameUpload{ stagingThroughPixels == stagingDirect };
+	const bool isCopiedOnce{ direct.copiedBytes == imageBytes };
+	const double imageMiB{ imageBytes / (1024. * 1024.) };
+	std::cout << "upload of " << imageMiB << " MiB of texels\n"
+		<< "through pixels " << throughPixels.millis << " ms, " << throughPixels.copiedBytes / static_cast<double>(imageBytes)
+		<< " copies, " << throughPixels.peakExtraBytes / 1024 << " KiB pixel vector at most\n"
+		<< "into staging " << direct.millis << " ms, " << direct.copiedBytes / static_cast<double>(imageBytes)
+		<< " copies, " << direct.peakExtraBytes / 1024 << " KiB pixel vector at most, "
+		<< (isSameUpload ? "identical" : "DIFFERENT") << std::endl;
+
+	return isMatch && isSameUpload && isCopiedOnce ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "engine/textureEviction.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Checks the order in which FHResidencyManager drops textures without a .ktx2 to their mip tail once the budget is
+//exceeded, least recently drawn first and never one drawn this frame, and which evicted ones it loads again
+namespace
+{
+	bool g_Succeeded{ true };
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << what << std::endl;
+		g_Succeeded = g_Succeeded && condition;
+	}
+}
+
+int main()
+{
+	using Texture = FH::FHTextureEviction::Texture;
+	constexpr uint64_t frame{ 20 };
+
+	//Full chain and tail bytes, the surplus is what eviction frees. Texture 4 was drawn this frame, 5 is already
+	//evicted and 6 is no larger than its tail
+	const std::vector<Texture> textures{ { 12, 400, 10 }, { 3, 100, 10 }, { 12, 600, 10 }, { 7, 200, 10 },
+		{ frame, 900, 10 }, { 1, 500, 10, true }, { 2, 10, 10 } };
+	const VkDeviceSize residentBytes{ 400 + 100 + 600 + 200 + 900 + 10 + 10 };
+
+	Check(FH::FHTextureEviction::SelectEvictions(textures, frame, residentBytes, 0, residentBytes).empty(),
+		"nothing is evicted inside the budget");
+	Check(FH::FHTextureEviction::SelectEvictions(textures, frame, residentBytes, 0, residentBytes - 50) == std::vector<size_t>{ 1 },
+		"the least recently drawn texture goes first and eviction stops once the budget fits");
+	Check(FH::FHTextureEviction::SelectEvictions(textures, frame, residentBytes, 0, residentBytes - 300) == std::vector<size_t>{ 1, 3, 2 },
+		"older frames go first, the larger surplus first within a frame");
+	Check(FH::FHTextureEviction::SelectEvictions(textures, frame, residentBytes, 0, 0) == std::vector<size_t>{ 1, 3, 2, 0 },
+		"the texture drawn this frame, the evicted one and the one at its tail stay even when the budget cannot be met");
+	Check(FH::FHTextureEviction::SelectEvictions(textures, frame, residentBytes - 300, 300, residentBytes - 50) ==
+		std::vector<size_t>{ 1 }, "reload bytes count against the budget");
+
+	//Texture 5 is evicted and drawn again this frame
+	std::vector<Texture> drawn{ textures };
+	drawn[5].drawFrame = frame;
+	Check(FH::FHTextureEviction::GetReloadBytes(textures, frame) == 0, "nothing to reload when no evicted texture is drawn");
+	Check(FH::FHTextureEviction::GetReloadBytes(drawn, frame) == 490, "the reload needs the surplus of the drawn texture");
+	Check(FH::FHTextureEviction::SelectReloads(drawn, frame, residentBytes, residentBytes + 490) == std::vector<size_t>{ 5 },
+		"a drawn texture that fits is loaded again");
+	Check(FH::FHTextureEviction::SelectReloads(drawn, frame, residentBytes, residentBytes + 489).empty(),
+		"a drawn texture that does not fit stays at its tail");
+	Check(FH::FHTextureEviction::SelectReloads(textures, frame, 0, residentBytes).empty(),
+		"an evicted texture that is not drawn stays at its tail");
+
+	//Over budget with the drawn texture needing its reload: evict in LRU order until both fit, then reload
+	const VkDeviceSize budget{ residentBytes + 210 };
+	const VkDeviceSize reloadBytes{ FH::FHTextureEviction::GetReloadBytes(drawn, frame) };
+	const std::vector<size_t> evictions{ FH::FHTextureEviction::SelectEvictions(drawn, frame, residentBytes, reloadBytes, budget) };
+	Check(evictions == std::vector<size_t>{ 1, 3 }, "room for a reload is made from the least recently drawn textures");
+
+	VkDeviceSize evictedBytes{};
+	for (size_t textureIdx : evictions)
+		evictedBytes += drawn[textureIdx].fullBytes - drawn[textureIdx].tailBytes;
+	Check(FH::FHTextureEviction::SelectReloads(drawn, frame, residentBytes - evictedBytes, budget) == std::vector<size_t>{ 5 },
+		"the drawn texture is reloaded once the others made room");
+
+	std::cout << (g_Succeeded ? "texture eviction: all checks passed" : "texture eviction: FAILED") << std::endl;
+	return g_Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
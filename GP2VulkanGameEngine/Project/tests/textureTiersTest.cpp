@@ -0,0 +1,55 @@
+#include "engine/textureTiers.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Checks the load time texture tiers of FHResidencyManager: the bytes a catalogue takes at a tier, the largest tier
+//picked for a budget, and that the minimum size holds when even it does not fit
+namespace
+{
+	constexpr VkDeviceSize MIB{ 1024 * 1024 };
+
+	bool Expect(bool condition, const std::string& description)
+	{
+		if (!condition)
+			std::cerr << "FAILED: " << description << std::endl;
+		return condition;
+	}
+}
+
+int main()
+{
+	using TextureSize = FH::FHTextureTiers::TextureSize;
+
+	//Two 4096 RGBA8 textures with their mips, a 2048 one and a 512 one
+	const std::vector<TextureSize> catalogue{ { 4096, 85 * MIB }, { 4096, 85 * MIB }, { 2048, 21 * MIB }, { 512, 4 * MIB } };
+	const VkDeviceSize fullBytes{ 85 * MIB * 2 + 21 * MIB + 4 * MIB };
+
+	bool succeeded{ true };
+	succeeded = Expect(FH::FHTextureTiers::GetBytes(catalogue, UINT32_MAX) == fullBytes, "no tier keeps every byte") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::GetBytes(catalogue, 4096) == fullBytes, "the largest size keeps every byte") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::GetBytes(catalogue, 2048) == 85 * MIB / 4 * 2 + 21 * MIB + 4 * MIB,
+		"a 2048 tier quarters only the 4096 textures") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::GetBytes(catalogue, 1024) == 85 * MIB / 16 * 2 + 21 * MIB / 4 + 4 * MIB,
+		"a 1024 tier halves every texture above it until it fits") && succeeded;
+
+	succeeded = Expect(FH::FHTextureTiers::SelectMaxSize(catalogue, fullBytes, 256) == UINT32_MAX,
+		"a catalogue that fits is not limited") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::SelectMaxSize(catalogue, fullBytes - 1, 256) == 2048,
+		"one byte short drops one tier") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::SelectMaxSize(catalogue, 20 * MIB, 256) == 1024,
+		"the largest tier that fits is picked") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::SelectMaxSize(catalogue, 0, 256) == 256,
+		"an empty budget stops at the minimum size") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::GetBytes(catalogue, 256) > 0,
+		"the minimum size still reports its bytes so the caller can tell it does not fit") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::SelectMaxSize(catalogue, 30 * MIB, 8192) == 8192,
+		"a minimum above every texture leaves them at full size") && succeeded;
+	succeeded = Expect(FH::FHTextureTiers::SelectMaxSize({}, 0, 256) == UINT32_MAX,
+		"an empty catalogue always fits") && succeeded;
+
+	std::cout << (succeeded ? "texture tiers: all checks passed" : "texture tiers: FAILED") << std::endl;
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "engine/objLoader.h"
+#include "engine/utils.h"
+#include "engine/vertexWelder.h"
+
+#include <glm/gtc/constants.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//Times FHVertexWelder against the std::unordered_map dedup ModelData::LoadObj used before it, on the corners of the
+//bundled models and of a generated mesh, and fails when the two give different vertices or indices
+namespace
+{
+	struct Corner
+	{
+		glm::vec3 pos{};
+		glm::vec3 normal{};
+		glm::vec2 uv{};
+
+		bool operator==(const Corner& other) const
+		{
+			return pos == other.pos && normal == other.normal && uv == other.uv;
+		}
+	};
+
+	struct CornerHash
+	{
+		size_t operator()(const Corner& corner) const
+		{
+			size_t seed{};
+			FH::HashCombine(seed, corner.pos, corner.normal, corner.uv);
+			return seed;
+		}
+	};
+
+	struct Welded
+	{
+		std::vector<Corner> vertices{};
+		std::vector<uint32_t> indices{};
+	};
+
+	//The map based loop as it was, count() then operator[]
+	Welded WeldWithMap(const std::vector<Corner>& corners)
+	{
+		Welded welded{};
+		welded.indices.reserve(corners.size());
+
+		std::unordered_map<Corner, uint32_t, CornerHash> uniqueVertices{};
+		for (const Corner& corner : corners)
+		{
+			if (uniqueVertices.count(corner) == 0)
+			{
+				uniqueVertices[corner] = static_cast<uint32_t>(welded.vertices.size());
+				welded.vertices.push_back(corner);
+			}
+			welded.indices.push_back(uniqueVertices[corner]);
+		}
+		return welded;
+	}
+
+	Welded WeldWithWelder(const std::vector<Corner>& corners)
+	{
+		Welded welded{};
+		welded.indices.reserve(corners.size());
+
+		FH::FHVertexWelder welder{ corners.size() };
+		for (const Corner& corner : corners)
+		{
+			const uint32_t vertexIdx{ welder.Weld(corner.pos, corner.normal, corner.uv) };
+			if (vertexIdx == welded.vertices.size())
+				welded.vertices.push_back(corner);
+			welded.indices.push_back(vertexIdx);
+		}
+		return welded;
+	}
+
+	std::vector<Corner> LoadCorners(const std::string& filePath)
+	{
+		const FH::FHObjLoader::Result obj{ FH::FHObjLoader::Load(filePath) };
+
+		std::vector<Corner> corners(obj.indices.size());
+		for (size_t cornerIdx = 0; cornerIdx < corners.size(); ++cornerIdx)
+		{
+			const FH::FHObjLoader::Index& index{ obj.indices[cornerIdx] };
+			Corner& corner{ corners[cornerIdx] };
+			if (index.vertex >= 0)
+				corner.pos = { obj.positions[3 * index.vertex], obj.positions[3 * index.vertex + 1], obj.positions[3 * index.vertex + 2] };
+			if (index.normal >= 0)
+				corner.normal = { obj.normals[3 * index.normal], obj.normals[3 * index.normal + 1], obj.normals[3 * index.normal + 2] };
+			if (index.texcoord >= 0)
+				corner.uv = { obj.texcoords[2 * index.texcoord], obj.texcoords[2 * index.texcoord + 1] };
+		}
+		return corners;
+	}
+
+	//Two triangles per quad of a sphere grid with a UV seam and hard normals on every eighth row,
+	//about four corners per vertex like the scanned meshes
+	std::vector<Corner> MakeSphereCorners(int rows, int columns)
+	{
+		auto makeCorner = [rows, columns](int row, int column)
+			{
+				const float theta{ glm::pi<float>() * row / rows };
+				const float phi{ glm::two_pi<float>() * (column % columns) / columns };
+				const glm::vec3 pos{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+				const glm::vec3 normal{ row % 8 == 0 ? glm::vec3{ 0.f, row < rows / 2 ? 1.f : -1.f, 0.f } : pos };
+				return Corner{ pos, normal, { static_cast<float>(column) / columns, static_cast<float>(row) / rows } };
+			};
+
+		std::vector<Corner> corners{};
+		corners.reserve(static_cast<size_t>(rows) * columns * 6);
+		for (int row = 0; row < rows; ++row)
+			for (int column = 0; column < columns; ++column)
+				for (const auto& [rowOffset, columnOffset] : { std::pair{ 0, 0 }, { 1, 0 }, { 0, 1 }, { 0, 1 }, { 1, 0 }, { 1, 1 } })
+					corners.push_back(makeCorner(row + rowOffset, column + columnOffset));
+		return corners;
+	}
+
+	template<typename Weld>
+	double TimeBest(const std::vector<Corner>& corners, Weld&& weld, Welded& result)
+	{
+		constexpr int runCount{ 5 };
+		double bestMillis{ std::numeric_limits<double>::max() };
+		for (int run = 0; run < runCount; ++run)
+		{
+			const auto start{ std::chrono::steady_clock::now() };
+			result = weld(corners);
+			bestMillis = std::min(bestMillis, std::chrono::duration<double, std::milli>{ std::chrono::steady_clock::now() - start }.count());
+		}
+		return bestMillis;
+	}
+
+	bool Benchmark(const std::string& name, const std::vector<Corner>& corners)
+	{
+		Welded mapResult{};
+		Welded welderResult{};
+		const double mapMillis{ TimeBest(corners, WeldWithMap, mapResult) };
+		const double welderMillis{ TimeBest(corners, WeldWithWelder, welderResult) };
+
+		const bool isMatch{ mapResult.vertices == welderResult.vertices && mapResult.indices == welderResult.indices };
+		std::cout << name << ": " << corners.size() << " corners -> " << welderResult.vertices.size() << " vertices, map "
+			<< mapMillis << " ms, welder " << welderMillis << " ms (" << mapMillis / welderMillis << "x), "
+			<< (isMatch ? "identical" : "DIFFERENT") << std::endl;
+		return isMatch;
+	}
+}
+
+int main()
+{
+	bool succeeded{ Benchmark("generated sphere", MakeSphereCorners(512, 1024)) };
+
+	if (std::filesystem::is_directory("resources/models"))
+		for (const auto& entry : std::filesystem::directory_iterator{ "resources/models" })
+			if (entry.is_regular_file() && entry.path().extension() == ".obj")
+				succeeded = Benchmark(entry.path().string(), LoadCorners(entry.path().string())) && succeeded;
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "engine/ktxFile.h"
+#include "engine/virtualPage.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+//Writes a BC7 .ktx2 whose blocks hold their own level and position, copies every page of every level like
+//FHVirtualTextureCache does and checks each block of the slots, including the border that wraps around the level edges
+namespace
+{
+	constexpr uint32_t BLOCK_SIZE{ 16 };
+
+	struct BlockId
+	{
+		uint32_t level{};
+		uint32_t x{};
+		uint32_t y{};
+		uint32_t marker{};
+	};
+
+	BlockId GetBlockId(uint32_t level, uint32_t x, uint32_t y)
+	{
+		return { level, x, y, 0xB10C0000u | level };
+	}
+
+	//Signed modulo, the border left of and above the first page comes from the other edge
+	uint32_t Wrap(int64_t value, uint32_t size)
+	{
+		return static_cast<uint32_t>(((value % size) + size) % size);
+	}
+}
+
+int main()
+{
+	constexpr uint32_t width{ 512 };
+	constexpr uint32_t height{ 256 };
+	constexpr uint32_t levelCount{ 3 };	//down to 128x64, a level smaller than one page
+
+	std::vector<std::vector<uint8_t>> levels{};
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		const uint32_t blocksX{ (width >> level) / 4 };
+		const uint32_t blocksY{ (height >> level) / 4 };
+		std::vector<uint8_t>& data{ levels.emplace_back(static_cast<size_t>(blocksX) * blocksY * BLOCK_SIZE) };
+		for (uint32_t y = 0; y < blocksY; ++y)
+			for (uint32_t x = 0; x < blocksX; ++x)
+			{
+				const BlockId id{ GetBlockId(level, x, y) };
+				std::memcpy(data.data() + (static_cast<size_t>(y) * blocksX + x) * BLOCK_SIZE, &id, sizeof(id));
+			}
+	}
+
+	const std::filesystem::path path{ std::filesystem::temp_directory_path() / "fh_virtualpagetest.ktx2" };
+	if (!FH::FHKtxFile::Write(path.string(), VK_FORMAT_BC7_SRGB_BLOCK, width, height, levels))
+	{
+		std::cerr << "failed to write " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	bool succeeded{ true };
+	{
+		const FH::FHKtxFile file{ path.string() };
+		constexpr uint32_t slotBlocks{ FH::FHVirtualPage::SLOT_SIZE / 4 };
+		constexpr uint32_t pageBlocks{ FH::FHVirtualPage::PAGE_SIZE / 4 };
+		constexpr uint32_t borderBlocks{ FH::FHVirtualPage::PAGE_BORDER / 4 };
+
+		uint32_t pageCount{};
+		std::vector<uint8_t> slot{};
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			const uint32_t blocksX{ (width >> level) / 4 };
+			const uint32_t blocksY{ (height >> level) / 4 };
+			const uint32_t pagesX{ std::max((width >> level) / FH::FHVirtualPage::PAGE_SIZE, 1u) };
+			const uint32_t pagesY{ std::max((height >> level) / FH::FHVirtualPage::PAGE_SIZE, 1u) };
+
+			for (uint32_t pageY = 0; pageY < pagesY; ++pageY)
+				for (uint32_t pageX = 0; pageX < pagesX; ++pageX)
+				{
+					FH::FHVirtualPage::Copy(file, level, pageX, pageY, slot);
+					++pageCount;
+					if (slot.size() != static_cast<size_t>(slotBlocks) * slotBlocks * BLOCK_SIZE)
+					{
+						std::cerr << "level " << level << " page " << pageX << "," << pageY << ": wrong slot size " << slot.size() << std::endl;
+						succeeded = false;
+						continue;
+					}
+
+					for (uint32_t y = 0; y < slotBlocks; ++y)
+						for (uint32_t x = 0; x < slotBlocks; ++x)
+						{
+							const BlockId expected{ GetBlockId(level,
+								Wrap(static_cast<int64_t>(pageX * pageBlocks + x) - borderBlocks, blocksX),
+								Wrap(static_cast<int64_t>(pageY * pageBlocks + y) - borderBlocks, blocksY)) };
+							BlockId actual{};
+							std::memcpy(&actual, slot.data() + (static_cast<size_t>(y) * slotBlocks + x) * BLOCK_SIZE, sizeof(actual));
+							if (std::memcmp(&expected, &actual, sizeof(BlockId)) != 0)
+							{
+								std::cerr << "level " << level << " page " << pageX << "," << pageY << " slot block " << x << "," << y
+									<< " holds level " << actual.level << " block " << actual.x << "," << actual.y << ", expected "
+									<< expected.x << "," << expected.y << std::endl;
+								succeeded = false;
+							}
+						}
+				}
+		}
+
+		std::cout << "virtual pages: " << pageCount << " pages over " << levelCount << " levels "
+			<< (succeeded ? "copied correctly" : "WRONG") << std::endl;
+	}
+
+	std::filesystem::remove(path);
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "blockEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	//Bounding box corners of the block on its dominant diagonal, pulled in by 1/16 of the range
+	//since the extremes rarely deserve a whole palette entry
+	void GetEndpoints(const uint8_t texels[16][4], uint32_t channelCount, float low[4], float high[4])
+	{
+		float mean[4]{};
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+		{
+			low[channel] = 255.f;
+			high[channel] = 0.f;
+			for (uint32_t texel = 0; texel < 16; ++texel)
+			{
+				low[channel] = std::min(low[channel], static_cast<float>(texels[texel][channel]));
+				high[channel] = std::max(high[channel], static_cast<float>(texels[texel][channel]));
+				mean[channel] += texels[texel][channel] / 16.f;
+			}
+		}
+
+		uint32_t widest{};
+		for (uint32_t channel = 1; channel < channelCount; ++channel)
+			if (high[channel] - low[channel] > high[widest] - low[widest])
+				widest = channel;
+
+		//Channels that fall while the widest one rises run along the other diagonal
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+		{
+			float covariance{};
+			for (uint32_t texel = 0; texel < 16; ++texel)
+				covariance += (texels[texel][widest] - mean[widest]) * (texels[texel][channel] - mean[channel]);
+			if (covariance < 0.f)
+				std::swap(low[channel], high[channel]);
+
+			const float inset{ (high[channel] - low[channel]) / 16.f };
+			low[channel] += inset;
+			high[channel] -= inset;
+		}
+	}
+
+	template<uint32_t ChannelCount>
+	uint32_t FindNearest(const uint8_t texel[4], const int palette[][4], uint32_t paletteSize, const uint32_t* pChannels)
+	{
+		uint32_t nearest{};
+		int nearestError{ INT32_MAX };
+		for (uint32_t entry = 0; entry < paletteSize; ++entry)
+		{
+			int error{};
+			for (uint32_t channelIdx = 0; channelIdx < ChannelCount; ++channelIdx)
+			{
+				const int delta{ texel[pChannels[channelIdx]] - palette[entry][channelIdx] };
+				error += delta * delta;
+			}
+			if (error < nearestError)
+			{
+				nearestError = error;
+				nearest = entry;
+			}
+		}
+		return nearest;
+	}
+
+	uint16_t To565(const float color[3])
+	{
+		auto quantize = [](float value, int maxValue)
+			{
+				return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 255.f) * maxValue / 255.f));
+			};
+		return static_cast<uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+	}
+
+	void From565(uint16_t color, int rgb[4])
+	{
+		const int red{ (color >> 11) & 31 };
+		const int green{ (color >> 5) & 63 };
+		const int blue{ color & 31 };
+		rgb[0] = (red << 3) | (red >> 2);
+		rgb[1] = (green << 2) | (green >> 4);
+		rgb[2] = (blue << 3) | (blue >> 2);
+		rgb[3] = 255;
+	}
+
+	class BitWriter final
+	{
+	public:
+		explicit BitWriter(uint8_t* pBlock)
+			: m_pBlock{ pBlock }
+		{}
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; ++bit, ++m_Position)
+				if (value & (1u << bit))
+					m_pBlock[m_Position / 8] |= static_cast<uint8_t>(1u << (m_Position % 8));
+		}
+
+	private:
+		uint8_t* m_pBlock;
+		uint32_t m_Position{};
+	};
+}
+
+std::vector<uint8_t> FH::FHBlockEncoder::Encode(VkFormat format, const uint8_t* pRgba, uint32_t width, uint32_t height)
+{
+	uint32_t blockSize{};
+	switch (format)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+		blockSize = 8;
+		break;
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		blockSize = 16;
+		break;
+	default:
+		throw std::invalid_argument("unsupported block compressed format!");
+	}
+
+	const uint32_t blocksX{ (width + 3) / 4 };
+	const uint32_t blocksY{ (height + 3) / 4 };
+	std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+	uint8_t texels[16][4]{};
+	for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+	{
+		for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+		{
+			for (uint32_t texel = 0; texel < 16; ++texel)
+			{
+				const uint32_t x{ std::min(blockX * 4 + texel % 4, width - 1) };
+				const uint32_t y{ std::min(blockY * 4 + texel / 4, height - 1) };
+				std::copy_n(pRgba + (static_cast<size_t>(y) * width + x) * 4, 4, texels[texel]);
+			}
+
+			uint8_t* pBlock{ blocks.data() + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize };
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+				EncodeBC1(texels, pBlock);
+				break;
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				EncodeBC4(texels, 0, pBlock);
+				break;
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+				EncodeBC4(texels, 0, pBlock);
+				EncodeBC4(texels, 1, pBlock + 8);
+				break;
+			default:
+				EncodeBC7(texels, pBlock);
+				break;
+			}
+		}
+	}
+	return blocks;
+}
+
+void FH::FHBlockEncoder::EncodeBC1(const uint8_t texels[16][4], uint8_t* pBlock)
+{
+	float low[4]{};
+	float high[4]{};
+	GetEndpoints(texels, 3, low, high);
+
+	//The first color has to be the larger one for the four color mode
+	uint16_t color0{ To565(high) };
+	uint16_t color1{ To565(low) };
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	int palette[4][4]{};
+	From565(color0, palette[0]);
+	From565(color1, palette[1]);
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+		palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+	}
+
+	uint32_t indices{};
+	if (color0 != color1)
+	{
+		constexpr uint32_t channels[3]{ 0, 1, 2 };
+		for (uint32_t texel = 0; texel < 16; ++texel)
+			indices |= FindNearest<3>(texels[texel], palette, 4, channels) << (texel * 2);
+	}
+
+	pBlock[0] = static_cast<uint8_t>(color0);
+	pBlock[1] = static_cast<uint8_t>(color0 >> 8);
+	pBlock[2] = static_cast<uint8_t>(color1);
+	pBlock[3] = static_cast<uint8_t>(color1 >> 8);
+	for (uint32_t byte = 0; byte < 4; ++byte)
+		pBlock[4 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+}
+
+void FH::FHBlockEncoder::EncodeBC4(const uint8_t texels[16][4], uint32_t channel, uint8_t* pBlock)
+{
+	//Both extremes are exact in 8 bits, so the range is not inset
+	uint8_t low{ 255 };
+	uint8_t high{ 0 };
+	for (uint32_t texel = 0; texel < 16; ++texel)
+	{
+		low = std::min(low, texels[texel][channel]);
+		high = std::max(high, texels[texel][channel]);
+	}
+
+	//The larger endpoint first selects the eight value mode
+	int palette[8][4]{ { high }, { low } };
+	for (int entry = 2; entry < 8; ++entry)
+		palette[entry][0] = ((8 - entry) * high + (entry - 1) * low + 3) / 7;
+
+	uint64_t indices{};
+	if (high != low)
+	{
+		for (uint32_t texel = 0; texel < 16; ++texel)
+			indices |= static_cast<uint64_t>(FindNearest<1>(texels[texel], palette, 8, &channel)) << (texel * 3);
+	}
+
+	pBlock[0] = high;
+	pBlock[1] = low;
+	for (uint32_t byte = 0; byte < 6; ++byte)
+		pBlock[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+}
+
+void FH::FHBlockEncoder::EncodeBC7(const uint8_t texels[16][4], uint8_t* pBlock)
+{
+	constexpr int weights[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	float endpoints[2][4]{};
+	GetEndpoints(texels, 4, endpoints[0], endpoints[1]);
+
+	//7 bits per channel plus one shared low bit per endpoint, whichever low bit fits the endpoint best
+	uint32_t quantized[2][4]{};
+	uint32_t pBits[2]{};
+	int expanded[2][4]{};
+	for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+	{
+		float bestError{ INFINITY };
+		for (uint32_t pBit = 0; pBit < 2; ++pBit)
+		{
+			float error{};
+			uint32_t candidate[4]{};
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				const float value{ endpoints[endpoint][channel] };
+				candidate[channel] = static_cast<uint32_t>(std::clamp(std::lround((value - pBit) / 2.f), 0l, 127l));
+				const float delta{ static_cast<float>((candidate[channel] << 1) | pBit) - value };
+				error += delta * delta;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBits[endpoint] = pBit;
+				std::copy_n(candidate, 4, quantized[endpoint]);
+			}
+		}
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			expanded[endpoint][channel] = static_cast<int>((quantized[endpoint][channel] << 1) | pBits[endpoint]);
+	}
+
+	int palette[16][4]{};
+	for (uint32_t entry = 0; entry < 16; ++entry)
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			palette[entry][channel] = ((64 - weights[entry]) * expanded[0][channel] + weights[entry] * expanded[1][channel] + 32) >> 6;
+
+	constexpr uint32_t channels[4]{ 0, 1, 2, 3 };
+	uint32_t indices[16]{};
+	for (uint32_t texel = 0; texel < 16; ++texel)
+		indices[texel] = FindNearest<4>(texels[texel], palette, 16, channels);
+
+	//The first index is stored without its top bit, swapping the endpoints keeps it clear
+	if (indices[0] & 8)
+	{
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+		for (uint32_t& index : indices)
+			index = 15 - index;
+	}
+
+	std::fill_n(pBlock, 16, uint8_t{});
+	BitWriter writer{ pBlock };
+	writer.Write(1u << 6, 7);	//mode 6
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		writer.Write(quantized[0][channel], 7);
+		writer.Write(quantized[1][channel], 7);
+	}
+	writer.Write(pBits[0], 1);
+	writer.Write(pBits[1], 1);
+	for (uint32_t texel = 0; texel < 16; ++texel)
+		writer.Write(indices[texel], texel == 0 ? 3 : 4);
+}
\ No newline at end of file
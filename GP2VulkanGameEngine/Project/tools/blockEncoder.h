@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace FH
+{
+	//Offline BCn encoders for RGBA8 images. Endpoints come from the bounding box of each block along its
+	//dominant diagonal, indices are picked by exhaustive search. BC7 only uses mode 6 (one RGBA subset, 4 bit indices)
+	class FHBlockEncoder final
+	{
+	public:
+		//Supports the BC1 RGB, BC4, BC5 and BC7 formats FHKtxFile accepts. Edge blocks repeat the last texels
+		static std::vector<uint8_t> Encode(VkFormat format, const uint8_t* pRgba, uint32_t width, uint32_t height);
+
+		static void EncodeBC1(const uint8_t texels[16][4], uint8_t* pBlock);
+		static void EncodeBC4(const uint8_t texels[16][4], uint32_t channel, uint8_t* pBlock);
+		static void EncodeBC7(const uint8_t texels[16][4], uint8_t* pBlock);
+
+		FHBlockEncoder() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "tools/blockEncoder.h"
+#include "engine/ktxFile.h"
+#include "engine/mipChain.h"
+#include "engine/ormPacker.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "external/stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+//Offline converter from the PNG textures to .ktx2 files with block compressed mips, which FHTexture
+//picks up instead of the PNG next to them.
+//Usage: FHTextureEncoder [--format bc1|bc4|bc5|bc7] [--linear] [--max-size texels] <image or directory>...
+//Without --format the format follows the name: _normal is BC5 and the rest is BC7 in sRGB unless --linear
+//is given. _roughness/_specular/_ao images are packed per material into one linear BC7 _orm.ktx2 instead.
+//--max-size drops the levels larger than it, for the resolvable size the texel density report gives at load
+namespace
+{
+	struct Options
+	{
+		std::string format{};
+		bool isLinear{};
+		uint32_t maxSize{ UINT32_MAX };
+	};
+
+	std::optional<VkFormat> GetFormat(const Options& options, const std::filesystem::path& imagePath)
+	{
+		std::string format{ options.format };
+		bool isLinear{ options.isLinear };
+		if (format.empty())
+		{
+			const std::string stem{ imagePath.stem().string() };
+			auto endsWith = [&stem](const std::string& suffix)
+				{
+					return stem.size() >= suffix.size() && stem.compare(stem.size() - suffix.size(), suffix.size(), suffix) == 0;
+				};
+
+			format = endsWith("_normal") || stem == "normalmap" ? "bc5" : "bc7";
+		}
+
+		if (format == "bc1")
+			return isLinear ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		if (format == "bc4")
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		if (format == "bc5")
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		if (format == "bc7")
+			return isLinear ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+		return std::nullopt;
+	}
+
+	bool IsSrgb(VkFormat format)
+	{
+		return format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	//mipChain holds level 0 and has room for the rest of the chain
+	bool EncodeMipChain(VkFormat format, std::vector<uint8_t>& mipChain, uint32_t width, uint32_t height, uint32_t maxSize,
+		const std::string& ktxPath, std::chrono::steady_clock::time_point start)
+	{
+		const uint32_t levelCount{ FH::FHMipChain::GetLevelCount(width, height) };
+		const std::vector<VkBufferImageCopy> regions{ FH::FHMipChain::Downsample(mipChain.data(), width, height,
+			levelCount, IsSrgb(format)) };
+
+		//The file starts at the first level within maxSize, the larger ones are only made to filter it
+		size_t firstLevel{};
+		while (firstLevel + 1 < regions.size() &&
+			std::max(regions[firstLevel].imageExtent.width, regions[firstLevel].imageExtent.height) > maxSize)
+			++firstLevel;
+
+		std::vector<std::vector<uint8_t>> levels{};
+		size_t compressedSize{};
+		for (size_t levelIdx = firstLevel; levelIdx < regions.size(); ++levelIdx)
+		{
+			const VkBufferImageCopy& region{ regions[levelIdx] };
+			levels.push_back(FH::FHBlockEncoder::Encode(format, mipChain.data() + region.bufferOffset,
+				region.imageExtent.width, region.imageExtent.height));
+			compressedSize += levels.back().size();
+		}
+
+		width = regions[firstLevel].imageExtent.width;
+		height = regions[firstLevel].imageExtent.height;
+		if (!FH::FHKtxFile::Write(ktxPath, format, width, height, levels))
+			return false;
+
+		const std::chrono::duration<double, std::milli> encodeMillis{ std::chrono::steady_clock::now() - start };
+		std::cout << ktxPath << ": " << width << "x" << height << ", " << levels.size() << " levels, "
+			<< mipChain.size() / 1024 << " KiB RGBA8 -> " << compressedSize / 1024 << " KiB in "
+			<< encodeMillis.count() << " ms" << std::endl;
+		return true;
+	}
+
+	bool EncodeImage(const Options& options, const std::filesystem::path& imagePath)
+	{
+		const std::optional<VkFormat> format{ GetFormat(options, imagePath) };
+		if (!format)
+		{
+			std::cerr << "unknown format: " << options.format << std::endl;
+			return false;
+		}
+
+		const auto start{ std::chrono::steady_clock::now() };
+
+		//Flipped like FHTexture loads the PNG, so both paths share the UV convention
+		int width{};
+		int height{};
+		int channels{};
+		stbi_set_flip_vertically_on_load(true);
+		stbi_uc* pPixels{ stbi_load(imagePath.string().c_str(), &width, &height, &channels, STBI_rgb_alpha) };
+		if (!pPixels)
+		{
+			std::cerr << "failed to load image: " << imagePath.string() << std::endl;
+			return false;
+		}
+
+		const uint32_t levelWidth{ static_cast<uint32_t>(width) };
+		const uint32_t levelHeight{ static_cast<uint32_t>(height) };
+		std::vector<uint8_t> mipChain(FH::FHMipChain::GetSize(levelWidth, levelHeight,
+			FH::FHMipChain::GetLevelCount(levelWidth, levelHeight)));
+		std::copy_n(pPixels, static_cast<size_t>(levelWidth) * levelHeight * 4, mipChain.begin());
+		stbi_image_free(pPixels);
+
+		return EncodeMipChain(*format, mipChain, levelWidth, levelHeight, options.maxSize, FH::FHKtxFile::GetKtxPath(imagePath.string()), start);
+	}
+
+	bool EncodeOrm(const Options& options, const FH::FHMaterialPaths& material)
+	{
+		const auto start{ std::chrono::steady_clock::now() };
+
+		FH::FHOrmPacker::Image image{};
+		try
+		{
+			image = FH::FHOrmPacker::Pack(material, "");
+		}
+		catch (const std::exception& exc)
+		{
+			std::cerr << exc.what() << std::endl;
+			return false;
+		}
+
+		image.pixels.resize(FH::FHMipChain::GetSize(image.width, image.height,
+			FH::FHMipChain::GetLevelCount(image.width, image.height)));
+		return EncodeMipChain(VK_FORMAT_BC7_UNORM_BLOCK, image.pixels, image.width, image.height, options.maxSize,
+			FH::FHOrmPacker::GetPackedPath(material), start);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options{};
+	std::vector<std::filesystem::path> images{};
+
+	for (int argIdx = 1; argIdx < argc; ++argIdx)
+	{
+		const std::string argument{ argv[argIdx] };
+		if (argument == "--format" && argIdx + 1 < argc)
+			options.format = argv[++argIdx];
+		else if (argument == "--linear")
+			options.isLinear = true;
+		else if (argument == "--max-size" && argIdx + 1 < argc)
+			options.maxSize = static_cast<uint32_t>(std::max(std::atoi(argv[++argIdx]), 1));
+		else if (std::filesystem::is_directory(argument))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator{ argument })
+				if (entry.is_regular_file() && entry.path().extension() == ".png")
+					images.push_back(entry.path());
+		}
+		else
+			images.push_back(argument);
+	}
+
+	if (images.empty())
+	{
+		std::cerr << "usage: FHTextureEncoder [--format bc1|bc4|bc5|bc7] [--linear] [--max-size texels] <image or directory>..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	//Single channel maps are only sampled through their material's ORM texture
+	std::map<std::filesystem::path, FH::FHMaterialPaths> ormMaterials{};
+	bool succeeded{ true };
+	for (const std::filesystem::path& image : images)
+	{
+		const std::string stem{ image.stem().string() };
+		auto getOrmSlot = [&](const std::string& suffix) -> std::string*
+			{
+				if (!options.format.empty() || stem.size() <= suffix.size() ||
+					stem.compare(stem.size() - suffix.size(), suffix.size(), suffix) != 0)
+					return nullptr;
+
+				const std::filesystem::path prefix{ image.parent_path() / stem.substr(0, stem.size() - suffix.size()) };
+				FH::FHMaterialPaths& material{ ormMaterials[prefix] };
+				return suffix == "_ao" ? &material.ao : suffix == "_roughness" ? &material.roughness : &material.specular;
+			};
+
+		std::string* pSlot{ getOrmSlot("_ao") };
+		if (!pSlot)
+			pSlot = getOrmSlot("_roughness");
+		if (!pSlot)
+			pSlot = getOrmSlot("_specular");
+
+		if (pSlot)
+			*pSlot = image.generic_string();
+		else
+			succeeded = EncodeImage(options, image) && succeeded;
+	}
+
+	for (const auto& [prefix, material] : ormMaterials)
+		succeeded = EncodeOrm(options, material) && succeeded;
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file